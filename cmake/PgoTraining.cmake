@@ -0,0 +1,62 @@
+# PGO training workload, run by the pgo-train target in the GENERATE stage.
+#
+# The synthetic generator writes two repeatable years of measurements and
+# Unitify runs over them the way it is used: the default reports (parsing,
+# evaluation, the sorted statistics and the report files), the optional
+# report sections, queries that filter, sort and aggregate, and the diff.
+# Each run adds to the profiles in PROFILE_DIR, which start out empty.
+
+foreach(var UNITIFY GENERATOR LINES WORK_DIR PROFILE_DIR STAGE)
+  if(NOT DEFINED ${var})
+    message(FATAL_ERROR "PgoTraining.cmake: ${var} is not set")
+  endif()
+endforeach()
+if(NOT STAGE STREQUAL "GENERATE")
+  message(FATAL_ERROR "pgo-train needs an instrumented build: configure with -DUNITIFY_PGO=GENERATE")
+endif()
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+file(GLOB stale ${PROFILE_DIR}/*.gcda ${PROFILE_DIR}/*.profraw ${PROFILE_DIR}/*.profdata)
+if(stale)
+  file(REMOVE ${stale})
+endif()
+
+function(run)
+  execute_process(COMMAND ${ARGN}
+                  WORKING_DIRECTORY ${WORK_DIR}
+                  RESULT_VARIABLE result
+                  OUTPUT_QUIET)
+  if(NOT result EQUAL 0)
+    message(FATAL_ERROR "PGO training step failed (${result}): ${ARGN}")
+  endif()
+endfunction()
+
+run(${GENERATOR} --same-dimension ${LINES} 1 year1.txt)
+run(${GENERATOR} --same-dimension ${LINES} 2 year2.txt)
+
+set(files year1.txt year2.txt)
+run(${UNITIFY} --quiet ${files})
+run(${UNITIFY} --quiet --reader=mmap --histogram --distinct --unit-summary
+    --outliers=flag --report-units=km,kg,min,l ${files})
+run(${UNITIFY} --quiet --float32 --filter=dimension=Length,min=0|unit=g ${files})
+run(${UNITIFY} --quiet --fixed-point ${files})
+run(${UNITIFY} --quiet
+    "--query=select * where mag>100 stats count,mean,median,p99 sort desc limit 50"
+    ${files})
+run(${UNITIFY} --quiet
+    "--query=select dim=Length,dim=Volume where mag>=1km or valid convert km,l stats min,max sort asc"
+    ${files})
+run(${UNITIFY} --quiet --diff=percent:10 ${files})
+
+# Clang writes raw profiles that must be merged before the USE stage
+if(COMPILER_ID MATCHES "Clang")
+  find_program(LLVM_PROFDATA NAMES llvm-profdata)
+  if(NOT LLVM_PROFDATA)
+    message(FATAL_ERROR "llvm-profdata is needed to merge the Clang profiles")
+  endif()
+  file(GLOB raw ${PROFILE_DIR}/*.profraw)
+  run(${LLVM_PROFDATA} merge -output=${PROFILE_DIR}/default.profdata ${raw})
+endif()
+
+message(STATUS "PGO profiles written to ${PROFILE_DIR}; reconfigure with -DUNITIFY_PGO=USE and rebuild")
@@ -0,0 +1,89 @@
+/**
+ * @file ArrowExporter.h
+ * @brief Declaration of the ArrowExporter class.
+ *
+ * The ArrowExporter class writes the columns of a ResultStore in the Apache
+ * Arrow IPC format, as a stream (.arrows) or as a random-access file
+ * (.arrow), so tools such as pyarrow, DuckDB or Polars can read the results
+ * without a conversion step. The Flatbuffers metadata is encoded in-tree;
+ * no Arrow or Flatbuffers library is needed.
+ *
+ * The schema is:
+ *  - line: int64
+ *  - magnitude: float64, null where the result is not finite
+ *  - unit: dictionary<uint8, utf8>, e.g. "km"
+ *  - dimension: dictionary<uint8, utf8>, e.g. "Length"
+ *
+ * The store's columns already have Arrow's layout (little-endian int64 line
+ * numbers, float64 magnitudes under DOUBLE, one byte unit IDs), so record
+ * batch bodies are written straight from the columns and every buffer is
+ * 64-byte aligned in the output, ready to be memory-mapped. Only the
+ * validity bitmap (when a batch has nulls) and FLOAT32 magnitudes, which are
+ * widened, go through a scratch buffer.
+ *
+ * @version 0.1
+ */
+
+#ifndef ARROWEXPORTER_H
+#define ARROWEXPORTER_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include "ResultStore.h"
+#include "Units.h"
+
+/**
+ * @enum ArrowFormat
+ * @brief Framing of the Arrow IPC messages.
+ */
+enum class ArrowFormat {
+  STREAM,  ///< IPC streaming format: schema, dictionaries, batches, EOS.
+  FILE     ///< IPC file format: the stream between magic numbers, plus a
+           ///< footer indexing the batches for random access.
+};
+
+/**
+ * @class ArrowExporter
+ * @brief Utility class for exporting results in the Arrow IPC format.
+ */
+class ArrowExporter {
+ public:
+  static const std::size_t BATCH_ROWS = 65536;  ///< Rows per record batch.
+  static const std::size_t ALIGNMENT = 64;      ///< Buffer alignment.
+
+  /**
+   * @brief Writes results to a stream.
+   * @param results The result store.
+   * @param out The binary stream to write to.
+   * @param format Stream or file framing.
+   * @return The number of bytes written.
+   */
+  static std::size_t write(const ResultStore& results, std::ostream& out,
+                           ArrowFormat format = ArrowFormat::FILE);
+
+  /**
+   * @brief Writes results to a file.
+   * @param results The result store.
+   * @param path The file to create.
+   * @param format Stream or file framing.
+   * @return The number of bytes written.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  static std::size_t save(const ResultStore& results, const std::string& path,
+                          ArrowFormat format = ArrowFormat::FILE);
+
+  /**
+   * @brief Retrieves the label a unit is exported under.
+   *
+   * Units are stored as a base unit and a factor, so the label is rebuilt
+   * from both: "km" for (m, 1000), "min" for (s, 60). Factors without a
+   * symbol are written out, e.g. "m*0.3048".
+   *
+   * @param unit The unit.
+   * @return The label.
+   */
+  static std::string getUnitLabel(const Units& unit);
+};
+
+#endif  // ARROWEXPORTER_H
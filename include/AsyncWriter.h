@@ -0,0 +1,172 @@
+/**
+ * @file AsyncWriter.h
+ * @brief Declaration of the AsyncWriter and StreamRedirect classes.
+ *
+ * The AsyncWriter class is a stream buffer that moves the write system calls
+ * of an output stream to a background thread. It owns two large buffers:
+ * producers format into one while the thread writes the other to the file
+ * descriptor, so formatting the reports never waits on the disk or the
+ * terminal unless the thread falls a whole buffer behind.
+ *
+ * Any std::ostream can write through it, including std::cout for the
+ * lifetime of a StreamRedirect:
+ *
+ *   AsyncWriter writer(STDOUT_FILENO);
+ *   StreamRedirect redirect(std::cout, writer);
+ *
+ * On a terminal, std::endl hands the buffer over when the thread is idle so
+ * output still appears line by line; on files and pipes it does nothing and
+ * buffers are handed over when they are full.
+ *
+ * @version 0.1
+ */
+
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+/**
+ * @class AsyncWriter
+ * @brief Double-buffered stream buffer written by a background thread.
+ */
+class AsyncWriter : public std::streambuf {
+ private:
+  int fd;                          ///< The file descriptor written to.
+  bool ownsFd;                     ///< Whether the destructor closes fd.
+  bool isTerminal;                 ///< Whether fd is a terminal.
+  std::unique_ptr<char[]> buffers[2];  ///< The buffer pair, uninitialized.
+  std::size_t bufferSize;          ///< The size of each buffer.
+  int active;                      ///< The buffer producers fill.
+  std::size_t pendingSize;         ///< Bytes handed to the thread, 0 if idle.
+  std::size_t bytesWritten;        ///< Bytes the thread has written.
+  bool isStopping;                 ///< Tells the thread to exit.
+  bool hasFailed;                  ///< Whether a write failed.
+  std::mutex mutex;                ///< Guards the hand-over state.
+  std::condition_variable ready;   ///< Signalled when a buffer is handed over.
+  std::condition_variable done;    ///< Signalled when a buffer is written.
+  std::thread thread;              ///< The writing thread.
+
+  /**
+   * @brief Writes handed-over buffers until stopped.
+   */
+  void run();
+
+  /**
+   * @brief Hands the active buffer to the thread and switches buffers.
+   *
+   * Waits only while the thread is still writing the other buffer.
+   *
+   * @return false if a write failed.
+   */
+  bool handOver();
+
+  /**
+   * @brief Starts the thread.
+   * @param size The size of each buffer.
+   */
+  void start(std::size_t size);
+
+ protected:
+  /**
+   * @brief Hands over the full buffer and stores c in the next one.
+   * @param c The character that did not fit.
+   * @return c, or EOF if a write failed.
+   */
+  int_type overflow(int_type c) override;
+
+  /**
+   * @brief Copies characters in, handing over buffers as they fill up.
+   * @param s The characters.
+   * @param n The number of characters.
+   * @return n, or fewer if a write failed.
+   */
+  std::streamsize xsputn(const char* s, std::streamsize n) override;
+
+  /**
+   * @brief Called by std::flush and std::endl.
+   *
+   * Hands the buffer over if fd is a terminal and the thread is idle; never
+   * waits for the write.
+   *
+   * @return 0, or -1 if a write failed.
+   */
+  int sync() override;
+
+ public:
+  static const std::size_t DEFAULT_BUFFER_SIZE = 1 << 20;  ///< 1 MiB.
+
+  /**
+   * @brief Writes to an open file descriptor, which is left open.
+   * @param fd The file descriptor, e.g. STDOUT_FILENO.
+   * @param bufferSize The size of each of the two buffers.
+   */
+  explicit AsyncWriter(int fd, std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /**
+   * @brief Creates (or truncates) a file and writes to it.
+   * @param path The file.
+   * @param bufferSize The size of each of the two buffers.
+   * @throws std::runtime_error if the file cannot be created.
+   */
+  explicit AsyncWriter(const std::string& path,
+                       std::size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+  /**
+   * @brief Flushes, stops the thread and closes an owned file.
+   */
+  ~AsyncWriter() override;
+
+  AsyncWriter(const AsyncWriter&) = delete;
+  AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+  /**
+   * @brief Writes out everything buffered and waits for it.
+   * @throws std::runtime_error if a write failed.
+   */
+  void flush();
+
+  /**
+   * @brief Retrieves the number of bytes written to fd so far.
+   * @return The byte count.
+   */
+  std::size_t getBytesWritten();
+};
+
+/**
+ * @class StreamRedirect
+ * @brief Points a stream at another stream buffer until destroyed.
+ *
+ * Restoring the previous buffer before the AsyncWriter is destroyed keeps
+ * late writes (and the final flush of std::cout at exit) away from it.
+ */
+class StreamRedirect {
+ private:
+  std::ostream& stream;       ///< The redirected stream.
+  std::streambuf* previous;   ///< Its original buffer.
+
+ public:
+  /**
+   * @brief Redirects a stream.
+   * @param stream The stream, e.g. std::cout.
+   * @param buffer The buffer it writes to from now on.
+   */
+  StreamRedirect(std::ostream& stream, std::streambuf& buffer);
+
+  /**
+   * @brief Flushes the stream and restores its original buffer.
+   */
+  ~StreamRedirect();
+
+  StreamRedirect(const StreamRedirect&) = delete;
+  StreamRedirect& operator=(const StreamRedirect&) = delete;
+};
+
+#endif  // ASYNCWRITER_H
@@ -0,0 +1,136 @@
+/**
+ * @file CsvScanner.h
+ * @brief Declaration of the CsvScanner class.
+ *
+ * The CsvScanner class splits a buffer of CSV text into records and fields
+ * the way the TextScanner splits expression files into lines and tokens: 64
+ * bytes at a time are classified into quote, delimiter and newline bitmasks
+ * with SIMD compares, a prefix XOR over the quote mask marks the bytes inside
+ * quoted fields, and the delimiters and newlines outside quotes are walked
+ * with count-trailing-zeros.
+ *
+ * @version 0.1
+ */
+
+#ifndef CSVSCANNER_H
+#define CSVSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "TextScanner.h"
+
+/**
+ * @struct CsvOptions
+ * @brief How a CSV file maps to measurements.
+ *
+ * The defaults read the output of ReportGenerator::generateCSVReport. A
+ * column given by index takes precedence over one given by header name.
+ */
+struct CsvOptions {
+  char delimiter;               ///< Field separator.
+  bool hasHeader;               ///< Whether the first record names columns.
+  std::string magnitudeColumn;  ///< Header name of the magnitude column.
+  std::string unitColumn;       ///< Header name of the unit column.
+  int magnitudeIndex;           ///< Zero-based magnitude column, or -1.
+  int unitIndex;                ///< Zero-based unit column, or -1.
+
+  CsvOptions()
+      : delimiter(','),
+        hasHeader(true),
+        magnitudeColumn("Magnitude"),
+        unitColumn("Unit"),
+        magnitudeIndex(-1),
+        unitIndex(-1) {}
+};
+
+/**
+ * @struct ScannedRecords
+ * @brief The records and fields found in a buffer by CsvScanner::scanRecords.
+ *
+ * Record i owns fields [recordFieldEnds[i-1], recordFieldEnds[i]) (from 0
+ * for the first record). Field spans still include their quotes; a '\\r'
+ * before a record's '\\n' is not part of its last field.
+ */
+struct ScannedRecords {
+  std::vector<TokenSpan> fields;          ///< Every field, in order.
+  std::vector<uint32_t> recordEnds;       ///< Offset of each record's '\n'
+                                          ///< (the buffer end for a final,
+                                          ///< unterminated record).
+  std::vector<uint32_t> recordFieldEnds;  ///< One past each record's fields.
+  std::vector<uint64_t> quoteMasks;       ///< Scratch: 1 bit per '"' byte.
+  std::vector<uint64_t> delimiterMasks;   ///< Scratch: 1 bit per delimiter.
+  std::vector<uint64_t> newlineMasks;     ///< Scratch: 1 bit per '\n' byte.
+
+  /**
+   * @brief Retrieves the number of complete records found.
+   * @return The record count.
+   */
+  std::size_t recordCount() const;
+};
+
+/**
+ * @class CsvScanner
+ * @brief Utility class for SIMD CSV record and field scanning.
+ *
+ * Fields follow RFC 4180: a field may be enclosed in double quotes, inside
+ * which delimiters and newlines are data and "" stands for one quote.
+ */
+class CsvScanner {
+ public:
+  /**
+   * @brief Classifies bytes into quote, delimiter and newline bitmasks.
+   *
+   * Bit b of word w describes byte 64 * w + b; bits past the end of the
+   * buffer are clear.
+   *
+   * @param data The buffer.
+   * @param size The number of bytes.
+   * @param delimiter The field separator.
+   * @param quotes Receives (size + 63) / 64 quote masks.
+   * @param delimiters Receives (size + 63) / 64 delimiter masks.
+   * @param newlines Receives (size + 63) / 64 newline masks.
+   * @param backend The instruction set to use; must be supported.
+   */
+  static void classify(const char* data, std::size_t size, char delimiter,
+                       uint64_t* quotes, uint64_t* delimiters,
+                       uint64_t* newlines, ScanBackend backend);
+
+  /**
+   * @brief Finds the complete records of a buffer and their fields.
+   *
+   * The buffer must start at the beginning of a record. Unless it is the
+   * last one, bytes after its last record separator are an incomplete record
+   * and should be carried over to the next buffer.
+   *
+   * @param data The buffer (at most 4 GiB).
+   * @param size The number of bytes.
+   * @param isLast Whether no more data follows the buffer.
+   * @param delimiter The field separator.
+   * @param out Receives the records and fields; cleared first.
+   * @return The number of bytes covered by the reported records.
+   */
+  static std::size_t scanRecords(const char* data, std::size_t size,
+                                 bool isLast, char delimiter,
+                                 ScannedRecords& out);
+
+  /**
+   * @brief Checks whether a field is enclosed in quotes.
+   * @param data The buffer the field points into.
+   * @param field The field.
+   * @return true if the field needs getFieldText to be read.
+   */
+  static bool isQuoted(const char* data, const TokenSpan& field);
+
+  /**
+   * @brief Retrieves the text of a field, without quotes and with each ""
+   * inside them turned into ".
+   * @param data The buffer the field points into.
+   * @param field The field.
+   * @return The field's value.
+   */
+  static std::string getFieldText(const char* data, const TokenSpan& field);
+};
+
+#endif  // CSVSCANNER_H
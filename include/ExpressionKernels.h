@@ -0,0 +1,79 @@
+/**
+ * @file ExpressionKernels.h
+ * @brief Declaration of the ExpressionKernels class.
+ *
+ * The ExpressionKernels class evaluates expression lines without the operand
+ * and operator stacks of processOperatorsWithPEMDAS. A line of up to
+ * MAX_OPERANDS operands has one of a few dozen shapes (its operand count and
+ * operator sequence). Every shape has its own function, generated from a
+ * template at compile time with the evaluation order worked out in advance,
+ * so evaluating a line is one table lookup and one indirect call into
+ * straight-line floating-point code.
+ *
+ * The kernels follow the stack machine exactly, in its precedence (from the
+ * Operators tables) and its rounding. Anything they do not
+ * cover, such as operands of different units or a division by zero, is left
+ * to the stack machine, which reports it.
+ *
+ * @version 0.1
+ */
+
+#ifndef EXPRESSIONKERNELS_H
+#define EXPRESSIONKERNELS_H
+
+#include <cstddef>
+#include <vector>
+#include "Measurement.h"
+
+/**
+ * @class ExpressionKernels
+ * @brief Utility class evaluating expression lines by shape.
+ */
+class ExpressionKernels {
+ public:
+  static const std::size_t MAX_OPERANDS = 4;  ///< Longest line with a kernel.
+  static const int SHAPE_COUNT = 85;  ///< Shapes of 1 to 4 operands.
+
+  /**
+   * @brief Evaluates one shape.
+   * @param magnitudes The magnitudes of the operands.
+   * @param factors The base factors of their units.
+   * @param result The result in the base unit (the magnitude itself for a
+   * single operand).
+   * @return false if a divisor was zero.
+   */
+  typedef bool (*Kernel)(const double* magnitudes, const double* factors,
+                         double& result);
+
+  /**
+   * @brief Computes the shape of a line: 1 + 4 + ... + 4^(n-2) for the
+   * shorter lines, plus the operators of its own as base-4 digits.
+   * @param operators The operators.
+   * @param operandCount The number of operands.
+   * @return The shape, or -1 if the line has no kernel (too long, or not one
+   * operator fewer than operands).
+   */
+  static int getShape(const std::vector<char>& operators,
+                      std::size_t operandCount);
+
+  /**
+   * @brief Retrieves the kernel of a shape.
+   * @param shape A shape from getShape.
+   * @return The kernel.
+   */
+  static Kernel getKernel(int shape);
+
+  /**
+   * @brief Evaluates a line the way processOperatorsWithPEMDAS does.
+   * @param measurements The operands.
+   * @param operators The operators.
+   * @param magnitude The result: in the base unit, or the magnitude of the
+   * only operand.
+   * @return false if the stack machine must evaluate the line: it has no
+   * kernel, its units differ, or it divides by zero.
+   */
+  static bool evaluate(const std::vector<Measurement>& measurements,
+                       const std::vector<char>& operators, double& magnitude);
+};
+
+#endif  // EXPRESSIONKERNELS_H
@@ -0,0 +1,43 @@
+/**
+ * @file FastFloat.h
+ * @brief Declaration of the FastFloat class.
+ *
+ * The FastFloat class converts decimal ASCII magnitudes such as "860.587"
+ * to double without going through a locale-aware stream. Eight digits at a
+ * time are folded into the mantissa with SWAR (SIMD within a register)
+ * arithmetic, and the decimal-to-binary step uses the Eisel-Lemire
+ * algorithm: one or two 64x128-bit products against a table of truncated
+ * powers of five, which gives the correctly rounded result for every input
+ * with at most 19 significant digits. Anything the algorithm cannot decide
+ * is handed to strtod.
+ *
+ * @version 0.1
+ */
+
+#ifndef FASTFLOAT_H
+#define FASTFLOAT_H
+
+/**
+ * @class FastFloat
+ * @brief Utility class for correctly rounded decimal to double conversion.
+ */
+class FastFloat {
+ public:
+  /**
+   * @brief Parses a decimal number: [+-]digits[.digits][(e|E)[+-]digits].
+   *
+   * Hexadecimal, "inf" and "nan" are not accepted, nor are results that
+   * overflow to infinity or fall below the smallest normal double. Rejecting
+   * subnormals is deliberate: such rare lines are sent to the processLine
+   * fallback rather than handled by this fast path.
+   *
+   * @param first The first character.
+   * @param last One past the last character that may be read.
+   * @param value The parsed number, correctly rounded to nearest-even.
+   * @return One past the last character of the number, or nullptr if no
+   * number in range starts at first.
+   */
+  static const char* parse(const char* first, const char* last, double& value);
+};
+
+#endif  // FASTFLOAT_H
@@ -0,0 +1,101 @@
+/**
+ * @file GorillaCodec.h
+ * @brief Declaration of the GorillaCodec class.
+ *
+ * The GorillaCodec class compresses numeric columns the way Facebook's
+ * Gorilla time-series store does. Floating-point values are XORed with their
+ * predecessor and only the bits that changed are written; integers are
+ * written as the difference between consecutive deltas. Consecutive readings
+ * of a sensor share sign, exponent and leading mantissa bits, and line
+ * numbers grow by one, so both collapse to a few bits per value.
+ *
+ * @version 0.1
+ */
+
+#ifndef GORILLACODEC_H
+#define GORILLACODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class GorillaCodec
+ * @brief Utility class for XOR and delta-of-delta column compression.
+ *
+ * XOR encoding of value v after p, with x = bits(v) ^ bits(p):
+ *  - '0' if x is zero (the value repeated);
+ *  - '10' + the meaningful bits of x, if they fit in the previous value's
+ *    window of leading and trailing zeros;
+ *  - '11' + leading-zero count + meaningful-bit count + the meaningful bits.
+ *
+ * Delta-of-delta encoding of d = (v - p) - (p - pp):
+ *  - '0' if d is zero; '10' + 7 bits, '110' + 9 bits or '1110' + 12 bits for
+ *    small d; '1111' + 64 bits otherwise.
+ *
+ * The first value (and for integers the first delta) is written raw. Encoded
+ * streams are appended to the output, so several columns can share a buffer;
+ * decoders need the value count, which the caller stores alongside.
+ */
+class GorillaCodec {
+ public:
+  /**
+   * @brief XOR-encodes a block of doubles.
+   * @param values The values to encode.
+   * @param count The number of values.
+   * @param out The buffer the encoded bytes are appended to.
+   */
+  static void encodeDoubles(const double* values, std::size_t count,
+                            std::vector<uint8_t>& out);
+
+  /**
+   * @brief Decodes a block written by encodeDoubles.
+   * @param data The encoded bytes.
+   * @param size The number of encoded bytes.
+   * @param count The number of values to decode.
+   * @param out The buffer receiving count values.
+   */
+  static void decodeDoubles(const uint8_t* data, std::size_t size,
+                            std::size_t count, double* out);
+
+  /**
+   * @brief XOR-encodes a block of floats.
+   * @param values The values to encode.
+   * @param count The number of values.
+   * @param out The buffer the encoded bytes are appended to.
+   */
+  static void encodeFloats(const float* values, std::size_t count,
+                           std::vector<uint8_t>& out);
+
+  /**
+   * @brief Decodes a block written by encodeFloats.
+   * @param data The encoded bytes.
+   * @param size The number of encoded bytes.
+   * @param count The number of values to decode.
+   * @param out The buffer receiving count values.
+   */
+  static void decodeFloats(const uint8_t* data, std::size_t size,
+                           std::size_t count, float* out);
+
+  /**
+   * @brief Delta-of-delta encodes a block of integers (line numbers,
+   * fixed-point magnitudes).
+   * @param values The values to encode.
+   * @param count The number of values.
+   * @param out The buffer the encoded bytes are appended to.
+   */
+  static void encodeIntegers(const int64_t* values, std::size_t count,
+                             std::vector<uint8_t>& out);
+
+  /**
+   * @brief Decodes a block written by encodeIntegers.
+   * @param data The encoded bytes.
+   * @param size The number of encoded bytes.
+   * @param count The number of values to decode.
+   * @param out The buffer receiving count values.
+   */
+  static void decodeIntegers(const uint8_t* data, std::size_t size,
+                             std::size_t count, int64_t* out);
+};
+
+#endif  // GORILLACODEC_H
@@ -0,0 +1,118 @@
+/**
+ * @file Histogram.h
+ * @brief Declaration of the Histogram class.
+ *
+ * The Histogram class records the distribution of a stream of magnitudes in a
+ * fixed amount of memory. Buckets are log-linear in the style of HDR
+ * histograms: every power of two is split into a fixed number of equal-width
+ * sub-buckets, so the relative width of a bucket (and with it the error of any
+ * percentile read back) is bounded across the whole trackable range.
+ *
+ * @version 0.1
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct HistogramBucket
+ * @brief A non-empty bucket of a Histogram, covering [lower, upper).
+ */
+struct HistogramBucket {
+  double lower;    ///< Inclusive lower bound of the bucket.
+  double upper;    ///< Exclusive upper bound of the bucket.
+  uint64_t count;  ///< Number of values recorded in the bucket.
+};
+
+/**
+ * @class Histogram
+ * @brief Fixed-memory log-linear histogram with O(1) updates.
+ *
+ * The bucket of a value is read straight from the exponent and the top
+ * mantissa bits of its IEEE-754 representation, so recording is a handful of
+ * integer operations. Magnitudes between 2^MIN_EXPONENT and 2^MAX_EXPONENT are
+ * tracked with a relative bucket width of at most 1/2^SUB_BUCKET_BITS; values
+ * outside that range are clamped into the first or last bucket. Negative
+ * values are tracked in a mirrored set of buckets.
+ *
+ * Two histograms are merged by adding their counts, so per-thread histograms
+ * can be combined without loss.
+ */
+class Histogram {
+ public:
+  static const int SUB_BUCKET_BITS = 5;  ///< 32 sub-buckets per power of two.
+  static const int MIN_EXPONENT = -48;   ///< Smallest tracked power of two.
+  static const int MAX_EXPONENT = 48;    ///< Largest tracked power of two.
+
+ private:
+  static const std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BUCKET_BITS;
+  static const std::size_t MAGNITUDE_BUCKETS =
+      (MAX_EXPONENT - MIN_EXPONENT) * SUB_BUCKETS;
+
+  std::vector<uint64_t> counts;  ///< Negatives, zero, then positives.
+  uint64_t totalCount;           ///< Number of values recorded.
+  double min;                    ///< Smallest value recorded.
+  double max;                    ///< Largest value recorded.
+
+  static std::size_t magnitudeIndex(double magnitude);
+  static double magnitudeLowerBound(std::size_t index);
+
+ public:
+  /**
+   * @brief Constructs an empty Histogram.
+   */
+  Histogram();
+
+  /**
+   * @brief Records a value. NaN values are ignored.
+   * @param value The value to record.
+   */
+  void record(double value);
+
+  /**
+   * @brief Adds the counts of another histogram to this one.
+   * @param other The histogram to merge in.
+   */
+  void merge(const Histogram& other);
+
+  /**
+   * @brief Retrieves the number of values recorded.
+   * @return The total count.
+   */
+  uint64_t getTotalCount() const;
+
+  /**
+   * @brief Retrieves the smallest value recorded.
+   * @return The exact minimum, or 0 if the histogram is empty.
+   */
+  double getMin() const;
+
+  /**
+   * @brief Retrieves the largest value recorded.
+   * @return The exact maximum, or 0 if the histogram is empty.
+   */
+  double getMax() const;
+
+  /**
+   * @brief Estimates the value at a percentile.
+   *
+   * Returns the midpoint of the bucket holding the requested rank, clamped to
+   * the exact minimum and maximum.
+   *
+   * @param percentile The percentile in [0, 100].
+   * @return The estimated value, or 0 if the histogram is empty.
+   */
+  double getValueAtPercentile(double percentile) const;
+
+  /**
+   * @brief Retrieves the non-empty buckets in ascending value order.
+   * @return The non-empty buckets.
+   */
+  std::vector<HistogramBucket> getBuckets() const;
+};
+
+#endif  // HISTOGRAM_H
@@ -0,0 +1,89 @@
+/**
+ * @file HyperLogLog.h
+ * @brief Declaration of the HyperLogLog class.
+ *
+ * The HyperLogLog class estimates the number of distinct values in a stream
+ * using a few kilobytes of memory, whatever the length of the stream. It is
+ * used to tell, while a file is being ingested, whether the results repeat
+ * often enough for an exact mode to mean anything.
+ *
+ * @version 0.1
+ */
+
+#ifndef HYPERLOGLOG_H
+#define HYPERLOGLOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class HyperLogLog
+ * @brief Approximate distinct counter (Flajolet et al.) over 64-bit hashes.
+ *
+ * The top `precision` bits of a value's hash select one of 2^precision
+ * registers, which keeps the longest run of leading zeros seen in the
+ * remaining bits. The standard error of the estimate is about
+ * 1.04 / sqrt(2^precision), i.e. 1.6% at the default precision of 12 (4 KiB of
+ * registers). Small cardinalities fall back to linear counting. Two sketches
+ * with the same precision merge by taking the register-wise maximum.
+ */
+class HyperLogLog {
+ private:
+  int precision;                   ///< Number of index bits.
+  std::vector<uint8_t> registers;  ///< One rank per register.
+
+ public:
+  /**
+   * @brief Constructs an empty HyperLogLog.
+   * @param precision Number of index bits, clamped to [4, 18].
+   */
+  explicit HyperLogLog(int precision = 12);
+
+  /**
+   * @brief Adds a pre-hashed value to the sketch.
+   * @param hash A well-mixed 64-bit hash of the value.
+   */
+  void addHash(uint64_t hash);
+
+  /**
+   * @brief Adds a magnitude to the sketch.
+   * @param value The value to add; 0.0 and -0.0 count as the same value.
+   */
+  void add(double value);
+
+  /**
+   * @brief Adds the registers of another sketch to this one.
+   * @param other The sketch to merge in.
+   * @throws std::invalid_argument if the precisions differ.
+   */
+  void merge(const HyperLogLog& other);
+
+  /**
+   * @brief Estimates the number of distinct values added.
+   * @return The cardinality estimate.
+   */
+  double estimate() const;
+
+  /**
+   * @brief Hashes the bit pattern of a double.
+   *
+   * The bits are run through the 64-bit MurmurHash3 finalizer. -0.0 is folded
+   * into 0.0 so that equal magnitudes hash equally.
+   *
+   * @param value The value to hash.
+   * @return The 64-bit hash.
+   */
+  static uint64_t hashDouble(double value);
+
+  /**
+   * @brief Hashes a string with 64-bit FNV-1a followed by the MurmurHash3
+   * finalizer.
+   * @param str The string to hash.
+   * @return The 64-bit hash.
+   */
+  static uint64_t hashString(const std::string& str);
+};
+
+#endif  // HYPERLOGLOG_H
@@ -0,0 +1,107 @@
+/**
+ * @file InputReader.h
+ * @brief Declaration of the InputReader class.
+ *
+ * The InputReader class hands the bytes of an input file to readFile one
+ * block at a time, from one of several backends:
+ *  - ifstream: std::ifstream reads into a single buffer (the default).
+ *  - mmap: the file is mapped and its pages are handed out in place.
+ *  - io_uring: several large reads are kept in flight through an io_uring
+ *    set up with raw system calls, which suits NFS mounts and other inputs
+ *    with high latency. Kernels without io_uring (or where it is disabled)
+ *    get the readahead backend instead.
+ *  - readahead: a background thread read()s the next blocks while the
+ *    current one is processed.
+ *
+ * Blocks are handed out by pointer, so the mapped and queued backends do not
+ * copy the data again; a line that straddles two blocks is joined by the
+ * caller. Readers can also be opened on a descriptor, so input can be
+ * streamed from standard input or a pipe without landing on disk first.
+ *
+ * @version 0.1
+ */
+
+#ifndef INPUTREADER_H
+#define INPUTREADER_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * @enum ReaderBackend
+ * @brief How an InputReader reads the file.
+ */
+enum class ReaderBackend {
+  IFSTREAM,  ///< std::ifstream into one buffer.
+  MMAP,      ///< Memory-mapped; regular files only.
+  IO_URING,  ///< Queued reads through io_uring.
+  READAHEAD  ///< A background thread reading ahead with read().
+};
+
+/**
+ * @class InputReader
+ * @brief Reads a file as a sequence of blocks.
+ */
+class InputReader {
+ public:
+  static const std::size_t DEFAULT_BLOCK_SIZE = 1 << 20;  ///< 1 MiB.
+  static const unsigned QUEUE_DEPTH = 4;  ///< Blocks read ahead (io_uring,
+                                          ///< readahead).
+
+  virtual ~InputReader();
+
+  /**
+   * @brief Makes the next block of the input available.
+   * @param data Receives the block; it stays valid until the next call.
+   * @return The number of bytes in the block, 0 at the end of the input.
+   * @throws std::runtime_error if a read fails.
+   */
+  virtual std::size_t next(const char*& data) = 0;
+
+  /**
+   * @brief Retrieves the backend doing the reads, which is READAHEAD when
+   * io_uring was requested but is not available.
+   * @return The backend.
+   */
+  virtual ReaderBackend getBackend() const = 0;
+
+  /**
+   * @brief Opens a file.
+   * @param path The file.
+   * @param backend How to read it.
+   * @param blockSize The size of each block (each window for mmap).
+   * @return The reader.
+   * @throws std::runtime_error if the file cannot be opened, or cannot be
+   * mapped with MMAP.
+   */
+  static std::unique_ptr<InputReader> open(
+      const std::string& path, ReaderBackend backend = ReaderBackend::IFSTREAM,
+      std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+  /**
+   * @brief Reads an open file descriptor, such as standard input or a pipe
+   * from a decompressor; the descriptor is left open.
+   *
+   * IFSTREAM cannot adopt a descriptor and reads ahead instead.
+   *
+   * @param fd The descriptor.
+   * @param backend How to read it.
+   * @param blockSize The size of each block (each window for mmap).
+   * @return The reader.
+   * @throws std::runtime_error if MMAP is requested for a descriptor that is
+   * not a regular file.
+   */
+  static std::unique_ptr<InputReader> open(
+      int fd, ReaderBackend backend = ReaderBackend::IFSTREAM,
+      std::size_t blockSize = DEFAULT_BLOCK_SIZE);
+
+  /**
+   * @brief Retrieves the name of a backend.
+   * @param backend The backend.
+   * @return "ifstream", "mmap", "io_uring" or "readahead".
+   */
+  static const char* getBackendName(ReaderBackend backend);
+};
+
+#endif  // INPUTREADER_H
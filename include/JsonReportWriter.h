@@ -0,0 +1,124 @@
+/**
+ * @file JsonReportWriter.h
+ * @brief Declaration of the JsonReportWriter class.
+ *
+ * The JsonReportWriter class streams the results of a ResultStore as JSON
+ * records, either one object per line (NDJSON) or as a single JSON array.
+ * Records are formatted straight from the store's columns into a reusable
+ * buffer that is flushed to the output stream when it fills up: there is no
+ * document tree, no std::string per record and no stream formatting per
+ * number. The unit and dimension fields are escaped once per dictionary
+ * entry, not once per record.
+ *
+ * @version 0.1
+ */
+
+#ifndef JSONREPORTWRITER_H
+#define JSONREPORTWRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ResultStore.h"
+
+/**
+ * @enum JsonFormat
+ * @brief Layout of the records written by a JsonReportWriter.
+ */
+enum class JsonFormat {
+  NDJSON,  ///< One object per line, no enclosing array.
+  ARRAY    ///< A single array of objects, one per line.
+};
+
+/**
+ * @class JsonReportWriter
+ * @brief Streams result records as JSON.
+ *
+ * Each record looks like
+ * {"line":12,"magnitude":860.587,"unit":"m","dimension":"Length",
+ * "status":"ok"}; the status is "outlier" for flagged results. Magnitudes
+ * are written in the base unit named by "unit", with the fewest digits (up
+ * to 17) that parse back to the same double; non-finite magnitudes are
+ * written as null.
+ */
+class JsonReportWriter {
+ private:
+  std::ostream& out;          ///< Where full buffers are written.
+  JsonFormat format;          ///< NDJSON or ARRAY.
+  std::vector<char> buffer;   ///< Formatted records not yet written.
+  std::size_t used;           ///< Bytes of buffer in use.
+  std::size_t recordCount;    ///< Records written so far.
+  bool isFinished;            ///< Whether finish has been called.
+  std::vector<std::string> unitFields;  ///< Escaped unit and dimension
+                                        ///< fields, per unit ID.
+
+  /**
+   * @brief Writes the buffer to the stream and empties it.
+   */
+  void flush();
+
+ public:
+  static const std::size_t BUFFER_SIZE = 64 * 1024;  ///< Flush threshold.
+  static const std::size_t MAX_NUMBER_LENGTH = 32;   ///< formatNumber bound.
+
+  /**
+   * @brief Constructs a writer; nothing is written until the first record.
+   * @param out The stream to write to.
+   * @param format The layout of the records.
+   */
+  JsonReportWriter(std::ostream& out, JsonFormat format = JsonFormat::NDJSON);
+
+  /**
+   * @brief Finishes the output if finish has not been called.
+   */
+  ~JsonReportWriter();
+
+  /**
+   * @brief Writes the records of a range of rows.
+   * @param results The result store.
+   * @param first The first row to write.
+   * @param last One past the last row to write; clamped to the store size.
+   */
+  void write(const ResultStore& results, std::size_t first = 0,
+             std::size_t last = static_cast<std::size_t>(-1));
+
+  /**
+   * @brief Closes the array (under ARRAY) and flushes the buffer.
+   *
+   * No records may be written afterwards.
+   */
+  void finish();
+
+  /**
+   * @brief Retrieves the number of records written.
+   * @return The record count.
+   */
+  std::size_t getRecordCount() const;
+
+  /**
+   * @brief Formats a double as a JSON number.
+   * @param value The number.
+   * @param out Receives at most MAX_NUMBER_LENGTH characters, unterminated.
+   * @return One past the last character written.
+   */
+  static char* formatNumber(double value, char* out);
+
+  /**
+   * @brief Formats an integer in decimal.
+   * @param value The integer.
+   * @param out Receives at most 20 characters, unterminated.
+   * @return One past the last character written.
+   */
+  static char* formatInteger(int64_t value, char* out);
+
+  /**
+   * @brief Escapes a string as a JSON string literal, quotes included.
+   * @param text The string.
+   * @return The literal.
+   */
+  static std::string escapeString(const std::string& text);
+};
+
+#endif  // JSONREPORTWRITER_H
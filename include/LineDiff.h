@@ -0,0 +1,126 @@
+/**
+ * @file LineDiff.h
+ * @brief Declaration of the LineDiff class.
+ *
+ * The two input files follow the same schedule a year apart, so line N of
+ * one and line N of the other measure the same thing. The LineDiff class
+ * joins their results by line number and reports the lines whose change
+ * exceeds a threshold. Both files are read in lockstep, a batch of lines at
+ * a time (MeasurementFileProcessor::readNextLines), so memory stays bounded
+ * by one batch whatever the size of the files. Each batch's paired
+ * magnitudes are converted to base units into contiguous columns, and the
+ * delta, ratio, percent change and threshold test run as branch-free loops
+ * over them.
+ *
+ * @version 0.1
+ */
+
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "MeasurementFileProcessor.h"
+
+/**
+ * @enum DiffMetric
+ * @brief Which change is compared to the threshold.
+ */
+enum class DiffMetric {
+  DELTA,   ///< |year2 - year1|, in base units.
+  RATIO,   ///< year2 / year1, or its inverse, whichever is larger.
+  PERCENT  ///< |year2 - year1| / |year1| * 100.
+};
+
+/**
+ * @struct LineDiffStatistics
+ * @brief What a LineDiff run compared.
+ */
+struct LineDiffStatistics {
+  std::size_t lines;       ///< Lines read from the longer file.
+  std::size_t paired;      ///< Lines with a result of one dimension in both.
+  std::size_t unpaired;    ///< Lines with a result in one file only.
+  std::size_t mismatched;  ///< Lines whose results differ in dimension.
+  std::size_t reported;    ///< Paired lines past the threshold.
+
+  /**
+   * @brief Constructs empty statistics.
+   */
+  LineDiffStatistics();
+};
+
+/**
+ * @class LineDiff
+ * @brief Line-by-line comparison of two files.
+ */
+class LineDiff {
+ private:
+  MeasurementFileProcessor& year1;  ///< Reads the first file.
+  MeasurementFileProcessor& year2;  ///< Reads the second file.
+  DiffMetric metric;                ///< The change tested.
+  double threshold;                 ///< Lines past it are reported.
+  std::size_t batchLines;           ///< Lines read from each file at once.
+  LineDiffStatistics statistics;    ///< Counts of the last run.
+
+ public:
+  static const std::size_t DEFAULT_BATCH_LINES = 4096;  ///< Per file.
+
+  /**
+   * @brief Constructs a comparison of two files.
+   * @param year1 The processor of the first file, not yet read.
+   * @param year2 The processor of the second file, not yet read.
+   * @param metric The change tested.
+   * @param threshold Lines whose change is greater are reported.
+   * @param batchLines The lines read from each file at once.
+   */
+  LineDiff(MeasurementFileProcessor& year1, MeasurementFileProcessor& year2,
+           DiffMetric metric, double threshold,
+           std::size_t batchLines = DEFAULT_BATCH_LINES);
+
+  /**
+   * @brief Reads both files to the end and writes the reported lines as
+   * CSV records (Line,Dimension,Unit,Year1,Year2,Delta,Ratio,PercentChange,
+   * with a header), magnitudes in base units.
+   * @param out The stream to write to.
+   * @return The statistics of the run.
+   * @throws std::runtime_error if either file cannot be read.
+   */
+  const LineDiffStatistics& run(std::ostream& out);
+
+  /**
+   * @brief Computes the change of aligned base magnitudes and tests it.
+   *
+   * Division by a zero year1 magnitude follows IEEE 754 (an infinite or NaN
+   * ratio and percent change); NaN never passes the threshold.
+   *
+   * @param year1 The first year's magnitudes.
+   * @param year2 The second year's magnitudes.
+   * @param count The number of pairs.
+   * @param metric The change tested.
+   * @param threshold The change a pair must exceed.
+   * @param delta Receives year2 - year1.
+   * @param ratio Receives year2 / year1.
+   * @param percent Receives (year2 - year1) / |year1| * 100.
+   * @param isReported Receives 1 for each pair past the threshold, else 0.
+   * @return The number of pairs past the threshold.
+   */
+  static std::size_t compare(const double* year1, const double* year2,
+                             std::size_t count, DiffMetric metric,
+                             double threshold, double* delta, double* ratio,
+                             double* percent, uint8_t* isReported);
+
+  /**
+   * @brief Parses a METRIC:THRESHOLD specification, e.g. "percent:10".
+   * @param spec The specification; METRIC is delta, ratio or percent.
+   * @param metric Receives the metric.
+   * @param threshold Receives the threshold.
+   * @return true if the specification was valid, false otherwise.
+   */
+  static bool parseSpec(const std::string& spec, DiffMetric& metric,
+                        double& threshold);
+};
+
+#endif  // LINEDIFF_H
@@ -0,0 +1,218 @@
+/**
+ * @file LineIndex.h
+ * @brief Declaration of the LineIndex and IndexedFile classes.
+ *
+ * The LineIndex class records where every line of an input file starts so
+ * that any line can be read back without scanning the file. Offsets are
+ * sampled every N lines into a coarse table of absolute 64-bit offsets; the
+ * lines inside each block are stored as deltas from the block start, in the
+ * narrowest of 1, 2 or 4 bytes that fits the block. Finding a line is two
+ * array lookups, and the index costs about 2 bytes per line instead of 8.
+ *
+ * The index is saved as a sidecar file next to the input (<file>.lidx),
+ * together with the size of the file it describes and the lines that failed
+ * to parse, so a later run can reprocess just those lines or split the file
+ * into ranges of exactly equal line counts.
+ *
+ * @version 0.1
+ */
+
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class LineIndex
+ * @brief Sampled, delta-encoded index of line start offsets.
+ *
+ * Lines are numbered from 1, as in the reports.
+ */
+class LineIndex {
+ private:
+  /**
+   * @struct IndexBlock
+   * @brief A coarse entry: where a block of lines starts.
+   */
+  struct IndexBlock {
+    uint64_t offset;      ///< File offset of the block's first line.
+    uint32_t fineOffset;  ///< Where the block's deltas start in fine.
+    uint8_t width;        ///< Bytes per delta: 1, 2, 4 (or 8 past 4 GiB).
+  };
+
+  uint32_t interval;               ///< Lines per block.
+  std::size_t lineCount;           ///< Lines added.
+  uint64_t fileSize;               ///< Size of the indexed file.
+  std::vector<IndexBlock> blocks;  ///< One entry per interval lines.
+  std::vector<uint8_t> fine;       ///< Per-line deltas inside each block.
+  std::vector<uint64_t> pending;   ///< Offsets of the unfinished block.
+  std::vector<int64_t> failedLines;  ///< Lines that did not parse cleanly.
+
+  /**
+   * @brief Encodes the pending offsets as a block.
+   */
+  void flushBlock();
+
+ public:
+  static const uint32_t DEFAULT_INTERVAL = 64;  ///< Default lines per block.
+
+  /**
+   * @brief Constructs an empty index.
+   * @param interval Lines per coarse sample.
+   * @throws std::invalid_argument if interval is 0.
+   */
+  explicit LineIndex(uint32_t interval = DEFAULT_INTERVAL);
+
+  /**
+   * @brief Records the start of the next line.
+   * @param offset File offset of the line's first byte; offsets must be
+   * added in increasing order.
+   */
+  void addLine(uint64_t offset);
+
+  /**
+   * @brief Completes the index once every line has been added.
+   * @param size The size of the indexed file.
+   */
+  void finish(uint64_t size);
+
+  /**
+   * @brief Records a line that did not parse cleanly.
+   * @param line The line number.
+   */
+  void addFailedLine(int64_t line);
+
+  /**
+   * @brief Retrieves the number of indexed lines.
+   * @return The line count.
+   */
+  std::size_t getLineCount() const;
+
+  /**
+   * @brief Retrieves the size of the indexed file.
+   * @return The size in bytes.
+   */
+  uint64_t getFileSize() const;
+
+  /**
+   * @brief Retrieves the number of lines per coarse sample.
+   * @return The interval.
+   */
+  uint32_t getInterval() const;
+
+  /**
+   * @brief Retrieves the lines that did not parse cleanly.
+   * @return The failed line numbers, in file order.
+   */
+  const std::vector<int64_t>& getFailedLines() const;
+
+  /**
+   * @brief Retrieves where a line starts.
+   * @param line The line number, in [1, getLineCount()].
+   * @return The file offset of its first byte.
+   * @throws std::out_of_range if there is no such line.
+   */
+  uint64_t getLineOffset(std::size_t line) const;
+
+  /**
+   * @brief Retrieves where a line ends.
+   * @param line The line number, in [1, getLineCount()].
+   * @return The offset of the next line, or the file size for the last one
+   * (so the span includes the line's '\\n').
+   * @throws std::out_of_range if there is no such line.
+   */
+  uint64_t getLineEnd(std::size_t line) const;
+
+  /**
+   * @brief Splits the lines into ranges of equal line counts.
+   * @param parts The number of ranges.
+   * @return Up to parts [first, last] line ranges covering every line; the
+   * first lineCount % parts ranges have one extra line.
+   */
+  std::vector<std::pair<std::size_t, std::size_t>> split(
+      std::size_t parts) const;
+
+  /**
+   * @brief Computes the memory held by the index.
+   * @return The number of bytes of coarse and fine entries.
+   */
+  std::size_t memoryUsage() const;
+
+  /**
+   * @brief Saves the index as a sidecar file.
+   * @param path The file to write.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  void save(const std::string& path) const;
+
+  /**
+   * @brief Loads an index saved by save.
+   * @param path The file to read.
+   * @return The index.
+   * @throws std::runtime_error if the file cannot be read or is not an index.
+   */
+  static LineIndex load(const std::string& path);
+
+  /**
+   * @brief Retrieves the sidecar path of an input file.
+   * @param fileName The input file.
+   * @return fileName + ".lidx".
+   */
+  static std::string getSidecarPath(const std::string& fileName);
+};
+
+/**
+ * @class IndexedFile
+ * @brief Reads single lines of a file with pread, using a LineIndex.
+ */
+class IndexedFile {
+ private:
+  int fd;            ///< The open file.
+  LineIndex index;   ///< Where its lines start.
+
+ public:
+  /**
+   * @brief Opens a file for random line access.
+   * @param path The file.
+   * @param index The index of the file.
+   * @throws std::runtime_error if the file cannot be opened or its size does
+   * not match the index.
+   */
+  IndexedFile(const std::string& path, const LineIndex& index);
+
+  ~IndexedFile();
+
+  IndexedFile(const IndexedFile&) = delete;
+  IndexedFile& operator=(const IndexedFile&) = delete;
+
+  /**
+   * @brief Retrieves the index.
+   * @return The line index.
+   */
+  const LineIndex& getIndex() const;
+
+  /**
+   * @brief Reads one line, without its '\\n'.
+   * @param line The line number.
+   * @param text Receives the line; its capacity is reused.
+   * @throws std::out_of_range if there is no such line.
+   * @throws std::runtime_error if the read fails.
+   */
+  void readLine(std::size_t line, std::string& text) const;
+
+  /**
+   * @brief Reads a range of lines with a single pread.
+   * @param first The first line number.
+   * @param last The last line number (inclusive).
+   * @param text Receives the lines, '\\n' separators included.
+   * @throws std::out_of_range if a line of the range does not exist.
+   * @throws std::runtime_error if the read fails.
+   */
+  void readLines(std::size_t first, std::size_t last, std::string& text) const;
+};
+
+#endif  // LINEINDEX_H
@@ -17,6 +17,8 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <stack>
@@ -24,9 +26,21 @@
 #include <string>
 #include <vector>
 #include <optional>
+#include "CsvScanner.h"
+#include "ExpressionKernels.h"
+#include "FixedPoint.h"
+#include "Histogram.h"
+#include "HyperLogLog.h"
+#include "InputReader.h"
+#include "LineIndex.h"
 #include "Measurement.h"
+#include "OutlierDetector.h"
 #include "ReportGenerator.h"
+#include "ReportUnits.h"
+#include "ResultStore.h"
+#include "Selection.h"
 #include "StatisticsCalculator.h"
+#include "TextScanner.h"
 
 /**
  * @class MeasurementFileProcessor
@@ -39,17 +53,189 @@
  */
 class MeasurementFileProcessor {
  private:
+  /**
+   * @brief The per-dimension state a kept result updates, resolved once per
+   * result unit ID. Null members are disabled; a value-initialized slot is
+   * unresolved.
+   */
+  struct DimensionSlot {
+    bool isResolved;               ///< Whether the pointers are set.
+    Histogram* histogram;          ///< Entry of histograms.
+    HyperLogLog* distinct;         ///< Entry of distinctMagnitudes.
+    FixedPointColumn* fixedPoint;  ///< Entry of fixedPointColumns.
+  };
+
   std::string fileName;  ///< The name of the file containing measurement data.
-  std::vector< std::vector<Measurement> >measurementsList;  ///< A list of measurements loaded from the file.
+  ResultStore results;   ///< The results loaded from the file.
   bool isFileLoaded;     ///< Flag to check if the file has been successfully
                          ///< loaded.
   bool isValidOperator(
       const std::string& op);  ///> Checks if the operator is valid.
+  OutlierPolicy outlierPolicy;  ///< What to do with outlying results.
+  std::map<std::string, OutlierDetector>
+      outlierDetectors;         ///< One detector per unit type (dimension).
+  std::vector<int> outlierLines;  ///< Line numbers of flagged results.
+  std::map<std::string, Histogram>
+      histograms;  ///< Distribution of the kept results, per unit type.
+  std::map<std::string, HyperLogLog>
+      distinctMagnitudes;  ///< Distinct kept results, per unit type.
+  std::map<std::string, HyperLogLog>
+      distinctUnits;  ///< Distinct input units, per unit type.
+  bool isHistogramEnabled;      ///< Whether histograms are filled.
+  bool isDistinctCountEnabled;  ///< Whether the distinct sketches are filled.
+  std::vector<DimensionSlot>
+      dimensionSlots;  ///< Per result unit ID, its dimension's state.
+  bool isFixedPointEnabled;  ///< Whether scaled-integer columns are kept.
+  int defaultFixedPointPlaces;  ///< Decimal places for unlisted dimensions.
+  std::map<std::string, int>
+      fixedPointPlaces;  ///< Decimal places per unit type.
+  std::map<std::string, FixedPointColumn>
+      fixedPointColumns;  ///< Scaled-integer results, per unit type.
+  bool isCsvInput;         ///< Whether the file is CSV rather than expressions.
+  CsvOptions csvOptions;   ///< Column mapping of CSV input.
+  bool isLineIndexEnabled;  ///< Whether readFile saves a line index.
+  LineIndex lineIndex;      ///< Line start offsets found by readFile.
+  std::vector<int64_t> failedLines;  ///< Lines processLine reported errors on.
+  ScannedLines scannedLines;  ///< Scratch: lines and tokens of a buffer.
+  std::vector<Measurement> lineMeasurements;  ///< Scratch: a line's operands.
+  std::vector<char> lineOperators;            ///< Scratch: a line's operators.
+  ReaderBackend readerBackend;  ///< How readFile reads the file.
+  std::size_t readerBlockSize;  ///< Bytes per block read.
+  int inputFd;                  ///< Descriptor to read instead, -1 if none.
+  bool isExpressionKernelEnabled;  ///< Whether lines are evaluated by
+                                   ///< ExpressionKernels.
+  ReportUnits reportUnits;  ///< The units reports render each dimension in.
+  bool isLoggingEnabled;    ///< Whether evaluation progress is printed.
+  bool isAdaptiveModeEnabled;  ///< Whether computeStatistics may bin the mode.
+  std::unique_ptr<InputReader> streamReader;  ///< Open reader of
+                                              ///< readNextLines, if any.
+  std::vector<char> streamPending;  ///< Bytes read but not yet evaluated.
+  ScannedLines streamScanned;       ///< Lines and tokens of streamPending.
+  std::size_t streamScannedBytes;   ///< Bytes covered by streamScanned.
+  std::size_t streamNextLine;       ///< Next line of streamScanned.
+  int streamLineNum;                ///< Number of the next line to stream.
+  bool isStreamEnded;               ///< Whether the reader is exhausted.
+
+  /**
+   * @brief Opens the input: the descriptor, standard input for "-", or the
+   * named file.
+   * @return The reader.
+   * @throws std::runtime_error if the file cannot be opened.
+   */
+  std::unique_ptr<InputReader> openInput();
+
+  /**
+   * @brief Looks up, and on first use resolves, the per-dimension state of
+   * a result unit ID, so kept results skip the map lookups by type name.
+   * @param unitId The unit ID the result store gave the result.
+   * @return The slot of the unit's dimension.
+   */
+  DimensionSlot& dimensionSlot(uint8_t unitId);
+
+  /**
+   * @brief Evaluates a line directly into a scaled integer.
+   *
+   * Lines made only of additions and subtractions are evaluated from the
+   * digits of their tokens, so the result is exact. Anything else (products,
+   * quotients, lines that do not tokenize cleanly) is rounded from the double
+   * result of the reference evaluator.
+   *
+   * @param data The buffer the spans point into.
+   * @param tokens The line's tokens, as found by the scanner.
+   * @param count The number of tokens.
+   * @param result The result of the reference evaluator for the line.
+   * @param places The number of decimal places to keep.
+   * @param out The scaled result.
+   * @return The conversion status.
+   */
+  FixedPointStatus evaluateFixedPoint(const char* data,
+                                      const TokenSpan* tokens,
+                                      std::size_t count,
+                                      const Measurement& result, int places,
+                                      int64_t& out);
+
+  /**
+   * @brief Parses a line from the token spans found by the TextScanner.
+   *
+   * Only lines of the form "magnitude unit (operator magnitude unit)*" with
+   * plain decimal magnitudes, known units and single-character operators
+   * are accepted; they parse exactly as processLine would parse them.
+   *
+   * @param data The buffer the spans point into, NUL-terminated.
+   * @param tokens The line's tokens.
+   * @param count The number of tokens.
+   * @param measurements The vector to store the Measurement objects.
+   * @param operators The vector to store the arithmetic operators.
+   * @return false if the line needs processLine.
+   */
+  bool processTokens(const char* data, const TokenSpan* tokens,
+                     std::size_t count, std::vector<Measurement>& measurements,
+                     std::vector<char>& operators);
+
+  /**
+   * @brief Reads a CSV file, one measurement per record.
+   *
+   * Records are split by the CsvScanner and each one is evaluated as the
+   * single-operand expression "magnitude unit", so it is reported exactly
+   * like an expression line would be. Line numbers count records, the
+   * header included.
+   *
+   * @throws std::runtime_error if the file cannot be opened or a column
+   * named in the options is missing from the header.
+   * @throws std::runtime_error if a record cannot be evaluated.
+   */
+  void readCsvFile();
+
+  /**
+   * @brief Evaluates the complete lines of a buffer.
+   * @param data The buffer.
+   * @param size The number of bytes in the buffer.
+   * @param isLast Whether the buffer ends the input, so a final line without
+   * '\\n' is complete.
+   * @param offset The file offset of data[0], recorded in the line index.
+   * @param lineNum The number of the first line; advanced past every line.
+   * @return The number of bytes consumed (up to the last complete line).
+   * @throws std::runtime_error if a line cannot be evaluated.
+   */
+  std::size_t processBuffer(const char* data, std::size_t size, bool isLast,
+                            uint64_t offset, int& lineNum);
+
+  /**
+   * @brief Evaluates lines [first, last) of a scanned buffer.
+   * @param data The buffer.
+   * @param scanned The buffer's lines and tokens.
+   * @param first The first line to evaluate.
+   * @param last One past the last line to evaluate.
+   * @param offset The file offset of data[0], recorded in the line index.
+   * @param lineNum The number of line first; advanced past every line.
+   * @throws std::runtime_error if a line cannot be evaluated.
+   */
+  void processScannedLines(const char* data, const ScannedLines& scanned,
+                           std::size_t first, std::size_t last,
+                           uint64_t offset, int& lineNum);
+
+  /**
+   * @brief Evaluates a parsed line and records its result.
+   * @param data The buffer the spans point into.
+   * @param tokens The line's tokens, as found by the scanner.
+   * @param tokenCount The number of tokens.
+   * @param currentLine The line number in the file.
+   * @param measurements The operands of the line.
+   * @param operators The operators of the line.
+   * @throws std::runtime_error if the line cannot be evaluated.
+   */
+  void processMeasurements(const char* data, const TokenSpan* tokens,
+                           std::size_t tokenCount, int currentLine,
+                           const std::vector<Measurement>& measurements,
+                           const std::vector<char>& operators);
 
  public:
+  static const char STDIN_NAME[];  ///< The file name read from stdin: "-".
+
   /**
    * @brief Constructs a MeasurementFileProcessor with the specified file name.
-   * @param fileName The name of the file to be processed.
+   * @param fileName The name of the file to be processed, or "-" for
+   * standard input.
    */
   MeasurementFileProcessor(const std::string& fileName);
 
@@ -105,6 +291,59 @@ class MeasurementFileProcessor {
       const std::vector<Measurement>& measurements,
       const std::vector<char>& operators);
 
+  /**
+   * @brief Enables or disables the ExpressionKernels in
+   * processOperatorsWithPEMDAS (enabled by default).
+   *
+   * Lines a kernel covers skip the operand and operator stacks; the rest,
+   * and every line while disabled, go through the stack machine.
+   *
+   * @param isEnabled Whether to use the kernels.
+   */
+  void enableExpressionKernels(bool isEnabled = true);
+
+  /**
+   * @brief Enables or disables the per-line progress printed to standard
+   * output while lines are evaluated (enabled by default). Errors are
+   * always reported.
+   *
+   * @param isEnabled Whether to print the progress.
+   */
+  void enableLogging(bool isEnabled = true);
+
+  /**
+   * @brief Enables or disables the per-dimension histograms of
+   * getHistograms (disabled by default). Must be called before readFile.
+   *
+   * @param isEnabled Whether to fill the histograms.
+   */
+  void enableHistograms(bool isEnabled = true);
+
+  /**
+   * @brief Enables or disables the distinct-count sketches of
+   * getDistinctMagnitudes and getDistinctUnits (disabled by default). Must
+   * be called before readFile.
+   *
+   * The histograms are filled too, since they hold the result counts the
+   * estimates are reported against.
+   *
+   * @param isEnabled Whether to fill the sketches.
+   */
+  void enableDistinctCounts(bool isEnabled = true);
+
+  /**
+   * @brief Enables or disables the binned mode in computeStatistics
+   * (disabled by default, which reports the exact mode).
+   *
+   * While enabled, mostly distinct results report the midpoint of their
+   * fullest histogram bucket (see StatisticsCalculator::chooseModeStrategy),
+   * so the histograms and the magnitude sketches are filled. Must be called
+   * before readFile.
+   *
+   * @param isEnabled Whether the mode may be binned.
+   */
+  void enableAdaptiveMode(bool isEnabled = true);
+
     /**
      * @brief Processes a line of input data from the file.
      * @param line The line of input data to process.
@@ -118,8 +357,12 @@ class MeasurementFileProcessor {
                           std::stack<char>& operatorStack);
 
   /**
-   * @brief Reads the measurement data from the file and stores it in a
-   * measurementLine vector in the measurementsList vector.
+   * @brief Reads the measurement data from the file and stores the result of
+   * each line in the result store.
+   *
+   * The file is read in large blocks by an InputReader and split into lines
+   * and tokens by the TextScanner, in place. Lines the token fast path cannot
+   * parse go through processLine.
    * @return void
    * @throws std::runtime_error if the file cannot be opened or read properly.
    * @throws std::runtime_error if the arithmetic operation fails.
@@ -137,6 +380,224 @@ class MeasurementFileProcessor {
                      std::vector<Measurement>& measurements,
                      std::vector<char>& operators);
 
+  /**
+   * @brief Evaluates the next lines of the file into the result store,
+   * replacing the lines of the previous call.
+   *
+   * Successive calls walk the file in order, so two files can be read in
+   * lockstep with memory bounded by a block of input and a batch of
+   * results. Reports and statistics then cover the current batch only.
+   * The first call opens the file; readFile must not be mixed in.
+   *
+   * @param maxLines The most lines to evaluate.
+   * @return The number of lines evaluated, with or without a result; fewer
+   * than maxLines only at the end of the file.
+   * @throws std::runtime_error if the file cannot be read, or a line cannot
+   * be evaluated.
+   */
+  std::size_t readNextLines(std::size_t maxLines);
+
+  /**
+   * @brief Parses one line the way readFile does: the line is tokenized by
+   * the TextScanner and parsed by the token fast path, with processLine as
+   * the fallback.
+   *
+   * Parsing a line with processLine alone gives the reference result, so the
+   * two can be compared line by line.
+   *
+   * @param line The line, without its newline.
+   * @param lineNum The line number reported by processLine.
+   * @param measurements The vector to store the Measurement objects.
+   * @param operators The vector to store the arithmetic operators.
+   * @return true if the token fast path parsed the line.
+   */
+  bool parseLine(const std::string& line, int lineNum,
+                 std::vector<Measurement>& measurements,
+                 std::vector<char>& operators);
+
+  /**
+   * @brief Makes readFile read CSV records instead of expression lines.
+   *
+   * The default options read the Magnitude,Unit output of
+   * ReportGenerator::generateCSVReport back in. Must be called before
+   * readFile.
+   *
+   * @param options The delimiter, header and column mapping.
+   */
+  void setCsvInput(const CsvOptions& options = CsvOptions());
+
+  /**
+   * @brief Selects how readFile reads the file.
+   *
+   * Must be called before readFile.
+   *
+   * @param backend The reader backend (ifstream by default).
+   * @param blockSize The number of bytes per block.
+   */
+  void setReaderBackend(
+      ReaderBackend backend,
+      std::size_t blockSize = InputReader::DEFAULT_BLOCK_SIZE);
+
+  /**
+   * @brief Makes readFile read an open descriptor instead of the file.
+   *
+   * The input is streamed block by block, e.g. from a pipe out of a
+   * decompressor, so it never has to be written to disk. The file name is
+   * still used in reports. The descriptor is not closed.
+   *
+   * @param fd The descriptor.
+   */
+  void setInputDescriptor(int fd);
+
+  /**
+   * @brief Makes readFile save a line index next to the file.
+   *
+   * The index (<file>.lidx) records where every line starts and which lines
+   * failed, so readLines can later re-evaluate any subset of lines without
+   * scanning the file. While indexing, a line that cannot be evaluated is
+   * reported, recorded as failed and skipped rather than ending readFile, so
+   * the index is always saved. Not used for CSV input. Must be called before
+   * readFile.
+   *
+   * @param interval Lines per coarse sample of the index.
+   * @throws std::invalid_argument if interval is 0.
+   * @note readFile throws std::runtime_error if the input is a descriptor.
+   */
+  void enableLineIndex(uint32_t interval = LineIndex::DEFAULT_INTERVAL);
+
+  /**
+   * @brief Retrieves the line index built by readFile.
+   * @return The index; empty unless enableLineIndex was called.
+   */
+  const LineIndex& getLineIndex() const;
+
+  /**
+   * @brief Retrieves the lines processLine reported errors on, and while
+   * indexing the lines that could not be evaluated.
+   * @return The line numbers in file order.
+   */
+  const std::vector<int64_t>& getFailedLines() const;
+
+  /**
+   * @brief Evaluates only some lines of the file, using its saved line index.
+   *
+   * Each run of consecutive lines is fetched with a single pread and
+   * evaluated as readFile would, keeping its original line numbers, e.g. to
+   * re-evaluate the failed lines of an earlier run or one of the ranges of
+   * LineIndex::split.
+   *
+   * @param lines The line numbers, in increasing order.
+   * @throws std::runtime_error if the index is missing or does not match the
+   * file, or the input is CSV.
+   * @throws std::out_of_range if a line is not in the file.
+   * @throws std::runtime_error if a line cannot be evaluated.
+   */
+  void readLines(const std::vector<int64_t>& lines);
+
+  /**
+   * @brief Sets what readFile does with results flagged as outliers.
+   *
+   * Detection runs per dimension while the file is read, so it must be
+   * configured before readFile is called.
+   *
+   * @param policy The outlier policy to apply.
+   */
+  void setOutlierPolicy(OutlierPolicy policy);
+
+  /**
+   * @brief Retrieves the outlier detectors, keyed by unit type.
+   * @return The per-dimension detectors holding raw and clean statistics.
+   */
+  const std::map<std::string, OutlierDetector>& getOutlierDetectors() const;
+
+  /**
+   * @brief Retrieves the line numbers of the results flagged as outliers.
+   * @return The flagged line numbers in file order.
+   */
+  const std::vector<int>& getOutlierLines() const;
+
+  /**
+   * @brief Retrieves the distribution of the results, keyed by unit type.
+   *
+   * The histograms are filled while readFile ingests the file, so no second
+   * pass over the results is needed. Magnitudes are recorded in the base
+   * unit of their dimension; results excluded as outliers are not recorded.
+   *
+   * @return The per-dimension histograms; empty unless enableHistograms,
+   * enableDistinctCounts or enableAdaptiveMode was called.
+   */
+  const std::map<std::string, Histogram>& getHistograms() const;
+
+  /**
+   * @brief Retrieves the distinct-count sketches of the results, keyed by
+   * unit type.
+   * @return The per-dimension sketches of the kept result magnitudes, in
+   * the base unit of their dimension; empty unless enableDistinctCounts or
+   * enableAdaptiveMode was called.
+   */
+  const std::map<std::string, HyperLogLog>& getDistinctMagnitudes() const;
+
+  /**
+   * @brief Retrieves the distinct-count sketches of the input units, keyed by
+   * unit type.
+   *
+   * Every operand of every line contributes its unit, so this counts the
+   * units used in the file (e.g. mm, m and km are three Length units).
+   *
+   * @return The per-dimension sketches of the input units; empty unless
+   * enableDistinctCounts was called.
+   */
+  const std::map<std::string, HyperLogLog>& getDistinctUnits() const;
+
+  /**
+   * @brief Enables exact scaled-integer magnitudes alongside the doubles.
+   *
+   * Each kept result is also stored as a 64-bit integer scaled by 10^places
+   * of its dimension. Must be called before readFile.
+   *
+   * @param defaultPlaces Decimal places for dimensions not listed in places.
+   * @param places Decimal places per unit type (e.g. {"Length", 3}).
+   * @throws std::invalid_argument if a number of places is not in
+   * [0, FixedPoint::MAX_PLACES].
+   */
+  void enableFixedPoint(int defaultPlaces,
+                        const std::map<std::string, int>& places =
+                            std::map<std::string, int>());
+
+  /**
+   * @brief Retrieves the scaled-integer results, keyed by unit type.
+   * @return The per-dimension fixed-point columns; empty unless
+   * enableFixedPoint was called.
+   */
+  const std::map<std::string, FixedPointColumn>& getFixedPointColumns() const;
+
+  /**
+   * @brief Sets how the result store keeps magnitudes.
+   *
+   * FLOAT32 halves the memory and bandwidth of the magnitude column at the
+   * cost of precision beyond about 7 significant digits; the loss is tracked
+   * in ResultStore::getPrecisionLoss. Must be called before readFile.
+   *
+   * @param policy The storage policy.
+   */
+  void setStoragePolicy(StoragePolicy policy);
+
+  /**
+   * @brief Sets the units the generated reports render each dimension in.
+   *
+   * Only the report lines change; the stored results, statistics and
+   * exports keep their own units.
+   *
+   * @param units The target units; empty to keep the stored units.
+   */
+  void setReportUnits(const ReportUnits& units);
+
+  /**
+   * @brief Retrieves the results loaded from the file.
+   * @return The result store.
+   */
+  const ResultStore& getResults() const;
+
   /**
    * @brief Sorts the loaded measurements in ascending order.
    */
@@ -155,15 +616,32 @@ class MeasurementFileProcessor {
    */
   std::vector<std::string> generateReportsInOriginalOrder();
 
+  /**
+   * @brief Generates reports for the selected measurements, in their
+   * original order.
+   * @param selection A selection of the rows of getResults().
+   * @return A vector of strings, one per selected measurement.
+   */
+  std::vector<std::string> generateReportsInOriginalOrder(
+      const Selection& selection);
+
   /**
    * @brief Generates reports based on the sorted order of the measurements.
    * @return A vector of strings, each representing a report in sorted order.
    */
   std::vector<std::string> generateReportsInSortedOrder();
 
+  /**
+   * @brief Generates reports for the selected measurements, in sorted order.
+   * @param selection A selection of the rows of getResults().
+   * @return A vector of strings, one per selected measurement.
+   */
+  std::vector<std::string> generateReportsInSortedOrder(
+      const Selection& selection);
+
   /**
    * @brief Computes statistics (mean, mode, median) for the loaded
-   * measurements.
+   * measurements. The mode is exact unless enableAdaptiveMode was called.
    */
   void computeStatistics();
 };
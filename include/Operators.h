@@ -0,0 +1,111 @@
+/**
+ * @file Operators.h
+ * @brief Declaration of the Operators class.
+ *
+ * The Operators class describes the four arithmetic operators as constexpr
+ * tables indexed by a small opcode: their symbols, precedence and
+ * associativity, and an implementation that selects the result from a table
+ * instead of switching on the operator. Lines mix operators at random, so a
+ * switch per operator per line mispredicts often; a table lookup does not
+ * branch on the operator at all. The stack machine of
+ * MeasurementFileProcessor and the ExpressionKernels read the same tables.
+ *
+ * @version 0.1
+ */
+
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+#include <cstdint>
+
+/**
+ * @class Operators
+ * @brief Utility class of operator lookup tables.
+ */
+class Operators {
+ public:
+  /**
+   * @enum Opcode
+   * @brief The index of an operator in the tables.
+   */
+  enum Opcode : uint8_t {
+    ADD = 0,       ///< +
+    SUBTRACT = 1,  ///< -
+    MULTIPLY = 2,  ///< *
+    DIVIDE = 3,    ///< /
+    INVALID = 4    ///< Anything else.
+  };
+
+  static const int COUNT = 4;  ///< Number of valid opcodes.
+
+  /**
+   * @brief Opcodes of the characters '*' to '/', which include all four
+   * operators.
+   */
+  static constexpr Opcode OPCODES[6] = {MULTIPLY, ADD,     INVALID,
+                                        SUBTRACT, INVALID, DIVIDE};
+
+  static constexpr char SYMBOLS[COUNT + 1] = {'+', '-', '*', '/',
+                                              '?'};  ///< Per opcode.
+
+  /**
+   * @brief Precedence per opcode: the values of
+   * MeasurementFileProcessor::precedence (0 for INVALID, 1 for + and -, 2
+   * for * and /); higher binds tighter.
+   */
+  static constexpr int PRECEDENCE[COUNT + 1] = {1, 1, 2, 2, 0};
+
+  /**
+   * @brief Whether each operator groups left to right, so an operator of
+   * the same precedence already on the stack is applied first. INVALID
+   * groups the same way, as the >= comparison it replaces did.
+   */
+  static constexpr bool IS_LEFT_ASSOCIATIVE[COUNT + 1] = {true, true, true,
+                                                          true, true};
+
+  /**
+   * @brief Whether each operator fails on a zero right operand.
+   */
+  static constexpr bool IS_DIVISION[COUNT + 1] = {false, false, false, true,
+                                                  false};
+
+  /**
+   * @brief Maps a character to its opcode.
+   * @param symbol The character.
+   * @return The opcode, INVALID if the character is not an operator.
+   */
+  static constexpr Opcode getOpcode(char symbol) {
+    return static_cast<unsigned char>(symbol - '*') < 6
+               ? OPCODES[static_cast<unsigned char>(symbol - '*')]
+               : INVALID;
+  }
+
+  /**
+   * @brief Decides whether the stack machine applies an operator already on
+   * the stack before it pushes the next one.
+   * @param stacked The operator on top of the stack.
+   * @param next The operator that follows it.
+   * @return true if stacked is applied first.
+   */
+  static constexpr bool isAppliedBefore(Opcode stacked, Opcode next) {
+    ///> Higher, or equal and left-associative, in one comparison
+    return PRECEDENCE[stacked] + IS_LEFT_ASSOCIATIVE[next] > PRECEDENCE[next];
+  }
+
+  /**
+   * @brief Applies a valid operator without branching on it: all four
+   * results are computed and the one for op is selected.
+   * @param op The opcode; must not be INVALID.
+   * @param left The left operand.
+   * @param right The right operand.
+   * @return The result; a division by zero is not checked here (see
+   * IS_DIVISION).
+   */
+  static inline double apply(Opcode op, double left, double right) {
+    const double results[COUNT] = {left + right, left - right, left * right,
+                                   left / right};
+    return results[op];
+  }
+};
+
+#endif  // OPERATORS_H
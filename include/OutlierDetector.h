@@ -0,0 +1,191 @@
+/**
+ * @file OutlierDetector.h
+ * @brief Declaration of the OutlierDetector class and its helpers.
+ *
+ * The OutlierDetector class flags suspicious readings in a stream of
+ * magnitudes while the file is being ingested. It combines a rolling
+ * median/MAD (robust against the very outliers it is looking for) with a
+ * z-score against Welford moments of the same window. Every update costs
+ * O(log W) for a fixed window size W, so the per-line cost is bounded
+ * regardless of file size.
+ *
+ * @version 0.1
+ */
+
+#ifndef OUTLIERDETECTOR_H
+#define OUTLIERDETECTOR_H
+
+#include <cstddef>
+#include <deque>
+#include <set>
+#include "StatisticsCalculator.h"
+
+/**
+ * @enum OutlierPolicy
+ * @brief What the file processor does with a reading flagged as an outlier.
+ */
+enum class OutlierPolicy {
+  NONE,     ///< Outlier detection is disabled.
+  FLAG,     ///< Outliers are kept in the results but reported as such.
+  EXCLUDE   ///< Outliers are dropped from the results.
+};
+
+/**
+ * @class RollingMedian
+ * @brief Median of the last W values using two balanced multisets.
+ *
+ * The lower half of the window lives in `low` and the upper half in `high`,
+ * so the median is always at the boundary of the two sets. Inserting a value
+ * and evicting the oldest one are both O(log W).
+ */
+class RollingMedian {
+ private:
+  std::size_t window;             ///< Maximum number of values kept.
+  std::deque<double> history;     ///< Values in arrival order.
+  std::multiset<double> low;      ///< Lower half of the window.
+  std::multiset<double> high;     ///< Upper half of the window.
+
+  void rebalance();  ///< Restores |low| == |high| or |low| == |high| + 1.
+
+ public:
+  /**
+   * @brief Constructs a RollingMedian over a window of the given size.
+   * @param window The number of most recent values to keep (at least 1).
+   */
+  explicit RollingMedian(std::size_t window);
+
+  /**
+   * @brief Adds a value, evicting the oldest one when the window is full.
+   * @param value The value to add.
+   */
+  void add(double value);
+
+  /**
+   * @brief Retrieves the median of the values currently in the window.
+   * @return The median, or 0 if the window is empty.
+   */
+  double median() const;
+
+  /**
+   * @brief Retrieves the number of values currently in the window.
+   * @return The window occupancy.
+   */
+  std::size_t size() const;
+};
+
+/**
+ * @class RollingMoments
+ * @brief Mean and standard deviation of the last W values.
+ *
+ * Welford's update is run forwards for the new value and backwards for the
+ * evicted one, so both cost O(1).
+ */
+class RollingMoments {
+ private:
+  std::size_t window;          ///< Maximum number of values kept.
+  std::deque<double> history;  ///< Values in arrival order.
+  double mean;                 ///< Mean of the window.
+  double m2;                   ///< Sum of squared deviations from the mean.
+
+ public:
+  /**
+   * @brief Constructs a RollingMoments over a window of the given size.
+   * @param window The number of most recent values to keep (at least 1).
+   */
+  explicit RollingMoments(std::size_t window);
+
+  /**
+   * @brief Adds a value, evicting the oldest one when the window is full.
+   * @param value The value to add.
+   */
+  void add(double value);
+
+  /**
+   * @brief Retrieves the mean of the values currently in the window.
+   * @return The mean, or 0 if the window is empty.
+   */
+  double getMean() const;
+
+  /**
+   * @brief Retrieves the sample standard deviation of the window.
+   * @return The standard deviation, or 0 with fewer than two values.
+   */
+  double getStandardDeviation() const;
+};
+
+/**
+ * @class OutlierDetector
+ * @brief Streaming outlier detector for a single dimension.
+ *
+ * A value is flagged when its robust score 0.6745 * |x - median| / MAD exceeds
+ * the robust threshold, or when its z-score against the moments of the window
+ * exceeds the z threshold. The MAD is tracked as the rolling median of the
+ * absolute deviations observed at arrival time, which keeps the update
+ * O(log W) instead of re-deriving every deviation when the median moves.
+ *
+ * The windows see every value, flagged or not, so a genuine level shift is
+ * flagged for about half a window and then accepted. Raw moments cover every
+ * value seen; clean moments, only reported, the values that were not
+ * flagged. No value is flagged before `minSamples` values have been seen.
+ * NaN and infinite values are always flagged and only counted: they stay out
+ * of the windows and of both sets of moments.
+ */
+class OutlierDetector {
+ private:
+  RollingMedian values;      ///< Rolling median of the magnitudes.
+  RollingMedian deviations;  ///< Rolling median of |x - median| (the MAD).
+  RollingMoments moments;    ///< Rolling moments for the z-score.
+  RunningStatistics raw;     ///< Moments of every value seen.
+  RunningStatistics clean;   ///< Moments of the values not flagged.
+  std::size_t minSamples;    ///< Warm-up before anything is flagged.
+  double robustThreshold;    ///< Limit on the modified z-score (0 disables).
+  double zThreshold;         ///< Limit on the classic z-score (0 disables).
+  std::size_t outliers;      ///< Number of values flagged so far.
+  std::size_t nonFinite;     ///< Number of NaN and infinite values seen.
+
+ public:
+  /**
+   * @brief Constructs an OutlierDetector.
+   * @param window Size of the rolling median/MAD window.
+   * @param minSamples Number of values to see before flagging anything.
+   * @param robustThreshold Limit on the modified z-score (3.5 is the usual
+   * Iglewicz-Hoaglin cut-off); 0 disables the robust test.
+   * @param zThreshold Limit on the classic z-score; 0 disables the test.
+   */
+  OutlierDetector(std::size_t window = 101, std::size_t minSamples = 16,
+                  double robustThreshold = 3.5, double zThreshold = 4.0);
+
+  /**
+   * @brief Feeds a value to the detector.
+   * @param value The magnitude to classify.
+   * @return true if the value was flagged as an outlier or is not finite,
+   * false otherwise.
+   */
+  bool add(double value);
+
+  /**
+   * @brief Retrieves the moments of every value seen.
+   * @return The raw running statistics.
+   */
+  const RunningStatistics& getRawStatistics() const;
+
+  /**
+   * @brief Retrieves the moments of the values that were not flagged.
+   * @return The clean running statistics.
+   */
+  const RunningStatistics& getCleanStatistics() const;
+
+  /**
+   * @brief Retrieves the number of values flagged so far.
+   * @return The outlier count.
+   */
+  std::size_t getOutlierCount() const;
+
+  /**
+   * @brief Retrieves the number of NaN and infinite values seen.
+   * @return The non-finite count, not included in the outlier count.
+   */
+  std::size_t getNonFiniteCount() const;
+};
+
+#endif  // OUTLIERDETECTOR_H
@@ -0,0 +1,157 @@
+/**
+ * @file Query.h
+ * @brief Declaration of the Query class.
+ *
+ * A query is a short statement over the results of a file, e.g.
+ *
+ *   select dim=Length where mag>500m stats mean,p99 sort desc limit 20
+ *
+ * The Query class parses it once into a plan of the kernels that already
+ * work on a ResultStore's columns: the select and where clauses become
+ * ResultFilter selections combined a word at a time, convert becomes a
+ * ReportUnits scaling pass, stats aggregate the selected column, and sort
+ * with limit is a partial sort of the selected rows only. The plan can then
+ * be executed against any number of stores without parsing it again.
+ *
+ * @version 0.1
+ */
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ReportUnits.h"
+#include "ResultStore.h"
+#include "Selection.h"
+
+/**
+ * @enum QueryOrder
+ * @brief The order a query returns its rows in.
+ */
+enum class QueryOrder {
+  FILE,        ///< The order of the input file.
+  ASCENDING,   ///< Smallest magnitude first, NaN last.
+  DESCENDING   ///< Largest magnitude first, NaN last.
+};
+
+/**
+ * @struct QueryResult
+ * @brief The rows and statistics a query returned.
+ */
+struct QueryResult {
+  std::size_t matched;                ///< Rows selected, before the limit.
+  std::vector<uint32_t> rows;         ///< Returned rows, in query order.
+  std::vector<int64_t> lineNumbers;   ///< Per returned row.
+  std::vector<double> magnitudes;     ///< Per returned row, as rendered.
+  std::vector<std::string> labels;    ///< Per returned row, the unit.
+  std::vector<std::pair<std::string, double>>
+      statistics;                     ///< Name and value, in query order.
+  std::size_t aggregated;             ///< Non-NaN rows the statistics cover.
+  std::string statisticsUnit;         ///< Unit of the statistics.
+
+  /**
+   * @brief Constructs an empty result.
+   */
+  QueryResult();
+};
+
+/**
+ * @class Query
+ * @brief A parsed query, compiled to a plan of column kernels.
+ *
+ * The clauses, every one optional but select and each at most once, are:
+ *  - select TERM[,TERM...]: the rows of any of the terms, dim=TYPE,
+ *    unit=NAME or * for every row.
+ *  - where PRED [and|or PRED...]: PRED is dim=TYPE, unit=NAME, valid or
+ *    mag OP X[UNIT] with OP one of >, >=, <, <= and =; and binds tighter
+ *    than or. X is compared with each row's magnitude in its base unit.
+ *    With a unit, X is converted to that dimension's base unit first and only
+ *    rows of the dimension match; without one, rows of every dimension do.
+ *  - convert LIST: render each dimension in one unit, as --report-units.
+ *    Dimensions it does not list render in their base unit.
+ *  Bound and convert units must be of a dimension the select clause can
+ *  return (any, with *), e.g. "select dim=Length where mag>5kg" is an error.
+ *  - stats LIST: any of count, sum, mean, median, mode, min, max and pNN
+ *    (nearest-rank percentile, 0 < NN <= 100) over every selected row.
+ *  - sort asc|desc: order the rows by magnitude in a common unit per
+ *    dimension (the convert unit, else the base unit).
+ *  - limit N: return at most N rows.
+ */
+class Query {
+ private:
+  /**
+   * @brief One compiled predicate: a single filter kernel call.
+   */
+  struct Term {
+    enum Kind { ALL, DIMENSION, UNIT, MAGNITUDE, BASE_MAGNITUDE, VALID };
+    Kind kind;          ///< The kernel.
+    std::string name;   ///< Dimension or unit name, if any.
+    double lower;       ///< Smallest magnitude selected, if any.
+    double upper;       ///< Largest magnitude selected, if any.
+  };
+
+  std::vector<Term> scope;               ///< Select terms, ORed.
+  std::vector<std::vector<Term>> where;  ///< OR of AND groups; empty is all.
+  ReportUnits convert;                   ///< Units the rows render in, over
+                                         ///< the base units.
+  std::vector<std::string> statistics;   ///< Aggregates, in query order.
+  QueryOrder order;                      ///< Order of the returned rows.
+  std::size_t limit;                     ///< Rows returned at most.
+
+  /**
+   * @brief Compiles one term of the select clause.
+   */
+  static Term parseSelectTerm(const std::string& text);
+
+  /**
+   * @brief Compiles one predicate of the where clause.
+   */
+  static Term parsePredicate(const std::string& text);
+
+  /**
+   * @brief Runs the kernel of one term.
+   */
+  static Selection evaluate(const ResultStore& results, const Term& term);
+
+ public:
+  /**
+   * @brief Constructs the query "select *".
+   */
+  Query();
+
+  /**
+   * @brief Parses and compiles a query.
+   * @param text The query, e.g. "select dim=Mass stats mean sort desc".
+   * @return The compiled query.
+   * @throws std::invalid_argument if the query is malformed.
+   */
+  static Query parse(const std::string& text);
+
+  /**
+   * @brief Evaluates the select and where clauses.
+   * @param results The results to query.
+   * @return The selected rows.
+   */
+  Selection select(const ResultStore& results) const;
+
+  /**
+   * @brief Runs the whole plan.
+   * @param results The results to query.
+   * @return The returned rows and the statistics.
+   */
+  QueryResult execute(const ResultStore& results) const;
+
+  /**
+   * @brief Formats a query result as report text: one line per row with its
+   * line number, then the statistics, or "No results" if they cover no row.
+   * @param result The result to format.
+   * @return The lines.
+   */
+  static std::vector<std::string> format(const QueryResult& result);
+};
+
+#endif  // QUERY_H
@@ -13,9 +13,16 @@
 #ifndef REPORTGENERATOR_H
 #define REPORTGENERATOR_H
 
+#include <map>
 #include <string>
 #include <vector>
+#include "FixedPoint.h"
+#include "Histogram.h"
+#include "HyperLogLog.h"
+#include "JsonReportWriter.h"
 #include "Measurement.h"
+#include "OutlierDetector.h"
+#include "ResultStore.h"
 
 /**
  * @class ReportGenerator
@@ -53,6 +60,116 @@ class ReportGenerator {
    */
   static std::string generateCSVReport(
       const std::vector<Measurement>& measurements);
+
+  /**
+   * @brief Generates a per-dimension summary of raw and clean statistics.
+   *
+   * For each dimension the report lists the count, mean and standard
+   * deviation of every result (raw) next to the same figures with the flagged
+   * outliers left out (clean), so the effect of bad readings is visible.
+   * The figures are in the dimension's base unit; NaN and infinite results
+   * are only counted.
+   *
+   * @param detectors The outlier detectors filled during ingest, keyed by unit
+   * type.
+   * @return A string representing the outlier summary.
+   */
+  static std::string generateOutlierReport(
+      const std::map<std::string, OutlierDetector>& detectors);
+
+  /**
+   * @brief Generates a bucket table for each dimension's histogram.
+   *
+   * Each dimension gets a header with its count, range and p50/p90/p99
+   * estimates, followed by one row per non-empty bucket with its bounds,
+   * count, share of the total and a proportional bar.
+   *
+   * @param histograms The histograms filled during ingest, keyed by unit type.
+   * @return A string representing the histogram report.
+   */
+  static std::string generateHistogramReport(
+      const std::map<std::string, Histogram>& histograms);
+
+  /**
+   * @brief Generates a CSV export of each dimension's histogram.
+   *
+   * One row per non-empty bucket, with the columns
+   * `Dimension,Lower,Upper,Count`.
+   *
+   * @param histograms The histograms filled during ingest, keyed by unit type.
+   * @return A string representing the CSV-formatted histogram buckets.
+   */
+  static std::string generateHistogramCSV(
+      const std::map<std::string, Histogram>& histograms);
+
+  /**
+   * @brief Generates a per-dimension summary of approximate distinct counts.
+   *
+   * For each dimension the report lists the number of results, the estimated
+   * number of distinct magnitudes and units, and the mode method that
+   * StatisticsCalculator::chooseModeStrategy picks for it.
+   *
+   * @param histograms The histograms filled during ingest (for the counts).
+   * @param magnitudes The distinct-magnitude sketches, keyed by unit type.
+   * @param units The distinct-unit sketches, keyed by unit type.
+   * @return A string representing the distinct-count summary.
+   */
+  static std::string generateDistinctCountReport(
+      const std::map<std::string, Histogram>& histograms,
+      const std::map<std::string, HyperLogLog>& magnitudes,
+      const std::map<std::string, HyperLogLog>& units);
+
+  /**
+   * @brief Generates a per-dimension summary of the exact fixed-point sums.
+   *
+   * For each dimension the report lists the count, the exact sum and the mean
+   * (rounded half away from zero to the column's decimal places), and how
+   * many values had to be rounded or did not fit. A sum that overflows 64 bits
+   * is reported as such instead of being printed wrong.
+   *
+   * @param columns The fixed-point columns filled during ingest, keyed by
+   * unit type.
+   * @return A string representing the fixed-point summary.
+   */
+  static std::string generateFixedPointReport(
+      const std::map<std::string, FixedPointColumn>& columns);
+
+  /**
+   * @brief Generates a summary of the precision lost to float storage.
+   *
+   * Lists how many magnitudes were stored, how many float could not hold
+   * exactly, the largest absolute and relative errors, the mean relative
+   * error and the memory held by the store's columns.
+   *
+   * @param results The result store.
+   * @return A string representing the precision loss summary.
+   */
+  static std::string generatePrecisionLossReport(const ResultStore& results);
+
+  /**
+   * @brief Generates per-unit counts, means and ranges.
+   *
+   * The store's unit-ID column is run-length encoded and aggregated run by
+   * run (see UnitRuns), one line per distinct unit in dictionary order.
+   *
+   * @param results The result store.
+   * @return A string representing the per-unit summary.
+   */
+  static std::string generateUnitSummaryReport(const ResultStore& results);
+
+  /**
+   * @brief Generates a JSON or NDJSON report of every result.
+   *
+   * One record per result (line, magnitude, unit, dimension, status), as
+   * written by JsonReportWriter. To stream a large store to a file without
+   * building the string, use a JsonReportWriter directly.
+   *
+   * @param results The result store.
+   * @param format NDJSON or a single JSON array.
+   * @return A string representing the JSON report.
+   */
+  static std::string generateJSONReport(
+      const ResultStore& results, JsonFormat format = JsonFormat::NDJSON);
 };
 
 #endif  // REPORTGENERATOR_H
\ No newline at end of file
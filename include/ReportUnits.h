@@ -0,0 +1,98 @@
+/**
+ * @file ReportUnits.h
+ * @brief Declaration of the ReportUnits class.
+ *
+ * Units::getUnitByName names every unit after its dimension's base unit
+ * ("km" is an "m" with a factor of 1000), so reports print base symbols
+ * whatever the scale of the magnitude. The ReportUnits class holds one
+ * requested unit per dimension and renders a ResultStore in those units: a
+ * scale factor and a label are worked out once per unit ID, and the whole
+ * magnitude column is scaled in a single pass just before formatting,
+ * without converting any result to a Measurement.
+ *
+ * @version 0.1
+ */
+
+#ifndef REPORTUNITS_H
+#define REPORTUNITS_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ResultStore.h"
+#include "Units.h"
+
+/**
+ * @class ReportUnits
+ * @brief The units reports render each dimension in.
+ *
+ * Dimensions without a target keep the unit the result was stored in.
+ */
+class ReportUnits {
+ private:
+  std::map<std::string, std::shared_ptr<Units>>
+      targets;  ///< Target unit, per unit type (dimension).
+  std::map<std::string, std::string>
+      labels;  ///< Name the target was requested by, per unit type.
+
+  /**
+   * @brief Fills the scale factor and label of each unit ID of a store.
+   */
+  void buildTables(const ResultStore& results, double* scales,
+                   std::vector<std::string>& unitLabels) const;
+
+ public:
+  /**
+   * @brief Parses a comma-separated list of unit names, e.g. "km,kg,min".
+   * @param spec The list.
+   * @return The targets.
+   * @throws std::invalid_argument if a unit is unknown or two units share a
+   * dimension.
+   */
+  static ReportUnits parse(const std::string& spec);
+
+  /**
+   * @brief Renders the unit's dimension in the unit.
+   * @param unitName The unit name, e.g. "km"; reports print it as given.
+   * @throws std::invalid_argument if the unit is unknown or its dimension
+   * already has a target.
+   */
+  void setTarget(const std::string& unitName);
+
+  /**
+   * @brief Checks whether a dimension has a target.
+   * @param dimension The unit type, e.g. "Length".
+   * @return true if the dimension is rendered in a target unit.
+   */
+  bool hasTarget(const std::string& dimension) const;
+
+  /**
+   * @brief Checks whether any dimension has a target.
+   * @return true if reports keep the stored units.
+   */
+  bool empty() const;
+
+  /**
+   * @brief Scales every magnitude of a store into the target units.
+   * @param results The results to render.
+   * @param unitLabels Filled with the label of each unit ID.
+   * @return The rendered magnitudes, one per row.
+   */
+  std::vector<double> scale(const ResultStore& results,
+                            std::vector<std::string>& unitLabels) const;
+
+  /**
+   * @brief Scales some magnitudes of a store into the target units.
+   * @param results The results to render.
+   * @param rows The rows to scale.
+   * @param unitLabels Filled with the label of each unit ID.
+   * @return The rendered magnitudes, one per listed row.
+   */
+  std::vector<double> scale(const ResultStore& results,
+                            const std::vector<uint32_t>& rows,
+                            std::vector<std::string>& unitLabels) const;
+};
+
+#endif  // REPORTUNITS_H
@@ -0,0 +1,94 @@
+/**
+ * @file ResultFile.h
+ * @brief Declaration of the ResultFile class.
+ *
+ * The ResultFile class persists a ResultStore as a binary file of compressed
+ * blocks and reads it back, either whole or one decoded block at a time.
+ * Magnitudes are XOR-encoded and line numbers delta-of-delta encoded with
+ * the GorillaCodec, unit IDs are run-length encoded and flags are stored as
+ * they are.
+ *
+ * @version 0.1
+ */
+
+#ifndef RESULTFILE_H
+#define RESULTFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ResultStore.h"
+#include "UnitRuns.h"
+#include "Units.h"
+
+/**
+ * @struct ResultBlock
+ * @brief One decoded block of a result file, valid during a scan callback.
+ */
+struct ResultBlock {
+  std::size_t rows;            ///< Number of results in the block.
+  const double* magnitudes;    ///< Magnitudes, widened to double.
+  const uint8_t* unitIds;      ///< Index into units, expanded from runs.
+  const UnitRun* runs;         ///< Unit-ID runs, as stored.
+  std::size_t runCount;        ///< Number of unit-ID runs.
+  const int64_t* lineNumbers;  ///< 1-based source lines.
+  const uint8_t* flags;        ///< ResultFlag bits.
+  const std::vector<std::shared_ptr<Units>>* units;  ///< Unit dictionary.
+};
+
+/**
+ * @class ResultFile
+ * @brief Utility class to save, load and scan compressed result files.
+ *
+ * Layout, in host byte order:
+ *  - header: the magic "UNTFYRS2", the StoragePolicy (1 byte), the unit
+ *    count (4 bytes), each unit as type, name (1-byte length + bytes) and
+ *    base factor (8 bytes), and the row count (8 bytes);
+ *  - blocks of up to BLOCK_ROWS results: the row count, the encoded
+ *    magnitude size, the encoded line number size and the unit-ID run count
+ *    (4 bytes each), then the encoded magnitudes, the runs (unit ID and
+ *    2-byte length), the encoded line numbers and the flags. A run count of
+ *    zero means the unit IDs are stored raw, one byte per row, because the
+ *    block has too many runs for run-length encoding to pay off.
+ *
+ * Blocks are independent, so a scan decodes one block into a fixed scratch
+ * buffer and hands it to a kernel without materializing the whole store.
+ * Kernels that group or filter by unit can use the runs (see UnitRuns)
+ * instead of the expanded unit IDs.
+ */
+class ResultFile {
+ public:
+  static const std::size_t BLOCK_ROWS = 4096;  ///< Results per block.
+
+  /**
+   * @brief Saves a result store.
+   * @param store The results to save.
+   * @param path The file to write.
+   * @return The number of bytes written.
+   * @throws std::runtime_error if the file cannot be written.
+   */
+  static std::size_t save(const ResultStore& store, const std::string& path);
+
+  /**
+   * @brief Loads a result store.
+   * @param path The file to read.
+   * @return The results, with the storage policy they were saved with.
+   * @throws std::runtime_error if the file cannot be read or is malformed.
+   */
+  static ResultStore load(const std::string& path);
+
+  /**
+   * @brief Decodes a result file block by block.
+   * @param path The file to read.
+   * @param kernel Called once per decoded block.
+   * @return The number of results scanned.
+   * @throws std::runtime_error if the file cannot be read or is malformed.
+   */
+  static std::size_t scan(const std::string& path,
+                          const std::function<void(const ResultBlock&)>& kernel);
+};
+
+#endif  // RESULTFILE_H
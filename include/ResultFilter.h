@@ -0,0 +1,124 @@
+/**
+ * @file ResultFilter.h
+ * @brief Declaration of the ResultFilter class.
+ *
+ * The ResultFilter class evaluates predicates over the columns of a
+ * ResultStore and returns the matching rows as a Selection. Each kernel
+ * writes 64 rows to a word: unit predicates look each unit ID up in a table
+ * built once from the unit dictionary, and magnitude ranges compare the
+ * native float or double column four or eight rows per instruction under
+ * AVX2. Selections combine with & and |, and reports, sorts and statistics
+ * consume them directly.
+ *
+ * @version 0.1
+ */
+
+#ifndef RESULTFILTER_H
+#define RESULTFILTER_H
+
+#include <string>
+#include "ResultStore.h"
+#include "Selection.h"
+
+/**
+ * @class ResultFilter
+ * @brief Utility class of filter kernels over a ResultStore.
+ */
+class ResultFilter {
+ public:
+  /**
+   * @brief Selects the results of one dimension.
+   * @param results The results to filter.
+   * @param dimension The unit type, e.g. "Length" or "Mass".
+   * @return The rows whose unit has that type.
+   */
+  static Selection byDimension(const ResultStore& results,
+                               const std::string& dimension);
+
+  /**
+   * @brief Selects the results in one unit.
+   *
+   * A unit is matched on its base unit and factor, so "km" and "kilometers"
+   * select the same rows and never those in m. Under FLOAT32 every result is
+   * stored in its base unit.
+   *
+   * @param results The results to filter.
+   * @param unitName The unit name or symbol, e.g. "km".
+   * @return The rows stored in that unit.
+   * @throws std::invalid_argument if the unit is unknown.
+   */
+  static Selection byUnit(const ResultStore& results,
+                          const std::string& unitName);
+
+  /**
+   * @brief Selects the results whose magnitude lies in a closed range.
+   *
+   * Compares the stored magnitudes, each in its own row's unit (the base
+   * unit under FLOAT32); combine with byUnit or byDimension to compare like
+   * with like. NaN is never selected.
+   *
+   * @param results The results to filter.
+   * @param lower The smallest magnitude selected.
+   * @param upper The largest magnitude selected.
+   * @return The rows with lower <= magnitude <= upper.
+   */
+  static Selection byMagnitude(const ResultStore& results, double lower,
+                               double upper);
+
+  /**
+   * @brief Selects the results of one dimension whose magnitude, converted
+   * to the base unit, lies in a closed range.
+   *
+   * Unlike byMagnitude, rows stored in different units of the dimension are
+   * compared on one scale: each row's magnitude is multiplied by its unit's
+   * base factor, looked up per unit ID, in the same pass as the comparison.
+   *
+   * @param results The results to filter.
+   * @param dimension The unit type, e.g. "Length".
+   * @param lower The smallest base magnitude selected.
+   * @param upper The largest base magnitude selected.
+   * @return The rows of the dimension with lower <= base magnitude <= upper.
+   */
+  static Selection byBaseMagnitude(const ResultStore& results,
+                                   const std::string& dimension, double lower,
+                                   double upper);
+
+  /**
+   * @brief Selects the results whose magnitude, converted to the base unit
+   * of its dimension, lies in a closed range.
+   * @param results The results to filter.
+   * @param lower The smallest base magnitude selected.
+   * @param upper The largest base magnitude selected.
+   * @return The rows with lower <= base magnitude <= upper.
+   */
+  static Selection byBaseMagnitude(const ResultStore& results, double lower,
+                                   double upper);
+
+  /**
+   * @brief Selects the results MeasurementValidator::validateMeasurement
+   * accepts, those with a non-negative magnitude.
+   * @param results The results to filter.
+   * @return The valid rows.
+   */
+  static Selection byValidity(const ResultStore& results);
+
+  /**
+   * @brief Evaluates a filter specification.
+   *
+   * A specification is a list of terms joined by ',' (AND), and groups of
+   * them joined by '|' (OR), AND binding tighter: "dimension=Length,min=0|
+   * unit=g" selects the non-negative lengths and everything in grams. The
+   * terms are dimension=TYPE, unit=NAME, min=X, max=X and valid; min and
+   * max bound the magnitude in base units (byBaseMagnitude), so "min=1"
+   * keeps 0.6 km and drops 400 m.
+   *
+   * @param results The results to filter.
+   * @param spec The specification.
+   * @return The selected rows.
+   * @throws std::invalid_argument if a term is malformed or names an
+   * unknown unit.
+   */
+  static Selection select(const ResultStore& results, const std::string& spec);
+};
+
+#endif  // RESULTFILTER_H
@@ -0,0 +1,281 @@
+/**
+ * @file ResultStore.h
+ * @brief Declaration of the ResultStore class.
+ *
+ * The ResultStore class holds the results of a processed file as columns
+ * (magnitude, unit, line number, flags) instead of as a vector of Measurement
+ * objects. A Measurement carries a shared_ptr to its unit, which costs a
+ * pointer, a reference count update on every copy and a heap object per
+ * result; the store keeps one dictionary entry per distinct unit and a one
+ * byte ID per result instead.
+ *
+ * Magnitudes are kept either as double or as float, chosen at run time with
+ * a StoragePolicy. Statistics are always accumulated in double.
+ *
+ * @version 0.1
+ */
+
+#ifndef RESULTSTORE_H
+#define RESULTSTORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Measurement.h"
+#include "Selection.h"
+#include "Units.h"
+
+/**
+ * @enum StoragePolicy
+ * @brief How a ResultStore keeps its magnitudes.
+ */
+enum class StoragePolicy {
+  DOUBLE,  ///< 8 bytes per magnitude, no precision loss.
+  FLOAT32  ///< 4 bytes per magnitude, normalized to the base unit.
+};
+
+/**
+ * @enum ResultFlag
+ * @brief Bits of the per-result flags column.
+ */
+enum ResultFlag : uint8_t {
+  RESULT_OUTLIER = 1  ///< Flagged by the outlier detector.
+};
+
+/**
+ * @struct PrecisionLossStatistics
+ * @brief How much storing magnitudes as float changed them.
+ */
+struct PrecisionLossStatistics {
+  std::size_t count;        ///< Number of magnitudes stored.
+  std::size_t inexact;      ///< Number of magnitudes float could not hold.
+  double maxAbsoluteError;  ///< Largest |float - double|.
+  double maxRelativeError;  ///< Largest |float - double| / |double|.
+  double sumRelativeError;  ///< Sum of the relative errors (for the mean).
+
+  /**
+   * @brief Constructs empty statistics.
+   */
+  PrecisionLossStatistics();
+};
+
+/**
+ * @class ResultStore
+ * @brief Columnar store of the results of a processed file.
+ *
+ * Results are appended in file order and addressed by their row index. Under
+ * FLOAT32, a magnitude in a non-base unit (a single-operand line such as
+ * "3 km") is converted to the base unit before it is narrowed, so that every
+ * stored float is in a sane range and shares its unit's scale.
+ */
+class ResultStore {
+ private:
+  StoragePolicy policy;                    ///< Magnitude representation.
+  std::vector<double> doubleMagnitudes;    ///< Used under DOUBLE.
+  std::vector<float> floatMagnitudes;      ///< Used under FLOAT32.
+  std::vector<uint8_t> unitIds;            ///< Index into units.
+  std::vector<int64_t> lineNumbers;        ///< 1-based source line.
+  std::vector<uint8_t> flags;              ///< ResultFlag bits.
+  std::vector<std::shared_ptr<Units>> units;  ///< Unit dictionary.
+  PrecisionLossStatistics precisionLoss;   ///< Filled under FLOAT32.
+
+ public:
+  /**
+   * @brief Constructs an empty ResultStore.
+   * @param policy How magnitudes are kept.
+   */
+  explicit ResultStore(StoragePolicy policy = StoragePolicy::DOUBLE);
+
+  /**
+   * @brief Retrieves the storage policy.
+   * @return The storage policy.
+   */
+  StoragePolicy getPolicy() const;
+
+  /**
+   * @brief Appends a result.
+   * @param lineNumber The line the result was computed from.
+   * @param m The result.
+   * @param resultFlags ResultFlag bits for the result.
+   * @throws std::length_error if more than 256 distinct units are appended.
+   */
+  void append(int64_t lineNumber, const Measurement& m,
+              uint8_t resultFlags = 0);
+
+  /**
+   * @brief Removes every result, keeping the unit dictionary (so unit IDs
+   * stay valid) and the column capacity, so a store can be refilled batch
+   * by batch without reallocating.
+   */
+  void clear();
+
+  /**
+   * @brief Retrieves the number of results.
+   * @return The row count.
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Checks whether the store is empty.
+   * @return true if no result was appended.
+   */
+  bool empty() const;
+
+  /**
+   * @brief Retrieves the magnitude of a result, widened to double.
+   * @param row The row index.
+   * @return The magnitude.
+   */
+  double getMagnitude(std::size_t row) const;
+
+  /**
+   * @brief Retrieves the unit ID of a result.
+   * @param row The row index.
+   * @return The index of the result's unit in the dictionary.
+   */
+  uint8_t getUnitId(std::size_t row) const;
+
+  /**
+   * @brief Retrieves the unit of a result.
+   * @param row The row index.
+   * @return The result's unit.
+   */
+  const std::shared_ptr<Units>& getUnit(std::size_t row) const;
+
+  /**
+   * @brief Retrieves the line number of a result.
+   * @param row The row index.
+   * @return The 1-based line number.
+   */
+  int64_t getLineNumber(std::size_t row) const;
+
+  /**
+   * @brief Retrieves the flags of a result.
+   * @param row The row index.
+   * @return The ResultFlag bits.
+   */
+  uint8_t getFlags(std::size_t row) const;
+
+  /**
+   * @brief Rebuilds a result as a Measurement.
+   * @param row The row index.
+   * @return The result.
+   */
+  Measurement getMeasurement(std::size_t row) const;
+
+  /**
+   * @brief Retrieves the unit dictionary.
+   * @return The distinct units, indexed by unit ID.
+   */
+  const std::vector<std::shared_ptr<Units>>& getUnits() const;
+
+  /**
+   * @brief Retrieves the magnitude column under DOUBLE.
+   * @return The magnitudes; empty under FLOAT32.
+   */
+  const std::vector<double>& getDoubleMagnitudes() const;
+
+  /**
+   * @brief Retrieves the magnitude column under FLOAT32.
+   * @return The magnitudes; empty under DOUBLE.
+   */
+  const std::vector<float>& getFloatMagnitudes() const;
+
+  /**
+   * @brief Retrieves the unit ID column.
+   * @return One dictionary index per result.
+   */
+  const std::vector<uint8_t>& getUnitIds() const;
+
+  /**
+   * @brief Retrieves the line number column.
+   * @return One 1-based line number per result.
+   */
+  const std::vector<int64_t>& getLineNumbers() const;
+
+  /**
+   * @brief Retrieves the flags column.
+   * @return One set of ResultFlag bits per result.
+   */
+  const std::vector<uint8_t>& getFlagsColumn() const;
+
+  /**
+   * @brief Computes the row order that sorts the results by magnitude.
+   *
+   * The sort moves (magnitude, row) pairs of the native width, so under
+   * FLOAT32 it moves half the bytes it moves under DOUBLE. Ties keep file
+   * order.
+   *
+   * @return The row indices in ascending magnitude order.
+   */
+  std::vector<uint32_t> sortedOrder() const;
+
+  /**
+   * @brief Computes the mean of every magnitude, accumulated in double.
+   * @return The mean.
+   */
+  double computeMean() const;
+
+  /**
+   * @brief Computes the exact mode of every magnitude.
+   * @return The most frequent magnitude (the smallest one on ties).
+   */
+  double computeMode() const;
+
+  /**
+   * @brief Computes the median of every magnitude.
+   *
+   * Works on a copy of the native column, so under FLOAT32 the selection
+   * moves half the bytes.
+   *
+   * @return The median.
+   */
+  double computeMedian() const;
+
+  /**
+   * @brief Computes the row order that sorts the selected results by
+   * magnitude, as sortedOrder() does for all of them.
+   * @param selection A selection of this store's rows.
+   * @return The selected row indices in ascending magnitude order.
+   */
+  std::vector<uint32_t> sortedOrder(const Selection& selection) const;
+
+  /**
+   * @brief Computes the mean of the selected magnitudes.
+   * @param selection A selection of this store's rows.
+   * @return The mean.
+   */
+  double computeMean(const Selection& selection) const;
+
+  /**
+   * @brief Computes the exact mode of the selected magnitudes.
+   * @param selection A selection of this store's rows.
+   * @return The most frequent magnitude (the smallest one on ties).
+   */
+  double computeMode(const Selection& selection) const;
+
+  /**
+   * @brief Computes the median of the selected magnitudes.
+   *
+   * Gathers only the selected values of the native column.
+   *
+   * @param selection A selection of this store's rows.
+   * @return The median.
+   */
+  double computeMedian(const Selection& selection) const;
+
+  /**
+   * @brief Retrieves how much narrowing to float changed the magnitudes.
+   * @return The precision loss statistics; all zero under DOUBLE.
+   */
+  const PrecisionLossStatistics& getPrecisionLoss() const;
+
+  /**
+   * @brief Computes the memory held by the columns.
+   * @return The number of bytes of column storage.
+   */
+  std::size_t memoryUsage() const;
+};
+
+#endif  // RESULTSTORE_H
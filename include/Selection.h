@@ -0,0 +1,113 @@
+/**
+ * @file Selection.h
+ * @brief Declaration of the Selection class.
+ *
+ * The Selection class marks a subset of the rows of a ResultStore with one
+ * bit per row, 64 rows to a word. Filter kernels (see ResultFilter) write
+ * whole words at a time, selections combine with AND and OR a word at a
+ * time, and reports, sorts and statistics read the selected rows straight
+ * from the store's columns, so filtering never copies results into a
+ * vector<Measurement>.
+ *
+ * @version 0.1
+ */
+
+#ifndef SELECTION_H
+#define SELECTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class Selection
+ * @brief Bitmap of selected rows.
+ *
+ * Bits past the last row are always clear.
+ */
+class Selection {
+ private:
+  std::size_t rowCount;          ///< Number of rows covered.
+  std::vector<uint64_t> words;   ///< Bit r % 64 of word r / 64 is row r.
+
+ public:
+  /**
+   * @brief Constructs a selection of no rows, or of every row.
+   * @param rowCount The number of rows covered.
+   * @param isSelected Whether every row starts selected.
+   */
+  explicit Selection(std::size_t rowCount = 0, bool isSelected = false);
+
+  /**
+   * @brief Retrieves the number of rows covered.
+   * @return The row count the selection was built for.
+   */
+  std::size_t size() const;
+
+  /**
+   * @brief Counts the selected rows.
+   * @return The number of set bits.
+   */
+  std::size_t count() const;
+
+  /**
+   * @brief Checks whether a row is selected.
+   * @param row The row index.
+   * @return true if it is selected.
+   */
+  bool contains(std::size_t row) const;
+
+  /**
+   * @brief Selects a row.
+   * @param row The row index.
+   */
+  void select(std::size_t row);
+
+  /**
+   * @brief Retrieves the bitmap.
+   * @return The words, (size() + 63) / 64 of them.
+   */
+  const std::vector<uint64_t>& getWords() const;
+
+  /**
+   * @brief Retrieves the bitmap for a filter kernel to fill in.
+   * @return The words; the bits past the last row must be left clear.
+   */
+  std::vector<uint64_t>& getWords();
+
+  /**
+   * @brief Lists the selected rows.
+   * @return The row indices in ascending order.
+   */
+  std::vector<uint32_t> getRows() const;
+
+  /**
+   * @brief Keeps the rows selected in both.
+   * @param other A selection of the same rows.
+   * @return This selection.
+   * @throws std::invalid_argument if the row counts differ.
+   */
+  Selection& operator&=(const Selection& other);
+
+  /**
+   * @brief Adds the rows selected in other.
+   * @param other A selection of the same rows.
+   * @return This selection.
+   * @throws std::invalid_argument if the row counts differ.
+   */
+  Selection& operator|=(const Selection& other);
+};
+
+/**
+ * @brief Intersects two selections.
+ * @throws std::invalid_argument if the row counts differ.
+ */
+Selection operator&(Selection left, const Selection& right);
+
+/**
+ * @brief Unites two selections.
+ * @throws std::invalid_argument if the row counts differ.
+ */
+Selection operator|(Selection left, const Selection& right);
+
+#endif  // SELECTION_H
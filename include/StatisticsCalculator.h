@@ -13,9 +13,85 @@
 #ifndef STATISTICSCALCULATOR_H
 #define STATISTICSCALCULATOR_H
 
+#include <cstddef>
 #include <vector>
+#include "Histogram.h"
 #include "Measurement.h"
 
+/**
+ * @enum ModeStrategy
+ * @brief How the mode of a set of measurements is computed.
+ */
+enum class ModeStrategy {
+  EXACT,  ///< Count every distinct magnitude (computeMode).
+  BINNED  ///< Take the fullest histogram bucket (computeBinnedMode).
+};
+
+/**
+ * @class RunningStatistics
+ * @brief Single-pass mean and variance using Welford's algorithm.
+ *
+ * Values are folded in one at a time, so the moments are available during
+ * ingest without keeping the values around. Welford's update is numerically
+ * stable where the naive sum of squares is not.
+ */
+class RunningStatistics {
+ private:
+  std::size_t count;  ///< Number of values added.
+  double mean;        ///< Running mean.
+  double m2;          ///< Sum of squared deviations from the mean.
+  double min;         ///< Smallest value added.
+  double max;         ///< Largest value added.
+
+ public:
+  /**
+   * @brief Constructs an empty RunningStatistics.
+   */
+  RunningStatistics();
+
+  /**
+   * @brief Adds a value to the running moments.
+   * @param value The value to add.
+   */
+  void add(double value);
+
+  /**
+   * @brief Retrieves the number of values added.
+   * @return The count.
+   */
+  std::size_t getCount() const;
+
+  /**
+   * @brief Retrieves the mean of the values added.
+   * @return The mean, or 0 if no value was added.
+   */
+  double getMean() const;
+
+  /**
+   * @brief Retrieves the sample variance of the values added.
+   * @return The variance, or 0 if fewer than two values were added.
+   */
+  double getVariance() const;
+
+  /**
+   * @brief Retrieves the sample standard deviation of the values added.
+   * @return The standard deviation.
+   */
+  double getStandardDeviation() const;
+
+  /**
+   * @brief Retrieves the smallest value added.
+   * @return The minimum, or 0 if no value was added.
+   */
+  double getMin() const;
+
+  /**
+   * @brief Retrieves the largest value added.
+   * @return The maximum, or 0 if no value was added.
+   */
+  double getMax() const;
+};
+
 /**
  * @class StatisticsCalculator
  * @brief A utility class for calculating statistical measures of a collection
@@ -34,7 +110,7 @@ class StatisticsCalculator {
    * objects.
    *
    * @param measurements A vector containing Measurement objects.
-   * @return The mean value of the measurements.
+   * @return The mean value of the measurements, or 0 if there are none.
    */
   static double computeMean(const std::vector<Measurement>& measurements);
 
@@ -45,7 +121,7 @@ class StatisticsCalculator {
    * vector of Measurement objects.
    *
    * @param measurements A vector containing Measurement objects.
-   * @return The mode value of the measurements.
+   * @return The mode value of the measurements, or 0 if there are none.
    */
   static double computeMode(const std::vector<Measurement>& measurements);
 
@@ -58,9 +134,97 @@ class StatisticsCalculator {
    *
    * @param measurements A vector containing Measurement objects. The vector may
    * be modified.
-   * @return The median value of the measurements.
+   * @return The median value of the measurements, or 0 if there are none.
    */
   static double computeMedian(std::vector<Measurement>& measurements);
+
+  /**
+   * @brief Computes the mean of a magnitude column, accumulating in double.
+   * @param values The magnitudes.
+   * @return The mean value, or 0 if the column is empty.
+   */
+  static double computeMean(const std::vector<double>& values);
+
+  /**
+   * @copydoc computeMean(const std::vector<double>&)
+   */
+  static double computeMean(const std::vector<float>& values);
+
+  /**
+   * @brief Computes the mode of a magnitude column.
+   * @param values The magnitudes.
+   * @return The most frequent magnitude (the smallest one on ties).
+   */
+  static double computeMode(const std::vector<double>& values);
+
+  /**
+   * @copydoc computeMode(const std::vector<double>&)
+   */
+  static double computeMode(const std::vector<float>& values);
+
+  /**
+   * @brief Computes the median of a magnitude column.
+   * @param values The magnitudes. The vector is reordered.
+   * @return The median value, or 0 if the column is empty.
+   */
+  static double computeMedian(std::vector<double>& values);
+
+  /**
+   * @copydoc computeMedian(std::vector<double>&)
+   */
+  static double computeMedian(std::vector<float>& values);
+
+  /**
+   * @brief Decides whether an exact mode is worth computing.
+   *
+   * When nearly every magnitude is distinct, the exact mode degenerates into
+   * an arbitrary value seen once, and counting it costs a node per value. In
+   * that case the mode of the binned distribution is the meaningful answer.
+   * Small inputs always use the exact mode.
+   *
+   * @param distinctEstimate Estimated number of distinct magnitudes (e.g.
+   * from a HyperLogLog sketch).
+   * @param count Number of magnitudes.
+   * @return BINNED if at least half of the magnitudes are distinct and there
+   * are at least MIN_BINNED_MODE_COUNT of them, EXACT otherwise.
+   */
+  static ModeStrategy chooseModeStrategy(double distinctEstimate,
+                                         std::size_t count);
+
+  /**
+   * @brief Computes the mode of a binned distribution.
+   *
+   * The bucket with the highest count is chosen, ties going to the smallest.
+   * Dividing by the bucket width instead would let a single tiny value in a
+   * narrow bucket outweigh hundreds of repeats of a large one.
+   *
+   * @param histogram The histogram of the magnitudes.
+   * @return The midpoint of the fullest bucket, or 0 if the histogram is
+   * empty.
+   */
+  static double computeBinnedMode(const Histogram& histogram);
+
+  /**
+   * @brief Computes the mode, choosing the exact or binned method.
+   *
+   * A HyperLogLog sketch estimates the number of distinct magnitudes in one
+   * pass, and chooseModeStrategy picks the method.
+   *
+   * @param measurements A vector containing Measurement objects.
+   * @return The mode value of the measurements.
+   */
+  static double computeAdaptiveMode(
+      const std::vector<Measurement>& measurements);
+
+  /**
+   * @brief Computes the mode of a magnitude column, choosing the exact or
+   * binned method.
+   * @param values The magnitudes.
+   * @return The mode value.
+   */
+  static double computeAdaptiveMode(const std::vector<double>& values);
+
+  static const std::size_t MIN_BINNED_MODE_COUNT = 1024;  ///< See above.
 };
 
 #endif  // STATISTICSCALCULATOR_H
\ No newline at end of file
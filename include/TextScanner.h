@@ -0,0 +1,128 @@
+/**
+ * @file TextScanner.h
+ * @brief Declaration of the TextScanner class.
+ *
+ * The TextScanner class finds line and token boundaries in a buffer of text
+ * without looking at it one byte at a time. In the style of simdjson's first
+ * stage, it classifies 64 bytes at a time into a newline bitmask and a
+ * whitespace bitmask with SIMD compares, then derives token starts and ends
+ * from the masks with shifts and walks them with count-trailing-zeros.
+ *
+ * @version 0.1
+ */
+
+#ifndef TEXTSCANNER_H
+#define TEXTSCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @enum ScanBackend
+ * @brief Instruction set used to classify bytes.
+ */
+enum class ScanBackend {
+  SCALAR,  ///< One byte at a time; always available.
+  SSE2,    ///< 16 bytes per compare (x86-64 baseline).
+  AVX2     ///< 32 bytes per compare, if the CPU supports it.
+};
+
+/**
+ * @struct TokenSpan
+ * @brief A run of non-whitespace bytes, as offsets into the scanned buffer.
+ */
+struct TokenSpan {
+  uint32_t begin;   ///< Offset of the first byte.
+  uint32_t length;  ///< Number of bytes.
+};
+
+/**
+ * @struct ScannedLines
+ * @brief The lines and tokens found in a buffer by TextScanner::scanLines.
+ *
+ * Line i spans [lineEnds[i-1] + 1, lineEnds[i]) (from 0 for the first line)
+ * and owns tokens [lineTokenEnds[i-1], lineTokenEnds[i]).
+ */
+struct ScannedLines {
+  std::vector<TokenSpan> tokens;         ///< Every token, in order.
+  std::vector<uint32_t> lineEnds;        ///< Offset of each line's '\n'
+                                         ///< (the buffer end for a final,
+                                         ///< unterminated line).
+  std::vector<uint32_t> lineTokenEnds;   ///< One past each line's tokens.
+  std::vector<uint32_t> tokenBegins;     ///< Scratch: start of each token.
+  std::vector<uint32_t> tokenEnds;       ///< Scratch: one past each token.
+  std::vector<uint64_t> newlineMasks;    ///< Scratch: 1 bit per '\n' byte.
+  std::vector<uint64_t> whitespaceMasks; ///< Scratch: 1 bit per space byte.
+
+  /**
+   * @brief Retrieves the number of complete lines found.
+   * @return The line count.
+   */
+  std::size_t lineCount() const;
+};
+
+/**
+ * @class TextScanner
+ * @brief Utility class for SIMD line and token scanning.
+ *
+ * Whitespace is what std::isspace accepts in the "C" locale (space, \\t,
+ * \\n, \\v, \\f, \\r), so tokens match what operator>> on a stringstream
+ * would split the line into.
+ */
+class TextScanner {
+ public:
+  /**
+   * @brief Retrieves the fastest backend the CPU supports.
+   * @return The backend scanLines uses.
+   */
+  static ScanBackend getDefaultBackend();
+
+  /**
+   * @brief Checks whether the CPU supports a backend.
+   * @param backend The backend to check.
+   * @return true if classify can run with the backend.
+   */
+  static bool isSupported(ScanBackend backend);
+
+  /**
+   * @brief Retrieves the name of a backend.
+   * @param backend The backend.
+   * @return "scalar", "sse2" or "avx2".
+   */
+  static const char* getBackendName(ScanBackend backend);
+
+  /**
+   * @brief Classifies bytes into newline and whitespace bitmasks.
+   *
+   * Bit b of word w describes byte 64 * w + b. Bytes past the end of the
+   * buffer in the last word count as whitespace.
+   *
+   * @param data The buffer.
+   * @param size The number of bytes.
+   * @param newlines Receives (size + 63) / 64 newline masks.
+   * @param whitespace Receives (size + 63) / 64 whitespace masks.
+   * @param backend The instruction set to use; must be supported.
+   */
+  static void classify(const char* data, std::size_t size, uint64_t* newlines,
+                       uint64_t* whitespace, ScanBackend backend);
+
+  /**
+   * @brief Finds the complete lines of a buffer and their tokens.
+   *
+   * Unless the buffer is the last one, bytes after its last '\n' are an
+   * incomplete line; they are not reported and should be carried over to
+   * the next buffer. The last buffer's trailing bytes are reported as a
+   * final line, as getline would.
+   *
+   * @param data The buffer (at most 4 GiB).
+   * @param size The number of bytes.
+   * @param isLast Whether no more data follows the buffer.
+   * @param out Receives the lines and tokens; cleared first.
+   * @return The number of bytes covered by the reported lines.
+   */
+  static std::size_t scanLines(const char* data, std::size_t size, bool isLast,
+                               ScannedLines& out);
+};
+
+#endif  // TEXTSCANNER_H
@@ -0,0 +1,117 @@
+/**
+ * @file UnitRuns.h
+ * @brief Declaration of the UnitRuns class and its run-length types.
+ *
+ * Input files tend to repeat the same unit for many lines, so the unit-ID
+ * column of a result store is mostly long runs of one dictionary ID. The
+ * UnitRuns class run-length encodes that column and provides kernels that
+ * work on the runs directly: a filter looks at each run's unit once instead
+ * of at every row, and a per-unit aggregate folds a contiguous slice of
+ * magnitudes into one accumulator instead of dispatching on every row.
+ *
+ * @version 0.1
+ */
+
+#ifndef UNITRUNS_H
+#define UNITRUNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Units.h"
+
+/**
+ * @struct UnitRun
+ * @brief A run of consecutive rows sharing a unit ID.
+ */
+struct UnitRun {
+  uint8_t unitId;   ///< Index into the unit dictionary.
+  uint32_t length;  ///< Number of rows in the run.
+};
+
+/**
+ * @struct UnitAggregate
+ * @brief Count, sum and range of the magnitudes of one unit.
+ */
+struct UnitAggregate {
+  std::size_t count;  ///< Number of magnitudes.
+  double sum;         ///< Sum of the magnitudes.
+  double min;         ///< Smallest magnitude.
+  double max;         ///< Largest magnitude.
+
+  /**
+   * @brief Constructs an empty aggregate.
+   */
+  UnitAggregate();
+
+  /**
+   * @brief Computes the mean of the magnitudes.
+   * @return The mean, or 0 if the aggregate is empty.
+   */
+  double getMean() const;
+};
+
+/**
+ * @class UnitRuns
+ * @brief Utility class for run-length encoded unit-ID columns.
+ */
+class UnitRuns {
+ public:
+  /**
+   * @brief Run-length encodes a unit-ID column.
+   * @param unitIds The unit IDs.
+   * @param count The number of unit IDs.
+   * @return The runs, in row order.
+   */
+  static std::vector<UnitRun> encode(const uint8_t* unitIds,
+                                     std::size_t count);
+
+  /**
+   * @brief Expands runs back into a unit-ID column.
+   * @param runs The runs.
+   * @param runCount The number of runs.
+   * @param unitIds The buffer receiving one unit ID per row.
+   */
+  static void decode(const UnitRun* runs, std::size_t runCount,
+                     uint8_t* unitIds);
+
+  /**
+   * @brief Selects the rows whose unit belongs to a dimension.
+   * @param runs The runs.
+   * @param runCount The number of runs.
+   * @param units The unit dictionary.
+   * @param dimension The unit type to keep (e.g., "Length").
+   * @param firstRow The row index of the first run's first row.
+   * @param rows The vector the selected row indices are appended to.
+   */
+  static void filterDimension(const UnitRun* runs, std::size_t runCount,
+                              const std::vector<std::shared_ptr<Units>>& units,
+                              const std::string& dimension,
+                              std::size_t firstRow, std::vector<uint32_t>& rows);
+
+  /**
+   * @brief Aggregates magnitudes per unit ID.
+   * @param runs The runs.
+   * @param runCount The number of runs.
+   * @param magnitudes One magnitude per row covered by the runs.
+   * @param perUnit The aggregates to fold into, grown to cover every unit ID.
+   */
+  static void aggregateByUnit(const UnitRun* runs, std::size_t runCount,
+                              const double* magnitudes,
+                              std::vector<UnitAggregate>& perUnit);
+
+  /**
+   * @brief Aggregates float magnitudes per unit ID, accumulating in double.
+   * @param runs The runs.
+   * @param runCount The number of runs.
+   * @param magnitudes One magnitude per row covered by the runs.
+   * @param perUnit The aggregates to fold into, grown to cover every unit ID.
+   */
+  static void aggregateByUnit(const UnitRun* runs, std::size_t runCount,
+                              const float* magnitudes,
+                              std::vector<UnitAggregate>& perUnit);
+};
+
+#endif  // UNITRUNS_H
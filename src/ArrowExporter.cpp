@@ -0,0 +1,599 @@
+/**
+ * @file ArrowExporter.cpp
+ * @brief Implementation of the ArrowExporter class.
+ *
+ * The metadata follows Arrow's Schema.fbs, Message.fbs and File.fbs
+ * (metadata version V5). Flatbuffers are built front to back: a table is
+ * written before the strings, vectors and tables it refers to, so every
+ * offset points forward as the format requires.
+ *
+ * @version 0.1
+ */
+
+#include "ArrowExporter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+const char MAGIC[8] = {'A', 'R', 'R', 'O', 'W', '1', 0, 0};  ///< Padded.
+const int16_t METADATA_V5 = 4;
+const uint32_t CONTINUATION = 0xFFFFFFFF;
+
+///> MessageHeader and Type union tags
+const uint8_t HEADER_SCHEMA = 1;
+const uint8_t HEADER_DICTIONARY_BATCH = 2;
+const uint8_t HEADER_RECORD_BATCH = 3;
+const uint8_t TYPE_INT = 2;
+const uint8_t TYPE_FLOATING_POINT = 3;
+const uint8_t TYPE_UTF8 = 5;
+const int16_t PRECISION_DOUBLE = 2;
+
+const int64_t UNIT_DICTIONARY = 0;       ///< Dictionary ID of "unit".
+const int64_t DIMENSION_DICTIONARY = 1;  ///< Dictionary ID of "dimension".
+
+/**
+ * @brief Appends little-endian Flatbuffers data front to back.
+ */
+class FlatBuilder {
+ public:
+  std::vector<uint8_t> bytes;  ///< The buffer built so far.
+
+  std::size_t size() const { return bytes.size(); }
+
+  /**
+   * @brief Pads with zeros until size() + extra is a multiple of alignment.
+   */
+  void pad(std::size_t alignment, std::size_t extra = 0) {
+    while ((bytes.size() + extra) % alignment != 0) {
+      bytes.push_back(0);
+    }
+  }
+
+  template <typename T>
+  std::size_t put(T value) {
+    std::size_t at = bytes.size();
+    bytes.resize(at + sizeof(T));
+    std::memcpy(&bytes[at], &value, sizeof(T));
+    return at;
+  }
+
+  template <typename T>
+  void set(std::size_t at, T value) {
+    std::memcpy(&bytes[at], &value, sizeof(T));
+  }
+
+  /**
+   * @brief Points the uoffset at slot to target, which must come later.
+   */
+  void link(std::size_t slot, std::size_t target) {
+    set<uint32_t>(slot, static_cast<uint32_t>(target - slot));
+  }
+
+  std::size_t putString(const std::string& text) {
+    pad(4);
+    std::size_t at = put<uint32_t>(static_cast<uint32_t>(text.size()));
+    bytes.insert(bytes.end(), text.begin(), text.end());
+    bytes.push_back(0);
+    return at;
+  }
+
+  /**
+   * @brief Starts a vector; elements are appended by the caller.
+   * @return The position of the length field, which offsets point to.
+   */
+  std::size_t beginVector(std::size_t count, std::size_t elementAlignment) {
+    pad(std::max<std::size_t>(elementAlignment, 4), 4);
+    return put<uint32_t>(static_cast<uint32_t>(count));
+  }
+};
+
+/**
+ * @brief One field of a table: a scalar, or a uoffset patched later.
+ */
+struct TableField {
+  int id;          ///< Field index in the schema.
+  int size;        ///< 1, 2, 4 or 8 bytes.
+  uint64_t value;  ///< Scalar bits; ignored for offsets.
+  bool isOffset;   ///< Whether the field refers to another object.
+  std::size_t at;  ///< Position in the buffer once written.
+};
+
+/**
+ * @brief Collects the fields of a table and writes its vtable and body.
+ */
+class TableBuilder {
+ private:
+  std::vector<TableField> fields;
+
+ public:
+  template <typename T>
+  TableBuilder& scalar(int id, T value) {
+    TableField field = {id, static_cast<int>(sizeof(T)), 0, false, 0};
+    std::memcpy(&field.value, &value, sizeof(T));
+    fields.push_back(field);
+    return *this;
+  }
+
+  TableBuilder& offset(int id) {
+    TableField field = {id, 4, 0, true, 0};
+    fields.push_back(field);
+    return *this;
+  }
+
+  /**
+   * @brief Writes the vtable, then the table.
+   * @return The position of the table.
+   */
+  std::size_t finish(FlatBuilder& builder) {
+    ///> Lay fields out largest first after the 4-byte vtable offset
+    std::stable_sort(fields.begin(), fields.end(),
+                     [](const TableField& a, const TableField& b) {
+                       return a.size > b.size;
+                     });
+    std::vector<uint16_t> positions;
+    int maxId = -1;
+    std::size_t inlineSize = 4;
+    std::size_t alignment = 4;
+    for (const TableField& field : fields) {
+      inlineSize = (inlineSize + field.size - 1) / field.size * field.size;
+      positions.push_back(static_cast<uint16_t>(inlineSize));
+      inlineSize += field.size;
+      maxId = std::max(maxId, field.id);
+      alignment = std::max<std::size_t>(alignment, field.size);
+    }
+
+    builder.pad(2);
+    const std::size_t vtable = builder.size();
+    builder.put<uint16_t>(static_cast<uint16_t>(4 + 2 * (maxId + 1)));
+    builder.put<uint16_t>(static_cast<uint16_t>(inlineSize));
+    for (int id = 0; id <= maxId; ++id) {
+      uint16_t position = 0;
+      for (std::size_t i = 0; i < fields.size(); ++i) {
+        if (fields[i].id == id) {
+          position = positions[i];
+        }
+      }
+      builder.put<uint16_t>(position);
+    }
+
+    builder.pad(alignment);
+    const std::size_t table = builder.size();
+    builder.put<int32_t>(static_cast<int32_t>(table - vtable));
+    builder.bytes.resize(table + inlineSize, 0);
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+      fields[i].at = table + positions[i];
+      std::memcpy(&builder.bytes[fields[i].at], &fields[i].value,
+                  fields[i].size);
+    }
+    return table;
+  }
+
+  /**
+   * @brief Retrieves where an offset field was written.
+   */
+  std::size_t slot(int id) const {
+    for (const TableField& field : fields) {
+      if (field.id == id) {
+        return field.at;
+      }
+    }
+    throw std::logic_error("Flatbuffer field not set");
+  }
+};
+
+/**
+ * @brief A buffer of a record batch body, written from memory as is.
+ */
+struct BodyBuffer {
+  const void* data;
+  std::size_t length;
+};
+
+/**
+ * @brief A node of a record batch: the length and null count of a field.
+ */
+struct FieldNode {
+  int64_t length;
+  int64_t nullCount;
+};
+
+/**
+ * @brief The position of a message in an IPC file, for the footer.
+ */
+struct Block {
+  int64_t offset;
+  int32_t metadataLength;
+  int64_t bodyLength;
+};
+
+std::size_t padTo(std::size_t size, std::size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+/**
+ * @brief Writes an Int type table.
+ */
+std::size_t writeIntType(FlatBuilder& builder, int32_t bitWidth,
+                         bool isSigned) {
+  return TableBuilder()
+      .scalar<int32_t>(0, bitWidth)
+      .scalar<uint8_t>(1, isSigned)
+      .finish(builder);
+}
+
+/**
+ * @brief Writes a Field table and the objects it refers to.
+ *
+ * A dictionary field is described by its value type (utf8) plus a
+ * DictionaryEncoding naming its uint8 index type.
+ */
+std::size_t writeField(FlatBuilder& builder, const std::string& name,
+                       bool nullable, uint8_t typeTag, int64_t dictionaryId) {
+  TableBuilder field;
+  field.offset(0).scalar<uint8_t>(1, nullable).scalar<uint8_t>(2, typeTag);
+  field.offset(3).offset(5);
+  if (dictionaryId >= 0) {
+    field.offset(4);
+  }
+  std::size_t table = field.finish(builder);
+
+  builder.link(field.slot(0), builder.putString(name));
+  if (typeTag == TYPE_INT) {
+    builder.link(field.slot(3), writeIntType(builder, 64, true));
+  } else if (typeTag == TYPE_FLOATING_POINT) {
+    builder.link(field.slot(3), TableBuilder()
+                                    .scalar<int16_t>(0, PRECISION_DOUBLE)
+                                    .finish(builder));
+  } else {
+    builder.link(field.slot(3), TableBuilder().finish(builder));
+  }
+  builder.link(field.slot(5), builder.beginVector(0, 4));
+  if (dictionaryId >= 0) {
+    TableBuilder encoding;
+    encoding.scalar<int64_t>(0, dictionaryId).offset(1);
+    builder.link(field.slot(4), encoding.finish(builder));
+    builder.link(encoding.slot(1), writeIntType(builder, 8, false));
+  }
+  return table;
+}
+
+/**
+ * @brief Writes the Schema table of the exported columns.
+ */
+std::size_t writeSchema(FlatBuilder& builder) {
+  TableBuilder schema;
+  schema.offset(1);
+  std::size_t table = schema.finish(builder);
+
+  std::size_t vector = builder.beginVector(4, 4);
+  builder.link(schema.slot(1), vector);
+  std::size_t slots[4];
+  for (int i = 0; i < 4; ++i) {
+    slots[i] = builder.put<uint32_t>(0);
+  }
+  builder.link(slots[0], writeField(builder, "line", false, TYPE_INT, -1));
+  builder.link(slots[1], writeField(builder, "magnitude", true,
+                                    TYPE_FLOATING_POINT, -1));
+  builder.link(slots[2],
+               writeField(builder, "unit", false, TYPE_UTF8, UNIT_DICTIONARY));
+  builder.link(slots[3], writeField(builder, "dimension", false, TYPE_UTF8,
+                                    DIMENSION_DICTIONARY));
+  return table;
+}
+
+/**
+ * @brief Writes a RecordBatch table; buffers are laid out back to back,
+ * each padded to ALIGNMENT.
+ */
+std::size_t writeRecordBatch(FlatBuilder& builder, int64_t length,
+                             const std::vector<FieldNode>& nodes,
+                             const std::vector<BodyBuffer>& buffers) {
+  TableBuilder batch;
+  batch.scalar<int64_t>(0, length).offset(1).offset(2);
+  std::size_t table = batch.finish(builder);
+
+  builder.link(batch.slot(1), builder.beginVector(nodes.size(), 8));
+  for (const FieldNode& node : nodes) {
+    builder.put<int64_t>(node.length);
+    builder.put<int64_t>(node.nullCount);
+  }
+  builder.link(batch.slot(2), builder.beginVector(buffers.size(), 8));
+  std::size_t offset = 0;
+  for (const BodyBuffer& buffer : buffers) {
+    builder.put<int64_t>(static_cast<int64_t>(offset));
+    builder.put<int64_t>(static_cast<int64_t>(buffer.length));
+    offset += padTo(buffer.length, ArrowExporter::ALIGNMENT);
+  }
+  return table;
+}
+
+/**
+ * @brief Builds a Message around a header written by writeHeader.
+ */
+template <typename WriteHeader>
+FlatBuilder buildMessage(uint8_t headerType, int64_t bodyLength,
+                         WriteHeader writeHeader) {
+  FlatBuilder builder;
+  std::size_t root = builder.put<uint32_t>(0);
+  TableBuilder message;
+  message.scalar<int16_t>(0, METADATA_V5)
+      .scalar<uint8_t>(1, headerType)
+      .offset(2)
+      .scalar<int64_t>(3, bodyLength);
+  builder.link(root, message.finish(builder));
+  builder.link(message.slot(2), writeHeader(builder));
+  return builder;
+}
+
+/**
+ * @brief Writes encapsulated IPC messages and tracks the output position.
+ */
+class MessageWriter {
+ private:
+  std::ostream& out;
+  std::size_t position;
+
+  void writeZeros(std::size_t count) {
+    static const char zeros[ArrowExporter::ALIGNMENT] = {};
+    while (count > 0) {
+      std::size_t chunk = std::min(count, sizeof(zeros));
+      out.write(zeros, static_cast<std::streamsize>(chunk));
+      count -= chunk;
+    }
+  }
+
+ public:
+  explicit MessageWriter(std::ostream& out) : out(out), position(0) {}
+
+  std::size_t getPosition() const { return position; }
+
+  void writeRaw(const void* data, std::size_t length) {
+    out.write(static_cast<const char*>(data),
+              static_cast<std::streamsize>(length));
+    position += length;
+  }
+
+  void pad(std::size_t length) {
+    writeZeros(length);
+    position += length;
+  }
+
+  /**
+   * @brief Writes the continuation marker, metadata length, metadata and
+   * body. The metadata is padded so the body starts ALIGNMENT-aligned.
+   * @return Where the message starts, and its framed sizes.
+   */
+  Block writeMessage(const FlatBuilder& metadata,
+                     const std::vector<BodyBuffer>& buffers) {
+    Block block;
+    block.offset = static_cast<int64_t>(position);
+    const std::size_t unpadded = 8 + metadata.size();
+    const std::size_t framed =
+        padTo(position + unpadded, ArrowExporter::ALIGNMENT) - position;
+    const int32_t metadataLength = static_cast<int32_t>(framed - 8);
+    writeRaw(&CONTINUATION, 4);
+    writeRaw(&metadataLength, 4);
+    writeRaw(metadata.bytes.data(), metadata.size());
+    pad(framed - unpadded);
+    block.metadataLength = static_cast<int32_t>(framed);
+
+    std::size_t bodyLength = 0;
+    for (const BodyBuffer& buffer : buffers) {
+      if (buffer.length != 0) {
+        writeRaw(buffer.data, buffer.length);
+      }
+      std::size_t padded = padTo(buffer.length, ArrowExporter::ALIGNMENT);
+      pad(padded - buffer.length);
+      bodyLength += padded;
+    }
+    block.bodyLength = static_cast<int64_t>(bodyLength);
+    return block;
+  }
+
+  void writeEndOfStream() {
+    const uint32_t zero = 0;
+    writeRaw(&CONTINUATION, 4);
+    writeRaw(&zero, 4);
+  }
+};
+
+std::size_t bodyLengthOf(const std::vector<BodyBuffer>& buffers) {
+  std::size_t length = 0;
+  for (const BodyBuffer& buffer : buffers) {
+    length += padTo(buffer.length, ArrowExporter::ALIGNMENT);
+  }
+  return length;
+}
+
+/**
+ * @brief Writes a dictionary of strings as a DictionaryBatch message.
+ */
+Block writeDictionary(MessageWriter& writer, int64_t id,
+                      const std::vector<std::string>& values) {
+  std::vector<int32_t> offsets(1, 0);
+  std::string data;
+  for (const std::string& value : values) {
+    data += value;
+    offsets.push_back(static_cast<int32_t>(data.size()));
+  }
+  std::vector<FieldNode> nodes(1);
+  nodes[0].length = static_cast<int64_t>(values.size());
+  nodes[0].nullCount = 0;
+  std::vector<BodyBuffer> buffers(3);
+  buffers[0].data = nullptr;
+  buffers[0].length = 0;
+  buffers[1].data = offsets.data();
+  buffers[1].length = offsets.size() * sizeof(int32_t);
+  buffers[2].data = data.data();
+  buffers[2].length = data.size();
+
+  FlatBuilder metadata = buildMessage(
+      HEADER_DICTIONARY_BATCH, static_cast<int64_t>(bodyLengthOf(buffers)),
+      [&](FlatBuilder& builder) {
+        TableBuilder dictionary;
+        dictionary.scalar<int64_t>(0, id).offset(1);
+        std::size_t table = dictionary.finish(builder);
+        builder.link(dictionary.slot(1),
+                     writeRecordBatch(builder, nodes[0].length, nodes,
+                                      buffers));
+        return table;
+      });
+  return writer.writeMessage(metadata, buffers);
+}
+
+/**
+ * @brief Writes the Footer flatbuffer of an IPC file.
+ */
+FlatBuilder buildFooter(const std::vector<Block>& dictionaries,
+                        const std::vector<Block>& batches) {
+  FlatBuilder builder;
+  std::size_t root = builder.put<uint32_t>(0);
+  TableBuilder footer;
+  footer.scalar<int16_t>(0, METADATA_V5).offset(1).offset(2).offset(3);
+  builder.link(root, footer.finish(builder));
+  builder.link(footer.slot(1), writeSchema(builder));
+  const std::vector<Block>* lists[] = {&dictionaries, &batches};
+  for (int i = 0; i < 2; ++i) {
+    builder.link(footer.slot(2 + i), builder.beginVector(lists[i]->size(), 8));
+    for (const Block& block : *lists[i]) {
+      builder.put<int64_t>(block.offset);
+      builder.put<int32_t>(block.metadataLength);
+      builder.put<int32_t>(0);
+      builder.put<int64_t>(block.bodyLength);
+    }
+  }
+  return builder;
+}
+}  // namespace
+
+const std::size_t ArrowExporter::BATCH_ROWS;
+const std::size_t ArrowExporter::ALIGNMENT;
+
+std::size_t ArrowExporter::write(const ResultStore& results,
+                                 std::ostream& out, ArrowFormat format) {
+  MessageWriter writer(out);
+  if (format == ArrowFormat::FILE) {
+    writer.writeRaw(MAGIC, sizeof(MAGIC));
+  }
+
+  writer.writeMessage(buildMessage(HEADER_SCHEMA, 0, writeSchema),
+                      std::vector<BodyBuffer>());
+
+  std::vector<std::string> unitLabels, dimensions;
+  for (const std::shared_ptr<Units>& unit : results.getUnits()) {
+    unitLabels.push_back(getUnitLabel(*unit));
+    dimensions.push_back(unit->getType());
+  }
+  std::vector<Block> dictionaryBlocks, batchBlocks;
+  dictionaryBlocks.push_back(
+      writeDictionary(writer, UNIT_DICTIONARY, unitLabels));
+  dictionaryBlocks.push_back(
+      writeDictionary(writer, DIMENSION_DICTIONARY, dimensions));
+
+  const bool isFloat = results.getPolicy() == StoragePolicy::FLOAT32;
+  std::vector<double> widened;    ///> FLOAT32 magnitudes, per batch
+  std::vector<uint8_t> validity;  ///> Built only for batches with nulls
+  for (std::size_t first = 0; first < results.size(); first += BATCH_ROWS) {
+    const std::size_t rows = std::min(BATCH_ROWS, results.size() - first);
+    const double* magnitudes = results.getDoubleMagnitudes().data() + first;
+    if (isFloat) {
+      const float* narrow = results.getFloatMagnitudes().data() + first;
+      widened.assign(narrow, narrow + rows);
+      magnitudes = widened.data();
+    }
+
+    int64_t nullCount = 0;
+    for (std::size_t i = 0; i < rows; ++i) {
+      nullCount += !std::isfinite(magnitudes[i]);
+    }
+    if (nullCount != 0) {
+      validity.assign((rows + 7) / 8, 0);
+      for (std::size_t i = 0; i < rows; ++i) {
+        validity[i / 8] |= uint8_t(std::isfinite(magnitudes[i])) << (i % 8);
+      }
+    }
+
+    const uint8_t* unitIds = results.getUnitIds().data() + first;
+    const BodyBuffer empty = {nullptr, 0};
+    std::vector<BodyBuffer> buffers;
+    buffers.push_back(empty);
+    buffers.push_back(BodyBuffer{results.getLineNumbers().data() + first,
+                                 rows * sizeof(int64_t)});
+    buffers.push_back(nullCount != 0
+                          ? BodyBuffer{validity.data(), validity.size()}
+                          : empty);
+    buffers.push_back(BodyBuffer{magnitudes, rows * sizeof(double)});
+    buffers.push_back(empty);
+    buffers.push_back(BodyBuffer{unitIds, rows});
+    buffers.push_back(empty);
+    buffers.push_back(BodyBuffer{unitIds, rows});
+
+    std::vector<FieldNode> nodes(4);
+    for (FieldNode& node : nodes) {
+      node.length = static_cast<int64_t>(rows);
+      node.nullCount = 0;
+    }
+    nodes[1].nullCount = nullCount;
+
+    FlatBuilder metadata = buildMessage(
+        HEADER_RECORD_BATCH, static_cast<int64_t>(bodyLengthOf(buffers)),
+        [&](FlatBuilder& builder) {
+          return writeRecordBatch(builder, static_cast<int64_t>(rows), nodes,
+                                  buffers);
+        });
+    batchBlocks.push_back(writer.writeMessage(metadata, buffers));
+  }
+  writer.writeEndOfStream();
+
+  if (format == ArrowFormat::FILE) {
+    FlatBuilder footer = buildFooter(dictionaryBlocks, batchBlocks);
+    const int32_t footerLength = static_cast<int32_t>(footer.size());
+    writer.writeRaw(footer.bytes.data(), footer.size());
+    writer.writeRaw(&footerLength, 4);
+    writer.writeRaw(MAGIC, 6);
+  }
+  return writer.getPosition();
+}
+
+std::size_t ArrowExporter::save(const ResultStore& results,
+                                const std::string& path, ArrowFormat format) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Could not open Arrow file: " + path);
+  }
+  std::size_t bytes = write(results, out, format);
+  out.close();
+  if (!out) {
+    throw std::runtime_error("Could not write Arrow file: " + path);
+  }
+  return bytes;
+}
+
+std::string ArrowExporter::getUnitLabel(const Units& unit) {
+  const std::string name = unit.getName();
+  const double factor = unit.getBaseFactor();
+  if (name == "s" && factor == 60.0) {
+    return "min";
+  } else if (name == "s" && factor == 3600.0) {
+    return "hr";
+  }
+  static const struct {
+    double factor;
+    const char* prefix;
+  } prefixes[] = {{1e-6, "u"}, {1e-3, "m"}, {1e-2, "c"},
+                  {1e-1, "d"}, {1.0, ""},   {1e3, "k"}};
+  for (const auto& prefix : prefixes) {
+    if (factor == prefix.factor) {
+      return prefix.prefix + name;
+    }
+  }
+  char text[32];
+  std::snprintf(text, sizeof(text), "*%.10g", factor);
+  return name + text;
+}
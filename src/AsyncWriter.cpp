@@ -0,0 +1,179 @@
+/**
+ * @file AsyncWriter.cpp
+ * @brief Implementation of the AsyncWriter and StreamRedirect classes.
+ *
+ * @version 0.1
+ */
+
+#include "AsyncWriter.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief Writes all of [data, data + size) to fd.
+ */
+bool writeAll(int fd, const char* data, std::size_t size) {
+  while (size > 0) {
+    ssize_t count = ::write(fd, data, size);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return false;
+    }
+    data += count;
+    size -= static_cast<std::size_t>(count);
+  }
+  return true;
+}
+}  // namespace
+
+const std::size_t AsyncWriter::DEFAULT_BUFFER_SIZE;
+
+AsyncWriter::AsyncWriter(int fd, std::size_t bufferSize)
+    : fd(fd), ownsFd(false) {
+  start(bufferSize);
+}
+
+AsyncWriter::AsyncWriter(const std::string& path, std::size_t bufferSize)
+    : fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)),
+      ownsFd(true) {
+  if (fd < 0) {
+    throw std::runtime_error("Could not open output file: " + path);
+  }
+  start(bufferSize);
+}
+
+void AsyncWriter::start(std::size_t size) {
+  isTerminal = ::isatty(fd) == 1;
+  bufferSize = std::max<std::size_t>(size, 1);
+  buffers[0].reset(new char[bufferSize]);
+  buffers[1].reset(new char[bufferSize]);
+  active = 0;
+  pendingSize = 0;
+  bytesWritten = 0;
+  isStopping = false;
+  hasFailed = false;
+  setp(buffers[0].get(), buffers[0].get() + bufferSize);
+  thread = std::thread(&AsyncWriter::run, this);
+}
+
+AsyncWriter::~AsyncWriter() {
+  try {
+    flush();
+  } catch (const std::exception&) {
+    ///> Nothing left to report the failure to
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isStopping = true;
+  }
+  ready.notify_one();
+  thread.join();
+  if (ownsFd) {
+    ::close(fd);
+  }
+}
+
+void AsyncWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    ready.wait(lock, [this] { return pendingSize != 0 || isStopping; });
+    if (pendingSize == 0) {
+      return;
+    }
+    ///> The producers own the active buffer; the other one is ours
+    const char* data = buffers[active ^ 1].get();
+    const std::size_t size = pendingSize;
+    lock.unlock();
+    const bool isWritten = writeAll(fd, data, size);
+    lock.lock();
+    if (isWritten) {
+      bytesWritten += size;
+    } else {
+      hasFailed = true;
+    }
+    pendingSize = 0;
+    done.notify_all();
+  }
+}
+
+bool AsyncWriter::handOver() {
+  const std::size_t size = static_cast<std::size_t>(pptr() - pbase());
+  std::unique_lock<std::mutex> lock(mutex);
+  if (size == 0 || hasFailed) {
+    return !hasFailed;
+  }
+  done.wait(lock, [this] { return pendingSize == 0; });
+  pendingSize = size;
+  active ^= 1;
+  setp(buffers[active].get(), buffers[active].get() + bufferSize);
+  ready.notify_one();
+  return !hasFailed;
+}
+
+AsyncWriter::int_type AsyncWriter::overflow(int_type c) {
+  if (!handOver()) {
+    return traits_type::eof();
+  }
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return traits_type::not_eof(c);
+}
+
+std::streamsize AsyncWriter::xsputn(const char* s, std::streamsize n) {
+  std::streamsize copied = 0;
+  while (copied < n) {
+    if (pptr() == epptr()) {
+      if (!handOver()) {
+        break;
+      }
+    }
+    const std::streamsize count =
+        std::min<std::streamsize>(n - copied, epptr() - pptr());
+    std::memcpy(pptr(), s + copied, static_cast<std::size_t>(count));
+    pbump(static_cast<int>(count));
+    copied += count;
+  }
+  return copied;
+}
+
+int AsyncWriter::sync() {
+  std::unique_lock<std::mutex> lock(mutex);
+  const bool isIdle = pendingSize == 0;
+  lock.unlock();
+  if (isTerminal && isIdle) {
+    return handOver() ? 0 : -1;  ///> The thread is idle, so this does not wait
+  }
+  lock.lock();
+  return hasFailed ? -1 : 0;
+}
+
+void AsyncWriter::flush() {
+  handOver();
+  std::unique_lock<std::mutex> lock(mutex);
+  done.wait(lock, [this] { return pendingSize == 0; });
+  if (hasFailed) {
+    throw std::runtime_error("Failed to write output.");
+  }
+}
+
+std::size_t AsyncWriter::getBytesWritten() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return bytesWritten;
+}
+
+StreamRedirect::StreamRedirect(std::ostream& stream, std::streambuf& buffer)
+    : stream(stream), previous(stream.rdbuf(&buffer)) {}
+
+StreamRedirect::~StreamRedirect() {
+  stream.flush();
+  stream.rdbuf(previous);
+}
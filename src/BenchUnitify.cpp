@@ -0,0 +1,1077 @@
+/**
+ * @file BenchUnitify.cpp
+ * @brief Micro-benchmarks for the Unitify ingest path.
+ *
+ * This file times the hot loops of the ingest path on synthetic input shaped
+ * like the output of the measurement generator, and prints the throughput of
+ * each fast path next to the reference code it replaces. It is not part of
+ * the test suite; run it from a Release build.
+ *
+ * @version 0.1
+ */
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "ArrowExporter.h"
+#include "AsyncWriter.h"
+#include "CsvScanner.h"
+#include "ExpressionKernels.h"
+#include "FastFloat.h"
+#include "InputReader.h"
+#include "JsonReportWriter.h"
+#include "LineDiff.h"
+#include "LineIndex.h"
+#include "MeasurementFileProcessor.h"
+#include "Operators.h"
+#include "Query.h"
+#include "ReportUnits.h"
+#include "ResultFilter.h"
+#include "StatisticsCalculator.h"
+#include "Units.h"
+#include "TextScanner.h"
+
+namespace {
+/**
+ * @brief Builds generator-shaped lines, e.g. "860.587 km + 12.300 m".
+ */
+std::string makeInput(std::size_t bytes) {
+  const char* units[] = {"mm", "cm", "m", "km", "g", "kg", "l", "ml"};
+  const char* operators[] = {"+", "-", "*", "/"};
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(3);
+  unsigned state = 2024;
+  while (static_cast<std::size_t>(oss.tellp()) < bytes) {
+    state = state * 1103515245 + 12345;
+    int operands = 1 + (state >> 16) % 3;
+    for (int i = 0; i < operands; ++i) {
+      state = state * 1103515245 + 12345;
+      if (i > 0) {
+        oss << ' ' << operators[(state >> 8) % 4] << ' ';
+      }
+      oss << ((state >> 12) % 1000000) / 1000.0 << ' '
+          << units[(state >> 20) % 8];
+    }
+    oss << '\n';
+  }
+  return oss.str();
+}
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+/**
+ * @brief Collects the magnitude and unit tokens of every operand.
+ */
+void splitOperands(const std::string& input,
+                   std::vector<std::string>& magnitudes,
+                   std::vector<std::string>& units) {
+  std::istringstream lines(input);
+  std::string line, magnitude, unit, op;
+  while (std::getline(lines, line)) {
+    std::istringstream ss(line);
+    while (ss >> magnitude >> unit) {
+      magnitudes.push_back(magnitude);
+      units.push_back(unit);
+      ss >> op;
+    }
+  }
+}
+
+/**
+ * @brief Discards everything written to it.
+ */
+class NullBuffer : public std::streambuf {
+ protected:
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+/**
+ * @brief Counts the branch misses of this thread in user space, where the
+ * kernel and the machine allow it (virtual machines often do not).
+ */
+class BranchMissCounter {
+ private:
+  int fd;  ///< The perf event, -1 if unavailable.
+
+ public:
+  BranchMissCounter() {
+    perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof attributes);
+    attributes.size = sizeof attributes;
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.config = PERF_COUNT_HW_BRANCH_MISSES;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    fd = static_cast<int>(
+        ::syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+  }
+
+  ~BranchMissCounter() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  /**
+   * @brief Reads the count so far, -1 if unavailable.
+   */
+  long long read() const {
+    long long count;
+    if (fd < 0 || ::read(fd, &count, sizeof count) != sizeof count) {
+      return -1;
+    }
+    return count;
+  }
+};
+
+void report(const std::string& name, std::size_t bytes, double seconds,
+            std::size_t items) {
+  std::cout << "  " << std::left << std::setw(28) << name << std::right
+            << std::fixed << std::setprecision(1) << std::setw(9)
+            << bytes / seconds / 1e6 << " MB/s  (" << items << " items)"
+            << std::endl;
+}
+
+/**
+ * @brief Prints one latency line, in microseconds, against a budget.
+ */
+void reportLatency(const std::string& name, double seconds, double budget) {
+  std::cout << "  " << std::left << std::setw(28) << name << std::right
+            << std::fixed << std::setprecision(1) << std::setw(9)
+            << seconds * 1e6 << " us  ("
+            << (seconds <= budget ? "within" : "over") << " the "
+            << budget * 1e3 << " ms budget)" << std::endl;
+}
+
+/**
+ * @brief The median of some timings.
+ */
+double medianOf(std::vector<double> seconds) {
+  std::sort(seconds.begin(), seconds.end());
+  return seconds[seconds.size() / 2];
+}
+}  // namespace
+
+/**
+ * @brief Times line and token splitting: getline + stringstream against the
+ * TextScanner with each backend.
+ */
+void benchTextScanner(const std::string& input) {
+  std::cout << "Line and token scanning, " << input.size() / 1000000
+            << " MB:" << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::istringstream lines(input);
+  std::string line, token;
+  std::size_t tokens = 0;
+  while (std::getline(lines, line)) {
+    std::istringstream ss(line);
+    while (ss >> token) {
+      ++tokens;
+    }
+  }
+  report("getline + stringstream", input.size(), secondsSince(start), tokens);
+
+  ///> Scan in 1 MiB chunks with carry-over, as readFile does
+  const std::size_t chunk = 1 << 20;
+  ScannedLines scanned;
+  tokens = 0;
+  start = std::chrono::steady_clock::now();
+  for (std::size_t offset = 0; offset < input.size();) {
+    std::size_t size = std::min(chunk, input.size() - offset);
+    bool isLast = offset + size == input.size();
+    offset += TextScanner::scanLines(input.data() + offset, size, isLast,
+                                     scanned);
+    tokens += scanned.tokens.size();
+  }
+  report(std::string("scanLines (") +
+             TextScanner::getBackendName(TextScanner::getDefaultBackend()) +
+             ")",
+         input.size(), secondsSince(start), tokens);
+
+  for (ScanBackend backend :
+       {ScanBackend::SCALAR, ScanBackend::SSE2, ScanBackend::AVX2}) {
+    if (!TextScanner::isSupported(backend)) {
+      continue;
+    }
+    std::vector<uint64_t> newlines((input.size() + 63) / 64);
+    std::vector<uint64_t> spaces(newlines.size());
+    start = std::chrono::steady_clock::now();
+    TextScanner::classify(input.data(), input.size(), newlines.data(),
+                          spaces.data(), backend);
+    report(std::string("classify (") + TextScanner::getBackendName(backend) +
+               ")",
+           input.size(), secondsSince(start), newlines.size());
+  }
+}
+
+/**
+ * @brief Times magnitude parsing: stringstream >> double and strtod against
+ * FastFloat::parse on the magnitude tokens of the input.
+ */
+void benchFloatParsing(const std::string& input) {
+  std::vector<std::string> magnitudes;
+  std::istringstream lines(input);
+  std::string token;
+  std::size_t bytes = 0;
+  while (lines >> token) {
+    if ((token[0] >= '0' && token[0] <= '9') || token[0] == '.') {
+      bytes += token.size();
+      magnitudes.push_back(token);
+    }
+  }
+  std::cout << "Magnitude parsing, " << magnitudes.size() << " tokens:"
+            << std::endl;
+
+  double sum = 0.0;
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  for (const std::string& magnitude : magnitudes) {
+    std::istringstream ss(magnitude);
+    double value;
+    ss >> value;
+    sum += value;
+  }
+  report("stringstream >> double", bytes, secondsSince(start),
+         magnitudes.size());
+
+  start = std::chrono::steady_clock::now();
+  for (const std::string& magnitude : magnitudes) {
+    sum += std::strtod(magnitude.c_str(), nullptr);
+  }
+  report("strtod", bytes, secondsSince(start), magnitudes.size());
+
+  start = std::chrono::steady_clock::now();
+  for (const std::string& magnitude : magnitudes) {
+    double value;
+    FastFloat::parse(magnitude.data(), magnitude.data() + magnitude.size(),
+                     value);
+    sum += value;
+  }
+  report("FastFloat::parse", bytes, secondsSince(start), magnitudes.size());
+  std::cout << "  (checksum " << sum << ")" << std::endl;
+}
+
+/**
+ * @brief Times CSV splitting: getline per record and field against the
+ * CsvScanner, on a Magnitude,Unit export of the input's operands.
+ */
+void benchCsvScanning(const std::string& input) {
+  std::vector<std::string> magnitudes, units;
+  splitOperands(input, magnitudes, units);
+  std::ostringstream oss;
+  oss << "Magnitude,Unit\n";
+  for (std::size_t i = 0; i < magnitudes.size(); ++i) {
+    oss << magnitudes[i] << ',' << units[i] << '\n';
+  }
+  const std::string csv = oss.str();
+  std::cout << "CSV scanning, " << csv.size() / 1000000 << " MB:" << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::istringstream records(csv);
+  std::string record, field;
+  std::size_t fields = 0;
+  while (std::getline(records, record)) {
+    std::istringstream ss(record);
+    while (std::getline(ss, field, ',')) {
+      ++fields;
+    }
+  }
+  report("getline per field", csv.size(), secondsSince(start), fields);
+
+  const std::size_t chunk = 1 << 20;
+  ScannedRecords scanned;
+  fields = 0;
+  start = std::chrono::steady_clock::now();
+  for (std::size_t offset = 0; offset < csv.size();) {
+    std::size_t size = std::min(chunk, csv.size() - offset);
+    bool isLast = offset + size == csv.size();
+    offset += CsvScanner::scanRecords(csv.data() + offset, size, isLast, ',',
+                                      scanned);
+    fields += scanned.fields.size();
+  }
+  report(std::string("scanRecords (") +
+             TextScanner::getBackendName(TextScanner::getDefaultBackend()) +
+             ")",
+         csv.size(), secondsSince(start), fields);
+}
+
+/**
+ * @brief Times result export: NDJSON with an ostringstream per record
+ * against the JsonReportWriter, and the Arrow IPC exporter, on a store
+ * holding the input's operands.
+ */
+void benchResultExport(const std::string& input) {
+  std::vector<std::string> magnitudes, units;
+  splitOperands(input, magnitudes, units);
+  ResultStore results;
+  for (std::size_t i = 0; i < magnitudes.size(); ++i) {
+    results.append(static_cast<int64_t>(i) + 1,
+                   Measurement(std::strtod(magnitudes[i].c_str(), nullptr),
+                               Units::getUnitByName(units[i])));
+  }
+  std::cout << "Result export, " << results.size() << " records:" << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::string streamed;
+  for (std::size_t row = 0; row < results.size(); ++row) {
+    const std::shared_ptr<Units>& resultUnit = results.getUnit(row);
+    std::ostringstream record;
+    record << std::setprecision(17) << "{\"line\":"
+           << results.getLineNumber(row) << ",\"magnitude\":"
+           << results.getMagnitude(row) * resultUnit->getBaseFactor()
+           << ",\"unit\":\"" << resultUnit->getName()
+           << "\",\"dimension\":\"" << resultUnit->getType()
+           << "\",\"status\":\"ok\"}\n";
+    streamed += record.str();
+  }
+  report("ostringstream per record", streamed.size(), secondsSince(start),
+         results.size());
+
+  std::ostringstream out;
+  start = std::chrono::steady_clock::now();
+  JsonReportWriter writer(out);
+  writer.write(results);
+  writer.finish();
+  report("JsonReportWriter", out.str().size(), secondsSince(start),
+         writer.getRecordCount());
+
+  std::ostringstream arrow;
+  start = std::chrono::steady_clock::now();
+  std::size_t bytes = ArrowExporter::write(results, arrow, ArrowFormat::FILE);
+  report("ArrowExporter", bytes, secondsSince(start), results.size());
+}
+
+/**
+ * @brief Times random line access: skipping lines with getline from the
+ * start of the file against an IndexedFile pread through the line index.
+ */
+void benchLineIndex(const std::string& input) {
+  const std::string fileName = "bench_lines.txt";
+  std::ofstream(fileName.c_str(), std::ios::binary) << input;
+  std::cout << "Line index, " << input.size() / 1000000 << " MB:" << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  LineIndex index;
+  ScannedLines scanned;
+  for (std::size_t offset = 0; offset < input.size();) {
+    std::size_t size = std::min<std::size_t>(1 << 20, input.size() - offset);
+    bool isLast = offset + size == input.size();
+    std::size_t consumed =
+        TextScanner::scanLines(input.data() + offset, size, isLast, scanned);
+    uint32_t lineBegin = 0;
+    for (std::size_t i = 0; i < scanned.lineCount(); ++i) {
+      index.addLine(offset + lineBegin);
+      lineBegin = scanned.lineEnds[i] + 1;
+    }
+    offset += consumed;
+  }
+  index.finish(input.size());
+  report("build index", input.size(), secondsSince(start),
+         index.getLineCount());
+  std::cout << "  " << index.memoryUsage() / index.getLineCount()
+            << " bytes per line" << std::endl;
+
+  ///> The same pseudo-random lines for both sides
+  std::vector<std::size_t> lines;
+  unsigned state = 7;
+  for (int i = 0; i < 20000; ++i) {
+    state = state * 1103515245 + 12345;
+    lines.push_back(1 + (state >> 4) % index.getLineCount());
+  }
+
+  const std::size_t scans = 20;
+  start = std::chrono::steady_clock::now();
+  std::string line;
+  std::size_t bytes = 0;
+  for (std::size_t i = 0; i < scans; ++i) {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    for (std::size_t n = 0; n < lines[i]; ++n) {
+      std::getline(file, line);
+    }
+    bytes += line.size();
+  }
+  double seconds = secondsSince(start);
+  std::cout << "  " << std::left << std::setw(28) << "getline from start"
+            << std::right << std::fixed << std::setprecision(2)
+            << std::setw(9) << seconds / scans * 1e6 << " us/line  ("
+            << bytes << " bytes)" << std::endl;
+
+  IndexedFile indexed(fileName, index);
+  start = std::chrono::steady_clock::now();
+  bytes = 0;
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    indexed.readLine(lines[i], line);
+    bytes += i < scans ? line.size() : 0;
+  }
+  seconds = secondsSince(start);
+  std::cout << "  " << std::left << std::setw(28) << "IndexedFile::readLine"
+            << std::right << std::fixed << std::setprecision(2)
+            << std::setw(9) << seconds / lines.size() * 1e6 << " us/line  ("
+            << bytes << " bytes)" << std::endl;
+  std::remove(fileName.c_str());
+}
+
+/**
+ * @brief Times printing one "Result:" line per operand with std::endl, as
+ * readFile does: through an ofstream against an AsyncWriter.
+ */
+void benchOutputWriter(const std::string& input) {
+  std::vector<std::string> magnitudes, units;
+  splitOperands(input, magnitudes, units);
+  const std::string fileName = "bench_output.txt";
+  std::cout << "Output writing, " << magnitudes.size() << " lines:" << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::size_t bytes = 0;
+  {
+    std::ofstream out(fileName.c_str(), std::ios::binary);
+    for (std::size_t i = 0; i < magnitudes.size(); ++i) {
+      out << "Result: " << magnitudes[i] << " " << units[i] << std::endl;
+    }
+    bytes = static_cast<std::size_t>(out.tellp());
+  }
+  report("ofstream", bytes, secondsSince(start), magnitudes.size());
+
+  start = std::chrono::steady_clock::now();
+  {
+    AsyncWriter writer(fileName);
+    std::ostream out(&writer);
+    for (std::size_t i = 0; i < magnitudes.size(); ++i) {
+      out << "Result: " << magnitudes[i] << " " << units[i] << std::endl;
+    }
+    writer.flush();
+  }
+  report("AsyncWriter", bytes, secondsSince(start), magnitudes.size());
+  std::remove(fileName.c_str());
+}
+
+/**
+ * @brief Times reading a file through each InputReader backend, counting
+ * its lines so every byte is touched. The file is in the page cache, so
+ * this measures the per-byte overhead of each backend, not the device.
+ */
+void benchInputReaders(const std::string& input) {
+  const std::string fileName = "bench_input.txt";
+  std::ofstream(fileName.c_str(), std::ios::binary) << input;
+  std::cout << "Input readers, " << input.size() / 1000000 << " MB:"
+            << std::endl;
+
+  const ReaderBackend backends[] = {ReaderBackend::IFSTREAM,
+                                    ReaderBackend::MMAP,
+                                    ReaderBackend::IO_URING,
+                                    ReaderBackend::READAHEAD};
+  for (ReaderBackend backend : backends) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    std::unique_ptr<InputReader> reader = InputReader::open(fileName, backend);
+    std::size_t lines = 0;
+    const char* data;
+    std::size_t size;
+    while ((size = reader->next(data)) > 0) {
+      lines += static_cast<std::size_t>(std::count(data, data + size, '\n'));
+    }
+    report(InputReader::getBackendName(reader->getBackend()), input.size(),
+           secondsSince(start), lines);
+  }
+  std::remove(fileName.c_str());
+}
+
+/**
+ * @brief Times evaluating parsed lines: the stack machine of
+ * processOperatorsWithPEMDAS against the ExpressionKernels, on the lines a
+ * kernel covers. processOperatorsWithPEMDAS still logs every line (to a
+ * discarding stream here), so the kernels are also timed on their own.
+ */
+void benchExpressionKernels(const std::string& input) {
+  const std::size_t prefix = input.find('\n', 4 << 20) + 1;
+  std::istringstream lines(input.substr(0, prefix));
+  MeasurementFileProcessor reference("-");
+  reference.enableExpressionKernels(false);
+  MeasurementFileProcessor processor("-");
+  std::vector<std::vector<Measurement>> operands;
+  std::vector<std::vector<char>> operators;
+  std::vector<Measurement> measurements;
+  std::vector<char> symbols;
+  std::string line;
+  std::size_t bytes = 0;
+  double magnitude;
+  NullBuffer sink;
+  {
+    StreamRedirect err(std::cerr, sink);
+    while (std::getline(lines, line)) {
+      measurements.clear();
+      symbols.clear();
+      processor.parseLine(line, 1, measurements, symbols);
+      if (ExpressionKernels::evaluate(measurements, symbols, magnitude)) {
+        operands.push_back(measurements);
+        operators.push_back(symbols);
+        bytes += line.size() + 1;
+      }
+    }
+  }
+  const int passes = 10;
+  std::cout << "Expression evaluation, " << operands.size()
+            << " lines with a kernel, " << passes << " passes:" << std::endl;
+
+  double stackSeconds, kernelSeconds, evaluateSeconds;
+  volatile double sum = 0;  ///> Keeps the loops from being optimized out
+  {
+    StreamRedirect out(std::cout, sink);
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+      for (std::size_t i = 0; i < operands.size(); ++i) {
+        sum += reference.processOperatorsWithPEMDAS(operands[i], operators[i])
+                   .getMagnitude();
+      }
+    }
+    stackSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+      for (std::size_t i = 0; i < operands.size(); ++i) {
+        sum += processor.processOperatorsWithPEMDAS(operands[i], operators[i])
+                   .getMagnitude();
+      }
+    }
+    kernelSeconds = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; ++pass) {
+      for (std::size_t i = 0; i < operands.size(); ++i) {
+        ExpressionKernels::evaluate(operands[i], operators[i], magnitude);
+        sum += magnitude;
+      }
+    }
+    evaluateSeconds = secondsSince(start);
+  }
+
+  const std::size_t items = operands.size() * passes;
+  report("PEMDAS, stack machine", bytes * passes, stackSeconds, items);
+  report("PEMDAS, kernels", bytes * passes, kernelSeconds, items);
+  report("ExpressionKernels::evaluate", bytes * passes, evaluateSeconds,
+         items);
+}
+
+namespace {
+/**
+ * @brief The precedence switch the Operators tables replaced.
+ */
+int switchPrecedence(char op) {
+  switch (op) {
+    case '+':
+    case '-':
+      return 1;
+    case '*':
+    case '/':
+      return 2;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief The operator switch of applyOperation the Operators tables
+ * replaced.
+ */
+double switchApply(char op, double left, double right) {
+  switch (op) {
+    case '+':
+      return left + right;
+    case '-':
+      return left - right;
+    case '*':
+      return left * right;
+    case '/':
+      if (right == 0) {
+        throw std::invalid_argument("Division by zero is not allowed.");
+      }
+      return left / right;
+    default:
+      throw std::invalid_argument("Invalid operator.");
+  }
+}
+
+double tableApply(char op, double left, double right) {
+  const Operators::Opcode opcode = Operators::getOpcode(op);
+  if (opcode == Operators::INVALID) {
+    throw std::invalid_argument("Invalid operator.");
+  }
+  if (right == 0 && Operators::IS_DIVISION[opcode]) {
+    throw std::invalid_argument("Division by zero is not allowed.");
+  }
+  return Operators::apply(opcode, left, right);
+}
+}  // namespace
+
+/**
+ * @brief Times the per-operator work of the stack machine (a precedence
+ * comparison and one operation) with switches against the Operators tables,
+ * on operators in random order as the generator writes them and sorted.
+ * Sorting makes the switches predictable, so the gap between the two orders
+ * is the cost of mispredictions; branch misses are counted where possible.
+ */
+void benchOperatorDispatch() {
+  const std::size_t count = 1 << 24;
+  const char symbols[] = {'+', '-', '*', '/'};
+  std::vector<char> randomOperators(count);
+  std::vector<double> lefts(count), rights(count), results(count);
+  unsigned state = 2024;
+  for (std::size_t i = 0; i < count; ++i) {
+    state = state * 1103515245 + 12345;
+    randomOperators[i] = symbols[(state >> 16) % 4];
+    lefts[i] = 1 + (state >> 8) % 1000;
+    rights[i] = 1 + (state >> 20) % 1000;
+  }
+  std::vector<char> sortedOperators(randomOperators);
+  std::sort(sortedOperators.begin(), sortedOperators.end());
+  std::cout << "Operator dispatch, " << count << " operators:" << std::endl;
+
+  struct Order {
+    const char* name;
+    const std::vector<char>* operators;
+  };
+  const Order orders[] = {{"random", &randomOperators},
+                          {"sorted", &sortedOperators}};
+  BranchMissCounter counter;
+  for (const Order& order : orders) {
+    const char* ops = order.operators->data();
+    for (int isTable = 0; isTable < 2; ++isTable) {
+      const long long missesBefore = counter.read();
+      std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      std::size_t applied = 0;
+      for (std::size_t i = 0; i + 1 < count; ++i) {
+        if (isTable) {
+          applied += Operators::isAppliedBefore(Operators::getOpcode(ops[i]),
+                                                Operators::getOpcode(ops[i + 1]));
+          results[i] = tableApply(ops[i], lefts[i], rights[i]);
+        } else {
+          applied += switchPrecedence(ops[i]) >= switchPrecedence(ops[i + 1]);
+          results[i] = switchApply(ops[i], lefts[i], rights[i]);
+        }
+      }
+      const double seconds = secondsSince(start);
+      const long long missesAfter = counter.read();
+      std::cout << "  " << std::left << std::setw(28)
+                << std::string(isTable ? "tables, " : "switches, ") + order.name
+                << std::right << std::fixed << std::setprecision(2)
+                << std::setw(9) << seconds * 1e9 / count << " ns/op  ";
+      if (missesBefore >= 0 && missesAfter >= 0) {
+        std::cout << std::setprecision(3)
+                  << static_cast<double>(missesAfter - missesBefore) / count
+                  << " misses/op";
+      } else {
+        std::cout << "(branch misses n/a)";
+      }
+      std::cout << "  (" << applied << " applied first)" << std::endl;
+    }
+  }
+}
+
+/**
+ * @brief Times restricting the results to lengths in a magnitude range:
+ * copying the matching Measurements out of a vector<Measurement> against the
+ * ResultFilter kernels building a selection over the columns, alone and
+ * followed by a median of the selected rows.
+ */
+void benchResultFilter(const std::string& input) {
+  std::vector<std::string> magnitudes, units;
+  splitOperands(input, magnitudes, units);
+  ResultStore results;
+  std::vector<Measurement> measurements;
+  measurements.reserve(magnitudes.size());
+  for (std::size_t i = 0; i < magnitudes.size(); ++i) {
+    Measurement m(std::strtod(magnitudes[i].c_str(), nullptr),
+                  Units::getUnitByName(units[i]));
+    results.append(static_cast<int64_t>(i) + 1, m);
+    measurements.push_back(m);
+  }
+  const std::size_t bytes =
+      results.size() * (sizeof(double) + sizeof(uint8_t));
+  const double lower = 100.0;
+  const double upper = 10000.0;
+  std::cout << "Result filter, " << results.size() << " records:" << std::endl;
+
+  for (int withMedian = 0; withMedian < 2; ++withMedian) {
+    const std::string suffix = withMedian ? " + median" : "";
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    std::vector<Measurement> copy;
+    for (const Measurement& m : measurements) {
+      if (m.getUnit()->getType() == "Length" && m.getMagnitude() >= lower &&
+          m.getMagnitude() <= upper) {
+        copy.push_back(m);
+      }
+    }
+    double median = withMedian ? StatisticsCalculator::computeMedian(copy) : 0;
+    report("Measurement copy" + suffix, bytes, secondsSince(start),
+           copy.size());
+
+    start = std::chrono::steady_clock::now();
+    Selection selection = ResultFilter::byDimension(results, "Length") &
+                          ResultFilter::byMagnitude(results, lower, upper);
+    const double selectedMedian =
+        withMedian ? results.computeMedian(selection) : 0;
+    report("selection kernels" + suffix, bytes, secondsSince(start),
+           selection.count());
+    if (selectedMedian != median) {
+      std::cout << "  (medians differ)" << std::endl;
+    }
+  }
+}
+
+/**
+ * @brief Times rendering every length in km: converting each result through
+ * a Measurement and its unit's virtual conversions against the ReportUnits
+ * scale pass over the magnitude column.
+ */
+void benchReportUnits(const std::string& input) {
+  std::vector<std::string> magnitudes, units;
+  splitOperands(input, magnitudes, units);
+  ResultStore results;
+  for (std::size_t i = 0; i < magnitudes.size(); ++i) {
+    results.append(static_cast<int64_t>(i) + 1,
+                   Measurement(std::strtod(magnitudes[i].c_str(), nullptr),
+                               Units::getUnitByName(units[i])));
+  }
+  const std::size_t bytes = results.size() * sizeof(double);
+  std::cout << "Report units, " << results.size() << " records:" << std::endl;
+
+  std::shared_ptr<Units> kilometers = Units::getUnitByName("km");
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::vector<double> converted(results.size());
+  for (std::size_t row = 0; row < results.size(); ++row) {
+    Measurement m = results.getMeasurement(row);
+    converted[row] = m.getUnit()->getType() == kilometers->getType()
+                         ? kilometers->fromBaseUnit(
+                               m.getUnit()->toBaseUnit(m.getMagnitude()))
+                         : m.getMagnitude();
+  }
+  report("Measurement per result", bytes, secondsSince(start),
+         converted.size());
+
+  ReportUnits targets = ReportUnits::parse("km");
+  std::vector<std::string> labels;
+  start = std::chrono::steady_clock::now();
+  std::vector<double> scaled = targets.scale(results, labels);
+  report("ReportUnits scale pass", bytes, secondsSince(start), scaled.size());
+}
+
+/**
+ * @brief Times comparing two aligned files line by line: loading both with
+ * readFile and joining the stores, against LineDiff reading them in
+ * lockstep, and reports the result memory each holds.
+ */
+void benchLineDiff() {
+  const char* units[] = {"mm", "cm", "m", "km"};
+  const char* operators[] = {"+", "-"};
+  std::ostringstream year1Text, year2Text;
+  year1Text << std::fixed << std::setprecision(3);
+  year2Text << std::fixed << std::setprecision(3);
+  unsigned state = 2024;
+  while (static_cast<std::size_t>(year1Text.tellp()) < (16 << 20)) {
+    state = state * 1103515245 + 12345;
+    const bool isChanged = (state >> 16) % 20 == 0;  ///> 5% of the lines
+    int operands = 1 + (state >> 20) % 3;
+    for (int i = 0; i < operands; ++i) {
+      state = state * 1103515245 + 12345;
+      const double magnitude = 1 + ((state >> 12) % 1000000) / 1000.0;
+      const char* unit = units[(state >> 8) % 4];
+      if (i > 0) {
+        year1Text << ' ' << operators[(state >> 6) % 2] << ' ';
+        year2Text << ' ' << operators[(state >> 6) % 2] << ' ';
+      }
+      year1Text << magnitude << ' ' << unit;
+      year2Text << (isChanged && i == 0 ? magnitude * 3 : magnitude) << ' '
+                << unit;
+    }
+    year1Text << '\n';
+    year2Text << '\n';
+  }
+  const std::string year1Name = "bench_year1.txt";
+  const std::string year2Name = "bench_year2.txt";
+  std::ofstream(year1Name.c_str(), std::ios::binary) << year1Text.str();
+  std::ofstream(year2Name.c_str(), std::ios::binary) << year2Text.str();
+  const std::size_t bytes = year1Text.str().size() + year2Text.str().size();
+  std::cout << "Line diff, 2 x " << year1Text.str().size() / 1000000
+            << " MB:" << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  MeasurementFileProcessor whole1(year1Name), whole2(year2Name);
+  whole1.enableLogging(false);
+  whole2.enableLogging(false);
+  whole1.readFile();
+  whole2.readFile();
+  const ResultStore& results1 = whole1.getResults();
+  const ResultStore& results2 = whole2.getResults();
+  std::size_t changed = 0;
+  for (std::size_t row = 0; row < results1.size(); ++row) {
+    const double before = results1.getMagnitude(row) *
+                          results1.getUnit(row)->getBaseFactor();
+    const double after = results2.getMagnitude(row) *
+                         results2.getUnit(row)->getBaseFactor();
+    changed += std::fabs(after - before) / std::fabs(before) * 100 > 10;
+  }
+  report("readFile both, then join", bytes, secondsSince(start), changed);
+  std::cout << "    results held: "
+            << (results1.memoryUsage() + results2.memoryUsage()) / 1024
+            << " KiB" << std::endl;
+
+  start = std::chrono::steady_clock::now();
+  MeasurementFileProcessor year1(year1Name), year2(year2Name);
+  year1.enableLogging(false);
+  year2.enableLogging(false);
+  NullBuffer discard;
+  std::ostream out(&discard);
+  LineDiff diff(year1, year2, DiffMetric::PERCENT, 10);
+  const LineDiffStatistics& statistics = diff.run(out);
+  report("LineDiff lockstep", bytes, secondsSince(start),
+         statistics.reported);
+  std::cout << "    results held: "
+            << (year1.getResults().memoryUsage() +
+                year2.getResults().memoryUsage()) /
+                   1024
+            << " KiB" << std::endl;
+  std::remove(year1Name.c_str());
+  std::remove(year2Name.c_str());
+}
+
+/**
+ * @brief Times the query "select dim=Length where mag>500m stats mean,p99
+ * sort desc limit 20": the way a script over the reports answers it, copying
+ * the matching Measurements, converting them and sorting them all, against
+ * the compiled plan over the columns.
+ */
+void benchQuery(const std::string& input) {
+  std::vector<std::string> magnitudes, units;
+  splitOperands(input, magnitudes, units);
+  ResultStore results;
+  std::vector<Measurement> measurements;
+  measurements.reserve(magnitudes.size());
+  for (std::size_t i = 0; i < magnitudes.size(); ++i) {
+    Measurement m(std::strtod(magnitudes[i].c_str(), nullptr),
+                  Units::getUnitByName(units[i]));
+    results.append(static_cast<int64_t>(i) + 1, m);
+    measurements.push_back(m);
+  }
+  const std::size_t bytes =
+      results.size() * (sizeof(double) + sizeof(uint8_t));
+  std::cout << "Query, " << results.size() << " records:" << std::endl;
+
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  std::vector<double> base;
+  for (const Measurement& m : measurements) {
+    if (m.getUnit()->getType() == "Length") {
+      const double meters = m.getUnit()->toBaseUnit(m.getMagnitude());
+      if (meters > 500) {
+        base.push_back(meters);
+      }
+    }
+  }
+  std::sort(base.begin(), base.end(), std::greater<double>());
+  double mean = 0;
+  for (double value : base) {
+    mean += value;
+  }
+  mean /= base.size();
+  const double p99 =
+      base.empty() ? 0
+                   : base[base.size() - static_cast<std::size_t>(std::ceil(
+                                            0.99 * base.size()))];
+  report("Measurement copy + sort", bytes, secondsSince(start), base.size());
+
+  start = std::chrono::steady_clock::now();
+  Query query = Query::parse(
+      "select dim=Length where mag>500m stats mean,p99 sort desc limit 20");
+  QueryResult result = query.execute(results);
+  report("compiled query plan", bytes, secondsSince(start), result.matched);
+  if (result.matched != base.size() ||
+      std::fabs(result.statistics[1].second - p99) > 1e-9 * std::fabs(p99) ||
+      std::fabs(result.statistics[0].second - mean) > 1e-6 * std::fabs(mean)) {
+    std::cout << "  (results differ)" << std::endl;
+  }
+}
+
+/**
+ * @brief Times the first result of a one-line file: in process, from
+ * constructing a MeasurementFileProcessor to its first report line, and as
+ * a whole Unitify run (the binary next to this one) with and without
+ * --quiet, from spawn to exit, next to the cost of spawning /bin/true. The
+ * budget is 1 ms.
+ */
+void benchColdStart() {
+  const double budget = 1e-3;
+  ///> The runs write measurement_report.txt; keep it out of the way
+  char directory[] = "/tmp/unitify_cold_XXXXXX";
+  if (mkdtemp(directory) == nullptr) {
+    std::cout << "Time to first result: no temporary directory" << std::endl;
+    return;
+  }
+  const std::string year1Name = std::string(directory) + "/year1.txt";
+  const std::string year2Name = std::string(directory) + "/year2.txt";
+  const std::string reportName =
+      std::string(directory) + "/measurement_report.txt";
+  std::ofstream(year1Name.c_str()) << "3 m + 2 km\n";
+  std::ofstream(year2Name.c_str()) << "5 kg\n";
+  std::cout << "Time to first result, one-line files:" << std::endl;
+
+  std::vector<double> timings;
+  for (int run = 0; run < 101; ++run) {
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    MeasurementFileProcessor fileProcessor(year1Name);
+    fileProcessor.enableLogging(false);
+    fileProcessor.readFile();
+    std::vector<std::string> lines =
+        fileProcessor.generateReportsInOriginalOrder();
+    timings.push_back(secondsSince(start));
+    if (lines.size() != 1) {
+      std::cout << "  (no result)" << std::endl;
+    }
+  }
+  reportLatency("in process, first run", timings[0], budget);
+  reportLatency("in process, median", medianOf(timings), budget);
+
+  char self[4096];
+  const ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+  std::string binary = length > 0 ? std::string(self, length) : "";
+  binary = binary.substr(0, binary.rfind('/') + 1) + "Unitify";
+  if (access(binary.c_str(), X_OK) != 0) {
+    std::cout << "  (" << binary << " not built; process runs skipped)"
+              << std::endl;
+  } else {
+    ///> posix_spawn, unlike fork, does not copy this process's page tables,
+    ///> which would cost more than the run being timed
+    char previous[4096];
+    const bool isMoved =
+        getcwd(previous, sizeof(previous)) != nullptr && chdir(directory) == 0;
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+    ///> /bin/true shows what spawning any process costs on this machine
+    const char* names[] = {"spawn floor (/bin/true)", "Unitify, median",
+                           "Unitify --quiet, median"};
+    for (int variant = 0; variant < 3; ++variant) {
+      const std::string program = variant == 0 ? "/bin/true" : binary;
+      std::vector<char*> args;
+      args.push_back(const_cast<char*>(program.c_str()));
+      if (variant == 2) {
+        args.push_back(const_cast<char*>("--quiet"));
+      }
+      args.push_back(const_cast<char*>(year1Name.c_str()));
+      args.push_back(const_cast<char*>(year2Name.c_str()));
+      args.push_back(nullptr);
+      timings.clear();
+      for (int run = 0; run < 21; ++run) {
+        std::chrono::steady_clock::time_point start =
+            std::chrono::steady_clock::now();
+        pid_t child;
+        if (posix_spawn(&child, program.c_str(), &actions, nullptr,
+                        args.data(), environ) == 0) {
+          int status = 0;
+          waitpid(child, &status, 0);
+        }
+        timings.push_back(secondsSince(start));
+      }
+      reportLatency(names[variant], medianOf(timings), budget);
+    }
+    posix_spawn_file_actions_destroy(&actions);
+    if (isMoved && chdir(previous) != 0) {
+      std::cout << "  (could not return to " << previous << ")" << std::endl;
+    }
+  }
+  std::remove(reportName.c_str());
+  std::remove(year1Name.c_str());
+  std::remove(year2Name.c_str());
+  rmdir(directory);
+}
+
+/**
+ * @brief Main function to run all benchmarks.
+ * @return 0.
+ */
+int main() {
+  std::string input = makeInput(64 << 20);
+
+  // Benchmark line and token scanning
+  benchTextScanner(input);
+
+  // Benchmark magnitude parsing
+  benchFloatParsing(input);
+
+  // Benchmark CSV scanning
+  benchCsvScanning(input);
+
+  // Benchmark result export
+  benchResultExport(input);
+
+  // Benchmark random line access
+  benchLineIndex(input);
+
+  // Benchmark report output
+  benchOutputWriter(input);
+
+  // Benchmark input reader backends
+  benchInputReaders(input);
+
+  // Benchmark expression evaluation
+  benchExpressionKernels(input);
+
+  // Benchmark operator dispatch
+  benchOperatorDispatch();
+
+  // Benchmark result filtering
+  benchResultFilter(input);
+
+  // Benchmark report unit targeting
+  benchReportUnits(input);
+
+  // Benchmark the line-by-line diff
+  benchLineDiff();
+
+  // Benchmark the query plan
+  benchQuery(input);
+
+  // Benchmark the time to the first result
+  benchColdStart();
+
+  return 0;
+}
@@ -0,0 +1,223 @@
+/**
+ * @file CsvScanner.cpp
+ * @brief Implementation of the CsvScanner class.
+ *
+ * @version 0.1
+ */
+
+#include "CsvScanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define UNITIFY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+/**
+ * @brief Classifies bytes [64 * word, size) one at a time; used for tails.
+ */
+void classifyScalarFrom(const char* data, std::size_t size, char delimiter,
+                        std::size_t word, uint64_t* quotes,
+                        uint64_t* delimiters, uint64_t* newlines) {
+  for (std::size_t start = word * 64; start < size; start += 64, ++word) {
+    uint64_t quote = 0;
+    uint64_t separator = 0;
+    uint64_t newline = 0;
+    for (std::size_t b = 0; b < 64 && start + b < size; ++b) {
+      char c = data[start + b];
+      quote |= uint64_t(c == '"') << b;
+      separator |= uint64_t(c == delimiter) << b;
+      newline |= uint64_t(c == '\n') << b;
+    }
+    quotes[word] = quote;
+    delimiters[word] = separator;
+    newlines[word] = newline;
+  }
+}
+
+#ifdef UNITIFY_X86
+void classifySse2(const char* data, std::size_t size, char delimiter,
+                  uint64_t* quotes, uint64_t* delimiters, uint64_t* newlines) {
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i separator = _mm_set1_epi8(delimiter);
+  const __m128i newline = _mm_set1_epi8('\n');
+
+  std::size_t word = 0;
+  for (; (word + 1) * 64 <= size; ++word) {
+    uint64_t quoteMask = 0;
+    uint64_t separatorMask = 0;
+    uint64_t newlineMask = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+      __m128i bytes = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(data + word * 64 + lane * 16));
+      quoteMask |= uint64_t(static_cast<uint16_t>(
+                       _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, quote))))
+                   << (lane * 16);
+      separatorMask |= uint64_t(static_cast<uint16_t>(
+                           _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, separator))))
+                       << (lane * 16);
+      newlineMask |= uint64_t(static_cast<uint16_t>(
+                         _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newline))))
+                     << (lane * 16);
+    }
+    quotes[word] = quoteMask;
+    delimiters[word] = separatorMask;
+    newlines[word] = newlineMask;
+  }
+  classifyScalarFrom(data, size, delimiter, word, quotes, delimiters,
+                     newlines);
+}
+
+__attribute__((target("avx2"))) void classifyAvx2(
+    const char* data, std::size_t size, char delimiter, uint64_t* quotes,
+    uint64_t* delimiters, uint64_t* newlines) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i separator = _mm256_set1_epi8(delimiter);
+  const __m256i newline = _mm256_set1_epi8('\n');
+
+  std::size_t word = 0;
+  for (; (word + 1) * 64 <= size; ++word) {
+    uint64_t quoteMask = 0;
+    uint64_t separatorMask = 0;
+    uint64_t newlineMask = 0;
+    for (int lane = 0; lane < 2; ++lane) {
+      __m256i bytes = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(data + word * 64 + lane * 32));
+      quoteMask |= uint64_t(static_cast<uint32_t>(
+                       _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, quote))))
+                   << (lane * 32);
+      separatorMask |=
+          uint64_t(static_cast<uint32_t>(
+              _mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, separator))))
+          << (lane * 32);
+      newlineMask |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(
+                         _mm256_cmpeq_epi8(bytes, newline))))
+                     << (lane * 32);
+    }
+    quotes[word] = quoteMask;
+    delimiters[word] = separatorMask;
+    newlines[word] = newlineMask;
+  }
+  classifyScalarFrom(data, size, delimiter, word, quotes, delimiters,
+                     newlines);
+}
+#endif
+
+/**
+ * @brief Sets each bit to the XOR of itself and every bit below it, so the
+ * bytes between an opening and a closing quote come out set.
+ */
+inline uint64_t prefixXor(uint64_t bits) {
+  bits ^= bits << 1;
+  bits ^= bits << 2;
+  bits ^= bits << 4;
+  bits ^= bits << 8;
+  bits ^= bits << 16;
+  bits ^= bits << 32;
+  return bits;
+}
+}  // namespace
+
+std::size_t ScannedRecords::recordCount() const {
+  return recordEnds.size();
+}
+
+void CsvScanner::classify(const char* data, std::size_t size, char delimiter,
+                          uint64_t* quotes, uint64_t* delimiters,
+                          uint64_t* newlines, ScanBackend backend) {
+#ifdef UNITIFY_X86
+  if (backend == ScanBackend::AVX2) {
+    classifyAvx2(data, size, delimiter, quotes, delimiters, newlines);
+    return;
+  } else if (backend == ScanBackend::SSE2) {
+    classifySse2(data, size, delimiter, quotes, delimiters, newlines);
+    return;
+  }
+#endif
+  (void)backend;
+  classifyScalarFrom(data, size, delimiter, 0, quotes, delimiters, newlines);
+}
+
+std::size_t CsvScanner::scanRecords(const char* data, std::size_t size,
+                                    bool isLast, char delimiter,
+                                    ScannedRecords& out) {
+  out.fields.clear();
+  out.recordEnds.clear();
+  out.recordFieldEnds.clear();
+  const std::size_t words = (size + 63) / 64;
+  out.quoteMasks.resize(words);
+  out.delimiterMasks.resize(words);
+  out.newlineMasks.resize(words);
+  classify(data, size, delimiter, out.quoteMasks.data(),
+           out.delimiterMasks.data(), out.newlineMasks.data(),
+           TextScanner::getDefaultBackend());
+
+  uint32_t fieldBegin = 0;
+  uint64_t inside = 0;  ///> All ones if the previous word ended in quotes
+  for (std::size_t word = 0; word < words; ++word) {
+    const uint64_t quoted = prefixXor(out.quoteMasks[word]) ^ inside;
+    inside = uint64_t(0) - (quoted >> 63);
+    const uint64_t newlines = out.newlineMasks[word] & ~quoted;
+    uint64_t separators = (out.delimiterMasks[word] & ~quoted) | newlines;
+
+    const uint32_t base = static_cast<uint32_t>(word * 64);
+    while (separators != 0) {
+      const int bit = __builtin_ctzll(separators);
+      const uint32_t end = base + bit;
+      if ((newlines >> bit) & 1) {
+        ///> CRLF: the '\r' ends the last field, not the '\n'
+        const uint32_t fieldEnd =
+            end > fieldBegin && data[end - 1] == '\r' ? end - 1 : end;
+        out.fields.push_back(TokenSpan{fieldBegin, fieldEnd - fieldBegin});
+        out.recordEnds.push_back(end);
+        out.recordFieldEnds.push_back(
+            static_cast<uint32_t>(out.fields.size()));
+      } else {
+        out.fields.push_back(TokenSpan{fieldBegin, end - fieldBegin});
+      }
+      fieldBegin = end + 1;
+      separators &= separators - 1;
+    }
+  }
+
+  std::size_t consumed = out.recordEnds.empty() ? 0 : out.recordEnds.back() + 1;
+  if (isLast && consumed < size) {
+    const uint32_t end = static_cast<uint32_t>(size);
+    const uint32_t fieldEnd =
+        end > fieldBegin && data[end - 1] == '\r' ? end - 1 : end;
+    out.fields.push_back(TokenSpan{fieldBegin, fieldEnd - fieldBegin});
+    out.recordEnds.push_back(end);
+    out.recordFieldEnds.push_back(static_cast<uint32_t>(out.fields.size()));
+    consumed = size;
+  }
+  out.fields.resize(out.recordFieldEnds.empty() ? 0
+                                                : out.recordFieldEnds.back());
+  return consumed;
+}
+
+bool CsvScanner::isQuoted(const char* data, const TokenSpan& field) {
+  return field.length != 0 && data[field.begin] == '"';
+}
+
+std::string CsvScanner::getFieldText(const char* data,
+                                     const TokenSpan& field) {
+  const char* first = data + field.begin;
+  const char* last = first + field.length;
+  if (!isQuoted(data, field)) {
+    return std::string(first, last);
+  }
+  std::string text;
+  text.reserve(field.length);
+  for (const char* c = first + 1; c != last; ++c) {
+    if (*c == '"') {
+      if (c + 1 == last || c[1] != '"') {
+        ///> The closing quote; anything after it is kept as is
+        text.append(c + 1, last);
+        break;
+      }
+      ++c;  ///> "" is one quote
+    }
+    text += *c;
+  }
+  return text;
+}
@@ -0,0 +1,452 @@
+/**
+ * @file DiffUnitify.cpp
+ * @brief Differential test of the Unitify fast paths against the reference
+ * evaluator.
+ *
+ * This file generates random expression lines from a seed and evaluates each
+ * one with two engines:
+ *  - reference: processLine, then the stack machine of
+ *    processOperatorsWithPEMDAS and applyOperation, as the original code
+ *    did.
+ *  - fast: parseLine (the TextScanner and token fast path readFile uses),
+ *    then processOperatorsWithPEMDAS with the ExpressionKernels.
+ * The parsed operands and operators, the result and any error must match
+ * exactly. A mismatching line is shrunk (tokens dropped, characters cut)
+ * while it still mismatches, and printed next to the original. Both engines
+ * are timed, so a fast path is checked for speed and correctness in one run.
+ *
+ * The reference semantics are compared as they are, quirks included.
+ * Precedence is that of the precedence enum in the header (* and / above +
+ * and -; a file-scope enum in MeasurementFileProcessor.cpp that ranked them
+ * the other way never took effect): "2 m + 3 m * 4 m" is 14 m. Magnitudes
+ * operator>> rejects end the line, unknown operators are skipped, and
+ * operands of different units fail the line. The generator aims at all of
+ * these.
+ *
+ * Usage: UnitifyDiff [lines] [seed]. CTest runs a short pass; run millions of
+ * lines from a Release build.
+ *
+ * @version 0.1
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "AsyncWriter.h"
+#include "Measurement.h"
+#include "MeasurementFileProcessor.h"
+#include "Units.h"
+
+namespace {
+const std::size_t BATCH_LINES = 1 << 16;  ///< Lines generated per batch.
+const std::size_t MAX_REPORTED = 10;      ///< Mismatches printed in full.
+
+/**
+ * @brief Discards everything written to it; the evaluator logs every line.
+ */
+class NullBuffer : public std::streambuf {
+ protected:
+  int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+  std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+/**
+ * @brief What one engine made of a line.
+ */
+struct Outcome {
+  std::vector<Measurement> operands;  ///< The parsed operands.
+  std::vector<char> operators;        ///< The parsed operators.
+  bool hasResult;                     ///< Whether the line evaluated.
+  double magnitude;                   ///< The result, if it evaluated.
+  std::shared_ptr<Units> unit;        ///< The unit of the result.
+  std::string error;                  ///< The error, if it did not.
+  bool isFastPath;                    ///< Whether the token fast path parsed it.
+
+  Outcome() : hasResult(false), magnitude(0), isFastPath(false) {}
+};
+
+void evaluate(MeasurementFileProcessor& processor, Outcome& outcome) {
+  outcome.hasResult = false;
+  outcome.error.clear();
+  try {
+    Measurement result = processor.processOperatorsWithPEMDAS(
+        outcome.operands, outcome.operators);
+    outcome.magnitude = result.getMagnitude();
+    outcome.unit = result.getUnit();
+    outcome.hasResult = true;
+  } catch (const std::exception& e) {
+    outcome.error = e.what();
+  }
+}
+
+void evaluateReference(MeasurementFileProcessor& processor,
+                       const std::string& line, Outcome& outcome) {
+  outcome.operands.clear();
+  outcome.operators.clear();
+  processor.processLine(line, 1, outcome.operands, outcome.operators);
+  outcome.isFastPath = false;
+  evaluate(processor, outcome);
+}
+
+void evaluateFast(MeasurementFileProcessor& processor, const std::string& line,
+                  Outcome& outcome) {
+  outcome.operands.clear();
+  outcome.operators.clear();
+  outcome.isFastPath =
+      processor.parseLine(line, 1, outcome.operands, outcome.operators);
+  evaluate(processor, outcome);
+}
+
+/**
+ * @brief Compares bit patterns, so -0 differs from 0 and NaN matches NaN.
+ */
+bool isSameDouble(double a, double b) {
+  return std::memcmp(&a, &b, sizeof a) == 0 || (std::isnan(a) && std::isnan(b));
+}
+
+bool isSameMeasurement(double aMagnitude, const Units& aUnit,
+                       double bMagnitude, const Units& bUnit) {
+  return isSameDouble(aMagnitude, bMagnitude) &&
+         aUnit.getName() == bUnit.getName() &&
+         aUnit.getType() == bUnit.getType() &&
+         isSameDouble(aUnit.getBaseFactor(), bUnit.getBaseFactor());
+}
+
+bool isSameOutcome(const Outcome& a, const Outcome& b) {
+  if (a.operands.size() != b.operands.size() || a.operators != b.operators ||
+      a.hasResult != b.hasResult || a.error != b.error) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.operands.size(); ++i) {
+    const Measurement& x = a.operands[i];
+    const Measurement& y = b.operands[i];
+    if (!isSameMeasurement(x.getMagnitude(), *x.getUnit(), y.getMagnitude(),
+                           *y.getUnit())) {
+      return false;
+    }
+  }
+  return !a.hasResult ||
+         isSameMeasurement(a.magnitude, *a.unit, b.magnitude, *b.unit);
+}
+
+std::string describe(const Outcome& outcome) {
+  std::ostringstream oss;
+  oss << std::setprecision(17) << "[";
+  for (std::size_t i = 0; i < outcome.operands.size(); ++i) {
+    const Measurement& m = outcome.operands[i];
+    if (i > 0) {
+      oss << ' ' << (i - 1 < outcome.operators.size()
+                         ? std::string(1, outcome.operators[i - 1])
+                         : std::string("?"))
+          << ' ';
+    }
+    oss << m.getMagnitude() << ' ' << m.getUnit()->getName() << "*"
+        << m.getUnit()->getBaseFactor();
+  }
+  oss << "] -> ";
+  if (outcome.hasResult) {
+    oss << outcome.magnitude << ' ' << outcome.unit->getName();
+  } else {
+    oss << "error \"" << outcome.error << "\"";
+  }
+  return oss.str();
+}
+
+/**
+ * @brief Runs both engines on a line with their logging discarded.
+ */
+bool isMismatch(MeasurementFileProcessor& referenceProcessor,
+                MeasurementFileProcessor& fastProcessor,
+                const std::string& line, Outcome& reference, Outcome& fast) {
+  NullBuffer sink;
+  StreamRedirect out(std::cout, sink);
+  StreamRedirect err(std::cerr, sink);
+  evaluateReference(referenceProcessor, line, reference);
+  evaluateFast(fastProcessor, line, fast);
+  return !isSameOutcome(reference, fast);
+}
+
+std::vector<std::string> splitTokens(const std::string& line) {
+  std::istringstream ss(line);
+  std::vector<std::string> tokens;
+  std::string token;
+  while (ss >> token) {
+    tokens.push_back(token);
+  }
+  return tokens;
+}
+
+std::string joinTokens(const std::vector<std::string>& tokens) {
+  std::string line;
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    line += (i > 0 ? " " : "") + tokens[i];
+  }
+  return line;
+}
+
+/**
+ * @brief Shrinks a mismatching line while it keeps mismatching: whitespace
+ * is normalized, then tokens are dropped and characters cut one step at a time
+ * until no single step keeps the mismatch.
+ */
+std::string minimize(MeasurementFileProcessor& referenceProcessor,
+                     MeasurementFileProcessor& fastProcessor,
+                     std::string line) {
+  Outcome reference, fast;
+  auto isKept = [&](const std::string& candidate) {
+    return isMismatch(referenceProcessor, fastProcessor, candidate, reference,
+                      fast);
+  };
+  std::string candidate = joinTokens(splitTokens(line));
+  if (candidate != line && isKept(candidate)) {
+    line = candidate;
+  }
+  if (candidate != line) {
+    return line;  ///> The whitespace itself matters
+  }
+
+  bool isShrunk = true;
+  while (isShrunk) {
+    isShrunk = false;
+    std::vector<std::string> tokens = splitTokens(line);
+    ///> Whole "operator magnitude unit" groups first, then single tokens
+    for (std::size_t width = 3; width > 0 && !isShrunk; --width) {
+      for (std::size_t i = 0; i + width <= tokens.size() && !isShrunk; ++i) {
+        std::vector<std::string> fewer(tokens);
+        fewer.erase(fewer.begin() + i, fewer.begin() + i + width);
+        candidate = joinTokens(fewer);
+        if (isKept(candidate)) {
+          line = candidate;
+          isShrunk = true;
+        }
+      }
+    }
+    for (std::size_t i = 0; i < tokens.size() && !isShrunk; ++i) {
+      for (std::size_t c = 0; c < tokens[i].size() && !isShrunk; ++c) {
+        std::vector<std::string> shorter(tokens);
+        shorter[i].erase(c, 1);
+        if (shorter[i].empty()) {
+          continue;
+        }
+        candidate = joinTokens(shorter);
+        if (isKept(candidate)) {
+          line = candidate;
+          isShrunk = true;
+        }
+      }
+    }
+  }
+  return line;
+}
+
+/**
+ * @brief Random expression lines: mostly well formed, with a steady share of
+ * the inputs the two parsers could disagree on.
+ */
+class LineGenerator {
+ private:
+  uint64_t state;  ///< xorshift64* state.
+
+  uint64_t next() {
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+  }
+
+  unsigned pick(unsigned count) {
+    return static_cast<unsigned>((next() >> 33) % count);
+  }
+
+  std::string magnitude() {
+    static const char* const edges[] = {
+        "0",      "-0",     "+5",      ".5",       "5.",       "-.25",
+        "1e3",    "1E-3",   "2.5e+2",  "1e308",    "1e309",    "-1e309",
+        "2.2250738585072014e-308",     "1e-310",   "1e-400",   "0x1A",
+        "inf",    "nan",    "1,5",     "abc",      "1e",       "--1",
+        "12345678901234567890123",     "0.1000000000000000055511151231257827",
+        "9007199254740993",            "00012.500"};
+    const unsigned kind = pick(16);
+    if (kind == 0) {
+      return edges[pick(sizeof edges / sizeof edges[0])];
+    }
+    std::ostringstream oss;
+    if (kind == 1) {
+      oss << std::setprecision(17) << static_cast<double>(next() >> 11) /
+                                          static_cast<double>(1ULL << 53) *
+                                          std::pow(10.0, pick(40) - 20.0);
+    } else if (kind == 2) {
+      oss << (pick(2) ? "-" : "") << pick(100000);
+    } else {
+      oss << std::fixed << std::setprecision(pick(5))
+          << pick(1000000) / 1000.0;
+    }
+    return oss.str();
+  }
+
+  std::string unit(const std::string& family) {
+    static const char* const strays[] = {"furlong", "M", "KM", "", "m2",
+                                         "meter"};
+    if (pick(40) == 0) {
+      return strays[pick(sizeof strays / sizeof strays[0])];
+    }
+    return family;
+  }
+
+  std::string op() {
+    static const char* const strays[] = {"%", "x", "**", "+-", "^", "//"};
+    if (pick(30) == 0) {
+      return strays[pick(sizeof strays / sizeof strays[0])];
+    }
+    static const char* const operators[] = {"+", "-", "*", "/"};
+    return operators[pick(4)];
+  }
+
+  std::string gap() {
+    static const char* const gaps[] = {"  ", "\t", " \t "};
+    return pick(20) == 0 ? gaps[pick(3)] : " ";
+  }
+
+ public:
+  explicit LineGenerator(uint64_t seed) : state(seed | 1) {}
+
+  std::string line() {
+    static const char* const units[] = {
+        "ug", "mg", "cg", "dg", "g",  "kg", "grams",      "um",
+        "mm", "cm", "dm", "m",  "km", "meters", "ms", "s", "seconds"};
+    const std::size_t unitCount = sizeof units / sizeof units[0];
+    ///> Operands share a unit family most of the time, so lines evaluate
+    const std::string family = units[pick(unitCount)];
+    const unsigned operands = pick(50) == 0 ? 0 : 1 + pick(4);
+
+    std::string text = pick(30) == 0 ? gap() : "";
+    for (unsigned i = 0; i < operands; ++i) {
+      if (i > 0) {
+        text += gap() + op() + gap();
+      }
+      const std::string u =
+          pick(8) == 0 ? units[pick(unitCount)] : unit(family);
+      text += magnitude() + (pick(60) == 0 ? "" : gap()) + u;
+    }
+    if (pick(40) == 0) {
+      text += " " + op();  ///> A dangling operator
+    }
+    if (pick(40) == 0) {
+      text += pick(2) ? "\r" : " ";
+    }
+    return text;
+  }
+};
+
+/**
+ * @brief Lines that pin the quirks of the reference evaluator.
+ */
+const char* const SEED_LINES[] = {
+    "2 m + 3 m * 4 m",     ///> 14 m: the header's precedence enum wins
+    "8 m / 2 m - 2 m",     ///> 8 / (2 - 2): division by zero
+    "1 km + 500 m",        ///> Both name "m", so they add in base units
+    "5 m + 3 kg",          ///> Units differ
+    "5 m % 3 m",           ///> The unknown operator is skipped
+    "5 m +",               ///> Not enough operands
+    "",                    ///> No result
+    "1e309 m",             ///> Out of range for operator>>
+    "1e-310 m + 1 m",      ///> Subnormal
+};
+
+void report(const std::string& name, std::size_t bytes, double seconds,
+            std::size_t lines) {
+  std::cout << "  " << std::left << std::setw(28) << name << std::right
+            << std::fixed << std::setprecision(1) << std::setw(9)
+            << bytes / seconds / 1e6 << " MB/s  " << std::setw(11)
+            << lines / seconds << " lines/s" << std::endl;
+}
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const std::size_t lineCount =
+      argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  const uint64_t seed = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2024;
+  std::cout << "Differential test, " << lineCount << " lines, seed " << seed
+            << ":" << std::endl;
+
+  MeasurementFileProcessor referenceProcessor("-");
+  MeasurementFileProcessor fastProcessor("-");
+  referenceProcessor.enableExpressionKernels(false);
+  LineGenerator generator(seed);
+  std::vector<std::string> lines;
+  std::vector<Outcome> references(BATCH_LINES), fasts(BATCH_LINES);
+  std::size_t bytes = 0, fastPathLines = 0, resultLines = 0, mismatches = 0;
+  double referenceSeconds = 0, fastSeconds = 0;
+
+  const std::size_t seedCount = sizeof SEED_LINES / sizeof SEED_LINES[0];
+  for (std::size_t done = 0; done < lineCount;) {
+    lines.clear();
+    for (std::size_t i = 0; i < BATCH_LINES && done + i < lineCount; ++i) {
+      lines.push_back(done + i < seedCount ? SEED_LINES[done + i]
+                                           : generator.line());
+      bytes += lines.back().size() + 1;
+    }
+    done += lines.size();
+
+    {
+      NullBuffer sink;
+      StreamRedirect out(std::cout, sink);
+      StreamRedirect err(std::cerr, sink);
+      std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < lines.size(); ++i) {
+        evaluateReference(referenceProcessor, lines[i], references[i]);
+      }
+      std::chrono::steady_clock::time_point middle =
+          std::chrono::steady_clock::now();
+      for (std::size_t i = 0; i < lines.size(); ++i) {
+        evaluateFast(fastProcessor, lines[i], fasts[i]);
+      }
+      std::chrono::steady_clock::time_point end =
+          std::chrono::steady_clock::now();
+      referenceSeconds += std::chrono::duration<double>(middle - start).count();
+      fastSeconds += std::chrono::duration<double>(end - middle).count();
+    }
+
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+      fastPathLines += fasts[i].isFastPath;
+      resultLines += references[i].hasResult;
+      if (isSameOutcome(references[i], fasts[i])) {
+        continue;
+      }
+      if (++mismatches <= MAX_REPORTED) {
+        std::string repro =
+            minimize(referenceProcessor, fastProcessor, lines[i]);
+        Outcome reference, fast;
+        isMismatch(referenceProcessor, fastProcessor, repro, reference, fast);
+        std::cout << "  MISMATCH on \"" << lines[i] << "\"" << std::endl
+                  << "    repro:     \"" << repro << "\"" << std::endl
+                  << "    reference: " << describe(reference) << std::endl
+                  << "    fast:      " << describe(fast) << std::endl;
+      }
+    }
+  }
+
+  std::cout << "  " << lineCount << " lines, " << resultLines
+            << " with a result, " << fastPathLines
+            << " on the token fast path, " << mismatches << " mismatches"
+            << std::endl;
+  report("reference (processLine)", bytes, referenceSeconds, lineCount);
+  report("fast (parseLine + kernels)", bytes, fastSeconds, lineCount);
+
+  if (mismatches > 0) {
+    std::cout << "Differential test failed." << std::endl;
+    return 1;
+  }
+  std::cout << "Differential test passed." << std::endl;
+  return 0;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file ExpressionKernels.cpp
+ * @brief Implementation of the ExpressionKernels class.
+ *
+ * Built with -ffp-contract=off: fusing a conversion and an addition into one
+ * fused multiply-add would round differently from applyOperation.
+ *
+ * @version 0.1
+ */
+
+#include "ExpressionKernels.h"
+#include <memory>
+#include <typeinfo>
+#include "Operators.h"
+#include "Units.h"
+
+namespace {
+/**
+ * @brief The first shape of lines with a given number of operands.
+ */
+constexpr int getFirstShape(int operands) {
+  return operands <= 1
+             ? 0
+             : getFirstShape(operands - 1) + (1 << (2 * (operands - 2)));
+}
+
+constexpr int getOperandCount(int shape) {
+  return shape < getFirstShape(2) ? 1
+         : shape < getFirstShape(3) ? 2
+         : shape < getFirstShape(4) ? 3
+                                    : 4;
+}
+
+/**
+ * @brief The opcode at a position of a shape.
+ */
+constexpr Operators::Opcode getShapeOperator(int shape, int position) {
+  return static_cast<Operators::Opcode>(
+      ((shape - getFirstShape(getOperandCount(shape))) >> (2 * position)) & 3);
+}
+
+/**
+ * @brief One operation of applyOperation, in base units. A zero divisor
+ * clears isValid; the caller then hands the line to the stack machine.
+ */
+template <Operators::Opcode OP>
+inline double apply(double left, double right, bool& isValid);
+
+template <>
+inline double apply<Operators::ADD>(double left, double right, bool&) {
+  return left + right;
+}
+
+template <>
+inline double apply<Operators::SUBTRACT>(double left, double right, bool&) {
+  return left - right;
+}
+
+template <>
+inline double apply<Operators::MULTIPLY>(double left, double right, bool&) {
+  return left * right;
+}
+
+template <>
+inline double apply<Operators::DIVIDE>(double left, double right,
+                                       bool& isValid) {
+  isValid &= right != 0;
+  return left / right;
+}
+
+/**
+ * @brief The kernel of one operand count and operator sequence. The
+ * evaluation order is the one the stack machine arrives at, from the same
+ * Operators tables; every branch below is on constants, so each
+ * instantiation is straight-line code.
+ */
+template <int OPERANDS, Operators::Opcode O1, Operators::Opcode O2,
+          Operators::Opcode O3>
+struct Evaluate;
+
+template <Operators::Opcode O1, Operators::Opcode O2, Operators::Opcode O3>
+struct Evaluate<1, O1, O2, O3> {
+  static bool run(const double* m, const double*, double& result) {
+    result = m[0];  ///> A lone operand is returned as written
+    return true;
+  }
+};
+
+template <Operators::Opcode O1, Operators::Opcode O2, Operators::Opcode O3>
+struct Evaluate<2, O1, O2, O3> {
+  static bool run(const double* m, const double* f, double& result) {
+    bool isValid = true;
+    result = apply<O1>(m[0] * f[0], m[1] * f[1], isValid);
+    return isValid;
+  }
+};
+
+template <Operators::Opcode O1, Operators::Opcode O2, Operators::Opcode O3>
+struct Evaluate<3, O1, O2, O3> {
+  static bool run(const double* m, const double* f, double& result) {
+    bool isValid = true;
+    const double a = m[0] * f[0], b = m[1] * f[1], c = m[2] * f[2];
+    if (Operators::isAppliedBefore(O1, O2)) {
+      result = apply<O2>(apply<O1>(a, b, isValid), c, isValid);
+    } else {
+      result = apply<O1>(a, apply<O2>(b, c, isValid), isValid);
+    }
+    return isValid;
+  }
+};
+
+template <Operators::Opcode O1, Operators::Opcode O2, Operators::Opcode O3>
+struct Evaluate<4, O1, O2, O3> {
+  static bool run(const double* m, const double* f, double& result) {
+    bool isValid = true;
+    const double a = m[0] * f[0], b = m[1] * f[1], c = m[2] * f[2],
+                 d = m[3] * f[3];
+    if (Operators::isAppliedBefore(O1, O2)) {
+      const double ab = apply<O1>(a, b, isValid);
+      if (Operators::isAppliedBefore(O2, O3)) {
+        result = apply<O3>(apply<O2>(ab, c, isValid), d, isValid);
+      } else {
+        result = apply<O2>(ab, apply<O3>(c, d, isValid), isValid);
+      }
+    } else if (Operators::isAppliedBefore(O2, O3)) {
+      ///> b O2 c is reduced when O3 arrives, then O1 if it ranks as high
+      const double bc = apply<O2>(b, c, isValid);
+      if (Operators::isAppliedBefore(O1, O3)) {
+        result = apply<O3>(apply<O1>(a, bc, isValid), d, isValid);
+      } else {
+        result = apply<O1>(a, apply<O3>(bc, d, isValid), isValid);
+      }
+    } else {
+      result = apply<O1>(
+          a, apply<O2>(b, apply<O3>(c, d, isValid), isValid), isValid);
+    }
+    return isValid;
+  }
+};
+
+template <int SHAPE>
+struct ShapeKernel {
+  static bool run(const double* m, const double* f, double& result) {
+    return Evaluate<getOperandCount(SHAPE), getShapeOperator(SHAPE, 0),
+                    getShapeOperator(SHAPE, 1),
+                    getShapeOperator(SHAPE, 2)>::run(m, f, result);
+  }
+};
+
+/**
+ * @brief The shapes 0..N-1, to expand the table from.
+ */
+template <int... SHAPES>
+struct ShapeList {};
+
+template <int N, int... SHAPES>
+struct MakeShapeList : MakeShapeList<N - 1, N - 1, SHAPES...> {};
+
+template <int... SHAPES>
+struct MakeShapeList<0, SHAPES...> {
+  typedef ShapeList<SHAPES...> type;
+};
+
+template <typename LIST>
+struct KernelTable;
+
+template <int... SHAPES>
+struct KernelTable<ShapeList<SHAPES...>> {
+  static const ExpressionKernels::Kernel kernels[sizeof...(SHAPES)];
+};
+
+template <int... SHAPES>
+const ExpressionKernels::Kernel
+    KernelTable<ShapeList<SHAPES...>>::kernels[sizeof...(SHAPES)] = {
+        &ShapeKernel<SHAPES>::run...};
+
+typedef KernelTable<MakeShapeList<ExpressionKernels::SHAPE_COUNT>::type>
+    Kernels;
+
+static_assert(getFirstShape(ExpressionKernels::MAX_OPERANDS + 1) ==
+                  ExpressionKernels::SHAPE_COUNT,
+              "SHAPE_COUNT must cover every shape up to MAX_OPERANDS");
+}  // namespace
+
+const std::size_t ExpressionKernels::MAX_OPERANDS;
+const int ExpressionKernels::SHAPE_COUNT;
+
+int ExpressionKernels::getShape(const std::vector<char>& operators,
+                                std::size_t operandCount) {
+  if (operandCount == 0 || operandCount > MAX_OPERANDS ||
+      operators.size() + 1 != operandCount) {
+    return -1;
+  }
+  int digits = 0;
+  for (std::size_t i = 0; i < operators.size(); ++i) {
+    const Operators::Opcode opcode = Operators::getOpcode(operators[i]);
+    if (opcode == Operators::INVALID) {
+      return -1;
+    }
+    digits |= opcode << (2 * i);
+  }
+  return getFirstShape(static_cast<int>(operandCount)) + digits;
+}
+
+ExpressionKernels::Kernel ExpressionKernels::getKernel(int shape) {
+  return Kernels::kernels[shape];
+}
+
+bool ExpressionKernels::evaluate(const std::vector<Measurement>& measurements,
+                                 const std::vector<char>& operators,
+                                 double& magnitude) {
+  const int shape = getShape(operators, measurements.size());
+  if (shape < 0) {
+    return false;
+  }
+  ///> applyOperation compares unit names; the kernels also need one type
+  const std::shared_ptr<Units> first = measurements[0].getUnit();
+  double magnitudes[MAX_OPERANDS];
+  double factors[MAX_OPERANDS];
+  for (std::size_t i = 0; i < measurements.size(); ++i) {
+    const std::shared_ptr<Units> unit = measurements[i].getUnit();
+    if (i > 0 && (!(*unit == first) || typeid(*unit) != typeid(*first))) {
+      return false;
+    }
+    magnitudes[i] = measurements[i].getMagnitude();
+    factors[i] = unit->getBaseFactor();
+  }
+  return Kernels::kernels[shape](magnitudes, factors, magnitude);
+}
@@ -0,0 +1,350 @@
+/**
+ * @file FastFloat.cpp
+ * @brief Implementation of the FastFloat class.
+ *
+ * The Eisel-Lemire step follows Lemire, "Number Parsing at a Gigabyte per
+ * Second" (2021), and the fast_float library it describes.
+ *
+ * @version 0.1
+ */
+
+#include "FastFloat.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+const int SMALLEST_POWER = -342;  ///< Below this, any mantissa rounds to 0.
+const int LARGEST_POWER = 308;    ///< Above this, any mantissa overflows.
+const int MAX_DIGITS = 19;        ///< Every 19-digit mantissa fits uint64.
+const int MANTISSA_BITS = 52;     ///< Explicit mantissa bits of a double.
+
+const double EXACT_POWERS[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                               1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                               1e18, 1e19, 1e20, 1e21, 1e22};  ///< Exact.
+
+/**
+ * @struct PowerTable
+ * @brief 128-bit truncated, normalized powers of five for 10^-342..10^308.
+ *
+ * The table is built once, on first use, with a small big-integer routine
+ * rather than shipped as 1302 literals. For q >= 0 an entry is the top 128
+ * bits of 5^q; for q < 0 it is the top 128 bits of floor(2^b / 5^-q) + 1
+ * with b = bitlength(5^-q) + 127 for q >= -27 and 2 * bitlength(5^-q) + 128
+ * below, as in fast_float.
+ */
+struct PowerTable {
+  uint64_t entries[2 * (LARGEST_POWER - SMALLEST_POWER + 1)];
+
+  typedef std::vector<uint32_t> BigInt;  ///< Little-endian 32-bit limbs.
+
+  static void multiplySmall(BigInt& v, uint32_t m) {
+    uint64_t carry = 0;
+    for (auto& limb : v) {
+      uint64_t product = uint64_t(limb) * m + carry;
+      limb = static_cast<uint32_t>(product);
+      carry = product >> 32;
+    }
+    if (carry != 0) {
+      v.push_back(static_cast<uint32_t>(carry));
+    }
+  }
+
+  static void divideSmall(BigInt& v, uint32_t d) {
+    uint64_t remainder = 0;
+    for (std::size_t i = v.size(); i-- > 0;) {
+      uint64_t current = (remainder << 32) | v[i];
+      v[i] = static_cast<uint32_t>(current / d);
+      remainder = current % d;
+    }
+    while (!v.empty() && v.back() == 0) {
+      v.pop_back();
+    }
+  }
+
+  static int bitLength(const BigInt& v) {
+    return v.empty() ? 0
+                     : static_cast<int>(v.size() * 32) -
+                           __builtin_clz(v.back());
+  }
+
+  static bool bitAt(const BigInt& v, int position) {
+    if (position < 0 || position >= static_cast<int>(v.size() * 32)) {
+      return false;
+    }
+    return (v[position / 32] >> (position % 32)) & 1;
+  }
+
+  /**
+   * @brief Stores the top 128 bits of v, zero-filled if v is shorter.
+   */
+  static void store(const BigInt& v, uint64_t* entry) {
+    int top = bitLength(v) - 1;
+    entry[0] = 0;
+    entry[1] = 0;
+    for (int i = 0; i < 128; ++i) {
+      entry[i / 64] |= uint64_t(bitAt(v, top - i)) << (63 - i % 64);
+    }
+  }
+
+  static void increment(BigInt& v) {
+    for (auto& limb : v) {
+      if (++limb != 0) {
+        return;
+      }
+    }
+    v.push_back(1);
+  }
+
+  static BigInt shiftRight(const BigInt& v, int shift) {
+    BigInt result;
+    int limbShift = shift / 32;
+    int bitShift = shift % 32;
+    for (std::size_t i = limbShift; i < v.size(); ++i) {
+      uint64_t low = v[i] >> bitShift;
+      uint64_t high = (bitShift != 0 && i + 1 < v.size())
+                          ? uint64_t(v[i + 1]) << (32 - bitShift)
+                          : 0;
+      result.push_back(static_cast<uint32_t>(low | high));
+    }
+    while (!result.empty() && result.back() == 0) {
+      result.pop_back();
+    }
+    return result;
+  }
+
+  PowerTable() {
+    ///> Positive powers: the top 128 bits of 5^q, left-aligned
+    BigInt power(1, 1);
+    for (int q = 0; q <= LARGEST_POWER; ++q) {
+      store(power, entries + 2 * (q - SMALLEST_POWER));
+      multiplySmall(power, 5);
+    }
+
+    ///> Negative powers: quotient = floor(2^B / 5^n) by repeated division,
+    ///> so floor(2^b / 5^n) is quotient >> (B - b) for any b <= B
+    const int totalBits = 1760;
+    BigInt quotient(totalBits / 32 + 1, 0);
+    quotient.back() = 1;
+    BigInt power5(1, 1);
+    for (int n = 1; n <= -SMALLEST_POWER; ++n) {
+      divideSmall(quotient, 5);
+      multiplySmall(power5, 5);
+      ///> Up to 5^27 the quotient is taken to exactly 128 bits
+      int b = n <= 27 ? bitLength(power5) + 127 : 2 * bitLength(power5) + 128;
+      BigInt value = shiftRight(quotient, totalBits - b);
+      increment(value);
+      store(value, entries + 2 * (-n - SMALLEST_POWER));
+    }
+  }
+};
+
+const uint64_t* powersOfFive() {
+  static const PowerTable table;
+  return table.entries;
+}
+
+inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+inline uint64_t readEight(const char* p) {
+  uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;  ///> Little-endian: the first character is the low byte
+}
+
+/**
+ * @brief Checks that all 8 bytes are ASCII digits, in one expression.
+ */
+inline bool isEightDigits(uint64_t value) {
+  return (((value & 0xF0F0F0F0F0F0F0F0ULL) |
+           (((value + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) ==
+          0x3333333333333333ULL);
+}
+
+/**
+ * @brief Converts 8 ASCII digits to their value with three multiplies.
+ */
+inline uint32_t parseEight(uint64_t value) {
+  const uint64_t mask = 0x000000FF000000FFULL;
+  const uint64_t mul1 = 0x000F424000000064ULL;  ///> 100 + (1000000 << 32)
+  const uint64_t mul2 = 0x0000271000000001ULL;  ///> 1 + (10000 << 32)
+  value -= 0x3030303030303030ULL;
+  value = (value * 10) + (value >> 8);  ///> Pairs of digits
+  value = (((value & mask) * mul1) + (((value >> 16) & mask) * mul2)) >> 32;
+  return static_cast<uint32_t>(value);
+}
+
+/**
+ * @brief Accumulates digits into the mantissa, 8 at a time where possible.
+ */
+inline const char* parseDigits(const char* p, const char* last,
+                               uint64_t& mantissa) {
+  while (last - p >= 8 && isEightDigits(readEight(p))) {
+    mantissa = mantissa * 100000000 + parseEight(readEight(p));
+    p += 8;
+  }
+  while (p != last && isDigit(*p)) {
+    mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+    ++p;
+  }
+  return p;
+}
+
+/**
+ * @brief Eisel-Lemire: rounds w * 10^q to a double bit pattern.
+ * @return false if the product was too close to a rounding boundary to
+ * decide, or the result is not a normal finite double.
+ */
+bool eiselLemire(int64_t q, uint64_t w, uint64_t& bits) {
+  const int lz = __builtin_clzll(w);
+  w <<= lz;
+
+  const uint64_t* entry = powersOfFive() + 2 * (q - SMALLEST_POWER);
+  unsigned __int128 first = static_cast<unsigned __int128>(w) * entry[0];
+  uint64_t high = static_cast<uint64_t>(first >> 64);
+  uint64_t low = static_cast<uint64_t>(first);
+  const uint64_t precisionMask = 0xFFFFFFFFFFFFFFFFULL >> (MANTISSA_BITS + 3);
+  if ((high & precisionMask) == precisionMask) {
+    ///> The truncated table entry may matter; add the next 64 bits
+    unsigned __int128 second = static_cast<unsigned __int128>(w) * entry[1];
+    uint64_t secondHigh = static_cast<uint64_t>(second >> 64);
+    low += secondHigh;
+    if (secondHigh > low) {
+      ++high;
+    }
+  }
+  if (low == 0xFFFFFFFFFFFFFFFFULL && (q < -27 || q > 55)) {
+    return false;
+  }
+
+  const int upperBit = static_cast<int>(high >> 63);
+  const int shift = upperBit + 64 - MANTISSA_BITS - 3;
+  uint64_t mantissa = high >> shift;
+  int power2 = static_cast<int>((((152170 + 65536) * q) >> 16) + 63) +
+               upperBit - lz + 1023;
+  if (power2 <= 0) {
+    return false;  ///> Subnormal or zero
+  }
+
+  ///> Exactly halfway between two doubles: round to even
+  if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+      (mantissa << shift) == high) {
+    mantissa &= ~uint64_t(1);
+  }
+  mantissa += mantissa & 1;
+  mantissa >>= 1;
+  if (mantissa >= (uint64_t(2) << MANTISSA_BITS)) {
+    mantissa = uint64_t(1) << MANTISSA_BITS;
+    ++power2;
+  }
+  mantissa &= ~(uint64_t(1) << MANTISSA_BITS);
+  if (power2 >= 0x7FF) {
+    return false;  ///> Infinity
+  }
+  bits = mantissa | (uint64_t(power2) << MANTISSA_BITS);
+  return true;
+}
+
+/**
+ * @brief Falls back to strtod for inputs the fast paths cannot decide.
+ */
+const char* parseSlow(const char* first, const char* end, double& value) {
+  std::string text(first, end);
+  char* parsedEnd;
+  errno = 0;
+  double parsed = std::strtod(text.c_str(), &parsedEnd);
+  if (parsedEnd != text.c_str() + text.size() || errno == ERANGE ||
+      std::isinf(parsed)) {
+    return nullptr;
+  }
+  value = parsed;
+  return end;
+}
+}  // namespace
+
+const char* FastFloat::parse(const char* first, const char* last,
+                             double& value) {
+  const char* p = first;
+  bool negative = false;
+  if (p != last && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+
+  uint64_t mantissa = 0;
+  const char* digitsBegin = p;
+  p = parseDigits(p, last, mantissa);
+  int64_t digitCount = p - digitsBegin;
+  int64_t exponent = 0;
+  if (p != last && *p == '.') {
+    const char* fractionBegin = ++p;
+    p = parseDigits(p, last, mantissa);
+    exponent = fractionBegin - p;
+    digitCount -= exponent;
+  }
+  if (digitCount == 0) {
+    return nullptr;
+  }
+
+  if (p != last && (*p == 'e' || *p == 'E')) {
+    const char* e = p + 1;
+    bool negativeExponent = false;
+    if (e != last && (*e == '+' || *e == '-')) {
+      negativeExponent = *e == '-';
+      ++e;
+    }
+    if (e != last && isDigit(*e)) {
+      int64_t written = 0;
+      for (; e != last && isDigit(*e); ++e) {
+        if (written < 0x10000000) {
+          written = written * 10 + (*e - '0');
+        }
+      }
+      exponent += negativeExponent ? -written : written;
+      p = e;
+    }  ///> Otherwise the 'e' is not part of the number
+  }
+
+  if (digitCount > MAX_DIGITS) {
+    ///> Leading zeros are not significant
+    for (const char* s = digitsBegin; s != p && (*s == '0' || *s == '.');
+         ++s) {
+      digitCount -= *s == '0';
+    }
+    if (digitCount > MAX_DIGITS) {
+      return parseSlow(first, p, value);
+    }
+  }
+
+  if (mantissa == 0) {
+    value = negative ? -0.0 : 0.0;
+    return p;
+  }
+
+  ///> Clinger: both operands exact, so one IEEE operation rounds correctly
+  if (exponent >= -22 && exponent <= 22 && mantissa <= (uint64_t(1) << 53)) {
+    double result = static_cast<double>(mantissa);
+    result = exponent < 0 ? result / EXACT_POWERS[-exponent]
+                          : result * EXACT_POWERS[exponent];
+    value = negative ? -result : result;
+    return p;
+  }
+
+  if (exponent < SMALLEST_POWER || exponent > LARGEST_POWER) {
+    return nullptr;
+  }
+  uint64_t bits;
+  if (!eiselLemire(exponent, mantissa, bits)) {
+    return parseSlow(first, p, value);
+  }
+  bits |= uint64_t(negative) << 63;
+  std::memcpy(&value, &bits, sizeof(value));
+  return p;
+}
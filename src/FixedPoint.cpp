@@ -0,0 +1,247 @@
+/**
+ * @file FixedPoint.cpp
+ * @brief Implementation of the FixedPoint class.
+ *
+ * @version 0.1
+ */
+
+#include "FixedPoint.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+const uint64_t POW10[20] = {1ULL,
+                            10ULL,
+                            100ULL,
+                            1000ULL,
+                            10000ULL,
+                            100000ULL,
+                            1000000ULL,
+                            10000000ULL,
+                            100000000ULL,
+                            1000000000ULL,
+                            10000000000ULL,
+                            100000000000ULL,
+                            1000000000000ULL,
+                            10000000000000ULL,
+                            100000000000000ULL,
+                            1000000000000000ULL,
+                            10000000000000000ULL,
+                            100000000000000000ULL,
+                            1000000000000000000ULL,
+                            10000000000000000000ULL};  ///< 10^0 .. 10^19
+
+const int MAX_SIGNIFICANT_DIGITS = 19;  ///< 10^19 - 1 still fits in uint64.
+const std::size_t SUM_BLOCK = 256;      ///< Values summed without checks.
+
+/**
+ * @brief Applies the sign and checks the int64 range.
+ */
+bool applySign(uint64_t magnitude, bool negative, int64_t& out) {
+  const uint64_t limit =
+      static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+  if (negative) {
+    if (magnitude > limit + 1) {
+      return false;
+    }
+    out = magnitude == limit + 1 ? std::numeric_limits<int64_t>::min()
+                                 : -static_cast<int64_t>(magnitude);
+  } else {
+    if (magnitude > limit) {
+      return false;
+    }
+    out = static_cast<int64_t>(magnitude);
+  }
+  return true;
+}
+}  // namespace
+
+const int FixedPoint::MAX_PLACES;
+
+FixedPointColumn::FixedPointColumn(int places)
+    : places(places), rounded(0), outOfRange(0) {}
+
+FixedPointStatus FixedPoint::parseDecimal(const std::string& token, int places,
+                                          int64_t& out) {
+  std::size_t i = 0;
+  const std::size_t n = token.size();
+  bool negative = false;
+  if (i < n && (token[i] == '+' || token[i] == '-')) {
+    negative = token[i] == '-';
+    ++i;
+  }
+
+  uint64_t mantissa = 0;
+  int exponent = 0;        ///> Value is mantissa * 10^exponent
+  int significant = 0;     ///> Digits accumulated in the mantissa
+  bool sticky = false;     ///> A dropped digit was non-zero
+  bool anyDigit = false;
+
+  for (; i < n && token[i] >= '0' && token[i] <= '9'; ++i) {
+    int digit = token[i] - '0';
+    anyDigit = true;
+    if (significant < MAX_SIGNIFICANT_DIGITS) {
+      mantissa = mantissa * 10 + digit;
+      significant += mantissa != 0;
+    } else {
+      ++exponent;
+      sticky |= digit != 0;
+    }
+  }
+  if (i < n && token[i] == '.') {
+    for (++i; i < n && token[i] >= '0' && token[i] <= '9'; ++i) {
+      int digit = token[i] - '0';
+      anyDigit = true;
+      if (significant < MAX_SIGNIFICANT_DIGITS) {
+        mantissa = mantissa * 10 + digit;
+        significant += mantissa != 0;
+        --exponent;
+      } else {
+        sticky |= digit != 0;
+      }
+    }
+  }
+  if (!anyDigit) {
+    return FixedPointStatus::INVALID;
+  }
+  if (i < n && (token[i] == 'e' || token[i] == 'E')) {
+    ++i;
+    bool negativeExponent = false;
+    if (i < n && (token[i] == '+' || token[i] == '-')) {
+      negativeExponent = token[i] == '-';
+      ++i;
+    }
+    if (i == n) {
+      return FixedPointStatus::INVALID;
+    }
+    int value = 0;
+    for (; i < n && token[i] >= '0' && token[i] <= '9'; ++i) {
+      value = std::min(value * 10 + (token[i] - '0'), 100000);
+    }
+    exponent += negativeExponent ? -value : value;
+  }
+  if (i != n) {
+    return FixedPointStatus::INVALID;
+  }
+
+  if (mantissa == 0) {
+    out = 0;
+    return FixedPointStatus::EXACT;
+  }
+
+  int shift = places + exponent;
+  uint64_t magnitude;
+  bool rounded = sticky;
+  if (shift >= 0) {
+    if (shift > MAX_SIGNIFICANT_DIGITS ||
+        __builtin_mul_overflow(mantissa, POW10[shift], &magnitude)) {
+      return FixedPointStatus::OUT_OF_RANGE;
+    }
+  } else if (-shift > MAX_SIGNIFICANT_DIGITS) {
+    ///> Every kept digit is below the requested precision
+    magnitude = 0;
+    rounded = true;
+  } else {
+    uint64_t divisor = POW10[-shift];
+    uint64_t remainder = mantissa % divisor;
+    uint64_t half = divisor / 2;
+    magnitude = mantissa / divisor;
+    if (remainder > half ||
+        (remainder == half && (sticky || (magnitude & 1) != 0))) {
+      ++magnitude;  ///> Round half to even
+    }
+    rounded |= remainder != 0;
+  }
+
+  if (!applySign(magnitude, negative, out)) {
+    return FixedPointStatus::OUT_OF_RANGE;
+  }
+  return rounded ? FixedPointStatus::ROUNDED : FixedPointStatus::EXACT;
+}
+
+FixedPointStatus FixedPoint::parseInUnit(const std::string& token, int places,
+                                         double baseUnitFactor, int64_t& out) {
+  for (int k = -MAX_PLACES; k <= MAX_PLACES; ++k) {
+    double power = std::pow(10.0, k);
+    if (std::fabs(baseUnitFactor - power) <= power * 1e-12) {
+      return parseDecimal(token, places + k, out);
+    }
+  }
+
+  if (baseUnitFactor < 1 || baseUnitFactor != std::floor(baseUnitFactor) ||
+      baseUnitFactor > static_cast<double>(POW10[MAX_PLACES])) {
+    return FixedPointStatus::INVALID;
+  }
+  int64_t value;
+  FixedPointStatus status = parseDecimal(token, places, value);
+  if (status == FixedPointStatus::EXACT ||
+      status == FixedPointStatus::ROUNDED) {
+    if (__builtin_mul_overflow(value, static_cast<int64_t>(baseUnitFactor),
+                               &out)) {
+      return FixedPointStatus::OUT_OF_RANGE;
+    }
+  }
+  return status;
+}
+
+FixedPointStatus FixedPoint::fromDouble(double value, int places,
+                                        int64_t& out) {
+  double scaled = value * static_cast<double>(POW10[places]);
+  ///> 2^63 is exactly representable, so the comparison is exact
+  if (!(std::fabs(scaled) < 9223372036854775808.0)) {
+    return FixedPointStatus::OUT_OF_RANGE;
+  }
+  out = std::llround(scaled);
+  return FixedPointStatus::ROUNDED;
+}
+
+bool FixedPoint::sum(const std::vector<int64_t>& values, int64_t& total) {
+  const int64_t blockLimit =
+      std::numeric_limits<int64_t>::max() / static_cast<int64_t>(SUM_BLOCK);
+  const int64_t* data = values.data();
+  __int128 wide = 0;
+
+  for (std::size_t start = 0; start < values.size(); start += SUM_BLOCK) {
+    std::size_t end = std::min(values.size(), start + SUM_BLOCK);
+    int64_t low = 0;
+    int64_t high = 0;
+    for (std::size_t i = start; i < end; ++i) {
+      low = std::min(low, data[i]);
+      high = std::max(high, data[i]);
+    }
+
+    if (low >= -blockLimit && high <= blockLimit) {
+      int64_t blockSum = 0;  ///> Cannot overflow; plain adds vectorize
+      for (std::size_t i = start; i < end; ++i) {
+        blockSum += data[i];
+      }
+      wide += blockSum;
+    } else {
+      for (std::size_t i = start; i < end; ++i) {
+        wide += data[i];
+      }
+    }
+  }
+
+  if (wide > std::numeric_limits<int64_t>::max() ||
+      wide < std::numeric_limits<int64_t>::min()) {
+    return false;
+  }
+  total = static_cast<int64_t>(wide);
+  return true;
+}
+
+std::string FixedPoint::toString(int64_t value, int places) {
+  bool negative = value < 0;
+  uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(value)
+                                : static_cast<uint64_t>(value);
+  std::string digits = std::to_string(magnitude);
+  if (places > 0) {
+    if (digits.size() <= static_cast<std::size_t>(places)) {
+      digits.insert(0, places + 1 - digits.size(), '0');
+    }
+    digits.insert(digits.size() - places, 1, '.');
+  }
+  return negative ? "-" + digits : digits;
+}
@@ -0,0 +1,301 @@
+/**
+ * @file GorillaCodec.cpp
+ * @brief Implementation of the GorillaCodec class.
+ *
+ * @version 0.1
+ */
+
+#include "GorillaCodec.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+/**
+ * @class BitWriter
+ * @brief Appends bit fields, most significant bit first, to a byte buffer.
+ */
+class BitWriter {
+ private:
+  std::vector<uint8_t>& out;  ///< Destination buffer.
+  uint64_t window;            ///< Pending bits, left-aligned.
+  int bits;                   ///< Number of pending bits (< 8 between calls).
+
+ public:
+  explicit BitWriter(std::vector<uint8_t>& out)
+      : out(out), window(0), bits(0) {}
+
+  void write(uint64_t value, int count) {
+    if (count > 32) {
+      write(value >> 32, count - 32);
+      count = 32;
+    }
+    if (count == 0) {
+      return;
+    }
+    value &= (uint64_t(1) << count) - 1;
+    window |= value << (64 - bits - count);
+    bits += count;
+    while (bits >= 8) {
+      out.push_back(static_cast<uint8_t>(window >> 56));
+      window <<= 8;
+      bits -= 8;
+    }
+  }
+
+  void flush() {
+    if (bits > 0) {
+      out.push_back(static_cast<uint8_t>(window >> 56));
+      window = 0;
+      bits = 0;
+    }
+  }
+};
+
+/**
+ * @class BitReader
+ * @brief Reads bit fields written by BitWriter, refilling 64 bits at a time.
+ */
+class BitReader {
+ private:
+  const uint8_t* data;  ///< Encoded bytes.
+  std::size_t size;     ///< Number of encoded bytes.
+  std::size_t next;     ///< Next byte to load into the window.
+  uint64_t window;      ///< Unread bits, left-aligned.
+  int bits;             ///< Number of unread bits in the window.
+
+  void refill() {
+    while (bits <= 56) {
+      uint64_t byte = next < size ? data[next] : 0;
+      ++next;
+      window |= byte << (56 - bits);
+      bits += 8;
+    }
+  }
+
+ public:
+  BitReader(const uint8_t* data, std::size_t size)
+      : data(data), size(size), next(0), window(0), bits(0) {}
+
+  uint64_t read(int count) {
+    if (count > 32) {
+      uint64_t high = read(count - 32);
+      return (high << 32) | read(32);
+    }
+    if (count == 0) {
+      return 0;
+    }
+    if (bits < count) {
+      refill();
+    }
+    uint64_t value = window >> (64 - count);
+    window <<= count;
+    bits -= count;
+    return value;
+  }
+
+  /**
+   * @brief Counts leading one bits, up to a limit, consuming them and the
+   * terminating zero (if the limit was not reached).
+   */
+  int readPrefix(int limit) {
+    int ones = 0;
+    while (ones < limit && read(1) == 1) {
+      ++ones;
+    }
+    return ones;
+  }
+};
+
+int leadingZeros(uint64_t x) {
+  return __builtin_clzll(x);
+}
+
+int leadingZeros(uint32_t x) {
+  return __builtin_clz(x);
+}
+
+int trailingZeros(uint64_t x) {
+  return __builtin_ctzll(x);
+}
+
+int trailingZeros(uint32_t x) {
+  return __builtin_ctz(x);
+}
+
+/**
+ * @brief XOR-encodes words of WIDTH bits. The leading-zero count takes 5
+ * bits; the meaningful-bit count takes log2(WIDTH) bits, with WIDTH stored as
+ * zero.
+ */
+template <typename Word>
+void encodeXor(const Word* words, std::size_t count, std::vector<uint8_t>& out) {
+  const int width = sizeof(Word) * 8;
+  const int lengthBits = width == 64 ? 6 : 5;
+  if (count == 0) {
+    return;
+  }
+
+  BitWriter writer(out);
+  writer.write(words[0], width);
+  Word previous = words[0];
+  int previousLeading = -1;
+  int previousTrailing = 0;
+
+  for (std::size_t i = 1; i < count; ++i) {
+    Word x = words[i] ^ previous;
+    previous = words[i];
+    if (x == 0) {
+      writer.write(0, 1);
+      continue;
+    }
+
+    int leading = std::min(leadingZeros(x), 31);
+    int trailing = trailingZeros(x);
+    if (previousLeading >= 0 && leading >= previousLeading &&
+        trailing >= previousTrailing) {
+      writer.write(2, 2);
+      writer.write(x >> previousTrailing,
+                   width - previousLeading - previousTrailing);
+    } else {
+      int meaningful = width - leading - trailing;
+      writer.write(3, 2);
+      writer.write(leading, 5);
+      writer.write(meaningful == width ? 0 : meaningful, lengthBits);
+      writer.write(x >> trailing, meaningful);
+      previousLeading = leading;
+      previousTrailing = trailing;
+    }
+  }
+  writer.flush();
+}
+
+template <typename Word>
+void decodeXor(const uint8_t* data, std::size_t size, std::size_t count,
+               Word* words) {
+  const int width = sizeof(Word) * 8;
+  const int lengthBits = width == 64 ? 6 : 5;
+  if (count == 0) {
+    return;
+  }
+
+  BitReader reader(data, size);
+  Word previous = static_cast<Word>(reader.read(width));
+  words[0] = previous;
+  int leading = 0;
+  int trailing = 0;
+
+  for (std::size_t i = 1; i < count; ++i) {
+    if (reader.read(1) == 1) {
+      if (reader.read(1) == 1) {
+        leading = static_cast<int>(reader.read(5));
+        int meaningful = static_cast<int>(reader.read(lengthBits));
+        if (meaningful == 0) {
+          meaningful = width;
+        }
+        trailing = width - leading - meaningful;
+      }
+      Word x = static_cast<Word>(reader.read(width - leading - trailing));
+      previous ^= static_cast<Word>(x << trailing);
+    }
+    words[i] = previous;
+  }
+}
+
+int64_t signExtend(uint64_t value, int bits) {
+  return static_cast<int64_t>(value << (64 - bits)) >> (64 - bits);
+}
+}  // namespace
+
+void GorillaCodec::encodeDoubles(const double* values, std::size_t count,
+                                 std::vector<uint8_t>& out) {
+  std::vector<uint64_t> words(count);
+  std::memcpy(words.data(), values, count * sizeof(double));
+  encodeXor(words.data(), count, out);
+}
+
+void GorillaCodec::decodeDoubles(const uint8_t* data, std::size_t size,
+                                 std::size_t count, double* out) {
+  std::vector<uint64_t> words(count);
+  decodeXor(data, size, count, words.data());
+  std::memcpy(out, words.data(), count * sizeof(double));
+}
+
+void GorillaCodec::encodeFloats(const float* values, std::size_t count,
+                                std::vector<uint8_t>& out) {
+  std::vector<uint32_t> words(count);
+  std::memcpy(words.data(), values, count * sizeof(float));
+  encodeXor(words.data(), count, out);
+}
+
+void GorillaCodec::decodeFloats(const uint8_t* data, std::size_t size,
+                                std::size_t count, float* out) {
+  std::vector<uint32_t> words(count);
+  decodeXor(data, size, count, words.data());
+  std::memcpy(out, words.data(), count * sizeof(float));
+}
+
+void GorillaCodec::encodeIntegers(const int64_t* values, std::size_t count,
+                                  std::vector<uint8_t>& out) {
+  if (count == 0) {
+    return;
+  }
+
+  ///> Unsigned arithmetic wraps instead of overflowing
+  BitWriter writer(out);
+  writer.write(static_cast<uint64_t>(values[0]), 64);
+  if (count > 1) {
+    uint64_t delta =
+        static_cast<uint64_t>(values[1]) - static_cast<uint64_t>(values[0]);
+    writer.write(delta, 64);
+    for (std::size_t i = 2; i < count; ++i) {
+      uint64_t next = static_cast<uint64_t>(values[i]) -
+                      static_cast<uint64_t>(values[i - 1]);
+      int64_t dod = static_cast<int64_t>(next - delta);
+      delta = next;
+      if (dod == 0) {
+        writer.write(0, 1);
+      } else if (dod >= -64 && dod <= 63) {
+        writer.write(2, 2);
+        writer.write(static_cast<uint64_t>(dod), 7);
+      } else if (dod >= -256 && dod <= 255) {
+        writer.write(6, 3);
+        writer.write(static_cast<uint64_t>(dod), 9);
+      } else if (dod >= -2048 && dod <= 2047) {
+        writer.write(14, 4);
+        writer.write(static_cast<uint64_t>(dod), 12);
+      } else {
+        writer.write(15, 4);
+        writer.write(static_cast<uint64_t>(dod), 64);
+      }
+    }
+  }
+  writer.flush();
+}
+
+void GorillaCodec::decodeIntegers(const uint8_t* data, std::size_t size,
+                                  std::size_t count, int64_t* out) {
+  if (count == 0) {
+    return;
+  }
+
+  BitReader reader(data, size);
+  uint64_t value = reader.read(64);
+  out[0] = static_cast<int64_t>(value);
+  if (count == 1) {
+    return;
+  }
+  uint64_t delta = reader.read(64);
+  value += delta;
+  out[1] = static_cast<int64_t>(value);
+
+  static const int PAYLOAD_BITS[] = {0, 7, 9, 12, 64};
+  for (std::size_t i = 2; i < count; ++i) {
+    int prefix = reader.readPrefix(4);
+    if (prefix > 0) {
+      int bits = PAYLOAD_BITS[prefix];
+      delta += static_cast<uint64_t>(signExtend(reader.read(bits), bits));
+    }
+    value += delta;
+    out[i] = static_cast<int64_t>(value);
+  }
+}
@@ -0,0 +1,138 @@
+/**
+ * @file Histogram.cpp
+ * @brief Implementation of the Histogram class.
+ *
+ * @version 0.1
+ */
+
+#include "Histogram.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+const int Histogram::SUB_BUCKET_BITS;
+const int Histogram::MIN_EXPONENT;
+const int Histogram::MAX_EXPONENT;
+const std::size_t Histogram::SUB_BUCKETS;
+const std::size_t Histogram::MAGNITUDE_BUCKETS;
+
+Histogram::Histogram()
+    : counts(2 * MAGNITUDE_BUCKETS + 1, 0), totalCount(0), min(0.0), max(0.0) {}
+
+std::size_t Histogram::magnitudeIndex(double magnitude) {
+  uint64_t bits;
+  std::memcpy(&bits, &magnitude, sizeof(bits));
+  int exponent = static_cast<int>((bits >> 52) & 0x7FF) - 1023;
+  if (exponent < MIN_EXPONENT) {
+    return 0;  ///> Also covers subnormals
+  }
+  if (exponent >= MAX_EXPONENT) {
+    return MAGNITUDE_BUCKETS - 1;  ///> Also covers infinity
+  }
+  std::size_t subBucket = (bits >> (52 - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+  return (exponent - MIN_EXPONENT) * SUB_BUCKETS + subBucket;
+}
+
+double Histogram::magnitudeLowerBound(std::size_t index) {
+  int exponent = static_cast<int>(index / SUB_BUCKETS) + MIN_EXPONENT;
+  double subBucket = static_cast<double>(index % SUB_BUCKETS);
+  return std::ldexp(1.0 + subBucket / SUB_BUCKETS, exponent);
+}
+
+void Histogram::record(double value) {
+  if (std::isnan(value)) {
+    return;
+  }
+
+  std::size_t index = MAGNITUDE_BUCKETS;
+  if (value > 0) {
+    index += 1 + magnitudeIndex(value);
+  } else if (value < 0) {
+    index -= 1 + magnitudeIndex(-value);
+  }
+  ++counts[index];
+
+  if (totalCount == 0) {
+    min = value;
+    max = value;
+  } else {
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  ++totalCount;
+}
+
+void Histogram::merge(const Histogram& other) {
+  if (other.totalCount == 0) {
+    return;
+  }
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    counts[i] += other.counts[i];
+  }
+  if (totalCount == 0) {
+    min = other.min;
+    max = other.max;
+  } else {
+    min = std::min(min, other.min);
+    max = std::max(max, other.max);
+  }
+  totalCount += other.totalCount;
+}
+
+uint64_t Histogram::getTotalCount() const {
+  return totalCount;
+}
+
+double Histogram::getMin() const {
+  return min;
+}
+
+double Histogram::getMax() const {
+  return max;
+}
+
+double Histogram::getValueAtPercentile(double percentile) const {
+  if (totalCount == 0) {
+    return 0.0;
+  }
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  uint64_t rank = static_cast<uint64_t>(
+      std::ceil(percentile / 100.0 * static_cast<double>(totalCount)));
+  rank = std::max<uint64_t>(rank, 1);
+
+  uint64_t seen = 0;
+  std::vector<HistogramBucket> buckets = getBuckets();
+  for (const auto& bucket : buckets) {
+    seen += bucket.count;
+    if (seen >= rank) {
+      double midpoint = (bucket.lower + bucket.upper) / 2;
+      return std::min(std::max(midpoint, min), max);
+    }
+  }
+  return max;
+}
+
+std::vector<HistogramBucket> Histogram::getBuckets() const {
+  std::vector<HistogramBucket> buckets;
+  for (std::size_t i = 0; i < counts.size(); ++i) {
+    if (counts[i] == 0) {
+      continue;
+    }
+    HistogramBucket bucket;
+    bucket.count = counts[i];
+    if (i == MAGNITUDE_BUCKETS) {
+      bucket.lower = 0.0;
+      bucket.upper = 0.0;
+    } else if (i > MAGNITUDE_BUCKETS) {
+      std::size_t index = i - MAGNITUDE_BUCKETS - 1;
+      bucket.lower = magnitudeLowerBound(index);
+      bucket.upper = magnitudeLowerBound(index + 1);
+    } else {
+      std::size_t index = MAGNITUDE_BUCKETS - 1 - i;
+      bucket.lower = -magnitudeLowerBound(index + 1);
+      bucket.upper = -magnitudeLowerBound(index);
+    }
+    buckets.push_back(bucket);
+  }
+  return buckets;
+}
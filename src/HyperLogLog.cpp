@@ -0,0 +1,92 @@
+/**
+ * @file HyperLogLog.cpp
+ * @brief Implementation of the HyperLogLog class.
+ *
+ * @version 0.1
+ */
+
+#include "HyperLogLog.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+/**
+ * @brief MurmurHash3 64-bit finalizer; spreads every input bit over the
+ * output.
+ */
+uint64_t mix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+}  // namespace
+
+HyperLogLog::HyperLogLog(int precision)
+    : precision(std::min(std::max(precision, 4), 18)),
+      registers(std::size_t(1) << this->precision, 0) {}
+
+void HyperLogLog::addHash(uint64_t hash) {
+  std::size_t index = static_cast<std::size_t>(hash >> (64 - precision));
+  ///> A sentinel bit bounds the rank when the remaining bits are all zero
+  uint64_t rest = (hash << precision) | (uint64_t(1) << (precision - 1));
+  uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+  if (rank > registers[index]) {
+    registers[index] = rank;
+  }
+}
+
+void HyperLogLog::add(double value) {
+  addHash(hashDouble(value));
+}
+
+void HyperLogLog::merge(const HyperLogLog& other) {
+  if (other.precision != precision) {
+    throw std::invalid_argument("Cannot merge sketches of different precision.");
+  }
+  for (std::size_t i = 0; i < registers.size(); ++i) {
+    registers[i] = std::max(registers[i], other.registers[i]);
+  }
+}
+
+double HyperLogLog::estimate() const {
+  double m = static_cast<double>(registers.size());
+  double sum = 0.0;
+  std::size_t zeros = 0;
+  for (uint8_t rank : registers) {
+    sum += std::ldexp(1.0, -rank);
+    if (rank == 0) {
+      ++zeros;
+    }
+  }
+
+  double alpha = 0.7213 / (1.0 + 1.079 / m);
+  double estimate = alpha * m * m / sum;
+  if (estimate <= 2.5 * m && zeros > 0) {
+    ///> Linear counting is more accurate for small cardinalities
+    estimate = m * std::log(m / zeros);
+  }
+  return estimate;
+}
+
+uint64_t HyperLogLog::hashDouble(double value) {
+  if (value == 0.0) {
+    value = 0.0;
+  }
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return mix64(bits);
+}
+
+uint64_t HyperLogLog::hashString(const std::string& str) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (char c : str) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 0x100000001b3ULL;
+  }
+  return mix64(hash);
+}
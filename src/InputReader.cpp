@@ -0,0 +1,573 @@
+/**
+ * @file InputReader.cpp
+ * @brief Implementation of the InputReader class and its backends.
+ *
+ * @version 0.1
+ */
+
+#include "InputReader.h"
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+/**
+ * @brief Reads with std::ifstream into one reusable buffer.
+ */
+class StreamReader : public InputReader {
+ private:
+  std::ifstream file;
+  std::unique_ptr<char[]> buffer;  ///< Uninitialized, not to fault in pages
+                                   ///< a short file never fills.
+  std::size_t blockSize;
+
+ public:
+  StreamReader(const std::string& path, std::size_t blockSize)
+      : file(path, std::ios::binary),
+        buffer(new char[blockSize]),
+        blockSize(blockSize) {
+    if (!file.is_open()) {
+      throw std::runtime_error("Failed to open file: " + path);
+    }
+  }
+
+  std::size_t next(const char*& data) override {
+    file.read(buffer.get(), static_cast<std::streamsize>(blockSize));
+    if (file.bad()) {
+      throw std::runtime_error("Failed to read input.");
+    }
+    data = buffer.get();
+    return static_cast<std::size_t>(file.gcount());
+  }
+
+  ReaderBackend getBackend() const override { return ReaderBackend::IFSTREAM; }
+};
+
+/**
+ * @brief Hands out windows of a read-only mapping of the whole file.
+ */
+class MappedReader : public InputReader {
+ private:
+  int fd;
+  bool ownsFd;
+  const char* mapping;
+  std::size_t size;
+  std::size_t position;
+  std::size_t blockSize;
+
+ public:
+  MappedReader(int fd, bool ownsFd, const std::string& path,
+               std::size_t blockSize)
+      : fd(fd),
+        ownsFd(ownsFd),
+        mapping(nullptr),
+        size(0),
+        position(0),
+        blockSize(blockSize) {
+    struct stat status;
+    if (::fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+      throw std::runtime_error("Cannot map input: " + path);
+    }
+    size = static_cast<std::size_t>(status.st_size);
+    if (size > 0) {
+      void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (address == MAP_FAILED) {
+        throw std::runtime_error("Cannot map input: " + path);
+      }
+      mapping = static_cast<const char*>(address);
+      ::madvise(address, size, MADV_SEQUENTIAL);
+    }
+  }
+
+  ~MappedReader() override {
+    if (mapping != nullptr) {
+      ::munmap(const_cast<char*>(mapping), size);
+    }
+    if (ownsFd) {
+      ::close(fd);
+    }
+  }
+
+  std::size_t next(const char*& data) override {
+    std::size_t count = std::min(blockSize, size - position);
+    data = mapping + position;
+    position += count;
+    return count;
+  }
+
+  ReaderBackend getBackend() const override { return ReaderBackend::MMAP; }
+};
+
+/**
+ * @brief A buffer of a queued backend, holding one block.
+ */
+struct Slot {
+  std::vector<char> buffer;  ///< The block's bytes.
+  uint64_t offset;           ///< File offset of the block.
+  std::size_t requested;     ///< Bytes wanted.
+  std::size_t filled;        ///< Bytes read so far.
+  bool isDone;               ///< Whether the block is complete.
+  struct iovec vector;       ///< The io_uring read target.
+};
+
+/**
+ * @brief Keeps up to QUEUE_DEPTH block reads in flight with io_uring.
+ *
+ * Blocks are read into a ring of slots and handed out in file order. Regular
+ * files have a read queued in every free slot; pipes and other
+ * non-seekable inputs keep a single read in flight, started as soon as the
+ * previous one completes.
+ */
+class UringReader : public InputReader {
+ private:
+  int fd;
+  bool ownsFd;
+  bool isSeekable;
+  uint64_t fileSize;
+  int ring;
+  void* sqRing;
+  std::size_t sqRingSize;
+  void* cqRing;
+  std::size_t cqRingSize;
+  struct io_uring_sqe* sqes;
+  std::size_t sqesSize;
+  unsigned* sqTail;
+  unsigned sqMask;
+  unsigned* sqArray;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  unsigned cqMask;
+  struct io_uring_cqe* cqes;
+  std::vector<Slot> slots;
+  uint64_t submitSequence;   ///< Blocks queued so far.
+  uint64_t deliverSequence;  ///< Blocks handed out so far.
+  uint64_t nextOffset;       ///< Offset of the next block to queue.
+  unsigned inFlight;         ///< Reads the kernel has not completed.
+  bool isDelivering;         ///< Whether the caller holds a slot.
+  bool isEnd;                ///< Whether a read reached the end of input.
+
+  void submit(std::size_t index) {
+    Slot& slot = slots[index];
+    const unsigned tail = *sqTail;
+    const unsigned position = tail & sqMask;
+    struct io_uring_sqe* sqe = &sqes[position];
+    std::memset(sqe, 0, sizeof(*sqe));
+    slot.vector.iov_base = slot.buffer.data() + slot.filled;
+    slot.vector.iov_len = slot.requested - slot.filled;
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = fd;
+    sqe->off =
+        isSeekable ? slot.offset + slot.filled : static_cast<uint64_t>(-1);
+    sqe->addr = reinterpret_cast<uint64_t>(&slot.vector);
+    sqe->len = 1;
+    sqe->user_data = index;
+    sqArray[position] = position;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+    if (syscall(__NR_io_uring_enter, ring, 1, 0, 0, nullptr, 0) < 0) {
+      throw std::runtime_error("io_uring submission failed.");
+    }
+    ++inFlight;
+  }
+
+  /**
+   * @brief Queues reads into free slots, in file order.
+   */
+  void fill() {
+    while (!isEnd &&
+           submitSequence - deliverSequence + (isDelivering ? 1 : 0) <
+               slots.size() &&
+           (isSeekable ? nextOffset < fileSize : inFlight == 0)) {
+      const std::size_t index = submitSequence % slots.size();
+      Slot& slot = slots[index];
+      slot.offset = nextOffset;
+      slot.requested =
+          isSeekable ? static_cast<std::size_t>(std::min<uint64_t>(
+                           slot.buffer.size(), fileSize - nextOffset))
+                     : slot.buffer.size();
+      slot.filled = 0;
+      slot.isDone = false;
+      submit(index);
+      nextOffset += slot.requested;
+      ++submitSequence;
+    }
+  }
+
+  /**
+   * @brief Waits for at least one completion and processes all available.
+   */
+  void reap() {
+    if (syscall(__NR_io_uring_enter, ring, 0, 1, IORING_ENTER_GETEVENTS,
+                nullptr, 0) < 0 &&
+        errno != EINTR) {
+      throw std::runtime_error("io_uring wait failed.");
+    }
+    unsigned head = *cqHead;
+    const unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      const struct io_uring_cqe& cqe = cqes[head & cqMask];
+      const std::size_t index = static_cast<std::size_t>(cqe.user_data);
+      const int result = cqe.res;
+      Slot& slot = slots[index];
+      --inFlight;
+      __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+      if (result == -EINTR || result == -EAGAIN) {
+        submit(index);
+      } else if (result < 0) {
+        throw std::runtime_error(std::string("Failed to read input: ") +
+                                 std::strerror(-result));
+      } else if (result == 0) {
+        slot.isDone = true;
+        isEnd = true;
+      } else {
+        slot.filled += static_cast<std::size_t>(result);
+        if (isSeekable && slot.filled < slot.requested) {
+          submit(index);  ///> Short read
+        } else {
+          slot.isDone = true;
+        }
+      }
+    }
+    fill();
+  }
+
+  void release() {
+    if (sqes != nullptr) {
+      ::munmap(sqes, sqesSize);
+    }
+    if (cqRing != nullptr && cqRing != sqRing) {
+      ::munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != nullptr) {
+      ::munmap(sqRing, sqRingSize);
+    }
+    if (ring >= 0) {
+      ::close(ring);
+    }
+  }
+
+ public:
+  /**
+   * @throws std::runtime_error if io_uring is not available; fd is then
+   * left open for the fallback.
+   */
+  UringReader(int fd, bool ownsFd, std::size_t blockSize)
+      : fd(fd),
+        ownsFd(ownsFd),
+        fileSize(0),
+        ring(-1),
+        sqRing(nullptr),
+        sqRingSize(0),
+        cqRing(nullptr),
+        cqRingSize(0),
+        sqes(nullptr),
+        sqesSize(0),
+        slots(QUEUE_DEPTH),
+        submitSequence(0),
+        deliverSequence(0),
+        nextOffset(0),
+        inFlight(0),
+        isDelivering(false),
+        isEnd(false) {
+    struct stat status;
+    isSeekable = ::fstat(fd, &status) == 0 && S_ISREG(status.st_mode);
+    fileSize = isSeekable ? static_cast<uint64_t>(status.st_size) : 0;
+
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring = static_cast<int>(syscall(__NR_io_uring_setup, QUEUE_DEPTH, &params));
+    if (ring < 0) {
+      throw std::runtime_error("io_uring is not available.");
+    }
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool isSingleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (isSingleMapping) {
+      sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    sqRing = ::mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED) {
+      sqRing = nullptr;
+      release();
+      throw std::runtime_error("io_uring is not available.");
+    }
+    cqRing = isSingleMapping
+                 ? sqRing
+                 : ::mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+    sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqeMapping =
+        cqRing == MAP_FAILED
+            ? MAP_FAILED
+            : ::mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+    if (cqRing == MAP_FAILED || sqeMapping == MAP_FAILED) {
+      if (cqRing == MAP_FAILED) {
+        cqRing = nullptr;
+      }
+      release();
+      throw std::runtime_error("io_uring is not available.");
+    }
+    sqes = static_cast<struct io_uring_sqe*>(sqeMapping);
+
+    char* sq = static_cast<char*>(sqRing);
+    char* cq = static_cast<char*>(cqRing);
+    sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    for (Slot& slot : slots) {
+      slot.buffer.resize(blockSize);
+      slot.isDone = false;
+    }
+    try {
+      fill();
+    } catch (const std::runtime_error&) {
+      release();
+      throw;
+    }
+  }
+
+  ~UringReader() override {
+    ///> The kernel may still be writing into the slots
+    isEnd = true;  ///> Queue nothing more
+    while (inFlight > 0) {
+      try {
+        reap();
+      } catch (const std::exception&) {
+        break;
+      }
+    }
+    release();
+    if (ownsFd) {
+      ::close(fd);
+    }
+  }
+
+  std::size_t next(const char*& data) override {
+    isDelivering = false;
+    fill();
+    if (deliverSequence == submitSequence) {
+      return 0;
+    }
+    Slot& slot = slots[deliverSequence % slots.size()];
+    while (!slot.isDone) {
+      reap();
+    }
+    if (slot.filled == 0) {
+      return 0;
+    }
+    ++deliverSequence;
+    isDelivering = true;
+    data = slot.buffer.data();
+    return slot.filled;
+  }
+
+  ReaderBackend getBackend() const override { return ReaderBackend::IO_URING; }
+};
+
+/**
+ * @brief Reads ahead into a ring of slots on a background thread.
+ */
+class ReadaheadReader : public InputReader {
+ private:
+  int fd;
+  bool ownsFd;
+  std::vector<Slot> slots;
+  uint64_t readSequence;     ///< Blocks the thread has finished.
+  uint64_t deliverSequence;  ///< Blocks handed out so far.
+  bool isDelivering;         ///< Whether the caller holds a slot.
+  bool isStopping;
+  int error;                 ///< errno of a failed read, 0 if none.
+  std::mutex mutex;
+  std::condition_variable filled;
+  std::condition_variable freed;
+  std::thread thread;
+
+  void run() {
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      ///> A slot is free once handed out and given back
+      freed.wait(lock, [this] {
+        return isStopping || readSequence < deliverSequence + slots.size() -
+                                                (isDelivering ? 1 : 0);
+      });
+      if (isStopping) {
+        return;
+      }
+      Slot& slot = slots[readSequence % slots.size()];
+      lock.unlock();
+
+      std::size_t total = 0;
+      int readError = 0;
+      while (total < slot.buffer.size()) {
+        ssize_t count = ::read(fd, slot.buffer.data() + total,
+                               slot.buffer.size() - total);
+        if (count < 0 && errno == EINTR) {
+          continue;
+        }
+        if (count < 0) {
+          readError = errno;
+        }
+        if (count <= 0) {
+          break;
+        }
+        total += static_cast<std::size_t>(count);
+      }
+
+      lock.lock();
+      slot.filled = readError != 0 ? 0 : total;
+      error = readError;
+      ++readSequence;
+      filled.notify_one();
+      if (total == 0 || readError != 0) {
+        return;  ///> The end of input, or an error, is the last block
+      }
+    }
+  }
+
+ public:
+  ReadaheadReader(int fd, bool ownsFd, std::size_t blockSize)
+      : fd(fd),
+        ownsFd(ownsFd),
+        slots(QUEUE_DEPTH),
+        readSequence(0),
+        deliverSequence(0),
+        isDelivering(false),
+        isStopping(false),
+        error(0) {
+    for (Slot& slot : slots) {
+      slot.buffer.resize(blockSize);
+    }
+    thread = std::thread(&ReadaheadReader::run, this);
+  }
+
+  ~ReadaheadReader() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      isStopping = true;
+    }
+    freed.notify_one();
+    thread.join();
+    if (ownsFd) {
+      ::close(fd);
+    }
+  }
+
+  std::size_t next(const char*& data) override {
+    std::unique_lock<std::mutex> lock(mutex);
+    if (isDelivering) {
+      isDelivering = false;
+      freed.notify_one();
+    }
+    filled.wait(lock, [this] { return readSequence > deliverSequence; });
+    Slot& slot = slots[deliverSequence % slots.size()];
+    if (slot.filled == 0) {
+      if (error != 0) {
+        throw std::runtime_error(std::string("Failed to read input: ") +
+                                 std::strerror(error));
+      }
+      return 0;
+    }
+    ++deliverSequence;
+    isDelivering = true;
+    data = slot.buffer.data();
+    return slot.filled;
+  }
+
+  ReaderBackend getBackend() const override {
+    return ReaderBackend::READAHEAD;
+  }
+};
+
+/**
+ * @brief Creates a descriptor-based reader; fd is not closed on failure.
+ */
+std::unique_ptr<InputReader> openDescriptor(int fd, bool ownsFd,
+                                            const std::string& name,
+                                            ReaderBackend backend,
+                                            std::size_t blockSize) {
+  blockSize = std::max<std::size_t>(blockSize, 1);
+  switch (backend) {
+    case ReaderBackend::MMAP:
+      return std::unique_ptr<InputReader>(
+          new MappedReader(fd, ownsFd, name, blockSize));
+    case ReaderBackend::IO_URING:
+      try {
+        return std::unique_ptr<InputReader>(
+            new UringReader(fd, ownsFd, blockSize));
+      } catch (const std::runtime_error&) {
+        ///> Older kernel, or io_uring disabled: read ahead on a thread
+      }
+      return std::unique_ptr<InputReader>(
+          new ReadaheadReader(fd, ownsFd, blockSize));
+    default:
+      ///> std::ifstream cannot adopt a descriptor, so it reads ahead too
+      return std::unique_ptr<InputReader>(
+          new ReadaheadReader(fd, ownsFd, blockSize));
+  }
+}
+}  // namespace
+
+const std::size_t InputReader::DEFAULT_BLOCK_SIZE;
+const unsigned InputReader::QUEUE_DEPTH;
+
+InputReader::~InputReader() {}
+
+std::unique_ptr<InputReader> InputReader::open(const std::string& path,
+                                               ReaderBackend backend,
+                                               std::size_t blockSize) {
+  if (backend == ReaderBackend::IFSTREAM) {
+    return std::unique_ptr<InputReader>(
+        new StreamReader(path, std::max<std::size_t>(blockSize, 1)));
+  }
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open file: " + path);
+  }
+  try {
+    return openDescriptor(fd, true, path, backend, blockSize);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+std::unique_ptr<InputReader> InputReader::open(int fd, ReaderBackend backend,
+                                               std::size_t blockSize) {
+  return openDescriptor(fd, false, "descriptor " + std::to_string(fd),
+                        backend, blockSize);
+}
+
+const char* InputReader::getBackendName(ReaderBackend backend) {
+  switch (backend) {
+    case ReaderBackend::MMAP:
+      return "mmap";
+    case ReaderBackend::IO_URING:
+      return "io_uring";
+    case ReaderBackend::READAHEAD:
+      return "readahead";
+    default:
+      return "ifstream";
+  }
+}
@@ -0,0 +1,265 @@
+/**
+ * @file JsonReportWriter.cpp
+ * @brief Implementation of the JsonReportWriter class.
+ *
+ * @version 0.1
+ */
+
+#include "JsonReportWriter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "FastFloat.h"
+
+namespace {
+const char DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "74757677787980818283848586878889909192939495969798"
+    "99";  ///< "00" to "99", two characters per pair.
+
+const double POWERS_OF_TEN[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                1e18, 1e19, 1e20, 1e21, 1e22};
+
+/**
+ * @brief Writes the decimal digits of value, most significant first.
+ */
+char* writeDigits(uint64_t value, char* out) {
+  char digits[20];
+  char* p = digits + sizeof(digits);
+  while (value >= 100) {
+    p -= 2;
+    std::memcpy(p, DIGIT_PAIRS + (value % 100) * 2, 2);
+    value /= 100;
+  }
+  if (value >= 10) {
+    p -= 2;
+    std::memcpy(p, DIGIT_PAIRS + value * 2, 2);
+  } else {
+    *--p = static_cast<char>('0' + value);
+  }
+  std::size_t length = digits + sizeof(digits) - p;
+  std::memcpy(out, p, length);
+  return out + length;
+}
+
+/**
+ * @brief Checks that [first, last) parses back to value.
+ */
+bool roundTrips(const char* first, const char* last, double value) {
+  double parsed;
+  return FastFloat::parse(first, last, parsed) == last && parsed == value;
+}
+
+/**
+ * @brief Formats a positive magnitude in [1e-5, 1e15) with a given number
+ * of significant digits, in plain (non-exponent) notation.
+ */
+char* formatFixed(double magnitude, int decimalExponent, int precision,
+                  char* out) {
+  const int scale = precision - 1 - decimalExponent;  ///> In [0, 22]
+  const uint64_t scaled =
+      static_cast<uint64_t>(std::llround(magnitude * POWERS_OF_TEN[scale]));
+  char digits[20];
+  const int count = static_cast<int>(writeDigits(scaled, digits) - digits);
+  const int integerDigits = count - scale;
+
+  char* p = out;
+  if (integerDigits <= 0) {
+    *p++ = '0';
+    *p++ = '.';
+    for (int i = integerDigits; i < 0; ++i) {
+      *p++ = '0';
+    }
+    std::memcpy(p, digits, count);
+    p += count;
+  } else {
+    std::memcpy(p, digits, integerDigits);
+    p += integerDigits;
+    *p++ = '.';
+    std::memcpy(p, digits + integerDigits, count - integerDigits);
+    p += count - integerDigits;
+  }
+  while (p[-1] == '0') {
+    --p;
+  }
+  if (p[-1] == '.') {
+    --p;
+  }
+  return p;
+}
+}  // namespace
+
+JsonReportWriter::JsonReportWriter(std::ostream& out, JsonFormat format)
+    : out(out),
+      format(format),
+      buffer(BUFFER_SIZE),
+      used(0),
+      recordCount(0),
+      isFinished(false) {}
+
+JsonReportWriter::~JsonReportWriter() {
+  if (!isFinished) {
+    finish();
+  }
+}
+
+void JsonReportWriter::flush() {
+  out.write(buffer.data(), static_cast<std::streamsize>(used));
+  used = 0;
+}
+
+void JsonReportWriter::write(const ResultStore& results, std::size_t first,
+                             std::size_t last) {
+  last = std::min(last, results.size());
+
+  ///> Escape each unit once; records only copy the prepared bytes
+  const std::vector<std::shared_ptr<Units>>& units = results.getUnits();
+  unitFields.resize(units.size());
+  std::size_t longestUnitField = 0;
+  for (std::size_t id = 0; id < units.size(); ++id) {
+    unitFields[id] = ",\"unit\":" + escapeString(units[id]->getName()) +
+                     ",\"dimension\":" + escapeString(units[id]->getType());
+    longestUnitField = std::max(longestUnitField, unitFields[id].size());
+  }
+  const std::size_t maxRecord = 64 + MAX_NUMBER_LENGTH + longestUnitField;
+  if (buffer.size() < maxRecord) {
+    buffer.resize(maxRecord);
+  }
+
+  const bool isFloat = results.getPolicy() == StoragePolicy::FLOAT32;
+  const double* doubles = results.getDoubleMagnitudes().data();
+  const float* floats = results.getFloatMagnitudes().data();
+  const uint8_t* unitIds = results.getUnitIds().data();
+  const int64_t* lineNumbers = results.getLineNumbers().data();
+  const uint8_t* flags = results.getFlagsColumn().data();
+
+  for (std::size_t row = first; row < last; ++row) {
+    if (used + maxRecord > buffer.size()) {
+      flush();
+    }
+    char* p = buffer.data() + used;
+    if (format == JsonFormat::ARRAY) {
+      *p++ = recordCount == 0 ? '[' : ',';
+      *p++ = '\n';
+    }
+    std::memcpy(p, "{\"line\":", 8);
+    p = formatInteger(lineNumbers[row], p + 8);
+    std::memcpy(p, ",\"magnitude\":", 13);
+    const std::string& unitField = unitFields[unitIds[row]];
+    double magnitude = isFloat ? floats[row] : doubles[row];
+    const double factor = units[unitIds[row]]->getBaseFactor();
+    p = formatNumber(factor == 1.0 ? magnitude : magnitude * factor, p + 13);
+    std::memcpy(p, unitField.data(), unitField.size());
+    p += unitField.size();
+    if (flags[row] & RESULT_OUTLIER) {
+      std::memcpy(p, ",\"status\":\"outlier\"}", 20);
+      p += 20;
+    } else {
+      std::memcpy(p, ",\"status\":\"ok\"}", 15);
+      p += 15;
+    }
+    if (format == JsonFormat::NDJSON) {
+      *p++ = '\n';
+    }
+    used = p - buffer.data();
+    ++recordCount;
+  }
+}
+
+void JsonReportWriter::finish() {
+  if (format == JsonFormat::ARRAY) {
+    const char* end = recordCount == 0 ? "[]\n" : "\n]\n";
+    std::size_t length = std::strlen(end);
+    if (used + length > buffer.size()) {
+      flush();
+    }
+    std::memcpy(buffer.data() + used, end, length);
+    used += length;
+  }
+  flush();
+  out.flush();
+  isFinished = true;
+}
+
+std::size_t JsonReportWriter::getRecordCount() const {
+  return recordCount;
+}
+
+char* JsonReportWriter::formatNumber(double value, char* out) {
+  if (!std::isfinite(value)) {
+    std::memcpy(out, "null", 4);
+    return out + 4;
+  }
+  char* p = out;
+  if (std::signbit(value)) {
+    *p++ = '-';
+  }
+  const double magnitude = std::fabs(value);
+  if (magnitude == 0.0) {
+    *p++ = '0';
+    return p;
+  }
+
+  ///> Plain notation: 15 significant digits always round to the shortest
+  ///> representation if it has at most 15, otherwise try 16 and 17
+  if (magnitude >= 1e-5 && magnitude < 1e15) {
+    int decimalExponent = 14;
+    while (decimalExponent > 0 &&
+           magnitude < POWERS_OF_TEN[decimalExponent]) {
+      --decimalExponent;
+    }
+    while (decimalExponent <= 0 &&
+           magnitude * POWERS_OF_TEN[-decimalExponent] < 1.0) {
+      --decimalExponent;
+    }
+    for (int precision = 15; precision <= 17; ++precision) {
+      char* end = formatFixed(magnitude, decimalExponent, precision, p);
+      if (roundTrips(out, end, value)) {
+        return end;
+      }
+    }
+  }
+
+  ///> Exponent notation, or the rare value the scaled product misrounds
+  char text[MAX_NUMBER_LENGTH];
+  int length = 0;
+  for (int precision = 15; precision <= 17; ++precision) {
+    length = std::snprintf(text, sizeof(text), "%.*g", precision, magnitude);
+    if (std::strtod(text, nullptr) == magnitude) {
+      break;
+    }
+  }
+  std::memcpy(p, text, length);
+  return p + length;
+}
+
+char* JsonReportWriter::formatInteger(int64_t value, char* out) {
+  if (value < 0) {
+    *out++ = '-';
+    return writeDigits(0 - static_cast<uint64_t>(value), out);
+  }
+  return writeDigits(static_cast<uint64_t>(value), out);
+}
+
+std::string JsonReportWriter::escapeString(const std::string& text) {
+  std::string literal = "\"";
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      literal += '\\';
+      literal += c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      char escaped[8];
+      std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+      literal += escaped;
+    } else {
+      literal += c;
+    }
+  }
+  literal += '"';
+  return literal;
+}
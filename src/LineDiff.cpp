@@ -0,0 +1,202 @@
+/**
+ * @file LineDiff.cpp
+ * @brief Implementation of the LineDiff class.
+ *
+ * @version 0.1
+ */
+
+#include "LineDiff.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+
+namespace {
+/**
+ * @brief Per unit ID of a store: the factor to the base unit and a code
+ * shared by every unit of the same dimension, in either store.
+ */
+struct UnitTable {
+  std::vector<double> baseFactors;  ///< Per unit ID.
+  std::vector<std::size_t> codes;   ///< Per unit ID, into the dimensions.
+};
+
+/**
+ * @brief The dimensions seen so far and their base unit names.
+ */
+struct DimensionTable {
+  std::vector<std::string> names;      ///< Per code.
+  std::vector<std::string> baseUnits;  ///< Per code.
+
+  /**
+   * @brief Extends a store's table to the units added since the last batch.
+   */
+  void update(const ResultStore& results, UnitTable& table) {
+    const std::vector<std::shared_ptr<Units>>& units = results.getUnits();
+    for (std::size_t id = table.codes.size(); id < units.size(); ++id) {
+      const std::string type = units[id]->getType();
+      std::size_t code = 0;
+      while (code < names.size() && names[code] != type) {
+        ++code;
+      }
+      if (code == names.size()) {
+        names.push_back(type);
+        baseUnits.push_back(units[id]->getBaseUnit()->getName());
+      }
+      table.baseFactors.push_back(units[id]->getBaseFactor());
+      table.codes.push_back(code);
+    }
+  }
+};
+}  // namespace
+
+LineDiffStatistics::LineDiffStatistics()
+    : lines(0), paired(0), unpaired(0), mismatched(0), reported(0) {}
+
+LineDiff::LineDiff(MeasurementFileProcessor& year1,
+                   MeasurementFileProcessor& year2, DiffMetric metric,
+                   double threshold, std::size_t batchLines)
+    : year1(year1),
+      year2(year2),
+      metric(metric),
+      threshold(threshold),
+      batchLines(batchLines) {}
+
+const LineDiffStatistics& LineDiff::run(std::ostream& out) {
+  statistics = LineDiffStatistics();
+  out << "Line,Dimension,Unit,Year1,Year2,Delta,Ratio,PercentChange\n";
+
+  DimensionTable dimensions;
+  UnitTable units1, units2;
+  std::vector<int64_t> lines;
+  std::vector<std::size_t> codes;
+  std::vector<double> magnitudes1, magnitudes2, delta, ratio, percent;
+  std::vector<uint8_t> isReported;
+  for (;;) {
+    const std::size_t read1 = year1.readNextLines(batchLines);
+    const std::size_t read2 = year2.readNextLines(batchLines);
+    if (read1 == 0 && read2 == 0) {
+      break;
+    }
+    statistics.lines += std::max(read1, read2);
+    const ResultStore& results1 = year1.getResults();
+    const ResultStore& results2 = year2.getResults();
+    dimensions.update(results1, units1);
+    dimensions.update(results2, units2);
+
+    ///> Both batches cover the same line numbers; join them in order
+    lines.clear();
+    codes.clear();
+    magnitudes1.clear();
+    magnitudes2.clear();
+    std::size_t row1 = 0;
+    std::size_t row2 = 0;
+    while (row1 < results1.size() && row2 < results2.size()) {
+      const int64_t line1 = results1.getLineNumber(row1);
+      const int64_t line2 = results2.getLineNumber(row2);
+      if (line1 != line2) {
+        ++statistics.unpaired;
+        if (line1 < line2) {
+          ++row1;
+        } else {
+          ++row2;
+        }
+        continue;
+      }
+      const uint8_t id1 = results1.getUnitId(row1);
+      const uint8_t id2 = results2.getUnitId(row2);
+      if (units1.codes[id1] != units2.codes[id2]) {
+        ++statistics.mismatched;
+      } else {
+        lines.push_back(line1);
+        codes.push_back(units1.codes[id1]);
+        magnitudes1.push_back(results1.getMagnitude(row1) *
+                              units1.baseFactors[id1]);
+        magnitudes2.push_back(results2.getMagnitude(row2) *
+                              units2.baseFactors[id2]);
+      }
+      ++row1;
+      ++row2;
+    }
+    statistics.unpaired += (results1.size() - row1) + (results2.size() - row2);
+
+    const std::size_t count = lines.size();
+    delta.resize(count);
+    ratio.resize(count);
+    percent.resize(count);
+    isReported.resize(count);
+    statistics.paired += count;
+    statistics.reported +=
+        compare(magnitudes1.data(), magnitudes2.data(), count, metric,
+                threshold, delta.data(), ratio.data(), percent.data(),
+                isReported.data());
+    for (std::size_t i = 0; i < count; ++i) {
+      if (isReported[i]) {
+        out << lines[i] << "," << dimensions.names[codes[i]] << ","
+            << dimensions.baseUnits[codes[i]] << "," << magnitudes1[i] << ","
+            << magnitudes2[i] << "," << delta[i] << "," << ratio[i] << ","
+            << percent[i] << "\n";
+      }
+    }
+  }
+  return statistics;
+}
+
+std::size_t LineDiff::compare(const double* year1, const double* year2,
+                              std::size_t count, DiffMetric metric,
+                              double threshold, double* delta, double* ratio,
+                              double* percent, uint8_t* isReported) {
+  for (std::size_t i = 0; i < count; ++i) {
+    delta[i] = year2[i] - year1[i];
+    ratio[i] = year2[i] / year1[i];
+    percent[i] = delta[i] / std::fabs(year1[i]) * 100.0;
+  }
+
+  ///> One loop per metric keeps the loops free of branches
+  switch (metric) {
+    case DiffMetric::DELTA:
+      for (std::size_t i = 0; i < count; ++i) {
+        isReported[i] = std::fabs(delta[i]) > threshold;
+      }
+      break;
+    case DiffMetric::RATIO:
+      for (std::size_t i = 0; i < count; ++i) {
+        isReported[i] = (ratio[i] > threshold) | (ratio[i] * threshold < 1.0);
+      }
+      break;
+    case DiffMetric::PERCENT:
+      for (std::size_t i = 0; i < count; ++i) {
+        isReported[i] = std::fabs(percent[i]) > threshold;
+      }
+      break;
+  }
+
+  std::size_t reported = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    reported += isReported[i];
+  }
+  return reported;
+}
+
+bool LineDiff::parseSpec(const std::string& spec, DiffMetric& metric,
+                         double& threshold) {
+  const std::size_t colon = spec.find(':');
+  if (colon == std::string::npos || colon + 1 == spec.size()) {
+    return false;
+  }
+  const std::string name = spec.substr(0, colon);
+  if (name == "delta") {
+    metric = DiffMetric::DELTA;
+  } else if (name == "ratio") {
+    metric = DiffMetric::RATIO;
+  } else if (name == "percent") {
+    metric = DiffMetric::PERCENT;
+  } else {
+    return false;
+  }
+  const char* number = spec.c_str() + colon + 1;
+  char* end = nullptr;
+  threshold = std::strtod(number, &end);
+  return *end == '\0' && std::isfinite(threshold) && threshold >= 0 &&
+         (metric != DiffMetric::RATIO || threshold >= 1);
+}
@@ -0,0 +1,308 @@
+/**
+ * @file LineIndex.cpp
+ * @brief Implementation of the LineIndex and IndexedFile classes.
+ *
+ * @version 0.1
+ */
+
+#include "LineIndex.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+const char MAGIC[8] = {'U', 'N', 'T', 'F', 'Y', 'L', 'X', '1'};
+const std::size_t BLOCK_BYTES = 8 + 4 + 1;  ///< Offset, fine offset, width.
+
+template <typename T>
+void writeValue(std::ofstream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readValue(std::ifstream& in) {
+  T value;
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+    throw std::runtime_error("Truncated line index.");
+  }
+  return value;
+}
+}  // namespace
+
+const uint32_t LineIndex::DEFAULT_INTERVAL;
+
+LineIndex::LineIndex(uint32_t interval)
+    : interval(interval), lineCount(0), fileSize(0) {
+  if (interval == 0) {
+    throw std::invalid_argument("Line index interval must be positive.");
+  }
+}
+
+void LineIndex::addLine(uint64_t offset) {
+  pending.push_back(offset);
+  ++lineCount;
+  if (pending.size() == interval) {
+    flushBlock();
+  }
+}
+
+void LineIndex::flushBlock() {
+  if (pending.empty()) {
+    return;
+  }
+  const uint64_t base = pending.front();
+  const uint64_t span = pending.back() - base;
+  IndexBlock block;
+  block.offset = base;
+  block.fineOffset = static_cast<uint32_t>(fine.size());
+  block.width = span <= UINT8_MAX ? 1 : span <= UINT16_MAX ? 2 : 4;
+  if (span > UINT32_MAX) {
+    block.width = 8;  ///> A single block spanning more than 4 GiB
+  }
+  blocks.push_back(block);
+
+  ///> The first line of a block is the block offset itself
+  for (std::size_t i = 1; i < pending.size(); ++i) {
+    const uint64_t delta = pending[i] - base;
+    const std::size_t at = fine.size();
+    fine.resize(at + block.width);
+    std::memcpy(&fine[at], &delta, block.width);  ///> Little-endian low bytes
+  }
+  pending.clear();
+}
+
+void LineIndex::finish(uint64_t size) {
+  flushBlock();
+  fileSize = size;
+}
+
+void LineIndex::addFailedLine(int64_t line) {
+  if (failedLines.empty() || failedLines.back() != line) {
+    failedLines.push_back(line);
+  }
+}
+
+std::size_t LineIndex::getLineCount() const {
+  return lineCount;
+}
+
+uint64_t LineIndex::getFileSize() const {
+  return fileSize;
+}
+
+uint32_t LineIndex::getInterval() const {
+  return interval;
+}
+
+const std::vector<int64_t>& LineIndex::getFailedLines() const {
+  return failedLines;
+}
+
+uint64_t LineIndex::getLineOffset(std::size_t line) const {
+  if (line == 0 || line > lineCount) {
+    throw std::out_of_range("No such line: " + std::to_string(line));
+  }
+  const std::size_t position = line - 1;
+  const IndexBlock& block = blocks[position / interval];
+  const std::size_t inBlock = position % interval;
+  if (inBlock == 0) {
+    return block.offset;
+  }
+  uint64_t delta = 0;
+  std::memcpy(&delta, &fine[block.fineOffset + (inBlock - 1) * block.width],
+              block.width);
+  return block.offset + delta;
+}
+
+uint64_t LineIndex::getLineEnd(std::size_t line) const {
+  if (line == lineCount && line != 0) {
+    return fileSize;
+  }
+  if (line == 0 || line > lineCount) {
+    throw std::out_of_range("No such line: " + std::to_string(line));
+  }
+  return getLineOffset(line + 1);
+}
+
+std::vector<std::pair<std::size_t, std::size_t>> LineIndex::split(
+    std::size_t parts) const {
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  if (parts == 0) {
+    return ranges;
+  }
+  const std::size_t base = lineCount / parts;
+  const std::size_t extra = lineCount % parts;
+  std::size_t first = 1;
+  for (std::size_t part = 0; part < parts && first <= lineCount; ++part) {
+    const std::size_t count = base + (part < extra ? 1 : 0);
+    ranges.push_back(std::make_pair(first, first + count - 1));
+    first += count;
+  }
+  return ranges;
+}
+
+std::size_t LineIndex::memoryUsage() const {
+  return blocks.size() * sizeof(IndexBlock) + fine.size();
+}
+
+void LineIndex::save(const std::string& path) const {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Could not open line index: " + path);
+  }
+  out.write(MAGIC, sizeof(MAGIC));
+  writeValue<uint32_t>(out, interval);
+  writeValue<uint64_t>(out, fileSize);
+  writeValue<uint64_t>(out, lineCount);
+  writeValue<uint64_t>(out, blocks.size());
+  for (const IndexBlock& block : blocks) {
+    writeValue<uint64_t>(out, block.offset);
+    writeValue<uint32_t>(out, block.fineOffset);
+    writeValue<uint8_t>(out, block.width);
+  }
+  writeValue<uint64_t>(out, fine.size());
+  out.write(reinterpret_cast<const char*>(fine.data()), fine.size());
+  writeValue<uint64_t>(out, failedLines.size());
+  for (int64_t line : failedLines) {
+    writeValue<int64_t>(out, line);
+  }
+  if (!out) {
+    throw std::runtime_error("Could not write line index: " + path);
+  }
+}
+
+LineIndex LineIndex::load(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open line index: " + path);
+  }
+  char magic[sizeof(MAGIC)];
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error("Not a line index: " + path);
+  }
+  const uint32_t interval = readValue<uint32_t>(in);
+  if (interval == 0) {
+    throw std::runtime_error("Corrupt line index: " + path);
+  }
+
+  ///> Every count is checked against the bytes left before it sizes a vector
+  const std::streamoff start = in.tellg();
+  in.seekg(0, std::ios::end);
+  const uint64_t end = static_cast<uint64_t>(in.tellg());
+  in.seekg(start);
+  auto remaining = [&in, end]() {
+    return end - static_cast<uint64_t>(in.tellg());
+  };
+
+  LineIndex index(interval);
+  index.fileSize = readValue<uint64_t>(in);
+  index.lineCount = readValue<uint64_t>(in);
+  const uint64_t blockCount = readValue<uint64_t>(in);
+  if (blockCount != index.lineCount / interval +
+                        (index.lineCount % interval != 0 ? 1 : 0) ||
+      blockCount > remaining() / BLOCK_BYTES) {
+    throw std::runtime_error("Corrupt line index: " + path);
+  }
+  index.blocks.resize(blockCount);
+  for (IndexBlock& block : index.blocks) {
+    block.offset = readValue<uint64_t>(in);
+    block.fineOffset = readValue<uint32_t>(in);
+    block.width = readValue<uint8_t>(in);
+  }
+  ///> A block keeps at most interval - 1 fine entries of at most 8 bytes
+  const uint64_t fineSize = readValue<uint64_t>(in);
+  const uint64_t perBlock = static_cast<uint64_t>(interval - 1) * 8;
+  if (fineSize > remaining() ||
+      (blockCount != 0 &&
+       (fineSize + blockCount - 1) / blockCount > perBlock) ||
+      (blockCount == 0 && fineSize != 0)) {
+    throw std::runtime_error("Corrupt line index: " + path);
+  }
+  index.fine.resize(fineSize);
+  if (!in.read(reinterpret_cast<char*>(index.fine.data()),
+               index.fine.size())) {
+    throw std::runtime_error("Truncated line index.");
+  }
+  const uint64_t failedCount = readValue<uint64_t>(in);
+  if (failedCount > index.lineCount ||
+      failedCount > remaining() / sizeof(int64_t)) {
+    throw std::runtime_error("Corrupt line index: " + path);
+  }
+  index.failedLines.resize(failedCount);
+  for (int64_t& line : index.failedLines) {
+    line = readValue<int64_t>(in);
+  }
+
+  ///> getLineOffset copies width bytes of each fine entry into a uint64_t,
+  ///> so every block must use a valid width and stay inside the fine array
+  for (std::size_t b = 0; b < index.blocks.size(); ++b) {
+    const IndexBlock& block = index.blocks[b];
+    if (block.width != 1 && block.width != 2 && block.width != 4 &&
+        block.width != 8) {
+      throw std::runtime_error("Corrupt line index: " + path);
+    }
+    const uint64_t lines =
+        std::min<uint64_t>(interval, index.lineCount - b * interval);
+    if (block.fineOffset + (lines - 1) * block.width > index.fine.size()) {
+      throw std::runtime_error("Corrupt line index: " + path);
+    }
+  }
+  return index;
+}
+
+std::string LineIndex::getSidecarPath(const std::string& fileName) {
+  return fileName + ".lidx";
+}
+
+IndexedFile::IndexedFile(const std::string& path, const LineIndex& index)
+    : fd(::open(path.c_str(), O_RDONLY)), index(index) {
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open file: " + path);
+  }
+  struct stat status;
+  if (::fstat(fd, &status) != 0 ||
+      static_cast<uint64_t>(status.st_size) != index.getFileSize()) {
+    ::close(fd);
+    throw std::runtime_error("Line index does not match file: " + path);
+  }
+}
+
+IndexedFile::~IndexedFile() {
+  ::close(fd);
+}
+
+const LineIndex& IndexedFile::getIndex() const {
+  return index;
+}
+
+void IndexedFile::readLine(std::size_t line, std::string& text) const {
+  readLines(line, line, text);
+  if (!text.empty() && text.back() == '\n') {
+    text.pop_back();
+  }
+}
+
+void IndexedFile::readLines(std::size_t first, std::size_t last,
+                            std::string& text) const {
+  const uint64_t begin = index.getLineOffset(first);
+  const uint64_t end = index.getLineEnd(last);
+  text.resize(end > begin ? end - begin : 0);
+  std::size_t done = 0;
+  while (done < text.size()) {
+    ssize_t count = ::pread(fd, &text[done], text.size() - done,
+                            static_cast<off_t>(begin + done));
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      throw std::runtime_error("Failed to read line " + std::to_string(first));
+    }
+    done += static_cast<std::size_t>(count);
+  }
+}
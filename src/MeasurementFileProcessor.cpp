@@ -10,49 +10,93 @@
  */
 
 #include "MeasurementFileProcessor.h"
+#include <unistd.h>
 #include <algorithm>
+#include <cstring>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
-#include <set>
 #include <sstream>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include "CsvScanner.h"
+#include "ExpressionKernels.h"
+#include "FastFloat.h"
+#include "InputReader.h"
 #include "IOStreamHandler.h"
 #include "Measurement.h"
+#include "Operators.h"
 #include "ReportGenerator.h"
+#include "ReportUnits.h"
 #include "StatisticsCalculator.h"
+#include "TextScanner.h"
 #include "UnitConverter.h"
 
 /**
  * @namespace anonymous (not the hacktivist group :P)
- * @brief Anonymous namespace to encapsulate the validOperators set.
+ * @brief Anonymous namespace to encapsulate the validOperators table and
+ * report helpers.
  */
 namespace {
-static const std::set<std::string> validOperators = {
-    "+", "-", "*", "/"};  ///< Set of valid operators.
+constexpr char validOperators[] = "+-*/";  ///< The valid operators.
+
+/**
+ * @brief Sorts the selected rows by rendered magnitude; ties keep file order.
+ */
+std::vector<uint32_t> sortSelected(const std::vector<double>& magnitudes,
+                                   const Selection& selection) {
+  std::vector<uint32_t> rows = selection.getRows();
+  std::vector<std::pair<double, uint32_t>> pairs(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    pairs[i] = std::make_pair(magnitudes[rows[i]], rows[i]);
+  }
+  std::sort(pairs.begin(), pairs.end());
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    rows[i] = pairs[i].second;
+  }
+  return rows;
 }
+}  // namespace
 
 MeasurementFileProcessor::MeasurementFileProcessor(const std::string& fileName)
-    : fileName(fileName), isFileLoaded(false) {}
+    : fileName(fileName),
+      isFileLoaded(false),
+      outlierPolicy(OutlierPolicy::NONE),
+      isHistogramEnabled(false),
+      isDistinctCountEnabled(false),
+      isFixedPointEnabled(false),
+      defaultFixedPointPlaces(6),
+      isCsvInput(false),
+      isLineIndexEnabled(false),
+      readerBackend(ReaderBackend::IFSTREAM),
+      readerBlockSize(InputReader::DEFAULT_BLOCK_SIZE),
+      inputFd(-1),
+      isExpressionKernelEnabled(true),
+      isLoggingEnabled(true),
+      isAdaptiveModeEnabled(false),
+      streamScannedBytes(0),
+      streamNextLine(0),
+      streamLineNum(1),
+      isStreamEnded(false) {}
+
+const char MeasurementFileProcessor::STDIN_NAME[] = "-";
 
 bool MeasurementFileProcessor::isValidOperator(const std::string& op) {
-  return validOperators.find(op) != validOperators.end();
+  return op.size() == 1 && op[0] != '\0' &&
+         std::strchr(validOperators, op[0]) != nullptr;
 }
 
-enum precedence { INVALID = 0, MUL_DIV, ADD_SUB };
+static_assert(Operators::PRECEDENCE[Operators::ADD] ==
+                      MeasurementFileProcessor::ADD_SUB &&
+                  Operators::PRECEDENCE[Operators::MULTIPLY] ==
+                      MeasurementFileProcessor::MUL_DIV &&
+                  Operators::PRECEDENCE[Operators::INVALID] ==
+                      MeasurementFileProcessor::INVALID,
+              "Operators::PRECEDENCE must match the precedence enum");
 
 int MeasurementFileProcessor::getPrecedence(char op) {
-  switch (op) {
-    case '+':
-    case '-':
-      return ADD_SUB;  ///> Lower precedence
-    case '*':
-    case '/':
-      return MUL_DIV;  ///> Higher precedence
-    default:
-      return INVALID;  ///> Invalid operator
-  }
+  return Operators::PRECEDENCE[Operators::getOpcode(op)];
 }
 
 Measurement MeasurementFileProcessor::applyOperation(const Measurement& left,
@@ -70,26 +114,15 @@ Measurement MeasurementFileProcessor::applyOperation(const Measurement& left,
     Measurement rightBase = UnitConverter::convertToBaseUnit(right);
 
     // Perform the arithmetic in base units
-    double newMagnitude;
-    switch (op) {
-      case '+':
-        newMagnitude = leftBase.getMagnitude() + rightBase.getMagnitude();
-        break;
-      case '-':
-        newMagnitude = leftBase.getMagnitude() - rightBase.getMagnitude();
-        break;
-      case '*':
-        newMagnitude = leftBase.getMagnitude() * rightBase.getMagnitude();
-        break;
-      case '/':
-        if (rightBase.getMagnitude() == 0) {
-          throw std::invalid_argument("Division by zero is not allowed.");
-        }
-        newMagnitude = leftBase.getMagnitude() / rightBase.getMagnitude();
-        break;
-      default:
-        throw std::invalid_argument("Invalid operator.");
+    const Operators::Opcode opcode = Operators::getOpcode(op);
+    if (opcode == Operators::INVALID) {
+      throw std::invalid_argument("Invalid operator.");
     }
+    if (rightBase.getMagnitude() == 0 && Operators::IS_DIVISION[opcode]) {
+      throw std::invalid_argument("Division by zero is not allowed.");
+    }
+    double newMagnitude = Operators::apply(opcode, leftBase.getMagnitude(),
+                                           rightBase.getMagnitude());
 
     // Return result in the original left unit
     return UnitConverter::convertToBaseUnit(
@@ -107,8 +140,19 @@ Measurement MeasurementFileProcessor::processOperatorsWithPEMDAS(
   std::stack<Measurement> operandStack;
   std::stack<char> operatorStack;
 
-  std::cout << "Processing PEMDAS, operands: " << measurements.size()
-            << ", operators: " << operators.size() << std::endl;
+  if (isLoggingEnabled) {
+    std::cout << "Processing PEMDAS, operands: " << measurements.size()
+              << ", operators: " << operators.size() << std::endl;
+  }
+
+  double magnitude;
+  if (isExpressionKernelEnabled &&
+      ExpressionKernels::evaluate(measurements, operators, magnitude)) {
+    ///> A lone operand keeps its unit; results of operations are in base units
+    const std::shared_ptr<Units> unit = measurements[0].getUnit();
+    return Measurement(magnitude,
+                       measurements.size() == 1 ? unit : unit->getBaseUnit());
+  }
 
   for (size_t i = 0; i < measurements.size(); ++i) {
     operandStack.push(measurements[i]);
@@ -116,8 +160,10 @@ Measurement MeasurementFileProcessor::processOperatorsWithPEMDAS(
     if (i < operators.size()) {
       char currentOperator = operators[i];
 
-      while (!operatorStack.empty() && getPrecedence(operatorStack.top()) >=
-                                           getPrecedence(currentOperator)) {
+      while (!operatorStack.empty() &&
+             Operators::isAppliedBefore(
+                 Operators::getOpcode(operatorStack.top()),
+                 Operators::getOpcode(currentOperator))) {
         if (!applyTopOperator(operandStack, operatorStack)) {
           throw std::runtime_error("Failed to apply operator");
         }
@@ -164,35 +210,486 @@ bool MeasurementFileProcessor::applyTopOperator(
   }
 }
 
+void MeasurementFileProcessor::enableExpressionKernels(bool isEnabled) {
+  isExpressionKernelEnabled = isEnabled;
+}
+
+void MeasurementFileProcessor::enableLogging(bool isEnabled) {
+  isLoggingEnabled = isEnabled;
+}
+
+void MeasurementFileProcessor::enableHistograms(bool isEnabled) {
+  isHistogramEnabled = isEnabled;
+  dimensionSlots.clear();
+}
+
+void MeasurementFileProcessor::enableDistinctCounts(bool isEnabled) {
+  isDistinctCountEnabled = isEnabled;
+  dimensionSlots.clear();
+}
+
+void MeasurementFileProcessor::enableAdaptiveMode(bool isEnabled) {
+  isAdaptiveModeEnabled = isEnabled;
+  dimensionSlots.clear();
+}
+
+MeasurementFileProcessor::DimensionSlot&
+MeasurementFileProcessor::dimensionSlot(uint8_t unitId) {
+  if (unitId >= dimensionSlots.size()) {
+    dimensionSlots.resize(unitId + 1);
+  }
+  DimensionSlot& slot = dimensionSlots[unitId];
+  if (slot.isResolved) {
+    return slot;
+  }
+
+  const std::string dimension = results.getUnits()[unitId]->getType();
+  ///> The distinct counts are reported against the histogram's total
+  const bool isDistinct = isDistinctCountEnabled || isAdaptiveModeEnabled;
+  if (isHistogramEnabled || isDistinct) {
+    slot.histogram = &histograms[dimension];
+  }
+  if (isDistinct) {
+    slot.distinct = &distinctMagnitudes[dimension];
+  }
+  if (isFixedPointEnabled) {
+    auto column = fixedPointColumns.find(dimension);
+    if (column == fixedPointColumns.end()) {
+      auto places = fixedPointPlaces.find(dimension);
+      column = fixedPointColumns
+                   .insert(std::make_pair(
+                       dimension,
+                       FixedPointColumn(places == fixedPointPlaces.end()
+                                            ? defaultFixedPointPlaces
+                                            : places->second)))
+                   .first;
+    }
+    slot.fixedPoint = &column->second;
+  }
+  slot.isResolved = true;
+  return slot;
+}
+
 void MeasurementFileProcessor::readFile() {
-  std::ifstream file(fileName);
-  if (!file.is_open()) {
-    throw std::runtime_error("Failed to open file: " + fileName);
+  if (isCsvInput) {
+    readCsvFile();
+    return;
+  }
+
+  if (isLineIndexEnabled && (inputFd >= 0 || fileName == STDIN_NAME)) {
+    throw std::runtime_error("A line index needs a named input file.");
   }
 
-  std::string line;
+  std::unique_ptr<InputReader> reader = openInput();
+  std::vector<char> carried;  ///> An incomplete line kept from before
+  uint64_t carriedOffset = 0;
+  uint64_t offset = 0;        ///> File offset of the block
   int lineNum = 1;
 
-  while (getline(file, line)) {
-    std::vector<Measurement> measurements;
-    std::vector<char> operators;
+  const char* block;
+  std::size_t size;
+  while ((size = reader->next(block)) > 0) {
+    ///> A line straddling blocks is completed from the new block and
+    ///> evaluated on its own; the rest is scanned in place
+    std::size_t begin = 0;
+    if (!carried.empty()) {
+      const char* newline =
+          static_cast<const char*>(std::memchr(block, '\n', size));
+      begin = newline != nullptr ? newline - block + 1 : size;
+      carried.insert(carried.end(), block, block + begin);
+      if (newline != nullptr) {
+        processBuffer(carried.data(), carried.size(), false, carriedOffset,
+                      lineNum);
+        carried.clear();
+      }
+    }
+    if (begin < size) {
+      std::size_t consumed = begin + processBuffer(block + begin, size - begin,
+                                                   false, offset + begin,
+                                                   lineNum);
+      if (consumed < size) {
+        carriedOffset = offset + consumed;
+        carried.assign(block + consumed, block + size);
+      }
+    }
+    offset += size;
+  }
+  if (!carried.empty()) {
+    processBuffer(carried.data(), carried.size(), true, carriedOffset, lineNum);
+  }
+
+  if (isLineIndexEnabled) {
+    lineIndex.finish(offset);
+    for (int64_t line : failedLines) {
+      lineIndex.addFailedLine(line);
+    }
+    lineIndex.save(LineIndex::getSidecarPath(fileName));
+  }
+  isFileLoaded = true;
+}
 
-    processLine(line, lineNum++, measurements, operators);
+std::size_t MeasurementFileProcessor::processBuffer(const char* data,
+                                                    std::size_t size,
+                                                    bool isLast,
+                                                    uint64_t offset,
+                                                    int& lineNum) {
+  std::size_t consumed =
+      TextScanner::scanLines(data, size, isLast, scannedLines);
+  processScannedLines(data, scannedLines, 0, scannedLines.lineCount(), offset,
+                      lineNum);
+  return consumed;
+}
 
-    try {
-      Measurement result = processOperatorsWithPEMDAS(measurements, operators);
-      std::cout << "Result: " << result.getMagnitude() << " "
-                << result.getUnit()->getName() << std::endl;
-      measurementsList.push_back({result});
-    } catch (const std::exception& e) {
-      throw std::runtime_error("Error: " + std::string(e.what()));
+void MeasurementFileProcessor::processScannedLines(const char* data,
+                                                   const ScannedLines& scanned,
+                                                   std::size_t first,
+                                                   std::size_t last,
+                                                   uint64_t offset,
+                                                   int& lineNum) {
+  std::vector<Measurement>& measurements = lineMeasurements;
+  std::vector<char>& operators = lineOperators;
+  uint32_t lineBegin = first == 0 ? 0 : scanned.lineEnds[first - 1] + 1;
+  uint32_t tokenBegin = first == 0 ? 0 : scanned.lineTokenEnds[first - 1];
+  for (std::size_t i = first; i < last; ++i) {
+    const char* text = data + lineBegin;
+    std::size_t length = scanned.lineEnds[i] - lineBegin;
+    int currentLine = lineNum++;
+    if (isLineIndexEnabled) {
+      lineIndex.addLine(offset + lineBegin);
+    }
+    const TokenSpan* tokens = scanned.tokens.data() + tokenBegin;
+    const std::size_t tokenCount = scanned.lineTokenEnds[i] - tokenBegin;
+    measurements.clear();
+    operators.clear();
+    if (!processTokens(data, tokens, tokenCount, measurements, operators)) {
+      measurements.clear();
+      operators.clear();
+      processLine(std::string(text, length), currentLine, measurements,
+                  operators);
+    }
+    if (!isLineIndexEnabled) {
+      processMeasurements(data, tokens, tokenCount, currentLine, measurements,
+                          operators);
+    } else {
+      ///> The index must get saved, so a line that fails is only recorded
+      try {
+        processMeasurements(data, tokens, tokenCount, currentLine,
+                            measurements, operators);
+      } catch (const std::exception& e) {
+        std::cerr << "Line " << currentLine << " error: " << e.what()
+                  << std::endl;
+        if (failedLines.empty() || failedLines.back() != currentLine) {
+          failedLines.push_back(currentLine);
+        }
+      }
+    }
+    lineBegin = scanned.lineEnds[i] + 1;
+    tokenBegin = scanned.lineTokenEnds[i];
+  }
+}
+
+std::size_t MeasurementFileProcessor::readNextLines(std::size_t maxLines) {
+  if (isCsvInput) {
+    throw std::runtime_error("Line streaming is not supported for CSV input.");
+  }
+  if (!streamReader) {
+    streamReader = openInput();
+  }
+
+  results.clear();
+  std::size_t evaluated = 0;
+  while (evaluated < maxLines) {
+    ///> Each block is scanned once; batches take their lines from the scan
+    const std::size_t scannedCount = streamScanned.lineCount();
+    if (streamNextLine < scannedCount) {
+      const std::size_t last =
+          std::min(scannedCount, streamNextLine + (maxLines - evaluated));
+      processScannedLines(streamPending.data(), streamScanned, streamNextLine,
+                          last, 0, streamLineNum);
+      evaluated += last - streamNextLine;
+      streamNextLine = last;
+      continue;
+    }
+    if (isStreamEnded) {
+      break;
+    }
+
+    ///> Keep the partial line, append the next block and scan again
+    streamPending.erase(streamPending.begin(),
+                        streamPending.begin() + streamScannedBytes);
+    const char* block;
+    std::size_t size = streamReader->next(block);
+    isStreamEnded = size == 0;
+    if (size > 0) {
+      streamPending.insert(streamPending.end(), block, block + size);
+    }
+    streamScannedBytes =
+        TextScanner::scanLines(streamPending.data(), streamPending.size(),
+                               isStreamEnded, streamScanned);
+    streamNextLine = 0;
+  }
+  isFileLoaded = true;
+  return evaluated;
+}
+
+void MeasurementFileProcessor::readLines(const std::vector<int64_t>& lines) {
+  if (isCsvInput) {
+    throw std::runtime_error("Line access is not supported for CSV input.");
+  }
+  IndexedFile file(fileName,
+                   LineIndex::load(LineIndex::getSidecarPath(fileName)));
+  const bool wasIndexing = isLineIndexEnabled;
+  isLineIndexEnabled = false;  ///> The saved index already covers the file
+
+  std::string text;
+  for (std::size_t i = 0; i < lines.size();) {
+    ///> Consecutive lines are fetched and scanned together
+    std::size_t run = i + 1;
+    while (run < lines.size() && lines[run] == lines[run - 1] + 1) {
+      ++run;
+    }
+    if (lines[i] < 1) {
+      throw std::out_of_range("No such line: " + std::to_string(lines[i]));
+    }
+    file.readLines(static_cast<std::size_t>(lines[i]),
+                   static_cast<std::size_t>(lines[run - 1]), text);
+    int lineNum = static_cast<int>(lines[i]);
+    processBuffer(text.c_str(), text.size(), true, 0, lineNum);
+    i = run;
+  }
+
+  isLineIndexEnabled = wasIndexing;
+  isFileLoaded = true;
+}
+
+std::unique_ptr<InputReader> MeasurementFileProcessor::openInput() {
+  if (inputFd >= 0) {
+    return InputReader::open(inputFd, readerBackend, readerBlockSize);
+  }
+  if (fileName == STDIN_NAME) {
+    return InputReader::open(STDIN_FILENO, readerBackend, readerBlockSize);
+  }
+  return InputReader::open(fileName, readerBackend, readerBlockSize);
+}
+
+void MeasurementFileProcessor::readCsvFile() {
+  std::unique_ptr<InputReader> reader = openInput();
+
+  std::vector<char> buffer;
+  std::size_t carried = 0;  ///> Bytes of an incomplete record kept from before
+  ScannedRecords scanned;
+  std::vector<Measurement> measurements;
+  std::vector<char> operators;
+  std::string expression;
+  std::size_t magnitudeIndex = static_cast<std::size_t>(
+      csvOptions.magnitudeIndex >= 0 || csvOptions.hasHeader
+          ? csvOptions.magnitudeIndex
+          : 0);
+  std::size_t unitIndex = static_cast<std::size_t>(
+      csvOptions.unitIndex >= 0 || csvOptions.hasHeader ? csvOptions.unitIndex
+                                                        : 1);
+  bool isHeader = csvOptions.hasHeader;
+  int lineNum = 1;
+
+  bool isLast = false;
+  while (!isLast) {
+    ///> Quotes can span blocks, so records are scanned from a copy that
+    ///> starts with the incomplete record of the previous block
+    const char* block;
+    std::size_t count = reader->next(block);
+    isLast = count == 0;
+    buffer.resize(carried + count + 1);
+    std::memcpy(buffer.data() + carried, block, count);
+    std::size_t size = carried + count;
+    buffer[size] = '\0';
+
+    const char* data = buffer.data();
+    std::size_t consumed = CsvScanner::scanRecords(
+        data, size, isLast, csvOptions.delimiter, scanned);
+    uint32_t fieldBegin = 0;
+    for (std::size_t i = 0; i < scanned.recordCount(); ++i) {
+      const TokenSpan* fields = &scanned.fields[fieldBegin];
+      std::size_t count = scanned.recordFieldEnds[i] - fieldBegin;
+      fieldBegin = scanned.recordFieldEnds[i];
+      int currentLine = lineNum++;
+
+      if (isHeader) {
+        ///> Columns not given by index are looked up by name
+        for (std::size_t f = 0; f < count; ++f) {
+          std::string name = CsvScanner::getFieldText(data, fields[f]);
+          if (csvOptions.magnitudeIndex < 0 &&
+              name == csvOptions.magnitudeColumn) {
+            magnitudeIndex = f;
+          } else if (csvOptions.unitIndex < 0 &&
+                     name == csvOptions.unitColumn) {
+            unitIndex = f;
+          }
+        }
+        if (magnitudeIndex == static_cast<std::size_t>(-1)) {
+          throw std::runtime_error("CSV column not found: " +
+                                   csvOptions.magnitudeColumn);
+        }
+        if (unitIndex == static_cast<std::size_t>(-1)) {
+          throw std::runtime_error("CSV column not found: " +
+                                   csvOptions.unitColumn);
+        }
+        isHeader = false;
+        continue;
+      }
+      if (count == 1 && fields[0].length == 0) {
+        continue;  ///> Blank line
+      }
+
+      ///> The record becomes the one-operand expression "magnitude unit"
+      expression.clear();
+      if (magnitudeIndex < count) {
+        const TokenSpan& field = fields[magnitudeIndex];
+        if (CsvScanner::isQuoted(data, field)) {
+          expression += CsvScanner::getFieldText(data, field);
+        } else {
+          expression.append(data + field.begin, field.length);
+        }
+      }
+      const uint32_t magnitudeLength =
+          static_cast<uint32_t>(expression.size());
+      expression += ' ';
+      if (unitIndex < count) {
+        const TokenSpan& field = fields[unitIndex];
+        if (CsvScanner::isQuoted(data, field)) {
+          expression += CsvScanner::getFieldText(data, field);
+        } else {
+          expression.append(data + field.begin, field.length);
+        }
+      }
+      const TokenSpan tokens[2] = {
+          {0, magnitudeLength},
+          {magnitudeLength + 1,
+           static_cast<uint32_t>(expression.size()) - magnitudeLength - 1}};
+
+      measurements.clear();
+      operators.clear();
+      if (!processTokens(expression.c_str(), tokens, 2, measurements,
+                         operators)) {
+        measurements.clear();
+        operators.clear();
+        processLine(expression, currentLine, measurements, operators);
+      }
+      processMeasurements(expression.c_str(), tokens, 2, currentLine,
+                          measurements, operators);
     }
+
+    carried = size - consumed;
+    std::copy(buffer.begin() + consumed, buffer.begin() + size,
+              buffer.begin());
   }
 
-  file.close();
   isFileLoaded = true;
 }
 
+bool MeasurementFileProcessor::processTokens(
+    const char* data,
+    const TokenSpan* tokens,
+    std::size_t count,
+    std::vector<Measurement>& measurements,
+    std::vector<char>& operators) {
+  ///> Only "magnitude unit (operator magnitude unit)*" takes this path
+  if (count % 3 != 2) {
+    return false;
+  }
+  for (std::size_t t = 0; t < count; t += 3) {
+    const char* number = data + tokens[t].begin;
+    const char* numberEnd = number + tokens[t].length;
+    double magnitude;
+    if (FastFloat::parse(number, numberEnd, magnitude) != numberEnd) {
+      return false;  ///> Not a plain decimal, or out of range
+    }
+
+    std::shared_ptr<Units> unit;
+    try {
+      unit = Units::getUnitByName(
+          std::string(data + tokens[t + 1].begin, tokens[t + 1].length));
+    } catch (const std::invalid_argument&) {
+      return false;  ///> The reference path reports the invalid unit
+    }
+    measurements.emplace_back(magnitude, unit);
+
+    if (t + 2 < count) {
+      const TokenSpan& op = tokens[t + 2];
+      char symbol = data[op.begin];
+      if (op.length != 1 || (symbol != '+' && symbol != '-' &&
+                             symbol != '*' && symbol != '/')) {
+        return false;
+      }
+      operators.push_back(symbol);
+    }
+  }
+  return true;
+}
+
+void MeasurementFileProcessor::processMeasurements(
+    const char* data,
+    const TokenSpan* tokens,
+    std::size_t tokenCount,
+    int currentLine,
+    const std::vector<Measurement>& measurements,
+    const std::vector<char>& operators) {
+  if (isDistinctCountEnabled) {
+    for (const auto& m : measurements) {
+      const std::shared_ptr<Units>& unit = m.getUnit();
+      distinctUnits[unit->getType()].addHash(
+          HyperLogLog::hashString(unit->getName()) ^
+          HyperLogLog::hashDouble(unit->getBaseFactor()));
+    }
+  }
+
+  try {
+    Measurement result = processOperatorsWithPEMDAS(measurements, operators);
+    bool isOutlier = false;
+    if (outlierPolicy != OutlierPolicy::NONE) {
+      ///> A lone operand keeps its unit, so compare on the base unit's scale
+      const std::shared_ptr<Units>& unit = result.getUnit();
+      isOutlier = outlierDetectors[unit->getType()].add(
+          result.getMagnitude() * unit->getBaseFactor());
+      if (isOutlier) {
+        outlierLines.push_back(currentLine);
+      }
+    }
+    if (isLoggingEnabled) {
+      std::cout << "Result: " << result.getMagnitude() << " "
+                << result.getUnit()->getName()
+                << (isOutlier ? " (outlier)" : "") << std::endl;
+    }
+    if (!isOutlier || outlierPolicy == OutlierPolicy::FLAG) {
+      results.append(currentLine, result,
+                     isOutlier ? RESULT_OUTLIER : 0);
+      DimensionSlot& slot = dimensionSlot(results.getUnitIds().back());
+      ///> A lone operand keeps its unit; bins are in the base unit's scale
+      const double base =
+          result.getMagnitude() * result.getUnit()->getBaseFactor();
+      if (slot.histogram != nullptr) {
+        slot.histogram->record(base);
+      }
+      if (slot.distinct != nullptr) {
+        slot.distinct->add(base);
+      }
+      if (slot.fixedPoint != nullptr) {
+        int64_t value;
+        FixedPointStatus status =
+            evaluateFixedPoint(data, tokens, tokenCount, result,
+                               slot.fixedPoint->places, value);
+        if (status == FixedPointStatus::OUT_OF_RANGE) {
+          ++slot.fixedPoint->outOfRange;
+        } else {
+          slot.fixedPoint->rounded += status == FixedPointStatus::ROUNDED;
+          slot.fixedPoint->values.push_back(value);
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    throw std::runtime_error("Error: " + std::string(e.what()));
+  }
+}
+
 void MeasurementFileProcessor::processLine(
     const std::string& line,
     int lineNum,
@@ -215,31 +712,194 @@ void MeasurementFileProcessor::processLine(
       }
     } catch (const std::exception& e) {
       std::cerr << "Line " << lineNum << " error: " << e.what() << std::endl;
+      if (failedLines.empty() || failedLines.back() != lineNum) {
+        failedLines.push_back(lineNum);
+      }
     }
   }
 }
 
-void MeasurementFileProcessor::sortMeasurements() {
-  if (!isFileLoaded) {
-    std::cerr << "No file loaded to process." << std::endl;
-    return;
+bool MeasurementFileProcessor::parseLine(const std::string& line, int lineNum,
+                                         std::vector<Measurement>& measurements,
+                                         std::vector<char>& operators) {
+  ScannedLines& scanned = scannedLines;
+  TextScanner::scanLines(line.c_str(), line.size(), true, scanned);
+  if (scanned.lineCount() == 1 &&
+      processTokens(line.c_str(), scanned.tokens.data(),
+                    scanned.lineTokenEnds[0], measurements, operators)) {
+    return true;
   }
+  ///> Rejected lines, and lines a newline would split, go to processLine
+  measurements.clear();
+  operators.clear();
+  processLine(line, lineNum, measurements, operators);
+  return false;
+}
 
-  std::vector<Measurement> measurementsToSort;
+void MeasurementFileProcessor::setCsvInput(const CsvOptions& options) {
+  isCsvInput = true;
+  csvOptions = options;
+}
 
-  for (const auto& measurements : measurementsList) {
-    for (const auto& m : measurements) {
-      measurementsToSort.push_back(m);
+void MeasurementFileProcessor::setReaderBackend(ReaderBackend backend,
+                                                std::size_t blockSize) {
+  readerBackend = backend;
+  readerBlockSize = blockSize;
+}
+
+void MeasurementFileProcessor::setInputDescriptor(int fd) {
+  inputFd = fd;
+}
+
+void MeasurementFileProcessor::enableLineIndex(uint32_t interval) {
+  isLineIndexEnabled = true;
+  lineIndex = LineIndex(interval);
+}
+
+const LineIndex& MeasurementFileProcessor::getLineIndex() const {
+  return lineIndex;
+}
+
+const std::vector<int64_t>& MeasurementFileProcessor::getFailedLines() const {
+  return failedLines;
+}
+
+void MeasurementFileProcessor::setOutlierPolicy(OutlierPolicy policy) {
+  outlierPolicy = policy;
+}
+
+const std::map<std::string, OutlierDetector>&
+MeasurementFileProcessor::getOutlierDetectors() const {
+  return outlierDetectors;
+}
+
+const std::vector<int>& MeasurementFileProcessor::getOutlierLines() const {
+  return outlierLines;
+}
+
+const std::map<std::string, Histogram>&
+MeasurementFileProcessor::getHistograms() const {
+  return histograms;
+}
+
+const std::map<std::string, HyperLogLog>&
+MeasurementFileProcessor::getDistinctMagnitudes() const {
+  return distinctMagnitudes;
+}
+
+const std::map<std::string, HyperLogLog>&
+MeasurementFileProcessor::getDistinctUnits() const {
+  return distinctUnits;
+}
+
+FixedPointStatus MeasurementFileProcessor::evaluateFixedPoint(
+    const char* data,
+    const TokenSpan* tokens,
+    std::size_t count,
+    const Measurement& result,
+    int places,
+    int64_t& out) {
+  ///> Exact path: "m u (+|-) m u ..." with every token well formed
+  bool additive = count % 3 == 2;
+  for (size_t i = 2; additive && i < count; i += 3) {
+    char symbol = data[tokens[i].begin];
+    additive = tokens[i].length == 1 && (symbol == '+' || symbol == '-');
+  }
+  if (additive && count == 2) {
+    ///> A single operand is not converted by the evaluator either
+    FixedPointStatus status = FixedPoint::parseDecimal(
+        std::string(data + tokens[0].begin, tokens[0].length), places, out);
+    if (status != FixedPointStatus::INVALID) {
+      return status;
     }
+  } else if (additive) {
+    int64_t total = 0;
+    FixedPointStatus status = FixedPointStatus::EXACT;
+    for (size_t i = 0; i < count; i += 3) {
+      int64_t value;
+      FixedPointStatus termStatus;
+      try {
+        termStatus = FixedPoint::parseInUnit(
+            std::string(data + tokens[i].begin, tokens[i].length), places,
+            Units::getUnitByName(std::string(data + tokens[i + 1].begin,
+                                             tokens[i + 1].length))
+                ->getBaseFactor(),
+            value);
+      } catch (const std::invalid_argument&) {
+        termStatus = FixedPointStatus::INVALID;
+      }
+      if (termStatus == FixedPointStatus::INVALID) {
+        status = termStatus;
+        break;
+      }
+      if (termStatus == FixedPointStatus::OUT_OF_RANGE) {
+        return termStatus;
+      }
+      if (termStatus == FixedPointStatus::ROUNDED) {
+        status = termStatus;
+      }
+      bool overflow = (i == 0 || data[tokens[i - 1].begin] == '+')
+                          ? __builtin_add_overflow(total, value, &total)
+                          : __builtin_sub_overflow(total, value, &total);
+      if (overflow) {
+        return FixedPointStatus::OUT_OF_RANGE;
+      }
+    }
+    if (status != FixedPointStatus::INVALID) {
+      out = total;
+      return status;
+    }
+  }
+
+  return FixedPoint::fromDouble(result.getMagnitude(), places, out);
+}
+
+void MeasurementFileProcessor::enableFixedPoint(
+    int defaultPlaces,
+    const std::map<std::string, int>& places) {
+  if (defaultPlaces < 0 || defaultPlaces > FixedPoint::MAX_PLACES) {
+    throw std::invalid_argument("Invalid number of decimal places.");
+  }
+  for (const auto& entry : places) {
+    if (entry.second < 0 || entry.second > FixedPoint::MAX_PLACES) {
+      throw std::invalid_argument("Invalid number of decimal places for " +
+                                  entry.first + ".");
+    }
+  }
+  isFixedPointEnabled = true;
+  defaultFixedPointPlaces = defaultPlaces;
+  fixedPointPlaces = places;
+  dimensionSlots.clear();
+}
+
+const std::map<std::string, FixedPointColumn>&
+MeasurementFileProcessor::getFixedPointColumns() const {
+  return fixedPointColumns;
+}
+
+void MeasurementFileProcessor::setStoragePolicy(StoragePolicy policy) {
+  results = ResultStore(policy);
+  dimensionSlots.clear();  ///> The new store numbers its units afresh
+}
+
+void MeasurementFileProcessor::setReportUnits(const ReportUnits& units) {
+  reportUnits = units;
+}
+
+const ResultStore& MeasurementFileProcessor::getResults() const {
+  return results;
+}
+
+void MeasurementFileProcessor::sortMeasurements() {
+  if (!isFileLoaded) {
+    std::cerr << "No file loaded to process." << std::endl;
+    return;
   }
 
-  std::sort(measurementsToSort.begin(), measurementsToSort.end(),
-            [](const Measurement& a, const Measurement& b) {
-              return a.getMagnitude() < b.getMagnitude();
-            });
   std::cout << "Sorted measurements: \n";
-  for (const auto& m : measurementsToSort) {
-    std::cout << m.getMagnitude() << " " << m.getUnit()->getName() << "\n";
+  for (uint32_t row : results.sortedOrder()) {
+    std::cout << results.getMagnitude(row) << " "
+              << results.getUnit(row)->getName() << "\n";
   }
 }
 
@@ -249,31 +909,34 @@ void MeasurementFileProcessor::numberOriginalOrder() {
     return;
   }
 
-  int i = 1;
-  for (const auto& measurements : measurementsList) {
-    for (const auto& m : measurements) {
-      std::cout << i++ << ". " << m.getMagnitude() << " "
-                << m.getUnit()->getName() << std::endl;
-    }
+  for (size_t row = 0; row < results.size(); ++row) {
+    std::cout << row + 1 << ". " << results.getMagnitude(row) << " "
+              << results.getUnit(row)->getName() << std::endl;
   }
 }
 
 std::vector<std::string>
 MeasurementFileProcessor::generateReportsInOriginalOrder() {
+  return generateReportsInOriginalOrder(Selection(results.size(), true));
+}
+
+std::vector<std::string>
+MeasurementFileProcessor::generateReportsInOriginalOrder(
+    const Selection& selection) {
   if (!isFileLoaded) {
     std::cerr << "No file loaded to process." << std::endl;
     return {};
   }
 
+  std::vector<std::string> labels;
+  const std::vector<double> magnitudes = reportUnits.scale(results, labels);
   std::vector<std::string> reportLines;
-
-  for (const auto& measurements : measurementsList) {
-    for (const auto& m : measurements) {
-      std::ostringstream oss;
-      oss << std::fixed << std::setprecision(2);
-      oss << m.getMagnitude() << " " << m.getUnit()->getName();
-      reportLines.push_back(oss.str());
-    }
+  reportLines.reserve(selection.count());
+  for (uint32_t row : selection.getRows()) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    oss << magnitudes[row] << " " << labels[results.getUnitId(row)];
+    reportLines.push_back(oss.str());
   }
 
   return reportLines;
@@ -281,28 +944,28 @@ MeasurementFileProcessor::generateReportsInOriginalOrder() {
 
 std::vector<std::string>
 MeasurementFileProcessor::generateReportsInSortedOrder() {
+  return generateReportsInSortedOrder(Selection(results.size(), true));
+}
+
+std::vector<std::string> MeasurementFileProcessor::generateReportsInSortedOrder(
+    const Selection& selection) {
   if (!isFileLoaded) {
     std::cerr << "No file loaded to process." << std::endl;
     return {};
   }
 
-  std::vector<Measurement> sortedMeasurements;
-
-  for (const auto& measurements : measurementsList) {
-    for (const auto& m : measurements) {
-      sortedMeasurements.push_back(m);
-    }
-  }
-
-  std::sort(sortedMeasurements.begin(), sortedMeasurements.end(),
-            [](const Measurement& a, const Measurement& b) {
-              return a.getMagnitude() < b.getMagnitude();
-            });
+  std::vector<std::string> labels;
+  const std::vector<double> magnitudes = reportUnits.scale(results, labels);
+  ///> Rescaled rows of one dimension may change order; sort what is printed
+  const std::vector<uint32_t> order =
+      reportUnits.empty() ? results.sortedOrder(selection)
+                          : sortSelected(magnitudes, selection);
   std::vector<std::string> reportLines;
-  for (const auto& m : sortedMeasurements) {
+  reportLines.reserve(selection.count());
+  for (uint32_t row : order) {
     std::ostringstream oss;
     oss << std::fixed << std::setprecision(2);
-    oss << m.getMagnitude() << " " << m.getUnit()->getName();
+    oss << magnitudes[row] << " " << labels[results.getUnitId(row)];
     reportLines.push_back(oss.str());
   }
 
@@ -315,24 +978,43 @@ void MeasurementFileProcessor::computeStatistics() {
     return;
   }
 
-  std::vector<Measurement> measurementsForStats;
-
-  for (const auto& measurements : measurementsList) {
-    for (const auto& m : measurements) {
-      measurementsForStats.push_back(m);
-    }
-  }
-
-  if (measurementsList.empty()) {
+  if (results.empty()) {
     std::cerr << "No measurements to compute statistics." << std::endl;
     return;
   }
 
-  double mean = StatisticsCalculator::computeMean(measurementsForStats);
-  double mode = StatisticsCalculator::computeMode(measurementsForStats);
-  double median = StatisticsCalculator::computeMedian(measurementsForStats);
+  double mean = results.computeMean();
+  double mode = 0.0;
+  if (!isAdaptiveModeEnabled) {
+    mode = results.computeMode();
+  } else {
+    ///> The sketches and histograms from ingest decide the mode method
+    HyperLogLog distinct;
+    Histogram histogram;
+    for (const auto& entry : distinctMagnitudes) {
+      distinct.merge(entry.second);
+    }
+    for (const auto& entry : histograms) {
+      histogram.merge(entry.second);
+    }
+    mode = StatisticsCalculator::chooseModeStrategy(
+               distinct.estimate(), results.size()) == ModeStrategy::EXACT
+               ? results.computeMode()
+               : StatisticsCalculator::computeBinnedMode(histogram);
+  }
+  double median = results.computeMedian();
 
   std::cout << "Mean: " << mean << "\n";
   std::cout << "Mode: " << mode << "\n";
   std::cout << "Median: " << median << "\n";
-}
\ No newline at end of file
+
+  if (outlierPolicy != OutlierPolicy::NONE) {
+    std::cout << ReportGenerator::generateOutlierReport(outlierDetectors);
+  }
+  if (isFixedPointEnabled) {
+    std::cout << ReportGenerator::generateFixedPointReport(fixedPointColumns);
+  }
+  if (results.getPolicy() == StoragePolicy::FLOAT32) {
+    std::cout << ReportGenerator::generatePrecisionLossReport(results);
+  }
+}
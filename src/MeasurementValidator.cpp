@@ -11,63 +11,28 @@
  */
 
 #include "MeasurementValidator.h"
-#include <set>
+
+namespace {
+///> Constant-initialized; checking a unit builds no container
+constexpr const char* validUnits[] = {
+    "micrometers", "um", "millimeters", "mm", "centimeters", "cm", "decimeters",
+    "dm", "meters", "m", "kilometers", "km", "microliters", "uL", "ul",
+    "milliliters", "mL", "ml", "centiliters", "cL", "cl", "deciliters", "dL",
+    "dl", "liters", "L", "l", "kiloliters", "kL", "kl", "micrograms", "ug",
+    "milligrams", "mg", "centigrams", "cg", "decigrams", "dg", "grams", "g",
+    "kilograms", "kg", "milliseconds", "ms", "seconds", "s", "minutes", "min",
+    "hours", "hr"};
+}  // namespace
 
 bool MeasurementValidator::validateMeasurement(const Measurement& m) {
   return m.getMagnitude() >= 0;
 }
 
 bool MeasurementValidator::validateUnit(const std::string& unitStr) {
-  std::set<std::string> validUnits = {"micrometers",
-                                      "um"
-                                      "millimeters",
-                                      "mm",
-                                      "centimeters",
-                                      "cm",
-                                      "decimeters",
-                                      "dm",
-                                      "meters",
-                                      "m",
-                                      "kilometers",
-                                      "km",
-                                      "microliters",
-                                      "uL",
-                                      "ul",
-                                      "milliliters",
-                                      "mL",
-                                      "ml",
-                                      "centiliters",
-                                      "cL",
-                                      "cl",
-                                      "deciliters",
-                                      "dL",
-                                      "dl",
-                                      "liters",
-                                      "L",
-                                      "l",
-                                      "kiloliters",
-                                      "kL",
-                                      "kl",
-                                      "micrograms",
-                                      "ug",
-                                      "milligrams",
-                                      "mg",
-                                      "centigrams",
-                                      "cg",
-                                      "decigrams",
-                                      "dg",
-                                      "grams",
-                                      "g",
-                                      "kilograms",
-                                      "kg",
-                                      "milliseconds",
-                                      "ms",
-                                      "seconds",
-                                      "s",
-                                      "minutes",
-                                      "min",
-                                      "hours",
-                                      "hr"};
-
-  return validUnits.find(unitStr) != validUnits.end();
+  for (const char* unit : validUnits) {
+    if (unitStr == unit) {
+      return true;
+    }
+  }
+  return false;
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+/**
+ * @file Operators.cpp
+ * @brief Definitions of the Operators tables.
+ *
+ * The tables are indexed at run time, so they need one definition each.
+ *
+ * @version 0.1
+ */
+
+#include "Operators.h"
+
+const int Operators::COUNT;
+constexpr Operators::Opcode Operators::OPCODES[6];
+constexpr char Operators::SYMBOLS[Operators::COUNT + 1];
+constexpr int Operators::PRECEDENCE[Operators::COUNT + 1];
+constexpr bool Operators::IS_LEFT_ASSOCIATIVE[Operators::COUNT + 1];
+constexpr bool Operators::IS_DIVISION[Operators::COUNT + 1];
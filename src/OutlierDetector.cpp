@@ -0,0 +1,167 @@
+/**
+ * @file OutlierDetector.cpp
+ * @brief Implementation of the RollingMedian and OutlierDetector classes.
+ *
+ * @version 0.1
+ */
+
+#include "OutlierDetector.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+RollingMedian::RollingMedian(std::size_t window)
+    : window(window == 0 ? 1 : window) {}
+
+void RollingMedian::rebalance() {
+  while (low.size() > high.size() + 1) {
+    auto last = std::prev(low.end());
+    high.insert(*last);
+    low.erase(last);
+  }
+  while (high.size() > low.size()) {
+    auto first = high.begin();
+    low.insert(*first);
+    high.erase(first);
+  }
+}
+
+void RollingMedian::add(double value) {
+  if (history.size() == window) {
+    double oldest = history.front();
+    history.pop_front();
+    // The oldest value is in whichever half still brackets it.
+    auto it = low.find(oldest);
+    if (it != low.end()) {
+      low.erase(it);
+    } else {
+      high.erase(high.find(oldest));
+    }
+  }
+
+  history.push_back(value);
+  if (low.empty() || value <= *low.rbegin()) {
+    low.insert(value);
+  } else {
+    high.insert(value);
+  }
+  rebalance();
+}
+
+double RollingMedian::median() const {
+  if (low.empty()) {
+    return 0.0;
+  }
+  if (low.size() > high.size()) {
+    return *low.rbegin();
+  }
+  return (*low.rbegin() + *high.begin()) / 2;
+}
+
+std::size_t RollingMedian::size() const {
+  return history.size();
+}
+
+RollingMoments::RollingMoments(std::size_t window)
+    : window(window == 0 ? 1 : window), mean(0.0), m2(0.0) {}
+
+void RollingMoments::add(double value) {
+  if (history.size() == window) {
+    double oldest = history.front();
+    history.pop_front();
+    if (history.empty()) {
+      mean = 0.0;
+      m2 = 0.0;
+    } else {
+      double delta = oldest - mean;
+      mean -= delta / history.size();
+      ///> Rounding must not leave a negative variance behind
+      m2 = std::max(0.0, m2 - delta * (oldest - mean));
+    }
+  }
+
+  history.push_back(value);
+  double delta = value - mean;
+  mean += delta / history.size();
+  m2 += delta * (value - mean);
+}
+
+double RollingMoments::getMean() const {
+  return mean;
+}
+
+double RollingMoments::getStandardDeviation() const {
+  if (history.size() < 2) {
+    return 0.0;
+  }
+  return std::sqrt(m2 / (history.size() - 1));
+}
+
+OutlierDetector::OutlierDetector(std::size_t window, std::size_t minSamples,
+                                 double robustThreshold, double zThreshold)
+    : values(window),
+      deviations(window),
+      moments(window),
+      minSamples(minSamples),
+      robustThreshold(robustThreshold),
+      zThreshold(zThreshold),
+      outliers(0),
+      nonFinite(0) {}
+
+bool OutlierDetector::add(double value) {
+  ///> NaN would break the ordering of the windows and infinities their
+  ///> deviations, so neither enters them or the moments
+  if (!std::isfinite(value)) {
+    ++nonFinite;
+    return true;
+  }
+  raw.add(value);
+
+  bool isOutlier = false;
+  if (raw.getCount() > minSamples) {
+    double deviation = std::fabs(value - values.median());
+    double mad = deviations.median();
+    ///> 0.6745 scales the MAD to the standard deviation of a normal sample
+    if (robustThreshold > 0 && mad > 0 &&
+        0.6745 * deviation / mad > robustThreshold) {
+      isOutlier = true;
+    }
+
+    double stddev = moments.getStandardDeviation();
+    if (zThreshold > 0 && stddev > 0 &&
+        std::fabs(value - moments.getMean()) / stddev > zThreshold) {
+      isOutlier = true;
+    }
+  }
+
+  ///> The windows see every value so a genuine level shift is accepted; the
+  ///> clean moments would keep flagging the new level forever
+  if (values.size() > 0) {
+    deviations.add(std::fabs(value - values.median()));
+  }
+  values.add(value);
+  moments.add(value);
+
+  if (isOutlier) {
+    ++outliers;
+  } else {
+    clean.add(value);
+  }
+  return isOutlier;
+}
+
+const RunningStatistics& OutlierDetector::getRawStatistics() const {
+  return raw;
+}
+
+const RunningStatistics& OutlierDetector::getCleanStatistics() const {
+  return clean;
+}
+
+std::size_t OutlierDetector::getOutlierCount() const {
+  return outliers;
+}
+
+std::size_t OutlierDetector::getNonFiniteCount() const {
+  return nonFinite;
+}
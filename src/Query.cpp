@@ -0,0 +1,526 @@
+/**
+ * @file Query.cpp
+ * @brief Implementation of the Query class.
+ *
+ * @version 0.1
+ */
+
+#include "Query.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include "ResultFilter.h"
+#include "StatisticsCalculator.h"
+
+namespace {
+const char* const clauseNames[] = {"select", "where", "convert",
+                                   "stats",  "sort",  "limit"};
+
+/**
+ * @brief Checks whether a word starts a clause.
+ */
+bool isClause(const std::string& word) {
+  for (const char* name : clauseNames) {
+    if (word == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Splits a clause's text on a separator; empty items are errors.
+ */
+std::vector<std::string> splitList(const std::string& text, char separator,
+                                   const std::string& clause) {
+  std::vector<std::string> items;
+  std::stringstream list(text);
+  std::string item;
+  while (getline(list, item, separator)) {
+    if (item.empty()) {
+      throw std::invalid_argument("Empty item in " + clause + " clause.");
+    }
+    items.push_back(item);
+  }
+  if (items.empty() || text.back() == separator) {
+    throw std::invalid_argument("Empty item in " + clause + " clause.");
+  }
+  return items;
+}
+
+/**
+ * @brief Parses the whole of a string as a finite number.
+ */
+double parseNumber(const std::string& text, const std::string& context) {
+  char* end = nullptr;
+  const double value = std::strtod(text.c_str(), &end);
+  if (text.empty() || *end != '\0' || !std::isfinite(value)) {
+    throw std::invalid_argument("Invalid number in query: " + context);
+  }
+  return value;
+}
+
+/**
+ * @brief Checks whether a statistic name is known: a fixed aggregate or
+ * pNN with 0 < NN <= 100.
+ */
+bool isStatistic(const std::string& name) {
+  const char* const fixed[] = {"count", "sum", "mean", "median",
+                               "mode",  "min", "max"};
+  for (const char* known : fixed) {
+    if (name == known) {
+      return true;
+    }
+  }
+  if (name.size() < 2 || name[0] != 'p') {
+    return false;
+  }
+  char* end = nullptr;
+  const double percent = std::strtod(name.c_str() + 1, &end);
+  return *end == '\0' && percent > 0 && percent <= 100;
+}
+
+/**
+ * @brief Computes one statistic over values without NaN; may reorder them.
+ */
+double computeStatistic(const std::string& name, std::vector<double>& values) {
+  if (name == "count") {
+    return static_cast<double>(values.size());
+  }
+  if (values.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  if (name == "sum") {
+    double sum = 0.0;
+    for (double value : values) {
+      sum += value;
+    }
+    return sum;
+  } else if (name == "mean") {
+    return StatisticsCalculator::computeMean(values);
+  } else if (name == "median") {
+    ///> computeMedian selects in place, which only reorders the values
+    return StatisticsCalculator::computeMedian(values);
+  } else if (name == "mode") {
+    return StatisticsCalculator::computeMode(values);
+  } else if (name == "min") {
+    return *std::min_element(values.begin(), values.end());
+  } else if (name == "max") {
+    return *std::max_element(values.begin(), values.end());
+  }
+  ///> Nearest rank: the smallest value with at least NN% of values below it
+  const double percent = std::strtod(name.c_str() + 1, nullptr);
+  std::size_t rank =
+      static_cast<std::size_t>(std::ceil(percent / 100 * values.size()));
+  rank = std::max<std::size_t>(rank, 1);
+  std::nth_element(values.begin(), values.begin() + (rank - 1), values.end());
+  return values[rank - 1];
+}
+
+/**
+ * @brief Orders (magnitude, row) pairs by magnitude, NaN last, then by row.
+ */
+struct RowOrder {
+  bool isDescending;
+
+  bool operator()(const std::pair<double, uint32_t>& a,
+                  const std::pair<double, uint32_t>& b) const {
+    const bool isNanA = std::isnan(a.first);
+    const bool isNanB = std::isnan(b.first);
+    if (isNanA || isNanB) {
+      return isNanA == isNanB ? a.second < b.second : isNanB;
+    }
+    if (a.first != b.first) {
+      return isDescending ? a.first > b.first : a.first < b.first;
+    }
+    return a.second < b.second;
+  }
+};
+}  // namespace
+
+QueryResult::QueryResult() : matched(0), aggregated(0) {}
+
+Query::Query() : order(QueryOrder::FILE), limit(SIZE_MAX) {
+  Term all;
+  all.kind = Term::ALL;
+  all.lower = 0;
+  all.upper = 0;
+  scope.push_back(all);
+}
+
+Query Query::parse(const std::string& text) {
+  ///> Group the words by clause; the words of a clause are rejoined without
+  ///> spaces, so "mag > 500 m" and "mag>500m" read the same
+  std::istringstream words(text);
+  std::string word;
+  std::map<std::string, std::vector<std::string>> clauses;
+  std::string clause;
+  while (words >> word) {
+    if (clause.empty() && word != "select") {
+      throw std::invalid_argument("A query starts with select: " + text);
+    } else if (isClause(word)) {
+      if (clauses.count(word) != 0) {
+        throw std::invalid_argument("Repeated " + word + " clause in query.");
+      }
+      clause = word;
+      clauses[clause];
+    } else {
+      clauses[clause].push_back(word);
+    }
+  }
+  if (clauses.empty()) {
+    throw std::invalid_argument("A query starts with select: " + text);
+  }
+  for (const auto& entry : clauses) {
+    if (entry.second.empty()) {
+      throw std::invalid_argument("Empty " + entry.first + " clause.");
+    }
+  }
+  auto joined = [&clauses](const std::string& name) {
+    std::string result;
+    for (const std::string& part : clauses[name]) {
+      result += part;
+    }
+    return result;
+  };
+
+  Query query;
+  query.scope.clear();
+  for (const std::string& term : splitList(joined("select"), ',', "select")) {
+    query.scope.push_back(parseSelectTerm(term));
+  }
+
+  ///> A unit of a dimension the select clause leaves out can never match
+  std::set<std::string> dimensions;
+  bool isAnyDimension = false;
+  for (const Term& term : query.scope) {
+    if (term.kind == Term::ALL) {
+      isAnyDimension = true;
+    } else if (term.kind == Term::DIMENSION) {
+      dimensions.insert(term.name);
+    } else {
+      dimensions.insert(Units::getUnitByName(term.name)->getType());
+    }
+  }
+  auto checkDimension = [&](const std::string& dimension,
+                            const std::string& context) {
+    if (!isAnyDimension && dimensions.count(dimension) == 0) {
+      throw std::invalid_argument(
+          "Query unit cannot match the select clause: " + context);
+    }
+  };
+
+  if (clauses.count("where") != 0) {
+    std::vector<Term> group;
+    std::string predicate;
+    const std::vector<std::string>& parts = clauses["where"];
+    for (std::size_t i = 0; i <= parts.size(); ++i) {
+      const bool isEnd = i == parts.size();
+      if (!isEnd && parts[i] != "and" && parts[i] != "or") {
+        predicate += parts[i];
+        continue;
+      }
+      if (predicate.empty()) {
+        throw std::invalid_argument("Missing predicate in where clause.");
+      }
+      group.push_back(parsePredicate(predicate));
+      if (group.back().kind == Term::BASE_MAGNITUDE) {
+        checkDimension(group.back().name, predicate);
+      }
+      predicate.clear();
+      if (isEnd || parts[i] == "or") {
+        query.where.push_back(group);
+        group.clear();
+      }
+    }
+  }
+
+  if (clauses.count("convert") != 0) {
+    query.convert = ReportUnits::parse(joined("convert"));
+    for (const std::string& name :
+         splitList(joined("convert"), ',', "convert")) {
+      checkDimension(Units::getUnitByName(name)->getType(), "convert " + name);
+    }
+  }
+
+  if (clauses.count("stats") != 0) {
+    for (const std::string& name : splitList(joined("stats"), ',', "stats")) {
+      if (!isStatistic(name)) {
+        throw std::invalid_argument("Unknown statistic: " + name);
+      }
+      query.statistics.push_back(name);
+    }
+  }
+
+  if (clauses.count("sort") != 0) {
+    const std::string direction = joined("sort");
+    if (direction == "asc") {
+      query.order = QueryOrder::ASCENDING;
+    } else if (direction == "desc") {
+      query.order = QueryOrder::DESCENDING;
+    } else {
+      throw std::invalid_argument("Invalid sort order: " + direction);
+    }
+  }
+
+  if (clauses.count("limit") != 0) {
+    const std::string count = joined("limit");
+    if (count.size() > 18 ||
+        count.find_first_not_of("0123456789") != std::string::npos) {
+      throw std::invalid_argument("Invalid limit: " + count);
+    }
+    query.limit = static_cast<std::size_t>(std::stoull(count));
+  }
+  return query;
+}
+
+Query::Term Query::parseSelectTerm(const std::string& text) {
+  if (text == "*") {
+    Term all;
+    all.kind = Term::ALL;
+    all.lower = 0;
+    all.upper = 0;
+    return all;
+  }
+  Term term = parsePredicate(text);
+  if (term.kind != Term::DIMENSION && term.kind != Term::UNIT) {
+    throw std::invalid_argument("Invalid select term: " + text);
+  }
+  return term;
+}
+
+Query::Term Query::parsePredicate(const std::string& text) {
+  Term term;
+  term.lower = 0;
+  term.upper = 0;
+  const std::size_t equals = text.find('=');
+  const std::string key = text.substr(0, equals);
+  if (text == "valid") {
+    term.kind = Term::VALID;
+    return term;
+  } else if (equals != std::string::npos &&
+             (key == "dim" || key == "dimension")) {
+    term.kind = Term::DIMENSION;
+    term.name = text.substr(equals + 1);
+    if (term.name.empty()) {
+      throw std::invalid_argument("Invalid query predicate: " + text);
+    }
+    return term;
+  } else if (equals != std::string::npos && key == "unit") {
+    term.kind = Term::UNIT;
+    term.name = text.substr(equals + 1);
+    ///> Rejects unknown units up front
+    Units::getUnitByName(term.name);
+    return term;
+  } else if (text.compare(0, 3, "mag") != 0) {
+    throw std::invalid_argument("Invalid query predicate: " + text);
+  }
+
+  ///> mag OP X[UNIT]: split the operator, then the number from the unit
+  std::size_t at = 3;
+  std::string op;
+  while (at < text.size() && std::string("<>=").find(text[at]) !=
+                                 std::string::npos) {
+    op += text[at++];
+  }
+  if (op != "<" && op != "<=" && op != ">" && op != ">=" && op != "=") {
+    throw std::invalid_argument("Invalid query predicate: " + text);
+  }
+  const std::string operand = text.substr(at);
+  std::size_t unitStart = operand.size();
+  while (unitStart > 0 && std::isalpha(static_cast<unsigned char>(
+                              operand[unitStart - 1]))) {
+    --unitStart;
+  }
+  double bound = parseNumber(operand.substr(0, unitStart), text);
+  term.kind = Term::MAGNITUDE;
+  if (unitStart < operand.size()) {
+    std::shared_ptr<Units> unit =
+        Units::getUnitByName(operand.substr(unitStart));
+    term.kind = Term::BASE_MAGNITUDE;
+    term.name = unit->getType();
+    bound *= unit->getBaseFactor();
+  }
+
+  ///> Strict bounds become the next representable closed bound
+  const double infinity = std::numeric_limits<double>::infinity();
+  term.lower = -infinity;
+  term.upper = infinity;
+  if (op == "<") {
+    term.upper = std::nextafter(bound, -infinity);
+  } else if (op == "<=") {
+    term.upper = bound;
+  } else if (op == ">") {
+    term.lower = std::nextafter(bound, infinity);
+  } else if (op == ">=") {
+    term.lower = bound;
+  } else {
+    term.lower = bound;
+    term.upper = bound;
+  }
+  return term;
+}
+
+Selection Query::evaluate(const ResultStore& results, const Term& term) {
+  switch (term.kind) {
+    case Term::ALL:
+      return Selection(results.size(), true);
+    case Term::DIMENSION:
+      return ResultFilter::byDimension(results, term.name);
+    case Term::UNIT:
+      return ResultFilter::byUnit(results, term.name);
+    case Term::MAGNITUDE:
+      return ResultFilter::byBaseMagnitude(results, term.lower, term.upper);
+    case Term::BASE_MAGNITUDE:
+      return ResultFilter::byBaseMagnitude(results, term.name, term.lower,
+                                           term.upper);
+    case Term::VALID:
+      return ResultFilter::byValidity(results);
+  }
+  return Selection(results.size());
+}
+
+Selection Query::select(const ResultStore& results) const {
+  Selection selection(results.size());
+  for (const Term& term : scope) {
+    selection |= evaluate(results, term);
+  }
+  if (where.empty()) {
+    return selection;
+  }
+  Selection matches(results.size());
+  for (const std::vector<Term>& group : where) {
+    Selection all = evaluate(results, group[0]);
+    for (std::size_t i = 1; i < group.size(); ++i) {
+      all &= evaluate(results, group[i]);
+    }
+    matches |= all;
+  }
+  return selection & matches;
+}
+
+QueryResult Query::execute(const ResultStore& results) const {
+  QueryResult result;
+  const Selection selection = select(results);
+  const std::vector<uint32_t> selected = selection.getRows();
+  result.matched = selected.size();
+
+  ///> Sorting, statistics and the rows compare like with like: every
+  ///> dimension in its convert unit, else its base unit
+  ReportUnits commonUnits = convert;
+  for (const std::shared_ptr<Units>& unit : results.getUnits()) {
+    if (!commonUnits.hasTarget(unit->getType())) {
+      commonUnits.setTarget(unit->getBaseUnit()->getName());
+    }
+  }
+  ///> Only the selected rows are scaled, and only if they are compared
+  std::vector<std::string> commonLabels;
+  std::vector<double> common;
+  if (order != QueryOrder::FILE || !statistics.empty()) {
+    common = commonUnits.scale(results, selected, commonLabels);
+  }
+
+  if (!statistics.empty()) {
+    std::vector<double> values;
+    values.reserve(selected.size());
+    uint8_t isUsed[256] = {};
+    for (std::size_t i = 0; i < selected.size(); ++i) {
+      isUsed[results.getUnitId(selected[i])] = 1;
+      if (!std::isnan(common[i])) {
+        values.push_back(common[i]);
+      }
+    }
+    result.aggregated = values.size();
+    ///> The statistics have a unit only if every row shares it
+    for (std::size_t id = 0; id < commonLabels.size(); ++id) {
+      if (!isUsed[id] || commonLabels[id] == result.statisticsUnit) {
+        continue;
+      }
+      result.statisticsUnit =
+          result.statisticsUnit.empty() ? commonLabels[id] : "(mixed units)";
+      if (result.statisticsUnit == "(mixed units)") {
+        break;
+      }
+    }
+    for (const std::string& name : statistics) {
+      result.statistics.push_back(
+          std::make_pair(name, computeStatistic(name, values)));
+    }
+  }
+
+  ///> Top-K: only the returned rows are put in order
+  const std::size_t count = std::min(limit, selected.size());
+  if (order == QueryOrder::FILE) {
+    result.rows.assign(selected.begin(), selected.begin() + count);
+  } else {
+    ///> A heap of the best rows so far, worst on top, so the selected rows
+    ///> are never copied out or sorted as a whole
+    RowOrder rowOrder = {order == QueryOrder::DESCENDING};
+    std::vector<std::pair<double, uint32_t>> best;
+    best.reserve(count);
+    for (std::size_t i = 0; i < selected.size() && count > 0; ++i) {
+      const std::pair<double, uint32_t> key(common[i], selected[i]);
+      if (best.size() < count) {
+        best.push_back(key);
+        std::push_heap(best.begin(), best.end(), rowOrder);
+      } else if (rowOrder(key, best.front())) {
+        std::pop_heap(best.begin(), best.end(), rowOrder);
+        best.back() = key;
+        std::push_heap(best.begin(), best.end(), rowOrder);
+      }
+    }
+    std::sort_heap(best.begin(), best.end(), rowOrder);
+    for (const auto& key : best) {
+      result.rows.push_back(key.second);
+    }
+  }
+
+  std::vector<std::string> labels;
+  result.magnitudes = commonUnits.scale(results, result.rows, labels);
+  for (uint32_t row : result.rows) {
+    result.lineNumbers.push_back(results.getLineNumber(row));
+    result.labels.push_back(labels[results.getUnitId(row)]);
+  }
+  return result;
+}
+
+std::vector<std::string> Query::format(const QueryResult& result) {
+  std::vector<std::string> lines;
+  for (std::size_t i = 0; i < result.rows.size(); ++i) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    oss << "Line " << result.lineNumbers[i] << ": " << result.magnitudes[i]
+        << " " << result.labels[i];
+    lines.push_back(oss.str());
+  }
+  std::ostringstream matched;
+  matched << result.rows.size() << " of " << result.matched
+          << " matching result(s) shown.";
+  lines.push_back(matched.str());
+  ///> Like the report, a selection without magnitudes has no statistics
+  if (!result.statistics.empty() && result.aggregated == 0) {
+    lines.push_back("No results");
+    return lines;
+  }
+  for (const auto& statistic : result.statistics) {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    if (statistic.first == "count") {
+      oss << "count: " << static_cast<std::size_t>(statistic.second);
+    } else {
+      oss << statistic.first << ": " << statistic.second;
+      if (!result.statisticsUnit.empty()) {
+        oss << " " << result.statisticsUnit;
+      }
+    }
+    lines.push_back(oss.str());
+  }
+  return lines;
+}
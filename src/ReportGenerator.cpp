@@ -11,8 +11,11 @@
  */
 
 #include "ReportGenerator.h"
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
+#include "StatisticsCalculator.h"
+#include "UnitRuns.h"
 
 std::string ReportGenerator::generateTextReport(
     const std::vector<Measurement>& measurements) {
@@ -33,4 +36,178 @@ std::string ReportGenerator::generateCSVReport(
     oss << m.getMagnitude() << "," << m.getUnit()->getName() << "\n";
   }
   return oss.str();
-}
\ No newline at end of file
+}
+std::string ReportGenerator::generateOutlierReport(
+    const std::map<std::string, OutlierDetector>& detectors) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(2);
+  oss << "\nOutlier summary in base units (raw / clean):\n";
+  for (const auto& entry : detectors) {
+    const RunningStatistics& raw = entry.second.getRawStatistics();
+    const RunningStatistics& clean = entry.second.getCleanStatistics();
+    oss << entry.first << ": " << entry.second.getOutlierCount()
+        << " outlier(s)";
+    if (entry.second.getNonFiniteCount() > 0) {
+      oss << ", " << entry.second.getNonFiniteCount() << " non-finite";
+    }
+    oss << "\n";
+    oss << "  Count: " << raw.getCount() << " / " << clean.getCount() << "\n";
+    oss << "  Mean: " << raw.getMean() << " / " << clean.getMean() << "\n";
+    oss << "  Std dev: " << raw.getStandardDeviation() << " / "
+        << clean.getStandardDeviation() << "\n";
+  }
+  return oss.str();
+}
+
+std::string ReportGenerator::generateHistogramReport(
+    const std::map<std::string, Histogram>& histograms) {
+  const int barWidth = 40;
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(2);
+  for (const auto& entry : histograms) {
+    const Histogram& histogram = entry.second;
+    std::vector<HistogramBucket> buckets = histogram.getBuckets();
+    uint64_t largest = 0;
+    for (const auto& bucket : buckets) {
+      largest = std::max(largest, bucket.count);
+    }
+
+    oss << "\nHistogram for " << entry.first
+        << " (n=" << histogram.getTotalCount() << ", min "
+        << histogram.getMin() << ", max " << histogram.getMax() << ", p50 "
+        << histogram.getValueAtPercentile(50) << ", p90 "
+        << histogram.getValueAtPercentile(90) << ", p99 "
+        << histogram.getValueAtPercentile(99) << "):\n";
+    for (const auto& bucket : buckets) {
+      double share = 100.0 * bucket.count / histogram.getTotalCount();
+      int bar = static_cast<int>(barWidth * bucket.count / largest);
+      oss << "  [" << std::setw(14) << bucket.lower << ", " << std::setw(14)
+          << bucket.upper << ") " << std::setw(8) << bucket.count << " "
+          << std::setw(6) << share << "% " << std::string(bar, '#') << "\n";
+    }
+  }
+  return oss.str();
+}
+
+std::string ReportGenerator::generateHistogramCSV(
+    const std::map<std::string, Histogram>& histograms) {
+  std::ostringstream oss;
+  oss << std::setprecision(17);
+  oss << "Dimension,Lower,Upper,Count\n";
+  for (const auto& entry : histograms) {
+    for (const auto& bucket : entry.second.getBuckets()) {
+      oss << entry.first << "," << bucket.lower << "," << bucket.upper << ","
+          << bucket.count << "\n";
+    }
+  }
+  return oss.str();
+}
+
+std::string ReportGenerator::generateDistinctCountReport(
+    const std::map<std::string, Histogram>& histograms,
+    const std::map<std::string, HyperLogLog>& magnitudes,
+    const std::map<std::string, HyperLogLog>& units) {
+  std::ostringstream oss;
+  oss << std::fixed << std::setprecision(0);
+  oss << "\nDistinct values (approximate):\n";
+  for (const auto& entry : magnitudes) {
+    auto histogram = histograms.find(entry.first);
+    auto unit = units.find(entry.first);
+    uint64_t count =
+        histogram == histograms.end() ? 0 : histogram->second.getTotalCount();
+    double distinct = entry.second.estimate();
+    ModeStrategy strategy =
+        StatisticsCalculator::chooseModeStrategy(distinct, count);
+
+    oss << entry.first << ": " << count << " result(s), ~" << distinct
+        << " distinct magnitude(s)";
+    if (unit != units.end()) {
+      oss << ", ~" << unit->second.estimate() << " distinct unit(s)";
+    }
+    oss << ", " << (strategy == ModeStrategy::EXACT ? "exact" : "binned")
+        << " mode\n";
+  }
+  return oss.str();
+}
+
+std::string ReportGenerator::generateFixedPointReport(
+    const std::map<std::string, FixedPointColumn>& columns) {
+  std::ostringstream oss;
+  oss << "\nExact fixed-point statistics:\n";
+  for (const auto& entry : columns) {
+    const FixedPointColumn& column = entry.second;
+    int64_t count = static_cast<int64_t>(column.values.size());
+    oss << entry.first << " (" << column.places << " decimal places): " << count
+        << " value(s)";
+
+    int64_t total;
+    if (!FixedPoint::sum(column.values, total)) {
+      oss << ", sum overflows 64 bits";
+    } else {
+      oss << ", sum " << FixedPoint::toString(total, column.places);
+      if (count > 0) {
+        int64_t mean = total / count;
+        int64_t remainder = total % count;
+        if (2 * (remainder < 0 ? -remainder : remainder) >= count) {
+          mean += total < 0 ? -1 : 1;
+        }
+        oss << ", mean " << FixedPoint::toString(mean, column.places);
+      }
+    }
+    oss << ", " << column.rounded << " rounded, " << column.outOfRange
+        << " out of range\n";
+  }
+  return oss.str();
+}
+
+std::string ReportGenerator::generatePrecisionLossReport(
+    const ResultStore& results) {
+  const PrecisionLossStatistics& loss = results.getPrecisionLoss();
+  std::ostringstream oss;
+  oss << "\nFloat32 storage: " << loss.count << " magnitude(s), "
+      << loss.inexact << " inexact\n";
+  oss << std::scientific << std::setprecision(3);
+  oss << "  Max absolute error: " << loss.maxAbsoluteError << "\n";
+  oss << "  Max relative error: " << loss.maxRelativeError << "\n";
+  oss << "  Mean relative error: "
+      << (loss.count > 0 ? loss.sumRelativeError / loss.count : 0.0) << "\n";
+  oss << "  Column storage: " << results.memoryUsage() << " bytes\n";
+  return oss.str();
+}
+
+std::string ReportGenerator::generateUnitSummaryReport(
+    const ResultStore& results) {
+  std::vector<UnitRun> runs = UnitRuns::encode(results.getUnitIds().data(),
+                                               results.size());
+  std::vector<UnitAggregate> perUnit(results.getUnits().size());
+  if (results.getPolicy() == StoragePolicy::FLOAT32) {
+    UnitRuns::aggregateByUnit(runs.data(), runs.size(),
+                              results.getFloatMagnitudes().data(), perUnit);
+  } else {
+    UnitRuns::aggregateByUnit(runs.data(), runs.size(),
+                              results.getDoubleMagnitudes().data(), perUnit);
+  }
+
+  std::ostringstream oss;
+  oss << "\nResults per unit (" << runs.size() << " run(s)):\n";
+  oss << std::fixed << std::setprecision(2);
+  for (size_t id = 0; id < perUnit.size(); ++id) {
+    const std::shared_ptr<Units>& unit = results.getUnits()[id];
+    const UnitAggregate& aggregate = perUnit[id];
+    oss << "  " << std::left << std::setw(9) << unit->getType() << std::right
+        << " " << unit->getName() << " (x" << std::defaultfloat
+        << std::setprecision(10) << unit->getBaseFactor() << std::fixed
+        << std::setprecision(2) << "): count " << aggregate.count << ", mean " << aggregate.getMean()
+        << ", min " << aggregate.min << ", max " << aggregate.max << "\n";
+  }
+  return oss.str();
+}
+
+std::string ReportGenerator::generateJSONReport(const ResultStore& results,
+                                                JsonFormat format) {
+  std::ostringstream oss;
+  JsonReportWriter writer(oss, format);
+  writer.write(results);
+  writer.finish();
+  return oss.str();
+}
@@ -0,0 +1,171 @@
+/**
+ * @file ReportUnits.cpp
+ * @brief Implementation of the ReportUnits class.
+ *
+ * @version 0.1
+ */
+
+#include "ReportUnits.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include "TextScanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define UNITIFY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+/**
+ * @brief Scales rows [start, size) one at a time; used for tails.
+ */
+template <typename T>
+void scaleScalarFrom(const T* magnitudes, const uint8_t* ids,
+                     const double* scales, std::size_t size,
+                     std::size_t start, double* out) {
+  for (std::size_t row = start; row < size; ++row) {
+    out[row] = magnitudes[row] * scales[ids[row]];
+  }
+}
+
+#ifdef UNITIFY_X86
+/**
+ * @brief Loads four unit IDs widened to 32-bit gather indices.
+ */
+__attribute__((target("avx2"))) inline __m128i loadIds(const uint8_t* ids) {
+  int32_t packed;
+  __builtin_memcpy(&packed, ids, sizeof packed);
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed));
+}
+
+__attribute__((target("avx2"))) void scaleAvx2(const double* magnitudes,
+                                               const uint8_t* ids,
+                                               const double* scales,
+                                               std::size_t size, double* out) {
+  std::size_t row = 0;
+  for (; row + 4 <= size; row += 4) {
+    __m256d factor = _mm256_i32gather_pd(scales, loadIds(ids + row), 8);
+    _mm256_storeu_pd(out + row,
+                     _mm256_mul_pd(_mm256_loadu_pd(magnitudes + row), factor));
+  }
+  scaleScalarFrom(magnitudes, ids, scales, size, row, out);
+}
+
+__attribute__((target("avx2"))) void scaleAvx2(const float* magnitudes,
+                                               const uint8_t* ids,
+                                               const double* scales,
+                                               std::size_t size, double* out) {
+  std::size_t row = 0;
+  for (; row + 4 <= size; row += 4) {
+    __m256d factor = _mm256_i32gather_pd(scales, loadIds(ids + row), 8);
+    __m256d widened = _mm256_cvtps_pd(_mm_loadu_ps(magnitudes + row));
+    _mm256_storeu_pd(out + row, _mm256_mul_pd(widened, factor));
+  }
+  scaleScalarFrom(magnitudes, ids, scales, size, row, out);
+}
+#endif
+
+/**
+ * @brief Scales a native magnitude column by the factor of each row's unit.
+ */
+template <typename T>
+void scaleColumn(const std::vector<T>& magnitudes,
+                 const std::vector<uint8_t>& ids, const double* scales,
+                 double* out) {
+#ifdef UNITIFY_X86
+  if (TextScanner::isSupported(ScanBackend::AVX2)) {
+    scaleAvx2(magnitudes.data(), ids.data(), scales, magnitudes.size(), out);
+    return;
+  }
+#endif
+  scaleScalarFrom(magnitudes.data(), ids.data(), scales, magnitudes.size(), 0,
+                  out);
+}
+}  // namespace
+
+ReportUnits ReportUnits::parse(const std::string& spec) {
+  ReportUnits reportUnits;
+  std::stringstream list(spec);
+  std::string unitName;
+  while (getline(list, unitName, ',')) {
+    reportUnits.setTarget(unitName);
+  }
+  if (reportUnits.empty()) {
+    throw std::invalid_argument("No report units given.");
+  }
+  return reportUnits;
+}
+
+void ReportUnits::setTarget(const std::string& unitName) {
+  std::shared_ptr<Units> unit = Units::getUnitByName(unitName);
+  const std::string dimension = unit->getType();
+  if (targets.count(dimension) != 0) {
+    throw std::invalid_argument("Two report units for " + dimension + ": " +
+                                labels[dimension] + " and " + unitName);
+  }
+  targets[dimension] = unit;
+  labels[dimension] = unitName;
+}
+
+bool ReportUnits::hasTarget(const std::string& dimension) const {
+  return targets.count(dimension) != 0;
+}
+
+bool ReportUnits::empty() const {
+  return targets.empty();
+}
+
+void ReportUnits::buildTables(const ResultStore& results, double* scales,
+                              std::vector<std::string>& unitLabels) const {
+  ///> One factor and label per unit ID; unused IDs keep a factor of 1
+  const std::vector<std::shared_ptr<Units>>& units = results.getUnits();
+  std::fill(scales, scales + 256, 1.0);
+  unitLabels.assign(units.size(), std::string());
+  for (std::size_t id = 0; id < units.size(); ++id) {
+    auto target = targets.find(units[id]->getType());
+    if (target == targets.end()) {
+      unitLabels[id] = units[id]->getName();
+    } else {
+      scales[id] =
+          units[id]->getBaseFactor() / target->second->getBaseFactor();
+      unitLabels[id] = labels.at(target->first);
+    }
+  }
+}
+
+std::vector<double> ReportUnits::scale(
+    const ResultStore& results, std::vector<std::string>& unitLabels) const {
+  double scales[256];
+  buildTables(results, scales, unitLabels);
+  std::vector<double> scaled(results.size());
+  if (results.getPolicy() == StoragePolicy::FLOAT32) {
+    scaleColumn(results.getFloatMagnitudes(), results.getUnitIds(), scales,
+                scaled.data());
+  } else {
+    scaleColumn(results.getDoubleMagnitudes(), results.getUnitIds(), scales,
+                scaled.data());
+  }
+  return scaled;
+}
+
+std::vector<double> ReportUnits::scale(
+    const ResultStore& results, const std::vector<uint32_t>& rows,
+    std::vector<std::string>& unitLabels) const {
+  double scales[256];
+  buildTables(results, scales, unitLabels);
+  const std::vector<uint8_t>& ids = results.getUnitIds();
+  std::vector<double> scaled(rows.size());
+  if (results.getPolicy() == StoragePolicy::FLOAT32) {
+    const std::vector<float>& magnitudes = results.getFloatMagnitudes();
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      scaled[i] = magnitudes[rows[i]] * scales[ids[rows[i]]];
+    }
+  } else {
+    const std::vector<double>& magnitudes = results.getDoubleMagnitudes();
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+      scaled[i] = magnitudes[rows[i]] * scales[ids[rows[i]]];
+    }
+  }
+  return scaled;
+}
@@ -0,0 +1,286 @@
+/**
+ * @file ResultFile.cpp
+ * @brief Implementation of the ResultFile class.
+ *
+ * @version 0.1
+ */
+
+#include "ResultFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include "GorillaCodec.h"
+#include "Length.h"
+#include "Mass.h"
+#include "Measurement.h"
+#include "TimeUnit.h"
+#include "Volume.h"
+
+namespace {
+const char MAGIC[8] = {'U', 'N', 'T', 'F', 'Y', 'R', 'S', '2'};
+const std::size_t RUN_BYTES = 3;  ///< Unit ID + 2-byte run length.
+
+template <typename T>
+void writeValue(std::ofstream& out, T value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T readValue(std::ifstream& in) {
+  T value;
+  if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+    throw std::runtime_error("Truncated result file.");
+  }
+  return value;
+}
+
+void writeString(std::ofstream& out, const std::string& text) {
+  writeValue<uint8_t>(out, static_cast<uint8_t>(text.size()));
+  out.write(text.data(), text.size());
+}
+
+std::string readString(std::ifstream& in) {
+  std::string text(readValue<uint8_t>(in), '\0');
+  if (!in.read(&text[0], text.size())) {
+    throw std::runtime_error("Truncated result file.");
+  }
+  return text;
+}
+
+void readBytes(std::ifstream& in, std::vector<uint8_t>& bytes,
+               std::size_t size) {
+  bytes.resize(size);
+  if (size > 0 && !in.read(reinterpret_cast<char*>(bytes.data()), size)) {
+    throw std::runtime_error("Truncated result file.");
+  }
+}
+
+/**
+ * @brief Bytes GorillaCodec writes at most for rows XOR-encoded values of
+ * width bits: the first raw, every other one with a full '11' header.
+ */
+std::size_t maxXorBytes(std::size_t rows, std::size_t width) {
+  const std::size_t lengthBits = width == 64 ? 6 : 5;
+  return (width + (rows - 1) * (2 + 5 + lengthBits + width) + 7) / 8;
+}
+
+/**
+ * @brief Bytes GorillaCodec writes at most for rows delta-of-delta encoded
+ * integers: the first value and delta raw, every other one with '1111'.
+ */
+std::size_t maxDeltaOfDeltaBytes(std::size_t rows) {
+  return (64 + (rows > 1 ? 64 + (rows - 2) * (4 + 64) : 0) + 7) / 8;
+}
+
+/**
+ * @brief Recreates a unit from its saved type, name and factor.
+ */
+std::shared_ptr<Units> makeUnit(const std::string& type,
+                                const std::string& name, double factor) {
+  if (type == "Length") {
+    return std::make_shared<Length>(name, factor);
+  } else if (type == "Mass") {
+    return std::make_shared<Mass>(name, factor);
+  } else if (type == "Volume") {
+    return std::make_shared<Volume>(name, factor);
+  } else if (type == "TimeUnit") {
+    return std::make_shared<TimeUnit>(name, factor);
+  }
+  throw std::runtime_error("Unknown unit type in result file: " + type);
+}
+}  // namespace
+
+const std::size_t ResultFile::BLOCK_ROWS;
+
+std::size_t ResultFile::save(const ResultStore& store,
+                             const std::string& path) {
+  std::ofstream out(path, std::ios::binary);
+  if (!out) {
+    throw std::runtime_error("Could not open result file: " + path);
+  }
+
+  out.write(MAGIC, sizeof(MAGIC));
+  writeValue<uint8_t>(out, static_cast<uint8_t>(store.getPolicy()));
+  const std::vector<std::shared_ptr<Units>>& units = store.getUnits();
+  writeValue<uint32_t>(out, static_cast<uint32_t>(units.size()));
+  for (const auto& unit : units) {
+    writeString(out, unit->getType());
+    writeString(out, unit->getName());
+    writeValue<double>(out, unit->getBaseFactor());
+  }
+  writeValue<uint64_t>(out, store.size());
+
+  const bool narrow = store.getPolicy() == StoragePolicy::FLOAT32;
+  std::vector<uint8_t> magnitudes;
+  std::vector<uint8_t> lines;
+  std::vector<UnitRun> runs;
+  for (std::size_t start = 0; start < store.size(); start += BLOCK_ROWS) {
+    std::size_t rows = std::min(BLOCK_ROWS, store.size() - start);
+    magnitudes.clear();
+    lines.clear();
+    if (narrow) {
+      GorillaCodec::encodeFloats(&store.getFloatMagnitudes()[start], rows,
+                                 magnitudes);
+    } else {
+      GorillaCodec::encodeDoubles(&store.getDoubleMagnitudes()[start], rows,
+                                  magnitudes);
+    }
+    GorillaCodec::encodeIntegers(&store.getLineNumbers()[start], rows, lines);
+    runs = UnitRuns::encode(&store.getUnitIds()[start], rows);
+
+    writeValue<uint32_t>(out, static_cast<uint32_t>(rows));
+    writeValue<uint32_t>(out, static_cast<uint32_t>(magnitudes.size()));
+    writeValue<uint32_t>(out, static_cast<uint32_t>(lines.size()));
+    ///> Rows that alternate units are cheaper raw; zero runs marks that
+    const bool raw = runs.size() * RUN_BYTES >= rows;
+    writeValue<uint32_t>(out, raw ? 0 : static_cast<uint32_t>(runs.size()));
+    out.write(reinterpret_cast<const char*>(magnitudes.data()),
+              magnitudes.size());
+    if (raw) {
+      out.write(reinterpret_cast<const char*>(&store.getUnitIds()[start]),
+                rows);
+    }
+    for (std::size_t r = 0; !raw && r < runs.size(); ++r) {
+      writeValue<uint8_t>(out, runs[r].unitId);
+      writeValue<uint16_t>(out, static_cast<uint16_t>(runs[r].length));
+    }
+    out.write(reinterpret_cast<const char*>(lines.data()), lines.size());
+    out.write(reinterpret_cast<const char*>(&store.getFlagsColumn()[start]),
+              rows);
+  }
+
+  std::size_t written = static_cast<std::size_t>(out.tellp());
+  if (!out) {
+    throw std::runtime_error("Could not write result file: " + path);
+  }
+  return written;
+}
+
+ResultStore ResultFile::load(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open result file: " + path);
+  }
+  char magic[sizeof(MAGIC)];
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error("Not a result file: " + path);
+  }
+  StoragePolicy policy = static_cast<StoragePolicy>(readValue<uint8_t>(in));
+  in.close();
+
+  ResultStore store(policy);
+  scan(path, [&store](const ResultBlock& block) {
+    for (std::size_t i = 0; i < block.rows; ++i) {
+      Measurement m(block.magnitudes[i], (*block.units)[block.unitIds[i]]);
+      store.append(block.lineNumbers[i], m, block.flags[i]);
+    }
+  });
+  return store;
+}
+
+std::size_t ResultFile::scan(
+    const std::string& path,
+    const std::function<void(const ResultBlock&)>& kernel) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) {
+    throw std::runtime_error("Could not open result file: " + path);
+  }
+  char magic[sizeof(MAGIC)];
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) {
+    throw std::runtime_error("Not a result file: " + path);
+  }
+
+  const bool narrow = readValue<uint8_t>(in) ==
+                      static_cast<uint8_t>(StoragePolicy::FLOAT32);
+  ///> Counts are checked before they size anything; a store has at most 256
+  ///> unit IDs
+  const uint32_t unitCount = readValue<uint32_t>(in);
+  if (unitCount > UINT8_MAX + 1) {
+    throw std::runtime_error("Malformed result file: " + path);
+  }
+  std::vector<std::shared_ptr<Units>> units(unitCount);
+  for (auto& unit : units) {
+    std::string type = readString(in);
+    std::string name = readString(in);
+    unit = makeUnit(type, name, readValue<double>(in));
+  }
+  const uint64_t total = readValue<uint64_t>(in);
+
+  ///> Scratch buffers are sized once and reused by every block
+  std::vector<double> magnitudes(BLOCK_ROWS);
+  std::vector<float> narrowMagnitudes(narrow ? BLOCK_ROWS : 0);
+  std::vector<int64_t> lineNumbers(BLOCK_ROWS);
+  std::vector<uint8_t> encodedMagnitudes, unitIds, encodedLines, flags;
+  std::vector<UnitRun> runs;
+
+  uint64_t scanned = 0;
+  while (scanned < total) {
+    std::size_t rows = readValue<uint32_t>(in);
+    std::size_t magnitudeBytes = readValue<uint32_t>(in);
+    std::size_t lineBytes = readValue<uint32_t>(in);
+    std::size_t runCount = readValue<uint32_t>(in);
+    if (rows == 0 || rows > BLOCK_ROWS || rows > total - scanned ||
+        runCount > rows ||
+        magnitudeBytes > maxXorBytes(rows, narrow ? 32 : 64) ||
+        lineBytes > maxDeltaOfDeltaBytes(rows)) {
+      throw std::runtime_error("Malformed result file: " + path);
+    }
+    readBytes(in, encodedMagnitudes, magnitudeBytes);
+    if (runCount == 0) {
+      readBytes(in, unitIds, rows);
+      runs = UnitRuns::encode(unitIds.data(), rows);
+      runCount = runs.size();
+    } else {
+      runs.resize(runCount);
+      std::size_t covered = 0;
+      for (auto& run : runs) {
+        run.unitId = readValue<uint8_t>(in);
+        run.length = readValue<uint16_t>(in);
+        covered += run.length;
+        if (run.length == 0) {
+          throw std::runtime_error("Malformed result file: " + path);
+        }
+      }
+      if (covered != rows) {
+        throw std::runtime_error("Malformed result file: " + path);
+      }
+      unitIds.resize(rows);
+      UnitRuns::decode(runs.data(), runCount, unitIds.data());
+    }
+    for (const auto& run : runs) {
+      if (run.unitId >= units.size()) {
+        throw std::runtime_error("Malformed result file: " + path);
+      }
+    }
+    readBytes(in, encodedLines, lineBytes);
+    readBytes(in, flags, rows);
+
+    if (narrow) {
+      GorillaCodec::decodeFloats(encodedMagnitudes.data(), magnitudeBytes,
+                                 rows, narrowMagnitudes.data());
+      std::copy(narrowMagnitudes.begin(), narrowMagnitudes.begin() + rows,
+                magnitudes.begin());
+    } else {
+      GorillaCodec::decodeDoubles(encodedMagnitudes.data(), magnitudeBytes,
+                                  rows, magnitudes.data());
+    }
+    GorillaCodec::decodeIntegers(encodedLines.data(), lineBytes, rows,
+                                 lineNumbers.data());
+
+    ResultBlock block;
+    block.rows = rows;
+    block.magnitudes = magnitudes.data();
+    block.unitIds = unitIds.data();
+    block.runs = runs.data();
+    block.runCount = runCount;
+    block.lineNumbers = lineNumbers.data();
+    block.flags = flags.data();
+    block.units = &units;
+    kernel(block);
+    scanned += rows;
+  }
+  return static_cast<std::size_t>(scanned);
+}
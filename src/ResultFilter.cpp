@@ -0,0 +1,365 @@
+/**
+ * @file ResultFilter.cpp
+ * @brief Implementation of the ResultFilter class.
+ *
+ * @version 0.1
+ */
+
+#include "ResultFilter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "TextScanner.h"
+#include "Units.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define UNITIFY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+/**
+ * @brief Selects the rows whose unit ID is marked in a 256-entry table.
+ */
+Selection selectUnitIds(const ResultStore& results, const uint8_t* isMatch) {
+  const std::vector<uint8_t>& ids = results.getUnitIds();
+  Selection selection(ids.size());
+  std::vector<uint64_t>& words = selection.getWords();
+  for (std::size_t w = 0; w < words.size(); ++w) {
+    const std::size_t begin = w * 64;
+    const std::size_t end = std::min(begin + 64, ids.size());
+    uint64_t word = 0;
+    for (std::size_t row = begin; row < end; ++row) {
+      word |= uint64_t(isMatch[ids[row]]) << (row - begin);
+    }
+    words[w] = word;
+  }
+  return selection;
+}
+
+/**
+ * @brief Tests rows [64 * word, size) one at a time; used for tails.
+ */
+template <typename T>
+void rangeScalarFrom(const T* values, std::size_t size, std::size_t word,
+                     T lower, T upper, uint64_t* words) {
+  for (std::size_t start = word * 64; start < size; start += 64, ++word) {
+    uint64_t bits = 0;
+    for (std::size_t r = 0; r < 64 && start + r < size; ++r) {
+      const T value = values[start + r];
+      bits |= uint64_t(value >= lower && value <= upper) << r;
+    }
+    words[word] = bits;
+  }
+}
+
+#ifdef UNITIFY_X86
+__attribute__((target("avx2"))) void rangeAvx2(const double* values,
+                                               std::size_t size, double lower,
+                                               double upper, uint64_t* words) {
+  const __m256d low = _mm256_set1_pd(lower);
+  const __m256d high = _mm256_set1_pd(upper);
+  std::size_t word = 0;
+  for (; (word + 1) * 64 <= size; ++word) {
+    uint64_t bits = 0;
+    for (int lane = 0; lane < 16; ++lane) {
+      __m256d v = _mm256_loadu_pd(values + word * 64 + lane * 4);
+      ///> Ordered compares, so NaN fails both
+      __m256d inside = _mm256_and_pd(_mm256_cmp_pd(v, low, _CMP_GE_OQ),
+                                     _mm256_cmp_pd(v, high, _CMP_LE_OQ));
+      bits |= uint64_t(_mm256_movemask_pd(inside)) << (lane * 4);
+    }
+    words[word] = bits;
+  }
+  rangeScalarFrom(values, size, word, lower, upper, words);
+}
+
+__attribute__((target("avx2"))) void rangeAvx2(const float* values,
+                                               std::size_t size, float lower,
+                                               float upper, uint64_t* words) {
+  const __m256 low = _mm256_set1_ps(lower);
+  const __m256 high = _mm256_set1_ps(upper);
+  std::size_t word = 0;
+  for (; (word + 1) * 64 <= size; ++word) {
+    uint64_t bits = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+      __m256 v = _mm256_loadu_ps(values + word * 64 + lane * 8);
+      __m256 inside = _mm256_and_ps(_mm256_cmp_ps(v, low, _CMP_GE_OQ),
+                                    _mm256_cmp_ps(v, high, _CMP_LE_OQ));
+      bits |= uint64_t(static_cast<uint8_t>(_mm256_movemask_ps(inside)))
+              << (lane * 8);
+    }
+    words[word] = bits;
+  }
+  rangeScalarFrom(values, size, word, lower, upper, words);
+}
+#endif
+
+/**
+ * @brief Tests scaled rows [64 * word, size) one at a time; used for tails.
+ */
+template <typename T>
+void scaledRangeScalarFrom(const T* values, const uint8_t* ids,
+                           const double* scales, std::size_t size,
+                           std::size_t word, double lower, double upper,
+                           uint64_t* words) {
+  for (std::size_t start = word * 64; start < size; start += 64, ++word) {
+    uint64_t bits = 0;
+    for (std::size_t r = 0; r < 64 && start + r < size; ++r) {
+      const double value = values[start + r] * scales[ids[start + r]];
+      bits |= uint64_t(value >= lower && value <= upper) << r;
+    }
+    words[word] = bits;
+  }
+}
+
+#ifdef UNITIFY_X86
+/**
+ * @brief Loads four magnitudes of a native column, widened to double.
+ */
+__attribute__((target("avx2"))) inline __m256d loadWide(const double* values) {
+  return _mm256_loadu_pd(values);
+}
+
+__attribute__((target("avx2"))) inline __m256d loadWide(const float* values) {
+  return _mm256_cvtps_pd(_mm_loadu_ps(values));
+}
+
+template <typename T>
+__attribute__((target("avx2"))) void scaledRangeAvx2(
+    const T* values, const uint8_t* ids, const double* scales,
+    std::size_t size, double lower, double upper, uint64_t* words) {
+  const __m256d low = _mm256_set1_pd(lower);
+  const __m256d high = _mm256_set1_pd(upper);
+  std::size_t word = 0;
+  for (; (word + 1) * 64 <= size; ++word) {
+    uint64_t bits = 0;
+    for (int lane = 0; lane < 16; ++lane) {
+      const std::size_t row = word * 64 + lane * 4;
+      int32_t packed;
+      __builtin_memcpy(&packed, ids + row, sizeof packed);
+      __m256d factor = _mm256_i32gather_pd(
+          scales, _mm_cvtepu8_epi32(_mm_cvtsi32_si128(packed)), 8);
+      __m256d v = _mm256_mul_pd(loadWide(values + row), factor);
+      __m256d inside = _mm256_and_pd(_mm256_cmp_pd(v, low, _CMP_GE_OQ),
+                                     _mm256_cmp_pd(v, high, _CMP_LE_OQ));
+      bits |= uint64_t(_mm256_movemask_pd(inside)) << (lane * 4);
+    }
+    words[word] = bits;
+  }
+  scaledRangeScalarFrom(values, ids, scales, size, word, lower, upper, words);
+}
+#endif
+
+/**
+ * @brief Selects the rows whose magnitude times their unit's scale lies
+ * inside [lower, upper]; a NaN scale excludes a unit.
+ */
+template <typename T>
+Selection selectScaledRange(const std::vector<T>& column,
+                            const std::vector<uint8_t>& ids,
+                            const double* scales, double lower,
+                            double upper) {
+  Selection selection(column.size());
+  uint64_t* words = selection.getWords().data();
+#ifdef UNITIFY_X86
+  if (TextScanner::isSupported(ScanBackend::AVX2)) {
+    scaledRangeAvx2(column.data(), ids.data(), scales, column.size(), lower,
+                    upper, words);
+    return selection;
+  }
+#endif
+  scaledRangeScalarFrom(column.data(), ids.data(), scales, column.size(), 0,
+                        lower, upper, words);
+  return selection;
+}
+
+/**
+ * @brief Selects the rows of the store whose magnitude times their unit's
+ * scale lies inside [lower, upper], in either storage policy.
+ */
+Selection selectScaledRange(const ResultStore& results, const double* scales,
+                            double lower, double upper) {
+  if (results.getPolicy() == StoragePolicy::FLOAT32) {
+    return selectScaledRange(results.getFloatMagnitudes(),
+                             results.getUnitIds(), scales, lower, upper);
+  }
+  return selectScaledRange(results.getDoubleMagnitudes(), results.getUnitIds(),
+                           scales, lower, upper);
+}
+
+/**
+ * @brief Selects the rows of a native column inside [lower, upper].
+ */
+template <typename T>
+Selection selectRange(const std::vector<T>& column, T lower, T upper) {
+  Selection selection(column.size());
+  uint64_t* words = selection.getWords().data();
+#ifdef UNITIFY_X86
+  if (TextScanner::isSupported(ScanBackend::AVX2)) {
+    rangeAvx2(column.data(), column.size(), lower, upper, words);
+    return selection;
+  }
+#endif
+  rangeScalarFrom(column.data(), column.size(), 0, lower, upper, words);
+  return selection;
+}
+
+/**
+ * @brief Narrows a closed double range to the float range that selects
+ * exactly the same floats, so the float column is compared without widening.
+ */
+void narrowRange(double lower, double upper, float& lowerFloat,
+                 float& upperFloat) {
+  lowerFloat = static_cast<float>(lower);
+  if (static_cast<double>(lowerFloat) < lower) {
+    lowerFloat = std::nextafter(lowerFloat,
+                                std::numeric_limits<float>::infinity());
+  }
+  upperFloat = static_cast<float>(upper);
+  if (static_cast<double>(upperFloat) > upper) {
+    upperFloat = std::nextafter(upperFloat,
+                                -std::numeric_limits<float>::infinity());
+  }
+}
+
+/**
+ * @brief Parses the number of a min= or max= term.
+ */
+double parseBound(const std::string& term, const std::string& value) {
+  std::size_t consumed = 0;
+  double bound = 0.0;
+  try {
+    bound = std::stod(value, &consumed);
+  } catch (const std::exception&) {
+    consumed = 0;
+  }
+  if (value.empty() || consumed != value.size()) {
+    throw std::invalid_argument("Invalid filter bound: " + term);
+  }
+  return bound;
+}
+
+/**
+ * @brief Evaluates one term of a filter specification.
+ */
+Selection selectTerm(const ResultStore& results, const std::string& term) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  if (term == "valid") {
+    return ResultFilter::byValidity(results);
+  }
+  const std::size_t equals = term.find('=');
+  if (equals == std::string::npos) {
+    throw std::invalid_argument("Invalid filter term: " + term);
+  }
+  const std::string key = term.substr(0, equals);
+  const std::string value = term.substr(equals + 1);
+  if (key == "dimension") {
+    return ResultFilter::byDimension(results, value);
+  } else if (key == "unit") {
+    return ResultFilter::byUnit(results, value);
+  } else if (key == "min") {
+    return ResultFilter::byBaseMagnitude(results, parseBound(term, value),
+                                         infinity);
+  } else if (key == "max") {
+    return ResultFilter::byBaseMagnitude(results, -infinity,
+                                         parseBound(term, value));
+  }
+  throw std::invalid_argument("Invalid filter term: " + term);
+}
+}  // namespace
+
+Selection ResultFilter::byDimension(const ResultStore& results,
+                                    const std::string& dimension) {
+  uint8_t isMatch[256] = {};
+  const std::vector<std::shared_ptr<Units>>& units = results.getUnits();
+  for (std::size_t id = 0; id < units.size(); ++id) {
+    isMatch[id] = units[id]->getType() == dimension;
+  }
+  return selectUnitIds(results, isMatch);
+}
+
+Selection ResultFilter::byUnit(const ResultStore& results,
+                               const std::string& unitName) {
+  ///> Units are named after their base unit, so the factor tells km from m
+  const std::shared_ptr<Units> unit = Units::getUnitByName(unitName);
+  uint8_t isMatch[256] = {};
+  const std::vector<std::shared_ptr<Units>>& units = results.getUnits();
+  for (std::size_t id = 0; id < units.size(); ++id) {
+    isMatch[id] = units[id]->getName() == unit->getName() &&
+                  units[id]->getBaseFactor() == unit->getBaseFactor();
+  }
+  return selectUnitIds(results, isMatch);
+}
+
+Selection ResultFilter::byMagnitude(const ResultStore& results, double lower,
+                                    double upper) {
+  if (results.getPolicy() == StoragePolicy::FLOAT32) {
+    float lowerFloat = 0.0f;
+    float upperFloat = 0.0f;
+    narrowRange(lower, upper, lowerFloat, upperFloat);
+    return selectRange(results.getFloatMagnitudes(), lowerFloat, upperFloat);
+  }
+  return selectRange(results.getDoubleMagnitudes(), lower, upper);
+}
+
+Selection ResultFilter::byBaseMagnitude(const ResultStore& results,
+                                        const std::string& dimension,
+                                        double lower, double upper) {
+  ///> Other dimensions scale to NaN, which no comparison selects
+  double scales[256];
+  std::fill(scales, scales + 256, std::numeric_limits<double>::quiet_NaN());
+  const std::vector<std::shared_ptr<Units>>& units = results.getUnits();
+  for (std::size_t id = 0; id < units.size(); ++id) {
+    if (units[id]->getType() == dimension) {
+      scales[id] = units[id]->getBaseFactor();
+    }
+  }
+  return selectScaledRange(results, scales, lower, upper);
+}
+
+Selection ResultFilter::byBaseMagnitude(const ResultStore& results,
+                                        double lower, double upper) {
+  double scales[256];
+  std::fill(scales, scales + 256, 1.0);
+  const std::vector<std::shared_ptr<Units>>& units = results.getUnits();
+  for (std::size_t id = 0; id < units.size(); ++id) {
+    scales[id] = units[id]->getBaseFactor();
+  }
+  return selectScaledRange(results, scales, lower, upper);
+}
+
+Selection ResultFilter::byValidity(const ResultStore& results) {
+  return byMagnitude(results, 0.0, std::numeric_limits<double>::infinity());
+}
+
+Selection ResultFilter::select(const ResultStore& results,
+                               const std::string& spec) {
+  Selection selection(results.size());
+  std::size_t groupStart = 0;
+  while (groupStart <= spec.size()) {
+    std::size_t groupEnd = spec.find('|', groupStart);
+    if (groupEnd == std::string::npos) {
+      groupEnd = spec.size();
+    }
+    Selection group(results.size(), true);
+    std::size_t termStart = groupStart;
+    while (termStart <= groupEnd) {
+      std::size_t termEnd = spec.find(',', termStart);
+      if (termEnd == std::string::npos || termEnd > groupEnd) {
+        termEnd = groupEnd;
+      }
+      const std::string term = spec.substr(termStart, termEnd - termStart);
+      if (term.empty()) {
+        throw std::invalid_argument("Empty filter term in: " + spec);
+      }
+      group &= selectTerm(results, term);
+      termStart = termEnd + 1;
+    }
+    selection |= group;
+    groupStart = groupEnd + 1;
+  }
+  return selection;
+}
@@ -0,0 +1,276 @@
+/**
+ * @file ResultStore.cpp
+ * @brief Implementation of the ResultStore class.
+ *
+ * @version 0.1
+ */
+
+#include "ResultStore.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include "StatisticsCalculator.h"
+
+namespace {
+/**
+ * @brief Sorts (key, row) pairs of the column's native width.
+ */
+template <typename T>
+std::vector<uint32_t> argsort(const std::vector<T>& keys) {
+  std::vector<std::pair<T, uint32_t>> pairs(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    pairs[i] = std::make_pair(keys[i], static_cast<uint32_t>(i));
+  }
+  std::sort(pairs.begin(), pairs.end());
+
+  std::vector<uint32_t> order(pairs.size());
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    order[i] = pairs[i].second;
+  }
+  return order;
+}
+
+/**
+ * @brief Sorts the (key, row) pairs of the selected rows only.
+ */
+template <typename T>
+std::vector<uint32_t> argsort(const std::vector<T>& keys,
+                              const Selection& selection) {
+  std::vector<uint32_t> rows = selection.getRows();
+  std::vector<std::pair<T, uint32_t>> pairs(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    pairs[i] = std::make_pair(keys[rows[i]], rows[i]);
+  }
+  std::sort(pairs.begin(), pairs.end());
+
+  for (size_t i = 0; i < pairs.size(); ++i) {
+    rows[i] = pairs[i].second;
+  }
+  return rows;
+}
+
+/**
+ * @brief Copies the selected magnitudes of a native column, in row order.
+ */
+template <typename T>
+std::vector<T> gather(const std::vector<T>& column,
+                      const Selection& selection) {
+  std::vector<T> values;
+  values.reserve(selection.count());
+  const std::vector<uint64_t>& words = selection.getWords();
+  for (size_t w = 0; w < words.size(); ++w) {
+    for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+      values.push_back(column[w * 64 + __builtin_ctzll(bits)]);
+    }
+  }
+  return values;
+}
+
+/**
+ * @brief Checks whether two units would convert and print identically.
+ */
+bool sameUnit(const Units& a, const Units& b) {
+  return a.getBaseFactor() == b.getBaseFactor() && a.getName() == b.getName() &&
+         a.getType() == b.getType();
+}
+
+/**
+ * @brief Computes the median of a copy of a native magnitude column.
+ */
+template <typename T>
+double columnMedian(const std::vector<T>& column) {
+  std::vector<T> scratch(column);
+  return StatisticsCalculator::computeMedian(scratch);
+}
+}  // namespace
+
+PrecisionLossStatistics::PrecisionLossStatistics()
+    : count(0),
+      inexact(0),
+      maxAbsoluteError(0.0),
+      maxRelativeError(0.0),
+      sumRelativeError(0.0) {}
+
+ResultStore::ResultStore(StoragePolicy policy) : policy(policy) {}
+
+StoragePolicy ResultStore::getPolicy() const {
+  return policy;
+}
+
+void ResultStore::append(int64_t lineNumber, const Measurement& m,
+                         uint8_t resultFlags) {
+  std::shared_ptr<Units> unit = m.getUnit();
+  double magnitude = m.getMagnitude();
+  if (policy == StoragePolicy::FLOAT32 && unit->getBaseFactor() != 1.0) {
+    magnitude = unit->toBaseUnit(magnitude);
+    unit = unit->getBaseUnit();
+  }
+
+  ///> Results come in runs of the same unit; check the last one first
+  size_t id = units.size();
+  if (!unitIds.empty() && sameUnit(*units[unitIds.back()], *unit)) {
+    id = unitIds.back();
+  }
+  for (size_t i = 0; id == units.size() && i < units.size(); ++i) {
+    if (sameUnit(*units[i], *unit)) {
+      id = i;
+    }
+  }
+  if (id == units.size()) {
+    if (units.size() > UINT8_MAX) {
+      throw std::length_error("Too many distinct units in the result store.");
+    }
+    units.push_back(unit);
+  }
+
+  if (policy == StoragePolicy::FLOAT32) {
+    float narrowed = static_cast<float>(magnitude);
+    double error = std::fabs(static_cast<double>(narrowed) - magnitude);
+    double relative = magnitude != 0 ? error / std::fabs(magnitude) : 0.0;
+    ++precisionLoss.count;
+    precisionLoss.inexact += error != 0;
+    precisionLoss.maxAbsoluteError =
+        std::max(precisionLoss.maxAbsoluteError, error);
+    precisionLoss.maxRelativeError =
+        std::max(precisionLoss.maxRelativeError, relative);
+    precisionLoss.sumRelativeError += relative;
+    floatMagnitudes.push_back(narrowed);
+  } else {
+    doubleMagnitudes.push_back(magnitude);
+  }
+  unitIds.push_back(static_cast<uint8_t>(id));
+  lineNumbers.push_back(lineNumber);
+  flags.push_back(resultFlags);
+}
+
+void ResultStore::clear() {
+  doubleMagnitudes.clear();
+  floatMagnitudes.clear();
+  unitIds.clear();
+  lineNumbers.clear();
+  flags.clear();
+}
+
+std::size_t ResultStore::size() const {
+  return unitIds.size();
+}
+
+bool ResultStore::empty() const {
+  return unitIds.empty();
+}
+
+double ResultStore::getMagnitude(std::size_t row) const {
+  return policy == StoragePolicy::FLOAT32 ? floatMagnitudes[row]
+                                          : doubleMagnitudes[row];
+}
+
+uint8_t ResultStore::getUnitId(std::size_t row) const {
+  return unitIds[row];
+}
+
+const std::shared_ptr<Units>& ResultStore::getUnit(std::size_t row) const {
+  return units[unitIds[row]];
+}
+
+int64_t ResultStore::getLineNumber(std::size_t row) const {
+  return lineNumbers[row];
+}
+
+uint8_t ResultStore::getFlags(std::size_t row) const {
+  return flags[row];
+}
+
+Measurement ResultStore::getMeasurement(std::size_t row) const {
+  return Measurement(getMagnitude(row), getUnit(row));
+}
+
+const std::vector<std::shared_ptr<Units>>& ResultStore::getUnits() const {
+  return units;
+}
+
+const std::vector<double>& ResultStore::getDoubleMagnitudes() const {
+  return doubleMagnitudes;
+}
+
+const std::vector<float>& ResultStore::getFloatMagnitudes() const {
+  return floatMagnitudes;
+}
+
+const std::vector<uint8_t>& ResultStore::getUnitIds() const {
+  return unitIds;
+}
+
+const std::vector<int64_t>& ResultStore::getLineNumbers() const {
+  return lineNumbers;
+}
+
+const std::vector<uint8_t>& ResultStore::getFlagsColumn() const {
+  return flags;
+}
+
+std::vector<uint32_t> ResultStore::sortedOrder() const {
+  return policy == StoragePolicy::FLOAT32 ? argsort(floatMagnitudes)
+                                          : argsort(doubleMagnitudes);
+}
+
+double ResultStore::computeMean() const {
+  return policy == StoragePolicy::FLOAT32
+             ? StatisticsCalculator::computeMean(floatMagnitudes)
+             : StatisticsCalculator::computeMean(doubleMagnitudes);
+}
+
+double ResultStore::computeMode() const {
+  return policy == StoragePolicy::FLOAT32
+             ? StatisticsCalculator::computeMode(floatMagnitudes)
+             : StatisticsCalculator::computeMode(doubleMagnitudes);
+}
+
+double ResultStore::computeMedian() const {
+  return policy == StoragePolicy::FLOAT32 ? columnMedian(floatMagnitudes)
+                                          : columnMedian(doubleMagnitudes);
+}
+
+std::vector<uint32_t> ResultStore::sortedOrder(
+    const Selection& selection) const {
+  return policy == StoragePolicy::FLOAT32
+             ? argsort(floatMagnitudes, selection)
+             : argsort(doubleMagnitudes, selection);
+}
+
+double ResultStore::computeMean(const Selection& selection) const {
+  return policy == StoragePolicy::FLOAT32
+             ? StatisticsCalculator::computeMean(
+                   gather(floatMagnitudes, selection))
+             : StatisticsCalculator::computeMean(
+                   gather(doubleMagnitudes, selection));
+}
+
+double ResultStore::computeMode(const Selection& selection) const {
+  return policy == StoragePolicy::FLOAT32
+             ? StatisticsCalculator::computeMode(
+                   gather(floatMagnitudes, selection))
+             : StatisticsCalculator::computeMode(
+                   gather(doubleMagnitudes, selection));
+}
+
+double ResultStore::computeMedian(const Selection& selection) const {
+  if (policy == StoragePolicy::FLOAT32) {
+    std::vector<float> scratch = gather(floatMagnitudes, selection);
+    return StatisticsCalculator::computeMedian(scratch);
+  }
+  std::vector<double> scratch = gather(doubleMagnitudes, selection);
+  return StatisticsCalculator::computeMedian(scratch);
+}
+
+const PrecisionLossStatistics& ResultStore::getPrecisionLoss() const {
+  return precisionLoss;
+}
+
+std::size_t ResultStore::memoryUsage() const {
+  return doubleMagnitudes.capacity() * sizeof(double) +
+         floatMagnitudes.capacity() * sizeof(float) +
+         unitIds.capacity() * sizeof(uint8_t) +
+         lineNumbers.capacity() * sizeof(int64_t) +
+         flags.capacity() * sizeof(uint8_t);
+}
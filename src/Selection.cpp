@@ -0,0 +1,90 @@
+/**
+ * @file Selection.cpp
+ * @brief Implementation of the Selection class.
+ *
+ * @version 0.1
+ */
+
+#include "Selection.h"
+#include <stdexcept>
+
+namespace {
+void checkSameRows(const Selection& left, const Selection& right) {
+  if (left.size() != right.size()) {
+    throw std::invalid_argument("Selections cover different rows.");
+  }
+}
+}  // namespace
+
+Selection::Selection(std::size_t rowCount, bool isSelected)
+    : rowCount(rowCount),
+      words((rowCount + 63) / 64, isSelected ? ~uint64_t(0) : 0) {
+  if (isSelected && rowCount % 64 != 0) {
+    words.back() = (uint64_t(1) << (rowCount % 64)) - 1;
+  }
+}
+
+std::size_t Selection::size() const {
+  return rowCount;
+}
+
+std::size_t Selection::count() const {
+  std::size_t total = 0;
+  for (uint64_t word : words) {
+    total += static_cast<std::size_t>(__builtin_popcountll(word));
+  }
+  return total;
+}
+
+bool Selection::contains(std::size_t row) const {
+  return (words[row / 64] >> (row % 64)) & 1;
+}
+
+void Selection::select(std::size_t row) {
+  words[row / 64] |= uint64_t(1) << (row % 64);
+}
+
+const std::vector<uint64_t>& Selection::getWords() const {
+  return words;
+}
+
+std::vector<uint64_t>& Selection::getWords() {
+  return words;
+}
+
+std::vector<uint32_t> Selection::getRows() const {
+  std::vector<uint32_t> rows;
+  rows.reserve(count());
+  for (std::size_t w = 0; w < words.size(); ++w) {
+    for (uint64_t bits = words[w]; bits != 0; bits &= bits - 1) {
+      rows.push_back(static_cast<uint32_t>(w * 64 + __builtin_ctzll(bits)));
+    }
+  }
+  return rows;
+}
+
+Selection& Selection::operator&=(const Selection& other) {
+  checkSameRows(*this, other);
+  for (std::size_t w = 0; w < words.size(); ++w) {
+    words[w] &= other.words[w];
+  }
+  return *this;
+}
+
+Selection& Selection::operator|=(const Selection& other) {
+  checkSameRows(*this, other);
+  for (std::size_t w = 0; w < words.size(); ++w) {
+    words[w] |= other.words[w];
+  }
+  return *this;
+}
+
+Selection operator&(Selection left, const Selection& right) {
+  left &= right;
+  return left;
+}
+
+Selection operator|(Selection left, const Selection& right) {
+  left |= right;
+  return left;
+}
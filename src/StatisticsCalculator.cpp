@@ -9,10 +9,104 @@
 
 #include "StatisticsCalculator.h"
 #include <algorithm>
+#include <cmath>
 #include <map>
+#include "HyperLogLog.h"
+
+namespace {
+template <typename T>
+double columnMean(const std::vector<T>& values) {
+  if (values.empty()) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for (T value : values) {
+    sum += value;
+  }
+  return sum / values.size();
+}
+
+template <typename T>
+double columnMode(const std::vector<T>& values) {
+  std::map<T, int> frequency;
+  for (T value : values) {
+    frequency[value]++;
+  }
+
+  int maxCount = 0;
+  double mode = 0.0;
+  for (const auto& pair : frequency) {
+    if (pair.second > maxCount) {
+      maxCount = pair.second;
+      mode = pair.first;
+    }
+  }
+  return mode;
+}
+
+template <typename T>
+double columnMedian(std::vector<T>& values) {
+  size_t size = values.size();
+  if (size == 0) {
+    return 0.0;
+  }
+  ///> A selection is enough; the column does not need to be fully sorted
+  std::nth_element(values.begin(), values.begin() + size / 2, values.end());
+  double upper = values[size / 2];
+  if (size % 2 != 0) {
+    return upper;
+  }
+  double lower = *std::max_element(values.begin(), values.begin() + size / 2);
+  return (lower + upper) / 2;
+}
+}  // namespace
+
+RunningStatistics::RunningStatistics()
+    : count(0), mean(0.0), m2(0.0), min(0.0), max(0.0) {}
+
+void RunningStatistics::add(double value) {
+  if (count == 0) {
+    min = value;
+    max = value;
+  } else {
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  ++count;
+  double delta = value - mean;
+  mean += delta / count;
+  m2 += delta * (value - mean);
+}
+
+std::size_t RunningStatistics::getCount() const {
+  return count;
+}
+
+double RunningStatistics::getMean() const {
+  return mean;
+}
+
+double RunningStatistics::getVariance() const {
+  return count > 1 ? m2 / (count - 1) : 0.0;
+}
+
+double RunningStatistics::getStandardDeviation() const {
+  return std::sqrt(getVariance());
+}
+
+double RunningStatistics::getMin() const {
+  return min;
+}
+
+double RunningStatistics::getMax() const {
+  return max;
+}
 
 double StatisticsCalculator::computeMean(
     const std::vector<Measurement>& measurements) {
+  if (measurements.empty()) {
+    return 0.0;
+  }
   double sum = 0.0;
   for (const auto& m : measurements) {
     sum += m.getMagnitude();
@@ -46,6 +140,9 @@ double StatisticsCalculator::computeMedian(
             });
 
   size_t size = measurements.size();
+  if (size == 0) {
+    return 0.0;
+  }
   if (size % 2 == 0) {
     return (measurements[size / 2 - 1].getMagnitude() +
             measurements[size / 2].getMagnitude()) /
@@ -54,3 +151,79 @@ double StatisticsCalculator::computeMedian(
     return measurements[size / 2].getMagnitude();
   }
 }
+
+double StatisticsCalculator::computeMean(const std::vector<double>& values) {
+  return columnMean(values);
+}
+
+double StatisticsCalculator::computeMean(const std::vector<float>& values) {
+  return columnMean(values);
+}
+
+double StatisticsCalculator::computeMode(const std::vector<double>& values) {
+  return columnMode(values);
+}
+
+double StatisticsCalculator::computeMode(const std::vector<float>& values) {
+  return columnMode(values);
+}
+
+double StatisticsCalculator::computeMedian(std::vector<double>& values) {
+  return columnMedian(values);
+}
+
+double StatisticsCalculator::computeMedian(std::vector<float>& values) {
+  return columnMedian(values);
+}
+
+const std::size_t StatisticsCalculator::MIN_BINNED_MODE_COUNT;
+
+ModeStrategy StatisticsCalculator::chooseModeStrategy(double distinctEstimate,
+                                                      std::size_t count) {
+  if (count < MIN_BINNED_MODE_COUNT || distinctEstimate < 0.5 * count) {
+    return ModeStrategy::EXACT;
+  }
+  return ModeStrategy::BINNED;
+}
+
+double StatisticsCalculator::computeBinnedMode(const Histogram& histogram) {
+  double mode = 0.0;
+  uint64_t bestCount = 0;
+  for (const auto& bucket : histogram.getBuckets()) {
+    ///> Ties go to the first (smallest) bucket; the zero bucket's midpoint is 0
+    if (bucket.count > bestCount) {
+      bestCount = bucket.count;
+      mode = (bucket.lower + bucket.upper) / 2;
+    }
+  }
+  return mode;
+}
+
+double StatisticsCalculator::computeAdaptiveMode(
+    const std::vector<Measurement>& measurements) {
+  std::vector<double> values;
+  values.reserve(measurements.size());
+  for (const auto& m : measurements) {
+    values.push_back(m.getMagnitude());
+  }
+  return computeAdaptiveMode(values);
+}
+
+double StatisticsCalculator::computeAdaptiveMode(
+    const std::vector<double>& values) {
+  HyperLogLog distinct;
+  for (double value : values) {
+    distinct.add(value);
+  }
+
+  if (chooseModeStrategy(distinct.estimate(), values.size()) ==
+      ModeStrategy::EXACT) {
+    return computeMode(values);
+  }
+
+  Histogram histogram;
+  for (double value : values) {
+    histogram.record(value);
+  }
+  return computeBinnedMode(histogram);
+}
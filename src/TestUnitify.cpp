@@ -10,19 +10,55 @@
  *
  */
 
+#include <fcntl.h>
+#include <unistd.h>
 #include <cassert>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <thread>
 #include <vector>
+#include "ArrowExporter.h"
+#include "AsyncWriter.h"
+#include "CsvScanner.h"
+#include "ExpressionKernels.h"
+#include "FastFloat.h"
+#include "FixedPoint.h"
+#include "GorillaCodec.h"
+#include "Histogram.h"
+#include "HyperLogLog.h"
 #include "IOStreamHandler.h"
+#include "InputReader.h"
+#include "JsonReportWriter.h"
 #include "Length.h"
+#include "LineDiff.h"
+#include "LineIndex.h"
 #include "Mass.h"
 #include "Measurement.h"
 #include "MeasurementFileProcessor.h"
 #include "MeasurementValidator.h"
+#include "Operators.h"
+#include "OutlierDetector.h"
+#include "Query.h"
 #include "ReportGenerator.h"
+#include "ReportUnits.h"
+#include "ResultFile.h"
+#include "ResultFilter.h"
+#include "ResultStore.h"
+#include "Selection.h"
 #include "StatisticsCalculator.h"
+#include "TextScanner.h"
 #include "TimeUnit.h"
 #include "UnitConverter.h"
+#include "UnitRuns.h"
 #include "Units.h"
 #include "Volume.h"
 
@@ -105,6 +141,26 @@ void testUnitConversions() {
   assert(convertedLength.getMagnitude() ==
          1000.0);  // 1 kilometer = 1000 meters
 
+  // Test the unit table: long and short names resolve alike
+  const char* aliases[][2] = {{"kilometers", "km"}, {"hours", "hr"},
+                              {"microliters", "ul"}, {"milligrams", "mg"}};
+  for (const auto& alias : aliases) {
+    std::shared_ptr<Units> name = Units::getUnitByName(alias[0]);
+    std::shared_ptr<Units> symbol = Units::getUnitByName(alias[1]);
+    assert(name->getType() == symbol->getType());
+    assert(name->getName() == symbol->getName());
+    assert(name->getBaseFactor() == symbol->getBaseFactor());
+  }
+  assert(Units::getUnitByName("hr")->getBaseFactor() == 3600.0);
+  assert(Units::getUnitByName("ul")->getName() == "l");
+  bool isUnknown = false;
+  try {
+    Units::getUnitByName("furlongs");
+  } catch (const std::invalid_argument&) {
+    isUnknown = true;
+  }
+  assert(isUnknown);
+
   std::cout << "All unit conversion tests passed." << std::endl;
 }
 
@@ -154,6 +210,9 @@ void testValidators() {
   assert(MeasurementValidator::validateUnit("grams"));
   assert(MeasurementValidator::validateUnit("meters"));
   assert(!MeasurementValidator::validateUnit("invalidUnit"));
+  assert(MeasurementValidator::validateUnit("um"));
+  assert(MeasurementValidator::validateUnit("millimeters"));
+  assert(!MeasurementValidator::validateUnit("ummillimeters"));
 
   // Test measurement validation
   Mass grams("grams", 1.0);
@@ -203,6 +262,2020 @@ void testStatistics() {
   std::cout << "All statistics tests passed." << std::endl;
 }
 
+/**
+ * @brief Unit tests for streaming outlier detection.
+ */
+void testOutlierDetection() {
+  // Test rolling median over a window of 3
+  RollingMedian rolling(3);
+  rolling.add(5.0);
+  rolling.add(1.0);
+  rolling.add(3.0);
+  assert(rolling.median() == 3.0);
+  rolling.add(10.0);  // Evicts 5 -> {1, 3, 10}
+  assert(rolling.median() == 3.0);
+  rolling.add(11.0);  // Evicts 1 -> {3, 10, 11}
+  std::cout << "Rolling median | Expected: 10, Actual: " << rolling.median()
+            << std::endl;
+  assert(rolling.median() == 10.0);
+
+  // Test a spike in an otherwise steady stream
+  OutlierDetector detector;
+  int flagged = 0;
+  for (int i = 0; i < 200; ++i) {
+    double value = (i == 150) ? 5000.0 : 100.0 + (i % 7);
+    if (detector.add(value)) {
+      ++flagged;
+      assert(i == 150);
+    }
+  }
+  std::cout << "Outliers | Expected: 1, Actual: " << flagged << std::endl;
+  assert(flagged == 1);
+  assert(detector.getOutlierCount() == 1);
+  assert(detector.getRawStatistics().getCount() == 200);
+  assert(detector.getCleanStatistics().getCount() == 199);
+  assert(detector.getRawStatistics().getMax() == 5000.0);
+  assert(detector.getCleanStatistics().getMax() < 107.0);
+  assert(std::fabs(detector.getCleanStatistics().getMean() - 103.0) < 0.1);
+
+  // Test a level shift is flagged for at most half a window, then accepted
+  OutlierDetector shifted;
+  for (int i = 0; i < 200; ++i) {
+    assert(!shifted.add(10.0 + (i % 3)));
+  }
+  int flaggedAfterShift = 0;
+  for (int i = 0; i < 1000; ++i) {
+    bool isFlagged = shifted.add(1000.0 + (i % 3));
+    flaggedAfterShift += isFlagged;
+    assert(!isFlagged || i <= 51);
+  }
+  std::cout << "Level shift | Flagged: " << flaggedAfterShift << " of 1000"
+            << std::endl;
+  assert(flaggedAfterShift > 0 && flaggedAfterShift <= 52);
+
+  // Test NaN and infinities are flagged and counted but never windowed
+  OutlierDetector nonFinite;
+  for (int i = 0; i < 300; ++i) {
+    double value = 100.0 + (i % 7);
+    if (i == 20) {
+      value = std::nan("");
+    } else if (i == 40) {
+      value = HUGE_VAL;
+    }
+    bool isFlagged = nonFinite.add(value);
+    assert(isFlagged == (i == 20 || i == 40));
+  }
+  assert(nonFinite.getNonFiniteCount() == 2);
+  assert(nonFinite.getOutlierCount() == 0);
+  assert(nonFinite.getRawStatistics().getCount() == 298);
+  assert(std::fabs(nonFinite.getRawStatistics().getMean() - 103.0) < 0.1);
+
+  // Test the processor compares results of one dimension in base units
+  const char* scaleFileName = "test_outlier_scales.txt";
+  {
+    std::ofstream file(scaleFileName);
+    for (int i = 0; i < 40; ++i) {
+      file << (i % 2 == 0 ? "0.5 km\n" : "500 m\n");
+    }
+    file << "1e308 m * 1e308 m - 1e308 m * 1e308 m\n";
+  }
+  MeasurementFileProcessor scaled(scaleFileName);
+  scaled.enableLogging(false);
+  scaled.setOutlierPolicy(OutlierPolicy::FLAG);
+  scaled.readFile();
+  std::remove(scaleFileName);
+  const OutlierDetector& lengths = scaled.getOutlierDetectors().at("Length");
+  assert(lengths.getOutlierCount() == 0 && lengths.getNonFiniteCount() == 1);
+  assert(lengths.getRawStatistics().getMean() == 500.0);
+  assert(scaled.getOutlierLines().size() == 1 &&
+         scaled.getOutlierLines()[0] == 41);
+
+  // Test that the file processor drops outliers when asked to
+  const char* fileName = "test_outliers.txt";
+  {
+    std::ofstream file(fileName);
+    for (int i = 0; i < 40; ++i) {
+      file << (i == 30 ? 90000 : 10 + i % 3) << " meters\n";
+    }
+  }
+  MeasurementFileProcessor processor(fileName);
+  processor.setOutlierPolicy(OutlierPolicy::EXCLUDE);
+  processor.readFile();
+  std::remove(fileName);
+  assert(processor.getOutlierLines().size() == 1);
+  assert(processor.getOutlierLines()[0] == 31);
+  assert(processor.generateReportsInOriginalOrder().size() == 39);
+  assert(processor.getOutlierDetectors().at("Length").getOutlierCount() == 1);
+
+  std::cout << "All outlier detection tests passed." << std::endl;
+}
+/**
+ * @brief Unit tests for log-linear histograms.
+ */
+void testHistogram() {
+  Histogram histogram;
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(i);
+  }
+  histogram.record(0.0);
+  histogram.record(-3.0);
+  assert(histogram.getTotalCount() == 1002);
+  assert(histogram.getMin() == -3.0);
+  assert(histogram.getMax() == 1000.0);
+
+  // Buckets are ascending, non-overlapping and within 1/32 relative width
+  std::vector<HistogramBucket> buckets = histogram.getBuckets();
+  uint64_t total = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    total += buckets[i].count;
+    if (i > 0) {
+      assert(buckets[i - 1].upper <= buckets[i].lower);
+    }
+    if (buckets[i].lower > 0) {
+      assert((buckets[i].upper - buckets[i].lower) / buckets[i].lower <=
+             1.0 / 32);
+    }
+  }
+  assert(total == 1002);
+  assert(buckets.front().upper < 0);  // The negative value comes first
+
+  // Percentiles are within the bucket width of the exact answer
+  double p50 = histogram.getValueAtPercentile(50);
+  double p99 = histogram.getValueAtPercentile(99);
+  std::cout << "p50 | Expected: ~500, Actual: " << p50 << std::endl;
+  assert(std::fabs(p50 - 500) / 500 < 1.0 / 32);
+  std::cout << "p99 | Expected: ~991, Actual: " << p99 << std::endl;
+  assert(std::fabs(p99 - 991) / 991 < 1.0 / 32);
+
+  // Merging adds the counts
+  Histogram other;
+  other.record(2000.0);
+  histogram.merge(other);
+  assert(histogram.getTotalCount() == 1003);
+  assert(histogram.getMax() == 2000.0);
+
+  std::map<std::string, Histogram> histograms;
+  histograms["Length"] = other;
+  std::string csv = ReportGenerator::generateHistogramCSV(histograms);
+  assert(csv == "Dimension,Lower,Upper,Count\nLength,1984,2016,1\n");
+
+  // Test the processor fills the histograms and sketches only when asked
+  const char* fileName = "test_histogram.txt";
+  {
+    std::ofstream file(fileName);
+    file << "1 km\n2 kg\n3 m\n4 km + 5 m\n";
+  }
+  MeasurementFileProcessor plain(fileName);
+  plain.enableLogging(false);
+  plain.readFile();
+  assert(plain.getHistograms().empty() &&
+         plain.getDistinctMagnitudes().empty() &&
+         plain.getDistinctUnits().empty());
+  MeasurementFileProcessor binned(fileName);
+  binned.enableLogging(false);
+  binned.enableHistograms();
+  binned.readFile();
+  assert(binned.getHistograms().at("Length").getTotalCount() == 3);
+  assert(binned.getHistograms().at("Mass").getTotalCount() == 1);
+  assert(binned.getDistinctMagnitudes().empty() &&
+         binned.getDistinctUnits().empty());
+  MeasurementFileProcessor counted(fileName);
+  counted.enableLogging(false);
+  counted.enableDistinctCounts();
+  counted.readFile();
+  std::remove(fileName);
+  assert(counted.getHistograms().at("Length").getTotalCount() == 3);
+  assert(counted.getDistinctMagnitudes().at("Length").estimate() > 2.5);
+
+  // Test the histograms bin one value in one bucket whatever its unit
+  const char* scaleFileName = "test_histogram_scales.txt";
+  {
+    std::ofstream file(scaleFileName);
+    file << "0.5 km\n500 m\n500 m + 0 m\n";
+  }
+  MeasurementFileProcessor scaled(scaleFileName);
+  scaled.enableLogging(false);
+  scaled.enableDistinctCounts();
+  scaled.readFile();
+  std::remove(scaleFileName);
+  const Histogram& lengths = scaled.getHistograms().at("Length");
+  assert(lengths.getTotalCount() == 3 && lengths.getBuckets().size() == 1);
+  assert(lengths.getMin() == 500.0 && lengths.getMax() == 500.0);
+  assert(std::fabs(scaled.getDistinctMagnitudes().at("Length").estimate() -
+                   1) < 0.1);
+  assert(std::fabs(counted.getDistinctUnits().at("Length").estimate() - 2) <
+         0.1);  // km and m
+
+  std::cout << "All histogram tests passed." << std::endl;
+}
+/**
+ * @brief Unit tests for HyperLogLog distinct counts and mode selection.
+ */
+void testDistinctCounts() {
+  // Test the estimate on 100000 distinct magnitudes, each added twice
+  HyperLogLog sketch;
+  for (int i = 0; i < 100000; ++i) {
+    sketch.add(i * 0.5);
+    sketch.add(i * 0.5);
+  }
+  double estimate = sketch.estimate();
+  std::cout << "HLL | Expected: ~100000, Actual: " << estimate << std::endl;
+  assert(std::fabs(estimate - 100000) / 100000 < 0.05);
+
+  // Test small cardinalities and that 0.0 and -0.0 are the same value
+  HyperLogLog small;
+  small.add(0.0);
+  small.add(-0.0);
+  small.add(1.0);
+  assert(std::fabs(small.estimate() - 2.0) < 0.1);
+
+  // Test merging two halves
+  HyperLogLog left, right;
+  for (int i = 0; i < 5000; ++i) {
+    left.add(i);
+    right.add(i + 2500);
+  }
+  left.merge(right);
+  assert(std::fabs(left.estimate() - 7500) / 7500 < 0.05);
+
+  // Test the mode strategy
+  assert(StatisticsCalculator::chooseModeStrategy(4, 4) ==
+         ModeStrategy::EXACT);  // Too small to bother
+  assert(StatisticsCalculator::chooseModeStrategy(100, 100000) ==
+         ModeStrategy::EXACT);  // Heavily repeated values
+  assert(StatisticsCalculator::chooseModeStrategy(99000, 100000) ==
+         ModeStrategy::BINNED);  // Nearly every value distinct
+
+  // Test the binned mode on distinct values clustered around 500
+  std::shared_ptr<Units> meters = std::make_shared<Length>("m", 1.0);
+  std::vector<Measurement> measurements;
+  for (int i = 0; i < 5000; ++i) {
+    measurements.emplace_back(1.0 + i * 0.37, meters);
+    measurements.emplace_back(500.0 + (i % 100) * 0.001 + i * 1e-9, meters);
+  }
+  double mode = StatisticsCalculator::computeAdaptiveMode(measurements);
+  std::cout << "Binned mode | Expected: ~500, Actual: " << mode << std::endl;
+  assert(std::fabs(mode - 500) < 500.0 / 32);
+
+  // Test that the fullest bucket wins over a narrow, nearly empty one
+  std::vector<double> values;
+  for (int i = 0; i < 5000; ++i) {
+    values.push_back(1.0 + i * 999.0 / 4999);
+  }
+  for (int i = 0; i < 200; ++i) {
+    values.push_back(500.0);
+  }
+  mode = StatisticsCalculator::computeAdaptiveMode(values);
+  assert(std::fabs(mode - 500) < 500.0 / 32);
+  values.push_back(0.001);
+  mode = StatisticsCalculator::computeAdaptiveMode(values);
+  std::cout << "Binned mode with a stray value | Expected: ~500, Actual: "
+            << mode << std::endl;
+  assert(std::fabs(mode - 500) < 500.0 / 32);
+
+  std::cout << "All distinct count tests passed." << std::endl;
+}
+/**
+ * @brief Unit tests for fixed-point magnitudes.
+ */
+void testFixedPoint() {
+  int64_t value = 0;
+
+  // Test parsing straight from the digits
+  assert(FixedPoint::parseDecimal("860.587", 6, value) ==
+         FixedPointStatus::EXACT);
+  assert(value == 860587000);
+  assert(FixedPoint::parseDecimal("-0.05", 3, value) ==
+         FixedPointStatus::EXACT);
+  assert(value == -50);
+  assert(FixedPoint::parseDecimal("1.5e2", 0, value) ==
+         FixedPointStatus::EXACT);
+  assert(value == 150);
+  assert(FixedPoint::parseDecimal("0.125", 2, value) ==
+         FixedPointStatus::ROUNDED);
+  assert(value == 12);  // Half to even
+  assert(FixedPoint::parseDecimal("0.135", 2, value) ==
+         FixedPointStatus::ROUNDED);
+  assert(value == 14);
+  assert(FixedPoint::parseDecimal("99999999999999", 6, value) ==
+         FixedPointStatus::OUT_OF_RANGE);
+  assert(FixedPoint::parseDecimal("12abc", 2, value) ==
+         FixedPointStatus::INVALID);
+  assert(FixedPoint::parseDecimal(".", 2, value) == FixedPointStatus::INVALID);
+
+  // Test unit conversion: power-of-ten shifts and integer factors
+  assert(FixedPoint::parseInUnit("860.587", 6, 0.001, value) ==
+         FixedPointStatus::EXACT);
+  assert(value == 860587);  // 860.587 mm = 0.860587 m
+  assert(FixedPoint::parseInUnit("1.25", 0, 60.0, value) ==
+         FixedPointStatus::ROUNDED);  // 1.25 min at 0 places: 1 * 60
+  assert(FixedPoint::parseInUnit("1.25", 1, 60.0, value) ==
+         FixedPointStatus::ROUNDED);
+  assert(FixedPoint::parseInUnit("1.5", 1, 3600.0, value) ==
+         FixedPointStatus::EXACT);
+  assert(value == 54000);  // 1.5 hr = 5400.0 s
+
+  // Test exact summation where doubles drift
+  std::vector<int64_t> tenths(1000000, 1);  // 0.1 with 1 decimal place
+  double drifting = 0.0;
+  for (size_t i = 0; i < tenths.size(); ++i) {
+    drifting += 0.1;
+  }
+  int64_t total = 0;
+  assert(FixedPoint::sum(tenths, total));
+  std::cout << "Fixed-point sum | Expected: 100000.0, Actual: "
+            << FixedPoint::toString(total, 1) << " (double: " << drifting
+            << ")" << std::endl;
+  assert(FixedPoint::toString(total, 1) == "100000.0");
+  assert(drifting != 100000.0);
+
+  // Test overflow detection, including one that cancels out
+  std::vector<int64_t> large = {INT64_MAX, 1};
+  assert(!FixedPoint::sum(large, total));
+  large.push_back(-2);
+  assert(FixedPoint::sum(large, total));
+  assert(total == INT64_MAX - 1);
+  assert(FixedPoint::toString(-5, 3) == "-0.005");
+
+  // Test the file processor's exact path and its rounded fallback
+  const char* fileName = "test_fixed_point.txt";
+  {
+    std::ofstream file(fileName);
+    file << "0.1 m + 0.2 m\n";
+    file << "1 km - 1 mm\n";
+    file << "2 m * 3 m\n";
+    file << "\t0.4 m \t-  0.1 m  \n";  // Tokens are split on any whitespace
+    file << "0.125 km\n";
+  }
+  MeasurementFileProcessor processor(fileName);
+  processor.enableLogging(false);
+  processor.enableFixedPoint(3);
+  processor.readFile();
+  std::remove(fileName);
+  const FixedPointColumn& column =
+      processor.getFixedPointColumns().at("Length");
+  assert(column.values.size() == 5);
+  assert(column.values[0] == 300);     // 0.3 m; doubles give 0.30000000000000004
+  assert(column.values[1] == 999999);  // 999.999 m
+  assert(column.values[2] == 6000);    // Rounded from the double 6 m^2
+  assert(column.values[3] == 300);     // 0.4 - 0.1 is not 0.3 in doubles
+  assert(column.values[4] == 125);     // A lone operand keeps its unit
+  assert(column.rounded == 1);
+
+  std::cout << "All fixed-point tests passed." << std::endl;
+}
+/**
+ * @brief Unit tests for the columnar result store and its storage policies.
+ */
+void testResultStore() {
+  std::shared_ptr<Units> meters = Units::getUnitByName("m");
+  std::shared_ptr<Units> kilometers = Units::getUnitByName("km");
+  std::shared_ptr<Units> seconds = Units::getUnitByName("s");
+
+  ResultStore doubles;
+  doubles.append(1, Measurement(0.1, meters));
+  doubles.append(2, Measurement(3.0, kilometers));
+  doubles.append(3, Measurement(2.0, seconds), RESULT_OUTLIER);
+  doubles.append(4, Measurement(0.1, meters));
+  assert(doubles.size() == 4);
+  assert(doubles.getUnits().size() == 3);  // m, km (not normalized), s
+  assert(doubles.getUnitId(0) == doubles.getUnitId(3));
+  assert(doubles.getMagnitude(0) == 0.1);
+  assert(doubles.getMagnitude(1) == 3.0);
+  assert(doubles.getUnit(2)->getType() == "TimeUnit");
+  assert(doubles.getLineNumber(2) == 3);
+  assert(doubles.getFlags(2) == RESULT_OUTLIER);
+  assert(doubles.getPrecisionLoss().count == 0);
+
+  std::vector<uint32_t> order = doubles.sortedOrder();
+  assert(order.size() == 4);
+  assert(order[0] == 0 && order[1] == 3 && order[2] == 2 && order[3] == 1);
+  assert(doubles.computeMode() == 0.1);
+  assert(doubles.computeMedian() == (0.1 + 2.0) / 2);
+
+  // Test float storage: normalized to the base unit, loss tracked
+  ResultStore floats(StoragePolicy::FLOAT32);
+  floats.append(1, Measurement(0.1, meters));
+  floats.append(2, Measurement(3.0, kilometers));
+  floats.append(3, Measurement(2.0, seconds));
+  assert(floats.getFloatMagnitudes().size() == 3);
+  assert(floats.getDoubleMagnitudes().empty());
+  assert(floats.getMagnitude(1) == 3000.0);  // 3 km stored as 3000 m
+  assert(floats.getUnitId(0) == floats.getUnitId(1));
+  assert(floats.getMagnitude(0) == static_cast<double>(0.1f));
+
+  const PrecisionLossStatistics& loss = floats.getPrecisionLoss();
+  std::cout << "Float32 | Inexact: " << loss.inexact
+            << ", max relative error: " << loss.maxRelativeError << std::endl;
+  assert(loss.count == 3);
+  assert(loss.inexact == 1);  // Only 0.1 is not representable
+  assert(loss.maxRelativeError > 0 && loss.maxRelativeError < 1e-7);
+  assert(std::fabs(floats.computeMean() - (0.1 + 3000.0 + 2.0) / 3) < 1e-6);
+  assert(floats.memoryUsage() < doubles.memoryUsage());
+
+  std::cout << "All result store tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the Gorilla codec and compressed result files.
+ */
+void testResultCompression() {
+  // Test XOR round trips, including repeats, sign flips and special values
+  std::vector<double> values;
+  for (int i = 0; i < 1000; ++i) {
+    values.push_back(500.0 + 0.25 * (i % 17));
+  }
+  values.push_back(values.back());
+  values.push_back(-0.0);
+  values.push_back(1e300);
+  values.push_back(5e-324);
+  values.push_back(-123.456);
+  std::vector<uint8_t> encoded;
+  GorillaCodec::encodeDoubles(values.data(), values.size(), encoded);
+  std::vector<double> decoded(values.size());
+  GorillaCodec::decodeDoubles(encoded.data(), encoded.size(), values.size(),
+                              decoded.data());
+  for (size_t i = 0; i < values.size(); ++i) {
+    assert(std::memcmp(&values[i], &decoded[i], sizeof(double)) == 0);
+  }
+  std::cout << "Gorilla doubles | Raw: " << values.size() * sizeof(double)
+            << " bytes, Encoded: " << encoded.size() << " bytes" << std::endl;
+  assert(encoded.size() * 4 < values.size() * sizeof(double));
+
+  std::vector<float> floats = {1.5f, 1.5f, 2.25f, -7.0f, 3.0e38f, 0.1f};
+  encoded.clear();
+  GorillaCodec::encodeFloats(floats.data(), floats.size(), encoded);
+  std::vector<float> decodedFloats(floats.size());
+  GorillaCodec::decodeFloats(encoded.data(), encoded.size(), floats.size(),
+                             decodedFloats.data());
+  assert(decodedFloats == floats);
+
+  // Test delta-of-delta round trips across every payload width
+  std::vector<int64_t> integers = {1, 2, 3, 4, 10, 11, 300, 301, 5000,
+                                   INT64_MIN, INT64_MAX, -5, -5, 7};
+  for (int64_t line = 8; line < 2000; ++line) {
+    integers.push_back(line);
+  }
+  encoded.clear();
+  GorillaCodec::encodeIntegers(integers.data(), integers.size(), encoded);
+  std::vector<int64_t> decodedIntegers(integers.size());
+  GorillaCodec::decodeIntegers(encoded.data(), encoded.size(), integers.size(),
+                               decodedIntegers.data());
+  assert(decodedIntegers == integers);
+  std::cout << "Gorilla integers | Values: " << integers.size()
+            << ", Encoded: " << encoded.size() << " bytes" << std::endl;
+  assert(encoded.size() < 400);  // Consecutive lines take one bit each
+
+  // Test saving, loading and scanning a multi-block result file
+  std::shared_ptr<Units> meters = Units::getUnitByName("m");
+  std::shared_ptr<Units> kilometers = Units::getUnitByName("km");
+  std::shared_ptr<Units> grams = Units::getUnitByName("g");
+  ResultStore store;
+  RunningStatistics expected;
+  for (int i = 0; i < 10000; ++i) {
+    double magnitude = 100.0 + (i % 50) * 0.5;
+    std::shared_ptr<Units> unit = i % 3 == 0 ? grams : meters;
+    if (i == 7) {
+      unit = kilometers;
+    }
+    store.append(i + 1, Measurement(magnitude, unit),
+                 i % 100 == 0 ? RESULT_OUTLIER : 0);
+    expected.add(magnitude);
+  }
+
+  const std::string path = "test_results.results";
+  std::size_t bytes = ResultFile::save(store, path);
+  std::cout << "Result file | Rows: " << store.size() << ", Bytes: " << bytes
+            << ", In memory: " << store.memoryUsage() << std::endl;
+  assert(bytes < store.size() * (sizeof(double) + sizeof(int64_t)));
+
+  ResultStore loaded = ResultFile::load(path);
+  assert(loaded.size() == store.size());
+  assert(loaded.getDoubleMagnitudes() == store.getDoubleMagnitudes());
+  assert(loaded.getUnitIds() == store.getUnitIds());
+  assert(loaded.getLineNumbers() == store.getLineNumbers());
+  assert(loaded.getFlagsColumn() == store.getFlagsColumn());
+  assert(loaded.getUnit(7)->getName() == kilometers->getName());
+  assert(loaded.getUnit(7)->getBaseFactor() == 1000.0);
+  assert(loaded.getUnit(0)->getType() == "Mass");
+
+  // Test feeding decoded blocks straight into a statistics kernel
+  RunningStatistics scanned;
+  size_t blocks = 0;
+  size_t rows = ResultFile::scan(path, [&](const ResultBlock& block) {
+    ++blocks;
+    for (size_t i = 0; i < block.rows; ++i) {
+      scanned.add(block.magnitudes[i]);
+    }
+  });
+  assert(rows == store.size());
+  assert(blocks == (store.size() + ResultFile::BLOCK_ROWS - 1) /
+                       ResultFile::BLOCK_ROWS);
+  assert(scanned.getMean() == expected.getMean());
+  assert(scanned.getMax() == expected.getMax());
+
+  // Test float32 stores keep their policy
+  ResultStore narrow(StoragePolicy::FLOAT32);
+  narrow.append(1, Measurement(0.1, meters));
+  narrow.append(2, Measurement(3.0, kilometers));
+  ResultFile::save(narrow, path);
+  ResultStore narrowLoaded = ResultFile::load(path);
+  assert(narrowLoaded.getPolicy() == StoragePolicy::FLOAT32);
+  assert(narrowLoaded.getFloatMagnitudes() == narrow.getFloatMagnitudes());
+
+  // Test sizes past what the codec can write are rejected, not allocated
+  std::size_t unitsEnd = 8 + 1 + 4;  // Magic, policy and unit count
+  for (const auto& unit : narrow.getUnits()) {
+    unitsEnd += 1 + unit->getType().size() + 1 + unit->getName().size() + 8;
+  }
+  const std::size_t corruptOffsets[] = {
+      9,                  // Unit count
+      unitsEnd + 8 + 4,   // Magnitude bytes of the first block
+      unitsEnd + 8 + 8};  // Line bytes of the first block
+  for (std::size_t offset : corruptOffsets) {
+    ResultFile::save(narrow, path);
+    {
+      std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+      const uint32_t huge = UINT32_MAX;
+      file.seekp(offset);
+      file.write(reinterpret_cast<const char*>(&huge), sizeof(huge));
+    }
+    bool isMalformed = false;
+    try {
+      ResultFile::load(path);
+    } catch (const std::runtime_error& e) {
+      isMalformed = std::string(e.what()).find("Malformed") == 0;
+    }
+    assert(isMalformed);
+  }
+  std::remove(path.c_str());
+
+  bool threw = false;
+  try {
+    ResultFile::load("missing_results.results");
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  assert(threw);
+
+  std::cout << "All result compression tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for run-length encoded unit IDs and run kernels.
+ */
+void testUnitRuns() {
+  std::vector<uint8_t> ids = {0, 0, 0, 1, 1, 0, 2, 2, 2, 2};
+  std::vector<UnitRun> runs = UnitRuns::encode(ids.data(), ids.size());
+  assert(runs.size() == 4);
+  assert(runs[0].unitId == 0 && runs[0].length == 3);
+  assert(runs[3].unitId == 2 && runs[3].length == 4);
+  std::vector<uint8_t> expanded(ids.size());
+  UnitRuns::decode(runs.data(), runs.size(), expanded.data());
+  assert(expanded == ids);
+
+  std::vector<std::shared_ptr<Units>> units = {Units::getUnitByName("m"),
+                                               Units::getUnitByName("g"),
+                                               Units::getUnitByName("km")};
+  std::vector<uint32_t> rows;
+  UnitRuns::filterDimension(runs.data(), runs.size(), units, "Length", 100,
+                            rows);
+  std::vector<uint32_t> expectedRows = {100, 101, 102, 105, 106,
+                                        107, 108, 109};
+  assert(rows == expectedRows);
+
+  std::vector<double> magnitudes = {1, 2, 3, 10, 20, 4, 5, 6, 7, 8};
+  std::vector<UnitAggregate> perUnit;
+  UnitRuns::aggregateByUnit(runs.data(), runs.size(), magnitudes.data(),
+                            perUnit);
+  assert(perUnit.size() == 3);
+  assert(perUnit[0].count == 4 && perUnit[0].sum == 10);
+  assert(perUnit[0].min == 1 && perUnit[0].max == 4);
+  assert(perUnit[1].getMean() == 15);
+  assert(perUnit[2].count == 4 && perUnit[2].max == 8);
+
+  // Test the runs survive a result file and feed the kernels per block
+  ResultStore store;
+  for (int i = 0; i < 9000; ++i) {
+    std::shared_ptr<Units> unit = units[(i / 1000) % 3];
+    store.append(i + 1, Measurement(i % 10, unit));
+  }
+  const std::string path = "test_unit_runs.results";
+  ResultFile::save(store, path);
+  std::vector<UnitAggregate> scanned;
+  size_t runCount = 0;
+  rows.clear();
+  size_t firstRow = 0;
+  ResultFile::scan(path, [&](const ResultBlock& block) {
+    runCount += block.runCount;
+    UnitRuns::aggregateByUnit(block.runs, block.runCount, block.magnitudes,
+                              scanned);
+    UnitRuns::filterDimension(block.runs, block.runCount, *block.units,
+                              "Mass", firstRow, rows);
+    firstRow += block.rows;
+  });
+  std::remove(path.c_str());
+  std::cout << "Unit runs | Rows: " << store.size() << ", Runs: " << runCount
+            << std::endl;
+  assert(runCount == 11);  // 9 runs, two of them split at block boundaries
+  assert(scanned.size() == 3);
+  assert(scanned[1].count == 3000 && scanned[1].getMean() == 4.5);
+  assert(rows.size() == 3000 && rows[0] == 1000 && rows.back() == 7999);
+  assert(ReportGenerator::generateUnitSummaryReport(store).find(
+             "count 3000") != std::string::npos);
+
+  std::cout << "All unit run tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the SIMD line and token scanner.
+ */
+void testTextScanner() {
+  // Test every backend classifies a buffer the same way
+  std::string text;
+  const char alphabet[] = "0123456789.km+ \t\r\n\v\f-x";
+  unsigned state = 12345;
+  for (int i = 0; i < 1000; ++i) {
+    state = state * 1103515245 + 12345;
+    text += alphabet[(state >> 16) % (sizeof(alphabet) - 1)];
+  }
+  size_t words = (text.size() + 63) / 64;
+  std::vector<uint64_t> expectedNewlines(words), expectedSpaces(words);
+  TextScanner::classify(text.data(), text.size(), expectedNewlines.data(),
+                        expectedSpaces.data(), ScanBackend::SCALAR);
+  for (ScanBackend backend : {ScanBackend::SSE2, ScanBackend::AVX2}) {
+    if (!TextScanner::isSupported(backend)) {
+      continue;
+    }
+    std::vector<uint64_t> newlines(words), spaces(words);
+    TextScanner::classify(text.data(), text.size(), newlines.data(),
+                          spaces.data(), backend);
+    assert(newlines == expectedNewlines);
+    assert(spaces == expectedSpaces);
+  }
+  std::cout << "Scanner | Default backend: "
+            << TextScanner::getBackendName(TextScanner::getDefaultBackend())
+            << std::endl;
+
+  // Test lines and tokens match getline and operator>>
+  ScannedLines scanned;
+  size_t consumed =
+      TextScanner::scanLines(text.data(), text.size(), true, scanned);
+  assert(consumed == text.size());
+  std::istringstream lines(text);
+  std::string line;
+  size_t lineIndex = 0;
+  size_t tokenIndex = 0;
+  while (std::getline(lines, line)) {
+    assert(lineIndex < scanned.lineCount());
+    std::istringstream tokens(line);
+    std::string token;
+    while (tokens >> token) {
+      const TokenSpan& span = scanned.tokens[tokenIndex++];
+      assert(text.compare(span.begin, span.length, token) == 0);
+    }
+    assert(scanned.lineTokenEnds[lineIndex] == tokenIndex);
+    ++lineIndex;
+  }
+  assert(lineIndex == scanned.lineCount());
+
+  // Test an incomplete last line is left for the next buffer
+  const std::string chunk = "1 m + 2 m\n3 km\n4.5 c";
+  consumed = TextScanner::scanLines(chunk.data(), chunk.size(), false, scanned);
+  std::cout << "Scanner | Consumed: " << consumed << ", Lines: "
+            << scanned.lineCount() << ", Tokens: " << scanned.tokens.size()
+            << std::endl;
+  assert(consumed == 15);
+  assert(scanned.lineCount() == 2);
+  assert(scanned.tokens.size() == 7);
+  assert(scanned.lineEnds[1] == 14);
+
+  // Test the processor reads tabs, CRLF and odd tokens like the reference
+  const std::string fileName = "test_scanner.txt";
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  file << "1 m + 2 m\r\n\t3\tkm\n4.5cm\n+2 mm - 1e1 mm\n5 m x 1 m";
+  file.close();
+  MeasurementFileProcessor processor(fileName);
+  processor.readFile();
+  std::remove(fileName.c_str());
+  const ResultStore& results = processor.getResults();
+  assert(results.size() == 5);
+  assert(results.getMagnitude(0) == 3.0);
+  assert(results.getMagnitude(1) == 3.0);  // Single operand, not converted
+  assert(results.getUnit(1)->getBaseFactor() == 1000.0);
+  assert(results.getMagnitude(2) == 4.5);
+  assert(std::fabs(results.getMagnitude(3) - -0.008) < 1e-12);
+  assert(results.getMagnitude(4) == 1.0);  // "x" is dropped, as before
+
+  std::cout << "All text scanner tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the fast float parser.
+ */
+void testFastFloat() {
+  // Test edge cases against strtod
+  const char* cases[] = {"860.587", "0", "-0", "+5", "1.", ".5", "1e5",
+                         "1E-5", "-12.300", "0.1", "0.3",
+                         "9007199254740993", "9007199254740992.5",
+                         "2706312395823432.75", "-8855893472410545.5",
+                         "1.7976931348623157e308", "2.2250738585072014e-308",
+                         "123456789012345678901234567890",
+                         "0.000000000000000000000000000001234",
+                         "1.00000000000000011102230246251565404236316680908"
+                         "203125"};
+  for (const char* text : cases) {
+    double value = -1.0;
+    const char* last = text + std::strlen(text);
+    assert(FastFloat::parse(text, last, value) == last);
+    assert(value == std::strtod(text, nullptr));
+    assert(std::signbit(value) == std::signbit(std::strtod(text, nullptr)));
+  }
+
+  // Test partial and rejected inputs
+  double value = 0.0;
+  const std::string partial = "5e km";
+  assert(FastFloat::parse(partial.data(), partial.data() + partial.size(),
+                          value) == partial.data() + 1);
+  assert(value == 5.0);
+  const char* rejected[] = {"", ".", "-", "e5", "km", "1e400", "1e-400",
+                            "inf", "nan"};
+  for (const char* text : rejected) {
+    assert(FastFloat::parse(text, text + std::strlen(text), value) == nullptr);
+  }
+
+  // Test random decimals round exactly like strtod
+  unsigned state = 777;
+  char buffer[64];
+  int parsed = 0;
+  for (int i = 0; i < 200000; ++i) {
+    state = state * 1103515245 + 12345;
+    uint64_t high = state;
+    state = state * 1103515245 + 12345;
+    uint64_t mantissa = (high << 32 | state) >> (state % 40);
+    int fraction = (state >> 8) % 20;
+    int exponent = static_cast<int>((state >> 16) % 64) - 32;
+    int length = std::snprintf(buffer, sizeof(buffer), "%s%llu.%0*llue%d",
+                               (state & 1) ? "-" : "",
+                               static_cast<unsigned long long>(mantissa / 1000),
+                               fraction % 4 + 1,
+                               static_cast<unsigned long long>(mantissa % 1000),
+                               exponent);
+    errno = 0;
+    double expected = std::strtod(buffer, nullptr);
+    const char* end = FastFloat::parse(buffer, buffer + length, value);
+    if (errno == ERANGE) {
+      continue;
+    }
+    assert(end == buffer + length);
+    assert(value == expected);
+    ++parsed;
+  }
+  std::cout << "FastFloat | Random decimals matching strtod: " << parsed
+            << std::endl;
+
+  std::cout << "All fast float tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for CSV scanning and ingestion.
+ */
+void testCsvScanner() {
+  // Test every backend classifies a buffer the same way
+  std::string text;
+  const char alphabet[] = "0123456789.km,;\"\r\n ";
+  unsigned state = 54321;
+  for (int i = 0; i < 1000; ++i) {
+    state = state * 1103515245 + 12345;
+    text += alphabet[(state >> 16) % (sizeof(alphabet) - 1)];
+  }
+  size_t words = (text.size() + 63) / 64;
+  std::vector<uint64_t> expectedQuotes(words), expectedDelimiters(words),
+      expectedNewlines(words);
+  CsvScanner::classify(text.data(), text.size(), ';', expectedQuotes.data(),
+                       expectedDelimiters.data(), expectedNewlines.data(),
+                       ScanBackend::SCALAR);
+  for (ScanBackend backend : {ScanBackend::SSE2, ScanBackend::AVX2}) {
+    if (!TextScanner::isSupported(backend)) {
+      continue;
+    }
+    std::vector<uint64_t> quotes(words), delimiters(words), newlines(words);
+    CsvScanner::classify(text.data(), text.size(), ';', quotes.data(),
+                         delimiters.data(), newlines.data(), backend);
+    assert(quotes == expectedQuotes);
+    assert(delimiters == expectedDelimiters);
+    assert(newlines == expectedNewlines);
+  }
+
+  // Test quoted fields keep their delimiters, newlines and quotes
+  const std::string csv =
+      "a,\"b,1\"\r\n\"line\nbreak\",\"say \"\"hi\"\"\"\n,\nlast,x";
+  ScannedRecords scanned;
+  size_t consumed =
+      CsvScanner::scanRecords(csv.data(), csv.size(), false, ',', scanned);
+  std::cout << "CSV | Consumed: " << consumed << ", Records: "
+            << scanned.recordCount() << ", Fields: " << scanned.fields.size()
+            << std::endl;
+  assert(scanned.recordCount() == 3);
+  assert(consumed == csv.size() - 6);  // "last,x" waits for more data
+  assert(CsvScanner::getFieldText(csv.data(), scanned.fields[1]) == "b,1");
+  assert(CsvScanner::getFieldText(csv.data(), scanned.fields[2]) ==
+         "line\nbreak");
+  assert(CsvScanner::getFieldText(csv.data(), scanned.fields[3]) ==
+         "say \"hi\"");
+  assert(scanned.fields[4].length == 0 && scanned.fields[5].length == 0);
+  consumed = CsvScanner::scanRecords(csv.data(), csv.size(), true, ',',
+                                     scanned);
+  assert(consumed == csv.size() && scanned.recordCount() == 4);
+
+  // Test a generateCSVReport export reads back into the same results
+  std::vector<Measurement> exported;
+  exported.emplace_back(860.59, Units::getUnitByName("m"));
+  exported.emplace_back(12.5, Units::getUnitByName("g"));
+  exported.emplace_back(-3.25, Units::getUnitByName("l"));
+  const std::string fileName = "test_csv.csv";
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  file << ReportGenerator::generateCSVReport(exported);
+  file.close();
+  MeasurementFileProcessor processor(fileName);
+  processor.setCsvInput();
+  processor.readFile();
+  const ResultStore& results = processor.getResults();
+  assert(results.size() == 3);
+  for (size_t i = 0; i < exported.size(); ++i) {
+    assert(results.getMagnitude(i) == exported[i].getMagnitude());
+    assert(results.getUnit(i)->getType() == exported[i].getUnit()->getType());
+    assert(results.getLineNumber(i) == static_cast<int64_t>(i) + 2);
+  }
+
+  // Test header-driven mapping with other columns, quotes and CRLF
+  file.open(fileName.c_str(), std::ios::binary);
+  file << "id;Unit;note;Magnitude\r\n1;m;\"a;b\";\"2.5\"\r\n\r\n2;kg;;7\r\n";
+  file.close();
+  CsvOptions options;
+  options.delimiter = ';';
+  MeasurementFileProcessor mapped(fileName);
+  mapped.setCsvInput(options);
+  mapped.readFile();
+  assert(mapped.getResults().size() == 2);
+  assert(mapped.getResults().getMagnitude(0) == 2.5);
+  assert(mapped.getResults().getMagnitude(1) == 7.0);
+  assert(mapped.getResults().getUnit(1)->getType() == "Mass");
+
+  // Test a missing column is reported
+  options.magnitudeColumn = "Value";
+  MeasurementFileProcessor missing(fileName);
+  missing.setCsvInput(options);
+  bool threw = false;
+  try {
+    missing.readFile();
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  std::remove(fileName.c_str());
+  assert(threw);
+
+  std::cout << "All CSV tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the JSON report writer.
+ */
+void testJsonReport() {
+  // Test numbers are short and round trip
+  char text[JsonReportWriter::MAX_NUMBER_LENGTH + 1];
+  const double numbers[] = {860.587, 0.1, -12.3, 1e-7, 123456789012345.0,
+                             1e300, 0.1 + 0.2, 5e-324, -0.0, 1.0 / 3.0};
+  const char* expected[] = {"860.587", "0.1", "-12.3", "1e-07",
+                            "123456789012345", "1e+300", "0.30000000000000004",
+                            nullptr, "-0", nullptr};
+  for (int i = 0; i < 10; ++i) {
+    char* end = JsonReportWriter::formatNumber(numbers[i], text);
+    *end = '\0';
+    assert(end - text <= static_cast<long>(JsonReportWriter::MAX_NUMBER_LENGTH));
+    assert(std::strtod(text, nullptr) == numbers[i]);
+    assert(expected[i] == nullptr || std::strcmp(text, expected[i]) == 0);
+  }
+  unsigned state = 99;
+  for (int i = 0; i < 100000; ++i) {
+    state = state * 1103515245 + 12345;
+    double value = (state >> 8) / 1000.0 * ((state & 1) ? 1.0 : 1e-3);
+    *JsonReportWriter::formatNumber(value, text) = '\0';
+    assert(std::strtod(text, nullptr) == value);
+  }
+  *JsonReportWriter::formatNumber(std::nan(""), text) = '\0';
+  assert(std::strcmp(text, "null") == 0);
+  *JsonReportWriter::formatInteger(-9223372036854775807LL - 1, text) = '\0';
+  assert(std::strcmp(text, "-9223372036854775808") == 0);
+
+  // Test NDJSON and array records from the result columns
+  ResultStore store;
+  store.append(3, Measurement(860.587, Units::getUnitByName("m")));
+  store.append(7, Measurement(2.5, Units::getUnitByName("km")),
+               RESULT_OUTLIER);
+  std::string ndjson = ReportGenerator::generateJSONReport(store);
+  std::cout << "JSON | " << ndjson;
+  assert(ndjson ==
+         "{\"line\":3,\"magnitude\":860.587,\"unit\":\"m\","
+         "\"dimension\":\"Length\",\"status\":\"ok\"}\n"
+         "{\"line\":7,\"magnitude\":2500,\"unit\":\"m\","
+         "\"dimension\":\"Length\",\"status\":\"outlier\"}\n");
+  std::string array =
+      ReportGenerator::generateJSONReport(store, JsonFormat::ARRAY);
+  assert(array.compare(0, 2, "[\n") == 0);
+  assert(array.find("},\n{") != std::string::npos);
+  assert(array.compare(array.size() - 3, 3, "\n]\n") == 0);
+  assert(ReportGenerator::generateJSONReport(ResultStore(), JsonFormat::ARRAY) ==
+         "[]\n");
+
+  // Test a stream larger than the buffer is written in full
+  ResultStore large(StoragePolicy::FLOAT32);
+  for (int i = 0; i < 20000; ++i) {
+    large.append(i + 1, Measurement(i * 0.5, Units::getUnitByName("g")));
+  }
+  std::ostringstream oss;
+  JsonReportWriter writer(oss);
+  writer.write(large, 0, 10000);
+  writer.write(large, 10000);
+  writer.finish();
+  std::string streamed = oss.str();
+  assert(writer.getRecordCount() == 20000);
+  assert(std::count(streamed.begin(), streamed.end(), '\n') == 20000);
+  assert(streamed.find("{\"line\":20000,\"magnitude\":9999.5,") !=
+         std::string::npos);
+  assert(JsonReportWriter::escapeString("a\"b\\\n") == "\"a\\\"b\\\\\\u000a\"");
+
+  std::cout << "All JSON report tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the Arrow IPC exporter.
+ */
+void testArrowExport() {
+  // Test unit labels are rebuilt from the base unit and factor
+  assert(ArrowExporter::getUnitLabel(*Units::getUnitByName("km")) == "km");
+  assert(ArrowExporter::getUnitLabel(*Units::getUnitByName("ug")) == "ug");
+  assert(ArrowExporter::getUnitLabel(*Units::getUnitByName("l")) == "l");
+  assert(ArrowExporter::getUnitLabel(*Units::getUnitByName("min")) == "min");
+  assert(ArrowExporter::getUnitLabel(Length("m", 0.3048)) == "m*0.3048");
+
+  // Test the file framing: magic numbers, footer and aligned messages
+  ResultStore store;
+  const char* names[] = {"m", "km", "mg", "hr", "ml"};
+  const size_t rows = ArrowExporter::BATCH_ROWS + 1000;
+  for (size_t i = 0; i < rows; ++i) {
+    double magnitude = i % 1000 == 7 ? NAN : i * 0.25;
+    store.append(static_cast<int64_t>(i) + 1,
+                 Measurement(magnitude, Units::getUnitByName(names[i % 5])));
+  }
+  std::ostringstream file;
+  size_t bytes = ArrowExporter::write(store, file, ArrowFormat::FILE);
+  std::string arrow = file.str();
+  std::cout << "Arrow | " << rows << " rows, " << bytes << " bytes"
+            << std::endl;
+  assert(bytes == arrow.size());
+  assert(arrow.compare(0, 8, std::string("ARROW1\0\0", 8)) == 0);
+  assert(arrow.compare(arrow.size() - 6, 6, "ARROW1") == 0);
+  int32_t footerLength;
+  std::memcpy(&footerLength, &arrow[arrow.size() - 10], 4);
+  assert(footerLength > 0 &&
+         static_cast<size_t>(footerLength) < arrow.size() - 18);
+
+  size_t offset = 8;
+  int messages = 0;
+  while (true) {
+    uint32_t marker;
+    int32_t metadataLength;
+    std::memcpy(&marker, &arrow[offset], 4);
+    std::memcpy(&metadataLength, &arrow[offset + 4], 4);
+    assert(marker == 0xFFFFFFFF);
+    if (metadataLength == 0) {
+      break;  // End of stream
+    }
+    ///> Message.bodyLength is field 3 of the root table
+    const char* metadata = &arrow[offset + 8];
+    uint32_t root;
+    int32_t vtableOffset;
+    uint16_t bodyLengthField;
+    int64_t bodyLength = 0;
+    std::memcpy(&root, metadata, 4);
+    std::memcpy(&vtableOffset, metadata + root, 4);
+    std::memcpy(&bodyLengthField, metadata + root - vtableOffset + 4 + 2 * 3,
+                2);
+    if (bodyLengthField != 0) {
+      std::memcpy(&bodyLength, metadata + root + bodyLengthField, 8);
+    }
+    offset += 8 + metadataLength;
+    assert(offset % ArrowExporter::ALIGNMENT == 0);  // The body is aligned
+    assert(bodyLength % static_cast<int64_t>(ArrowExporter::ALIGNMENT) == 0);
+    offset += bodyLength;
+    ++messages;
+  }
+  assert(messages == 5);  // Schema, two dictionaries, two batches
+
+  // Test the line numbers are written verbatim at an aligned offset
+  const char* lines =
+      reinterpret_cast<const char*>(store.getLineNumbers().data());
+  size_t found = arrow.find(std::string(lines, 64 * sizeof(int64_t)));
+  assert(found != std::string::npos);
+  assert(found % ArrowExporter::ALIGNMENT == 0);
+
+  // Test the stream framing ends with the end-of-stream marker
+  std::ostringstream stream;
+  ArrowExporter::write(store, stream, ArrowFormat::STREAM);
+  std::string ipc = stream.str();
+  assert(ipc.compare(ipc.size() - 8, 8,
+                     std::string("\xFF\xFF\xFF\xFF\0\0\0\0", 8)) == 0);
+  assert(ipc.size() + 8 < arrow.size());
+
+  // Test an empty store still writes a schema and dictionaries
+  std::ostringstream empty;
+  assert(ArrowExporter::write(ResultStore(), empty, ArrowFormat::FILE) > 0);
+  assert(empty.str().compare(empty.str().size() - 6, 6, "ARROW1") == 0);
+
+  std::cout << "All Arrow export tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the line index sidecar.
+ */
+void testLineIndex() {
+  // Test offsets round-trip through every delta width
+  LineIndex index(4);
+  std::vector<uint64_t> offsets;
+  uint64_t offset = 0;
+  for (int i = 0; i < 23; ++i) {
+    offsets.push_back(offset);
+    index.addLine(offset);
+    offset += i < 8 ? 10 : i < 16 ? 300 : 70000;  // 1, 2 and 4 byte blocks
+  }
+  index.finish(offset);
+  assert(index.getLineCount() == 23);
+  for (size_t line = 1; line <= offsets.size(); ++line) {
+    assert(index.getLineOffset(line) == offsets[line - 1]);
+  }
+  assert(index.getLineEnd(23) == offset);
+  assert(index.memoryUsage() < offsets.size() * sizeof(uint64_t));
+  bool threw = false;
+  try {
+    index.getLineOffset(24);
+  } catch (const std::out_of_range&) {
+    threw = true;
+  }
+  assert(threw);
+
+  // Test splits cover every line with counts differing by at most one
+  std::vector<std::pair<size_t, size_t>> ranges = index.split(5);
+  assert(ranges.size() == 5);
+  assert(ranges.front().first == 1 && ranges.back().second == 23);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    size_t count = ranges[i].second - ranges[i].first + 1;
+    assert(count == (i < 3 ? 5u : 4u));
+    assert(i == 0 || ranges[i].first == ranges[i - 1].second + 1);
+  }
+
+  // Test a sidecar with a bad delta width or fine offset is rejected
+  const std::string corruptName = "test_corrupt.lidx";
+  const std::streamoff firstBlock = 8 + 4 + 8 + 8 + 8;
+  const std::streamoff fineAt =
+      firstBlock + 13 * ((index.getLineCount() + 3) / 4);
+  index.save(corruptName);
+  uint64_t fineSize = 0;
+  {
+    std::ifstream saved(corruptName.c_str(), std::ios::binary);
+    saved.seekg(fineAt);
+    saved.read(reinterpret_cast<char*>(&fineSize), sizeof(fineSize));
+  }
+  const std::string huge("\xff\xff\xff\xff\xff\xff\xff\x0f", 8);
+  const std::pair<std::streamoff, std::string> corruptions[] = {
+      {firstBlock + 12, std::string(1, '\xc8')},                // Width
+      {firstBlock + 8, std::string("\xff\xff\x00\x00", 4)},  // Offset
+      {20, std::string("\x00\x00\x00\x00\x00\x00\x00\x10", 8) +
+               std::string("\x00\x00\x00\x00\x00\x00\x00\x04",
+                           8)},  // 2^60 lines in 2^58 blocks
+      {fineAt, huge},            // Fine size
+      {fineAt + 8 + static_cast<std::streamoff>(fineSize), huge}};  // Failed
+  for (const auto& corruption : corruptions) {
+    index.save(corruptName);
+    std::fstream patch(corruptName.c_str(),
+                       std::ios::binary | std::ios::in | std::ios::out);
+    patch.seekp(corruption.first);
+    patch.write(corruption.second.data(), corruption.second.size());
+    patch.close();
+    threw = false;
+    try {
+      LineIndex::load(corruptName);
+    } catch (const std::runtime_error& e) {
+      threw = std::string(e.what()).find("Corrupt line index") == 0;
+    }
+    assert(threw);
+  }
+  std::remove(corruptName.c_str());
+
+  // Test readFile saves a sidecar that locates every line
+  const std::string fileName = "test_lines.txt";
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  file << "5 m + 3 m\n2 kg\n7 xx 1 m\n4 s * 2 s\n9 qq 2 l\n1 l";
+  file.close();
+  MeasurementFileProcessor full(fileName);
+  full.enableLineIndex(2);
+  full.readFile();
+  assert(full.getResults().size() == 6);
+  assert(full.getFailedLines() == std::vector<int64_t>({3, 5}));
+  LineIndex saved = LineIndex::load(LineIndex::getSidecarPath(fileName));
+  assert(saved.getLineCount() == 6 && saved.getInterval() == 2);
+  assert(saved.getFailedLines() == full.getFailedLines());
+  IndexedFile indexed(fileName, saved);
+  std::string text;
+  indexed.readLine(4, text);
+  assert(text == "4 s * 2 s");
+  indexed.readLine(6, text);
+  assert(text == "1 l");
+  indexed.readLines(2, 3, text);
+  assert(text == "2 kg\n7 xx 1 m\n");
+
+  // Test only the requested lines are evaluated, under their own numbers
+  MeasurementFileProcessor partial(fileName);
+  partial.readLines(saved.getFailedLines());
+  const ResultStore& results = partial.getResults();
+  assert(results.size() == 2);
+  assert(results.getLineNumber(0) == 3 && results.getLineNumber(1) == 5);
+  assert(results.getMagnitude(0) == 1.0 && results.getMagnitude(1) == 2.0);
+  MeasurementFileProcessor run(fileName);
+  run.readLines(std::vector<int64_t>({1, 2, 6}));
+  assert(run.getResults().size() == 3);
+  assert(run.getResults().getLineNumber(2) == 6);
+  assert(run.getResults().getMagnitude(0) == 8.0);
+
+  // Test a changed file no longer matches its index
+  file.open(fileName.c_str(), std::ios::binary | std::ios::app);
+  file << "\n2 m";
+  file.close();
+  MeasurementFileProcessor stale(fileName);
+  threw = false;
+  try {
+    stale.readLines(std::vector<int64_t>({1}));
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  std::remove(LineIndex::getSidecarPath(fileName).c_str());
+  std::remove(fileName.c_str());
+  assert(threw);
+
+  // Test a line that cannot be evaluated is recorded, skipped and rerun
+  const std::string brokenName = "test_failed_lines.txt";
+  file.open(brokenName.c_str(), std::ios::binary);
+  file << "1 m\n2 h\n3 m\n";
+  file.close();
+  MeasurementFileProcessor indexing(brokenName);
+  indexing.enableLogging(false);
+  indexing.enableLineIndex();
+  indexing.readFile();
+  assert(indexing.getResults().size() == 2);
+  assert(indexing.getFailedLines() == std::vector<int64_t>({2}));
+  LineIndex failed = LineIndex::load(LineIndex::getSidecarPath(brokenName));
+  assert(failed.getLineCount() == 3);
+  assert(failed.getFailedLines() == std::vector<int64_t>({2}));
+  file.open(brokenName.c_str(), std::ios::binary | std::ios::in);
+  file.seekp(4);
+  file << "2 s";  // Fixed in place, so the index still matches
+  file.close();
+  MeasurementFileProcessor rerun(brokenName);
+  rerun.enableLogging(false);
+  rerun.readLines(failed.getFailedLines());
+  std::remove(LineIndex::getSidecarPath(brokenName).c_str());
+  std::remove(brokenName.c_str());
+  assert(rerun.getResults().size() == 1);
+  assert(rerun.getResults().getLineNumber(0) == 2);
+  assert(rerun.getResults().getMagnitude(0) == 2.0);
+
+  std::cout << "All line index tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the asynchronous output writer.
+ */
+void testAsyncWriter() {
+  // Test tiny buffers hand over often and keep every byte in order
+  const std::string fileName = "test_async.txt";
+  std::string expected;
+  {
+    AsyncWriter writer(fileName, 7);
+    std::ostream out(&writer);
+    for (int i = 0; i < 1000; ++i) {
+      out << "Result: " << i * 0.5 << " m" << std::endl;
+    }
+    out << std::string(100, 'x');
+    writer.flush();
+    assert(out.good());
+    for (int i = 0; i < 1000; ++i) {
+      std::ostringstream line;
+      line << "Result: " << i * 0.5 << " m\n";
+      expected += line.str();
+    }
+    expected += std::string(100, 'x');
+    assert(writer.getBytesWritten() == expected.size());
+    out << "tail";  // Written by the destructor
+  }
+  expected += "tail";
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  std::string written((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+  in.close();
+  assert(written == expected);
+
+  // Test a redirected std::cout goes through the writer and is restored
+  std::streambuf* original = std::cout.rdbuf();
+  {
+    AsyncWriter writer(fileName);
+    StreamRedirect redirect(std::cout, writer);
+    std::cout << "redirected" << std::endl;
+  }
+  assert(std::cout.rdbuf() == original);
+  in.open(fileName.c_str(), std::ios::binary);
+  std::getline(in, written);
+  in.close();
+  assert(written == "redirected");
+
+  // Test a failed write is reported
+  int fd = ::open(fileName.c_str(), O_RDONLY);
+  assert(fd >= 0);
+  bool threw = false;
+  {
+    AsyncWriter writer(fd);
+    std::ostream out(&writer);
+    out << "cannot be written";
+    try {
+      writer.flush();
+    } catch (const std::runtime_error&) {
+      threw = true;
+    }
+    out << std::string(2 * AsyncWriter::DEFAULT_BUFFER_SIZE, 'x');
+    assert(out.bad());
+  }
+  ::close(fd);
+  std::remove(fileName.c_str());
+  assert(threw);
+
+  std::cout << "All asynchronous writer tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the input reader backends.
+ */
+void testInputReader() {
+  const std::string fileName = "test_reader.txt";
+  std::string content;
+  for (int i = 0; i < 500; ++i) {
+    content += std::to_string(i * 1.25) + (i % 2 ? " m + 2 m\n" : " g\n");
+  }
+  content += "7 l";  // No final newline
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  file << content;
+  file.close();
+
+  // Test every backend returns the file's bytes in order, in small blocks
+  const ReaderBackend backends[] = {ReaderBackend::IFSTREAM,
+                                    ReaderBackend::MMAP,
+                                    ReaderBackend::IO_URING,
+                                    ReaderBackend::READAHEAD};
+  for (ReaderBackend backend : backends) {
+    std::unique_ptr<InputReader> reader =
+        InputReader::open(fileName, backend, 1000);
+    assert(reader->getBackend() == backend ||
+           (backend == ReaderBackend::IO_URING &&
+            reader->getBackend() == ReaderBackend::READAHEAD));
+    std::string read;
+    const char* data;
+    std::size_t size;
+    while ((size = reader->next(data)) > 0) {
+      assert(size <= 1000);
+      read.append(data, size);
+    }
+    assert(read == content);
+    assert(reader->next(data) == 0);
+  }
+
+  // Test lines straddling blocks are evaluated once, with the right offsets
+  MeasurementFileProcessor whole(fileName);
+  whole.readFile();
+  for (ReaderBackend backend : backends) {
+    MeasurementFileProcessor processor(fileName);
+    processor.setReaderBackend(backend, 7);
+    processor.enableLineIndex(16);
+    processor.readFile();
+    const ResultStore& results = processor.getResults();
+    assert(results.size() == whole.getResults().size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      assert(results.getMagnitude(i) == whole.getResults().getMagnitude(i));
+      assert(results.getLineNumber(i) == static_cast<int64_t>(i) + 1);
+    }
+    const LineIndex& index = processor.getLineIndex();
+    assert(index.getLineCount() == 501);
+    assert(index.getLineOffset(501) == content.size() - 3);
+    assert(index.getLineOffset(2) == content.find('\n') + 1);
+  }
+  std::remove(LineIndex::getSidecarPath(fileName).c_str());
+
+  // Test empty files and missing files
+  file.open(fileName.c_str(), std::ios::binary | std::ios::trunc);
+  file.close();
+  for (ReaderBackend backend : backends) {
+    const char* data;
+    assert(InputReader::open(fileName, backend)->next(data) == 0);
+  }
+  std::remove(fileName.c_str());
+  for (ReaderBackend backend : backends) {
+    bool threw = false;
+    try {
+      InputReader::open(fileName, backend);
+    } catch (const std::runtime_error&) {
+      threw = true;
+    }
+    assert(threw);
+  }
+
+  std::cout << "All input reader tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for streaming input from a pipe.
+ */
+void testStreamingInput() {
+  std::string content;
+  for (int i = 0; i < 300; ++i) {
+    content += std::to_string(i + 0.5) + (i % 3 ? " km - 1 km\n" : " s\n");
+  }
+  content += "2 l";
+  const std::string fileName = "test_stream.txt";
+  std::ofstream file(fileName.c_str(), std::ios::binary);
+  file << content;
+  file.close();
+  MeasurementFileProcessor reference(fileName);
+  reference.readFile();
+  std::remove(fileName.c_str());
+
+  // Test each backend streams a pipe written in pieces that split lines
+  const ReaderBackend backends[] = {ReaderBackend::IFSTREAM,
+                                    ReaderBackend::IO_URING,
+                                    ReaderBackend::READAHEAD};
+  for (ReaderBackend backend : backends) {
+    int fds[2];
+    int status = ::pipe(fds);
+    assert(status == 0);
+    (void)status;
+    std::thread writer([&content, &fds]() {
+      for (size_t at = 0; at < content.size(); at += 13) {
+        size_t count = std::min<size_t>(13, content.size() - at);
+        ssize_t written = ::write(fds[1], content.data() + at, count);
+        assert(written == static_cast<ssize_t>(count));
+        (void)written;
+      }
+      ::close(fds[1]);
+    });
+    MeasurementFileProcessor processor(MeasurementFileProcessor::STDIN_NAME);
+    processor.setInputDescriptor(fds[0]);
+    processor.setReaderBackend(backend, 64);
+    processor.readFile();
+    writer.join();
+    ::close(fds[0]);
+    const ResultStore& results = processor.getResults();
+    assert(results.size() == reference.getResults().size());
+    for (size_t i = 0; i < results.size(); ++i) {
+      assert(results.getMagnitude(i) ==
+             reference.getResults().getMagnitude(i));
+      assert(results.getLineNumber(i) ==
+             reference.getResults().getLineNumber(i));
+    }
+  }
+
+  // Test a pipe cannot be mapped, and has no line index
+  int fds[2];
+  int status = ::pipe(fds);
+  assert(status == 0);
+  (void)status;
+  bool threw = false;
+  try {
+    InputReader::open(fds[0], ReaderBackend::MMAP);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  assert(threw);
+  MeasurementFileProcessor indexed(MeasurementFileProcessor::STDIN_NAME);
+  indexed.setInputDescriptor(fds[0]);
+  indexed.enableLineIndex();
+  threw = false;
+  try {
+    indexed.readFile();
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+  assert(threw);
+
+  std::cout << "All streaming input tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the ExpressionKernels class.
+ */
+void testExpressionKernels() {
+  MeasurementFileProcessor reference("unused.txt");
+  reference.enableExpressionKernels(false);
+  MeasurementFileProcessor processor("unused.txt");
+  std::streambuf* coutBuffer = std::cout.rdbuf();
+  std::streambuf* cerrBuffer = std::cerr.rdbuf();
+  std::ostringstream log;
+
+  // Test every shape against the stack machine, in mixed units
+  const char symbols[] = {'+', '-', '*', '/'};
+  const char* units[] = {"km", "m", "cm", "mm"};
+  const double magnitudes[] = {7.25, 0.5, 1e3, -3.125};
+  std::vector<bool> seen(ExpressionKernels::SHAPE_COUNT, false);
+  for (size_t count = 1; count <= ExpressionKernels::MAX_OPERANDS; ++count) {
+    for (int code = 0; code < 1 << (2 * (count - 1)); ++code) {
+      std::vector<Measurement> measurements;
+      std::vector<char> operators;
+      for (size_t i = 0; i < count; ++i) {
+        measurements.emplace_back(magnitudes[i],
+                                  Units::getUnitByName(units[i]));
+        if (i + 1 < count) {
+          operators.push_back(symbols[(code >> (2 * i)) & 3]);
+        }
+      }
+      int shape = ExpressionKernels::getShape(operators, count);
+      assert(shape >= 0 && shape < ExpressionKernels::SHAPE_COUNT);
+      assert(!seen[shape]);
+      seen[shape] = true;
+
+      std::cout.rdbuf(log.rdbuf());
+      Measurement expected =
+          reference.processOperatorsWithPEMDAS(measurements, operators);
+      Measurement actual =
+          processor.processOperatorsWithPEMDAS(measurements, operators);
+      std::cout.rdbuf(coutBuffer);
+      assert(actual.getMagnitude() == expected.getMagnitude());
+      assert(actual.getUnit()->getName() == expected.getUnit()->getName());
+      assert(actual.getUnit()->getBaseFactor() ==
+             expected.getUnit()->getBaseFactor());
+    }
+  }
+
+  // Test the precedence of the class enum: 2 + 3 * 4 = 14
+  std::vector<Measurement> measurements = {
+      Measurement(2, Units::getUnitByName("m")),
+      Measurement(3, Units::getUnitByName("m")),
+      Measurement(4, Units::getUnitByName("m"))};
+  std::vector<char> operators = {'+', '*'};
+  double magnitude = 0;
+  bool isEvaluated =
+      ExpressionKernels::evaluate(measurements, operators, magnitude);
+  assert(isEvaluated && magnitude == 14);
+
+  // Test lines the stack machine must report are declined
+  operators = {'+', '/'};
+  measurements[2] = Measurement(0, Units::getUnitByName("m"));
+  isEvaluated = ExpressionKernels::evaluate(measurements, operators, magnitude);
+  assert(!isEvaluated);
+  measurements[2] = Measurement(4, Units::getUnitByName("kg"));
+  isEvaluated = ExpressionKernels::evaluate(measurements, operators, magnitude);
+  assert(!isEvaluated);
+  operators = {'+'};
+  isEvaluated = ExpressionKernels::evaluate(measurements, operators, magnitude);
+  assert(!isEvaluated);
+  (void)isEvaluated;
+
+  // Test a division by zero still fails the line with the kernels enabled
+  operators = {'/'};
+  measurements.pop_back();
+  measurements[1] = Measurement(0, Units::getUnitByName("m"));
+  bool threw = false;
+  std::cout.rdbuf(log.rdbuf());
+  std::cerr.rdbuf(log.rdbuf());
+  try {
+    processor.processOperatorsWithPEMDAS(measurements, operators);
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  std::cout.rdbuf(coutBuffer);
+  std::cerr.rdbuf(cerrBuffer);
+  assert(threw);
+
+  std::cout << "All expression kernel tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the Operators tables.
+ */
+void testOperators() {
+  MeasurementFileProcessor processor("unused.txt");
+
+  // Test the opcodes and precedence of every character
+  const std::string symbols = "+-*/";
+  for (int c = -128; c < 128; ++c) {
+    const char symbol = static_cast<char>(c);
+    const Operators::Opcode opcode = Operators::getOpcode(symbol);
+    const size_t position = symbols.find(symbol);
+    if (symbol != '\0' && position != std::string::npos) {
+      assert(opcode == static_cast<Operators::Opcode>(position));
+      assert(Operators::SYMBOLS[opcode] == symbol);
+    } else {
+      assert(opcode == Operators::INVALID);
+    }
+    assert(processor.getPrecedence(symbol) == Operators::PRECEDENCE[opcode]);
+  }
+  assert(processor.getPrecedence('*') ==
+         MeasurementFileProcessor::MUL_DIV);
+  assert(processor.getPrecedence('-') == MeasurementFileProcessor::ADD_SUB);
+
+  // Test the stack order matches the >= comparison for every pair
+  for (int stacked = 0; stacked <= Operators::COUNT; ++stacked) {
+    for (int next = 0; next <= Operators::COUNT; ++next) {
+      assert(Operators::isAppliedBefore(
+                 static_cast<Operators::Opcode>(stacked),
+                 static_cast<Operators::Opcode>(next)) ==
+             (Operators::PRECEDENCE[stacked] >= Operators::PRECEDENCE[next]));
+    }
+  }
+
+  // Test the branchless operations and the errors of applyOperation
+  assert(Operators::apply(Operators::ADD, 6, 3) == 9);
+  assert(Operators::apply(Operators::SUBTRACT, 6, 3) == 3);
+  assert(Operators::apply(Operators::MULTIPLY, 6, 3) == 18);
+  assert(Operators::apply(Operators::DIVIDE, 6, 3) == 2);
+  Measurement six(6, Units::getUnitByName("m"));
+  Measurement zero(0, Units::getUnitByName("m"));
+  assert(processor.applyOperation(six, zero, '-').getMagnitude() == 6);
+  std::streambuf* cerrBuffer = std::cerr.rdbuf();
+  std::ostringstream log;
+  std::cerr.rdbuf(log.rdbuf());
+  int failures = 0;
+  const char failing[] = {'/', '%'};
+  for (char op : failing) {
+    try {
+      processor.applyOperation(six, zero, op);
+    } catch (const std::invalid_argument&) {
+      ++failures;
+    }
+  }
+  std::cerr.rdbuf(cerrBuffer);
+  assert(failures == 2);
+  assert(log.str().find("Division by zero is not allowed.") !=
+         std::string::npos);
+  assert(log.str().find("Invalid operator.") != std::string::npos);
+
+  std::cout << "All operator table tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for selections and the result filter kernels.
+ */
+void testResultFilter() {
+  // Test the bitmap, including the bits past the last row
+  Selection all(130, true);
+  assert(all.count() == 130 && all.getWords().size() == 3);
+  assert(all.getWords()[2] == 3);
+  Selection some(130);
+  some.select(0);
+  some.select(64);
+  some.select(129);
+  assert(some.count() == 3 && some.contains(64) && !some.contains(65));
+  std::vector<uint32_t> rows = some.getRows();
+  assert(rows.size() == 3 && rows[0] == 0 && rows[1] == 64 && rows[2] == 129);
+  assert((some & all).count() == 3);
+  assert((some | Selection(130)).count() == 3);
+  bool isRejected = false;
+  try {
+    some &= Selection(129);
+  } catch (const std::invalid_argument&) {
+    isRejected = true;
+  }
+  assert(isRejected);
+
+  // Test every kernel against a row-by-row check, in both storage policies
+  const char* unitNames[] = {"m", "km", "g", "s", "l"};
+  const double magnitudes[] = {-2.5, -0.0, 0.0, 0.5, 499.0, 500.0, 1e6,
+                               std::nan("")};
+  const StoragePolicy policies[] = {StoragePolicy::DOUBLE,
+                                    StoragePolicy::FLOAT32};
+  for (StoragePolicy policy : policies) {
+    ResultStore results(policy);
+    for (int row = 0; row < 1000; ++row) {
+      results.append(row + 1,
+                     Measurement(magnitudes[(row * 7) % 8] * (1 + row % 3),
+                                 Units::getUnitByName(unitNames[row % 5])));
+    }
+    Selection lengths = ResultFilter::byDimension(results, "Length");
+    Selection grams = ResultFilter::byUnit(results, "g");
+    Selection kilometers = ResultFilter::byUnit(results, "km");
+    Selection range = ResultFilter::byMagnitude(results, 0.5, 500.0);
+    Selection baseRange = ResultFilter::byBaseMagnitude(results, 0.5, 500.0);
+    Selection valid = ResultFilter::byValidity(results);
+    assert(ResultFilter::byUnit(results, "kilometers").getWords() ==
+           kilometers.getWords());
+    bool isUnknownRejected = false;
+    try {
+      ResultFilter::byUnit(results, "ft");
+    } catch (const std::invalid_argument&) {
+      isUnknownRejected = true;
+    }
+    assert(isUnknownRejected);
+    for (size_t row = 0; row < results.size(); ++row) {
+      const double magnitude = results.getMagnitude(row);
+      const std::shared_ptr<Units> unit = results.getUnit(row);
+      const double base = magnitude * unit->getBaseFactor();
+      assert(lengths.contains(row) == (unit->getType() == "Length"));
+      assert(grams.contains(row) ==
+             (unit->getName() == "g" && unit->getBaseFactor() == 1.0));
+      assert(kilometers.contains(row) ==
+             (unit->getName() == "m" && unit->getBaseFactor() == 1000.0));
+      assert(range.contains(row) == (magnitude >= 0.5 && magnitude <= 500.0));
+      assert(baseRange.contains(row) == (base >= 0.5 && base <= 500.0));
+      assert(valid.contains(row) == MeasurementValidator::validateMeasurement(
+                                        results.getMeasurement(row)));
+    }
+
+    // Test the specification syntax: ',' is AND and binds tighter than '|'
+    Selection selected = ResultFilter::select(
+        results, "dimension=Length,min=0.5,max=500|unit=g,valid");
+    assert(selected.getWords() ==
+           ((lengths & baseRange) | (grams & valid)).getWords());
+    if (policy == StoragePolicy::DOUBLE) {
+      assert(kilometers.count() > 0);
+    }
+    assert(ResultFilter::select(results, "valid").count() == valid.count());
+
+    // Test stats and sorts on the selection match those of a filtered copy
+    std::vector<double> copy;
+    for (uint32_t row : selected.getRows()) {
+      copy.push_back(results.getMagnitude(row));
+    }
+    assert(std::fabs(results.computeMean(selected) -
+                     StatisticsCalculator::computeMean(copy)) < 1e-9);
+    assert(results.computeMode(selected) ==
+           StatisticsCalculator::computeMode(copy));
+    std::vector<uint32_t> order = results.sortedOrder(selected);
+    assert(order.size() == copy.size());
+    for (size_t i = 1; i < order.size(); ++i) {
+      assert(results.getMagnitude(order[i - 1]) <=
+             results.getMagnitude(order[i]));
+    }
+    assert(results.computeMedian(selected) ==
+           StatisticsCalculator::computeMedian(copy));
+  }
+
+  // Test malformed specifications
+  const char* malformed[] = {"", "valid,", "unit", "min=x", "max=1e", "mag=3"};
+  int failures = 0;
+  for (const char* spec : malformed) {
+    try {
+      ResultFilter::select(ResultStore(), spec);
+    } catch (const std::invalid_argument&) {
+      ++failures;
+    }
+  }
+  assert(failures == 6);
+
+  // Test a filter that selects nothing reports nothing and has empty stats
+  const char* fileName = "test_filter.txt";
+  {
+    std::ofstream file(fileName);
+    file << "1 m\n2 g\n";
+  }
+  MeasurementFileProcessor processor(fileName);
+  processor.enableLogging(false);
+  processor.readFile();
+  std::remove(fileName);
+  Selection none = ResultFilter::select(processor.getResults(),
+                                        "dimension=Volume|unit=m,unit=g");
+  assert(none.count() == 0);
+  assert(processor.generateReportsInOriginalOrder(none).empty());
+  assert(processor.generateReportsInSortedOrder(none).empty());
+  std::vector<Measurement> noMeasurements;
+  assert(StatisticsCalculator::computeMean(noMeasurements) == 0.0);
+  assert(StatisticsCalculator::computeMode(noMeasurements) == 0.0);
+  assert(StatisticsCalculator::computeMedian(noMeasurements) == 0.0);
+  assert(processor.getResults().computeMean(none) == 0.0);
+  assert(processor.getResults().computeMedian(none) == 0.0);
+
+  std::cout << "All result filter tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for rendering reports in requested units.
+ */
+void testReportUnits() {
+  // Test the scale pass in both storage policies
+  const StoragePolicy policies[] = {StoragePolicy::DOUBLE,
+                                    StoragePolicy::FLOAT32};
+  ReportUnits targets = ReportUnits::parse("km,min");
+  assert(!targets.empty() && ReportUnits().empty());
+  for (StoragePolicy policy : policies) {
+    ResultStore results(policy);
+    for (int row = 0; row < 102; ++row) {  // 103 rows leave a scalar tail
+      const char* unitName = row % 3 == 0 ? "km" : row % 3 == 1 ? "m" : "g";
+      results.append(row + 1,
+                     Measurement(row + 0.5, Units::getUnitByName(unitName)));
+    }
+    results.append(103, Measurement(90, Units::getUnitByName("s")));
+    std::vector<std::string> labels;
+    std::vector<double> scaled = targets.scale(results, labels);
+    assert(scaled.size() == results.size());
+    for (size_t row = 0; row + 1 < results.size(); ++row) {
+      const std::shared_ptr<Units>& unit = results.getUnit(row);
+      const std::string& label = labels[results.getUnitId(row)];
+      if (unit->getType() == "Length") {
+        assert(label == "km");
+        assert(std::fabs(scaled[row] - (row % 3 == 0 ? 1000.0 : 1.0) *
+                                           (row + 0.5) / 1000) < 1e-9);
+      } else {
+        assert(label == "g" && scaled[row] == results.getMagnitude(row));
+      }
+    }
+    assert(scaled.back() == 1.5 && labels[results.getUnitId(102)] == "min");
+  }
+
+  // Test the specifications that are rejected
+  const char* malformed[] = {"", "km,m", "furlong"};
+  int failures = 0;
+  for (const char* spec : malformed) {
+    try {
+      ReportUnits::parse(spec);
+    } catch (const std::invalid_argument&) {
+      ++failures;
+    }
+  }
+  assert(failures == 3);
+
+  // Test the reports: rescaled lengths sort by what is printed
+  const char* fileName = "test_report_units.txt";
+  {
+    std::ofstream file(fileName);
+    file << "3 km\n500 m\n2 kg\n90 s\n1 m + 1 m\n";
+  }
+  MeasurementFileProcessor processor(fileName);
+  processor.readFile();
+  processor.setReportUnits(targets);
+  std::vector<std::string> lines = processor.generateReportsInOriginalOrder();
+  std::vector<std::string> sorted = processor.generateReportsInSortedOrder();
+  processor.setReportUnits(ReportUnits());
+  std::vector<std::string> stored = processor.generateReportsInOriginalOrder();
+  std::remove(fileName);
+  const char* expected[] = {"3.00 km", "0.50 km", "2.00 g", "1.50 min",
+                            "0.00 km"};
+  const char* expectedSorted[] = {"0.00 km", "0.50 km", "1.50 min", "2.00 g",
+                                  "3.00 km"};
+  assert(lines.size() == 5 && sorted.size() == 5);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    assert(lines[i] == expected[i]);
+    assert(sorted[i] == expectedSorted[i]);
+  }
+  assert(stored[0] == "3.00 m");  // The stored unit keeps the base symbol
+
+  std::cout << "All report unit tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for line streaming and the line-by-line diff.
+ */
+void testLineDiff() {
+  // Test that batches of lines add up to what readFile loads
+  const char* year1Name = "test_diff_year1.txt";
+  const char* year2Name = "test_diff_year2.txt";
+  {
+    std::ofstream year1(year1Name);
+    year1 << "10 m\n5 kg\n2 m + 2 m\n3 xx 2 s\n1 s\n0 m\n100 m";
+    std::ofstream year2(year2Name);
+    year2 << "10 km\n5000 g\n8 m\n1 m\n1 m\n3 m\n95 m\n1 m\n";
+  }
+  MeasurementFileProcessor whole(year1Name);
+  whole.enableLogging(false);
+  whole.readFile();
+  MeasurementFileProcessor batched(year1Name);
+  batched.enableLogging(false);
+  batched.setReaderBackend(ReaderBackend::IFSTREAM, 5);  // Lines straddle
+  std::vector<double> magnitudes;
+  std::vector<int64_t> lineNumbers;
+  std::size_t lineCount = 0;
+  std::size_t read;
+  while ((read = batched.readNextLines(3)) > 0) {
+    assert(read == 3 || read == 1);
+    lineCount += read;
+    for (size_t row = 0; row < batched.getResults().size(); ++row) {
+      magnitudes.push_back(batched.getResults().getMagnitude(row));
+      lineNumbers.push_back(batched.getResults().getLineNumber(row));
+    }
+  }
+  assert(lineCount == 7 && magnitudes.size() == whole.getResults().size());
+  for (size_t row = 0; row < magnitudes.size(); ++row) {
+    assert(magnitudes[row] == whole.getResults().getMagnitude(row));
+    assert(lineNumbers[row] == whole.getResults().getLineNumber(row));
+  }
+
+  // Test the diff: 5 kg and 5000 g are equal, seconds and meters do not pair
+  MeasurementFileProcessor year1(year1Name);
+  MeasurementFileProcessor year2(year2Name);
+  year1.enableLogging(false);
+  year2.enableLogging(false);
+  std::ostringstream out;
+  LineDiff diff(year1, year2, DiffMetric::PERCENT, 10, 2);
+  const LineDiffStatistics& statistics = diff.run(out);
+  std::remove(year1Name);
+  std::remove(year2Name);
+  assert(statistics.lines == 8);
+  assert(statistics.paired == 5);    // Lines 1, 2, 3, 6 and 7
+  assert(statistics.unpaired == 1);  // Line 8 is only in year2
+  assert(statistics.mismatched == 2);
+  assert(statistics.reported == 3);
+  std::istringstream records(out.str());
+  std::string record;
+  std::vector<std::string> lines;
+  while (getline(records, record)) {
+    lines.push_back(record.substr(0, record.find(',')));
+  }
+  assert(lines.size() == 4 && lines[0] == "Line");
+  assert(lines[1] == "1" && lines[2] == "3" && lines[3] == "6");
+  assert(out.str().find("3,Length,m,4,8,4,2,100\n") != std::string::npos);
+
+  // Test the kernel, including a zero year1 magnitude
+  const double before[] = {100, 100, 100, 0, 0, -50};
+  const double after[] = {100, 250, 40, 0, 1, 50};
+  double delta[6], ratio[6], percent[6];
+  uint8_t isReported[6];
+  assert(LineDiff::compare(before, after, 6, DiffMetric::RATIO, 2, delta,
+                           ratio, percent, isReported) == 4);
+  const uint8_t expectedRatio[] = {0, 1, 1, 0, 1, 1};
+  for (int i = 0; i < 6; ++i) {
+    assert(isReported[i] == expectedRatio[i]);
+  }
+  assert(LineDiff::compare(before, after, 6, DiffMetric::DELTA, 59, delta,
+                           ratio, percent, isReported) == 3);
+  assert(delta[5] == 100 && percent[5] == 200 && ratio[5] == -1);
+  assert(LineDiff::compare(before, after, 6, DiffMetric::PERCENT, 60, delta,
+                           ratio, percent, isReported) == 3);
+  assert(isReported[4] == 1 && isReported[3] == 0);  // inf passes, NaN not
+
+  // Test the specifications
+  DiffMetric metric;
+  double threshold;
+  bool isValid = LineDiff::parseSpec("ratio:1.5", metric, threshold);
+  assert(isValid && metric == DiffMetric::RATIO && threshold == 1.5);
+  const char* malformed[] = {"percent", "percent:", "mean:3", "delta:-1",
+                             "ratio:0.5", "delta:1x", "delta:inf"};
+  for (const char* spec : malformed) {
+    isValid = LineDiff::parseSpec(spec, metric, threshold);
+    assert(!isValid);
+  }
+
+  std::cout << "All line diff tests passed." << std::endl;
+}
+
+/**
+ * @brief Unit tests for the query language and its plans.
+ */
+void testQuery() {
+  // Test the base magnitude kernel against a row-by-row check
+  const char* unitNames[] = {"m", "km", "cm", "g", "kg"};
+  const StoragePolicy policies[] = {StoragePolicy::DOUBLE,
+                                    StoragePolicy::FLOAT32};
+  for (StoragePolicy policy : policies) {
+    ResultStore results(policy);
+    for (int row = 0; row < 1000; ++row) {
+      const double magnitude = row % 11 == 0 ? std::nan("") : row - 300.0;
+      results.append(row + 1, Measurement(magnitude, Units::getUnitByName(
+                                                         unitNames[row % 5])));
+    }
+    Selection range =
+        ResultFilter::byBaseMagnitude(results, "Length", 5.0, 50000.0);
+    for (size_t row = 0; row < results.size(); ++row) {
+      const std::shared_ptr<Units>& unit = results.getUnit(row);
+      const double base = results.getMagnitude(row) * unit->getBaseFactor();
+      assert(range.contains(row) ==
+             (unit->getType() == "Length" && base >= 5.0 && base <= 50000.0));
+    }
+  }
+
+  // Test a whole plan: filter in base units, aggregate, top-K, convert
+  for (StoragePolicy policy : policies) {
+    ResultStore results(policy);
+    const double magnitudes[] = {0.2, 300, 600, 2, 1, -1, 0.7, std::nan("")};
+    const char* names[] = {"km", "m", "m", "kg", "km", "m", "km", "m"};
+    for (int row = 0; row < 8; ++row) {
+      results.append(row + 1, Measurement(magnitudes[row],
+                                          Units::getUnitByName(names[row])));
+    }
+    Query query = Query::parse(
+        "select dim=Length where mag > 500 m convert m "
+        "stats count,mean,max,p50 sort desc limit 2");
+    QueryResult result = query.execute(results);
+    assert(result.matched == 3);  // 600 m, 1 km and 0.7 km
+    assert(result.rows.size() == 2 && result.rows[0] == 4 &&
+           result.rows[1] == 6);
+    assert(result.lineNumbers[0] == 5 && result.labels[0] == "m");
+    assert(std::fabs(result.magnitudes[1] - 700) < 1e-3);
+    assert(result.statistics.size() == 4 && result.statisticsUnit == "m");
+    assert(result.statistics[0].first == "count" &&
+           result.statistics[0].second == 3);
+    assert(std::fabs(result.statistics[1].second - 2300.0 / 3) < 1e-3);
+    assert(std::fabs(result.statistics[2].second - 1000) < 1e-3);
+    assert(std::fabs(result.statistics[3].second - 700) < 1e-3);
+    std::vector<std::string> lines = Query::format(result);
+    assert(lines.size() == 7 && lines[0] == "Line 5: 1000.00 m");
+    assert(lines[2] == "2 of 3 matching result(s) shown.");
+    assert(lines[3] == "count: 3" && lines[5] == "max: 1000.00 m");
+
+    // Spaces inside a predicate do not matter, strict bounds are strict
+    Selection spaced = Query::parse("select dim = Length where mag>=600m")
+                           .select(results);
+    Selection strict =
+        Query::parse("select dim=Length where mag > 600 m").select(results);
+    assert(spaced.count() == 3 && spaced.contains(2));
+    assert(strict.count() == 2 && !strict.contains(2));
+
+    // and binds tighter than or; no sort keeps the file order
+    result = Query::parse("select * where dim=Mass or mag<0 and dim=Length")
+                 .execute(results);
+    assert(result.rows.size() == 2 && result.rows[0] == 3 &&
+           result.rows[1] == 5);
+
+    // A unit is its base unit and factor; FLOAT32 stores base units only
+    const bool isBaseOnly = policy == StoragePolicy::FLOAT32;
+    assert(Query::parse("select unit=kg").select(results).count() ==
+           (isBaseOnly ? 0u : 1u));
+    assert(Query::parse("select unit=g").select(results).count() ==
+           (isBaseOnly ? 1u : 0u));
+    Selection stored =
+        Query::parse("select * where mag>=1 and mag<=2").select(results);
+    assert(stored.getWords() ==
+           ResultFilter::byBaseMagnitude(results, 1, 2).getWords());
+    assert(stored.count() == 0);  // 1 km is 1000 m, 2 kg is 2000 g
+    result = Query::parse("select dim=Length limit 3").execute(results);
+    assert(result.matched == 7 && result.rows.size() == 3 &&
+           result.rows[2] == 2);
+    // Without convert, rows render in the base unit where compares them
+    assert(result.labels[0] == "m" &&
+           std::fabs(result.magnitudes[0] - 200) < 1e-3);
+    assert(Query::format(result)[0] == "Line 1: 200.00 m");
+
+    // A bound without a unit is in base units too, like the rows it prints
+    ResultStore levels(policy);
+    levels.append(1, Measurement(3, Units::getUnitByName("km")));
+    levels.append(2, Measurement(700, Units::getUnitByName("m")));
+    levels.append(3, Measurement(0.5, Units::getUnitByName("km")));
+    result = Query::parse("select dim=Length where mag>400").execute(levels);
+    assert(result.matched == 3 && result.labels[0] == "m" &&
+           std::fabs(result.magnitudes[0] - 3000) < 1e-3);
+    assert(Query::parse("select * where mag<=600").select(levels).count() ==
+           1);
+
+    // Statistics of no rows
+    result = Query::parse("select dim=Volume stats count,mean")
+                 .execute(results);
+    assert(result.matched == 0 && result.statistics[0].second == 0);
+    assert(std::isnan(result.statistics[1].second));
+    std::vector<std::string> none = Query::format(result);
+    assert(none.size() == 2 && none[1] == "No results");
+  }
+
+  // Test units of another dimension than the select clause's
+  Query::parse("select dim=Length,unit=kg where mag>5kg convert kg,km");
+  Query::parse("select * where mag>5kg convert kg");
+
+  // Test malformed queries
+  const char* malformed[] = {"",
+                             "where mag>1",
+                             "select",
+                             "select * where",
+                             "select mag>1",
+                             "select *,",
+                             "select * where mag>>1",
+                             "select * where mag>1xx",
+                             "select * where and valid",
+                             "select * where valid or",
+                             "select * stats p0",
+                             "select * stats p101,mean",
+                             "select * sort up",
+                             "select * limit -1",
+                             "select * limit 2 limit 3",
+                             "select * convert km,cm",
+                             "select unit=xx",
+                             "select dim=Length where mag>5kg",
+                             "select dim=Length where valid or mag<1kg",
+                             "select dim=Length convert kg",
+                             "select unit=g where mag<1m"};
+  for (const char* text : malformed) {
+    bool isRejected = false;
+    try {
+      Query::parse(text);
+    } catch (const std::invalid_argument&) {
+      isRejected = true;
+    }
+    assert(isRejected);
+  }
+
+  std::cout << "All query tests passed." << std::endl;
+}
 
 /**
  * @brief Main function to run all unit tests.
@@ -229,6 +2302,72 @@ int main() {
   // Test statistics
   testStatistics();
 
+  // Test outlier detection
+  testOutlierDetection();
+
+  // Test histograms
+  testHistogram();
+
+  // Test distinct counts
+  testDistinctCounts();
+
+  // Test fixed-point magnitudes
+  testFixedPoint();
+
+  // Test the result store
+  testResultStore();
+
+  // Test compressed result files
+  testResultCompression();
+
+  // Test run-length encoded unit IDs
+  testUnitRuns();
+
+  // Test the SIMD text scanner
+  testTextScanner();
+
+  // Test the fast float parser
+  testFastFloat();
+
+  // Test CSV ingestion
+  testCsvScanner();
+
+  // Test JSON reports
+  testJsonReport();
+
+  // Test Arrow IPC export
+  testArrowExport();
+
+  // Test the line index sidecar
+  testLineIndex();
+
+  // Test the asynchronous output writer
+  testAsyncWriter();
+
+  // Test the input reader backends
+  testInputReader();
+
+  // Test streaming input from a pipe
+  testStreamingInput();
+
+  // Test the expression kernels
+  testExpressionKernels();
+
+  // Test the operator tables
+  testOperators();
+
+  // Test the selection vectors and filter kernels
+  testResultFilter();
+
+  // Test rendering reports in requested units
+  testReportUnits();
+
+  // Test line streaming and the line-by-line diff
+  testLineDiff();
+
+  // Test the query language
+  testQuery();
+
   std::cout << "All tests passed successfully." << std::endl;
 
   return 0;
@@ -0,0 +1,266 @@
+/**
+ * @file TextScanner.cpp
+ * @brief Implementation of the TextScanner class.
+ *
+ * @version 0.1
+ */
+
+#include "TextScanner.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define UNITIFY_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+/**
+ * @brief Classifies a byte the way std::isspace does in the "C" locale.
+ */
+inline bool isSpace(unsigned char c) {
+  return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+/**
+ * @brief Classifies bytes [64 * word, size) one at a time; used for tails.
+ */
+void classifyScalarFrom(const char* data, std::size_t size, std::size_t word,
+                        uint64_t* newlines, uint64_t* whitespace) {
+  for (std::size_t start = word * 64; start < size; start += 64, ++word) {
+    uint64_t newline = 0;
+    uint64_t space = ~uint64_t(0);  ///> Bytes past the end are whitespace
+    for (std::size_t b = 0; b < 64 && start + b < size; ++b) {
+      unsigned char c = static_cast<unsigned char>(data[start + b]);
+      newline |= uint64_t(c == '\n') << b;
+      space &= ~(uint64_t(!isSpace(c)) << b);
+    }
+    newlines[word] = newline;
+    whitespace[word] = space;
+  }
+}
+
+#ifdef UNITIFY_X86
+void classifySse2(const char* data, std::size_t size, uint64_t* newlines,
+                  uint64_t* whitespace) {
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  const __m128i controlRange = _mm_set1_epi8('\r' - '\t');
+
+  std::size_t word = 0;
+  for (; (word + 1) * 64 <= size; ++word) {
+    uint64_t newlineMask = 0;
+    uint64_t spaceMask = 0;
+    for (int lane = 0; lane < 4; ++lane) {
+      __m128i bytes = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(data + word * 64 + lane * 16));
+      ///> \t..\r is an unsigned range check: min(c - \t, 4) == c - \t
+      __m128i offset = _mm_sub_epi8(bytes, tab);
+      __m128i control =
+          _mm_cmpeq_epi8(_mm_min_epu8(offset, controlRange), offset);
+      __m128i isSpace = _mm_or_si128(_mm_cmpeq_epi8(bytes, space), control);
+      newlineMask |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(
+                         _mm_cmpeq_epi8(bytes, newline))))
+                     << (lane * 16);
+      spaceMask |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(isSpace)))
+                   << (lane * 16);
+    }
+    newlines[word] = newlineMask;
+    whitespace[word] = spaceMask;
+  }
+  classifyScalarFrom(data, size, word, newlines, whitespace);
+}
+
+__attribute__((target("avx2"))) void classifyAvx2(const char* data,
+                                                  std::size_t size,
+                                                  uint64_t* newlines,
+                                                  uint64_t* whitespace) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i space = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i controlRange = _mm256_set1_epi8('\r' - '\t');
+
+  std::size_t word = 0;
+  for (; (word + 1) * 64 <= size; ++word) {
+    uint64_t newlineMask = 0;
+    uint64_t spaceMask = 0;
+    for (int lane = 0; lane < 2; ++lane) {
+      __m256i bytes = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(data + word * 64 + lane * 32));
+      __m256i offset = _mm256_sub_epi8(bytes, tab);
+      __m256i control =
+          _mm256_cmpeq_epi8(_mm256_min_epu8(offset, controlRange), offset);
+      __m256i isSpace =
+          _mm256_or_si256(_mm256_cmpeq_epi8(bytes, space), control);
+      newlineMask |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(
+                         _mm256_cmpeq_epi8(bytes, newline))))
+                     << (lane * 32);
+      spaceMask |=
+          uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(isSpace)))
+          << (lane * 32);
+    }
+    newlines[word] = newlineMask;
+    whitespace[word] = spaceMask;
+  }
+  classifyScalarFrom(data, size, word, newlines, whitespace);
+}
+#endif
+
+const std::size_t FLATTEN_SLACK = 16;  ///< Entries flatten may write past.
+
+inline uint32_t lowestBit(uint64_t bits) {
+  return bits != 0 ? __builtin_ctzll(bits) : 0;
+}
+
+/**
+ * @brief Writes base + the index of each set bit, in order, simdjson style.
+ *
+ * The first 8 (then 16) positions are written unconditionally so the loop
+ * does not mispredict on the number of bits; up to FLATTEN_SLACK entries
+ * past the returned end may be overwritten.
+ */
+inline uint32_t* flatten(uint32_t* out, uint32_t base, uint64_t bits) {
+  const int count = __builtin_popcountll(bits);
+  for (int k = 0; k < 8; ++k) {
+    out[k] = base + lowestBit(bits);
+    bits &= bits - 1;
+  }
+  if (count > 8) {
+    for (int k = 8; k < 16; ++k) {
+      out[k] = base + lowestBit(bits);
+      bits &= bits - 1;
+    }
+    for (int k = 16; bits != 0; ++k) {
+      out[k] = base + lowestBit(bits);
+      bits &= bits - 1;
+    }
+  }
+  return out + count;
+}
+
+ScanBackend detectBackend() {
+#ifdef UNITIFY_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return ScanBackend::AVX2;
+  }
+  return ScanBackend::SSE2;
+#else
+  return ScanBackend::SCALAR;
+#endif
+}
+}  // namespace
+
+std::size_t ScannedLines::lineCount() const {
+  return lineEnds.size();
+}
+
+ScanBackend TextScanner::getDefaultBackend() {
+  static const ScanBackend backend = detectBackend();
+  return backend;
+}
+
+bool TextScanner::isSupported(ScanBackend backend) {
+  return backend <= getDefaultBackend();
+}
+
+const char* TextScanner::getBackendName(ScanBackend backend) {
+  switch (backend) {
+    case ScanBackend::AVX2:
+      return "avx2";
+    case ScanBackend::SSE2:
+      return "sse2";
+    default:
+      return "scalar";
+  }
+}
+
+void TextScanner::classify(const char* data, std::size_t size,
+                           uint64_t* newlines, uint64_t* whitespace,
+                           ScanBackend backend) {
+#ifdef UNITIFY_X86
+  if (backend == ScanBackend::AVX2) {
+    classifyAvx2(data, size, newlines, whitespace);
+    return;
+  } else if (backend == ScanBackend::SSE2) {
+    classifySse2(data, size, newlines, whitespace);
+    return;
+  }
+#endif
+  (void)backend;
+  classifyScalarFrom(data, size, 0, newlines, whitespace);
+}
+
+std::size_t TextScanner::scanLines(const char* data, std::size_t size,
+                                   bool isLast, ScannedLines& out) {
+  out.tokens.clear();
+  out.lineEnds.clear();
+  out.lineTokenEnds.clear();
+  const std::size_t words = (size + 63) / 64;
+  out.newlineMasks.resize(words);
+  out.whitespaceMasks.resize(words);
+  classify(data, size, out.newlineMasks.data(), out.whitespaceMasks.data(),
+           getDefaultBackend());
+
+  ///> First pass: count boundaries so the outputs are sized exactly once
+  std::size_t tokenCount = 0;
+  std::size_t lineCount = 0;
+  uint64_t carry = 0;  ///> Whether the previous word ended inside a token
+  for (std::size_t word = 0; word < words; ++word) {
+    const uint64_t text = ~out.whitespaceMasks[word];
+    tokenCount += __builtin_popcountll(text & ~((text << 1) | carry));
+    lineCount += __builtin_popcountll(out.newlineMasks[word]);
+    carry = text >> 63;
+  }
+  out.tokens.resize(tokenCount);
+  out.tokenBegins.resize(tokenCount + FLATTEN_SLACK);
+  out.tokenEnds.resize(tokenCount + FLATTEN_SLACK + 1);
+  out.lineEnds.resize(lineCount);
+  out.lineTokenEnds.resize(lineCount);
+
+  ///> Second pass: starts and ends are flattened separately, without
+  ///> branching on the kind of boundary; token i ends at the i-th end
+  uint32_t* begins = out.tokenBegins.data();
+  uint32_t* ends = out.tokenEnds.data();
+  uint32_t* lineEnds = out.lineEnds.data();
+  uint32_t* lineTokenEnds = out.lineTokenEnds.data();
+  carry = 0;
+  for (std::size_t word = 0; word < words; ++word) {
+    const uint64_t text = ~out.whitespaceMasks[word];
+    const uint64_t previous = (text << 1) | carry;
+    const uint64_t wordStarts = text & ~previous;  ///> First byte of a token
+    const uint64_t wordEnds = ~text & previous;    ///> First byte after one
+    uint64_t newlines = out.newlineMasks[word];
+    carry = text >> 63;
+
+    const uint32_t base = static_cast<uint32_t>(word * 64);
+    const std::size_t endsBefore = ends - out.tokenEnds.data();
+    begins = flatten(begins, base, wordStarts);
+    ends = flatten(ends, base, wordEnds);
+    while (newlines != 0) {
+      const int bit = __builtin_ctzll(newlines);
+      ///> A token ending at the newline itself belongs to the line
+      const uint64_t upTo = (uint64_t(2) << bit) - 1;  ///> Wraps for bit 63
+      *lineEnds++ = base + bit;
+      *lineTokenEnds++ = static_cast<uint32_t>(
+          endsBefore + __builtin_popcountll(wordEnds & upTo));
+      newlines &= newlines - 1;
+    }
+  }
+  if (carry != 0) {
+    ///> The buffer ends inside a token
+    *ends++ = static_cast<uint32_t>(size);
+  }
+  for (std::size_t i = 0; i < tokenCount; ++i) {
+    out.tokens[i].begin = out.tokenBegins[i];
+    out.tokens[i].length = out.tokenEnds[i] - out.tokenBegins[i];
+  }
+
+  std::size_t consumed = out.lineEnds.empty() ? 0 : out.lineEnds.back() + 1;
+  if (isLast && consumed < size) {
+    out.lineEnds.push_back(static_cast<uint32_t>(size));
+    out.lineTokenEnds.push_back(static_cast<uint32_t>(out.tokens.size()));
+    consumed = size;
+  }
+  out.tokens.resize(out.lineTokenEnds.empty() ? 0 : out.lineTokenEnds.back());
+  return consumed;
+}
@@ -0,0 +1,116 @@
+/**
+ * @file UnitRuns.cpp
+ * @brief Implementation of the UnitRuns class.
+ *
+ * @version 0.1
+ */
+
+#include "UnitRuns.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+/**
+ * @brief Folds each run's contiguous slice into its unit's aggregate.
+ */
+template <typename T>
+void aggregateRuns(const UnitRun* runs, std::size_t runCount,
+                   const T* magnitudes, std::vector<UnitAggregate>& perUnit) {
+  const T* slice = magnitudes;
+  for (std::size_t r = 0; r < runCount; ++r) {
+    const UnitRun& run = runs[r];
+    if (run.unitId >= perUnit.size()) {
+      perUnit.resize(run.unitId + 1);
+    }
+
+    ///> One tight loop per run; no per-row unit lookup
+    double sum = 0.0;
+    double low = slice[0];
+    double high = slice[0];
+    for (uint32_t i = 0; i < run.length; ++i) {
+      double value = slice[i];
+      sum += value;
+      low = std::min(low, value);
+      high = std::max(high, value);
+    }
+
+    UnitAggregate& aggregate = perUnit[run.unitId];
+    if (aggregate.count == 0) {
+      aggregate.min = low;
+      aggregate.max = high;
+    } else {
+      aggregate.min = std::min(aggregate.min, low);
+      aggregate.max = std::max(aggregate.max, high);
+    }
+    aggregate.count += run.length;
+    aggregate.sum += sum;
+    slice += run.length;
+  }
+}
+}  // namespace
+
+UnitAggregate::UnitAggregate() : count(0), sum(0.0), min(0.0), max(0.0) {}
+
+double UnitAggregate::getMean() const {
+  return count > 0 ? sum / count : 0.0;
+}
+
+std::vector<UnitRun> UnitRuns::encode(const uint8_t* unitIds,
+                                      std::size_t count) {
+  std::vector<UnitRun> runs;
+  std::size_t start = 0;
+  while (start < count) {
+    std::size_t end = start + 1;
+    while (end < count && unitIds[end] == unitIds[start]) {
+      ++end;
+    }
+    UnitRun run;
+    run.unitId = unitIds[start];
+    run.length = static_cast<uint32_t>(end - start);
+    runs.push_back(run);
+    start = end;
+  }
+  return runs;
+}
+
+void UnitRuns::decode(const UnitRun* runs, std::size_t runCount,
+                      uint8_t* unitIds) {
+  for (std::size_t r = 0; r < runCount; ++r) {
+    std::memset(unitIds, runs[r].unitId, runs[r].length);
+    unitIds += runs[r].length;
+  }
+}
+
+void UnitRuns::filterDimension(const UnitRun* runs, std::size_t runCount,
+                               const std::vector<std::shared_ptr<Units>>& units,
+                               const std::string& dimension,
+                               std::size_t firstRow,
+                               std::vector<uint32_t>& rows) {
+  ///> Resolve the dimension once per dictionary entry, not per row
+  std::vector<bool> matches(units.size());
+  for (std::size_t i = 0; i < units.size(); ++i) {
+    matches[i] = units[i]->getType() == dimension;
+  }
+
+  std::size_t row = firstRow;
+  for (std::size_t r = 0; r < runCount; ++r) {
+    if (matches[runs[r].unitId]) {
+      for (uint32_t i = 0; i < runs[r].length; ++i) {
+        rows.push_back(static_cast<uint32_t>(row + i));
+      }
+    }
+    row += runs[r].length;
+  }
+}
+
+void UnitRuns::aggregateByUnit(const UnitRun* runs, std::size_t runCount,
+                               const double* magnitudes,
+                               std::vector<UnitAggregate>& perUnit) {
+  aggregateRuns(runs, runCount, magnitudes, perUnit);
+}
+
+void UnitRuns::aggregateByUnit(const UnitRun* runs, std::size_t runCount,
+                               const float* magnitudes,
+                               std::vector<UnitAggregate>& perUnit) {
+  aggregateRuns(runs, runCount, magnitudes, perUnit);
+}
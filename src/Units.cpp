@@ -38,73 +38,66 @@ double Units::getBaseFactor() const {
   return baseUnitFactor;
 }
 
-std::shared_ptr<Units> Units::getUnitByName(const std::string& unitName) {
-  ///> Handling mass units
-  if (unitName == "micrograms" || unitName == "ug") {
-    return std::make_shared<Mass>("g", 1e-6);  ///> Convert micrograms to grams
-  } else if (unitName == "milligrams" || unitName == "mg") {
-    return std::make_shared<Mass>("g", 0.001);  ///> Convert milligrams to grams
-  } else if (unitName == "centigrams" || unitName == "cg") {
-    return std::make_shared<Mass>("g", 0.01);  ///> Convert centigrams to grams
-  } else if (unitName == "decigrams" || unitName == "dg") {
-    return std::make_shared<Mass>("g", 0.1);  ///> Convert decigrams to grams
-  } else if (unitName == "grams" || unitName == "g") {
-    return std::make_shared<Mass>("g", 1.0);  ///> Base unit: grams
-  } else if (unitName == "kilograms" || unitName == "kg") {
-    return std::make_shared<Mass>("g", 1000.0);  ///> Convert kilograms to grams
+namespace {
+/**
+ * @brief The dimension a unit table entry belongs to.
+ */
+enum class UnitKind { MASS, LENGTH, TIME, VOLUME };
 
-    ///> Handling length units
-  } else if (unitName == "micrometers" || unitName == "um") {
-    return std::make_shared<Length>("m",
-                                    1e-6);  ///> Convert micrometers to meters
-  } else if (unitName == "millimeters" || unitName == "mm") {
-    return std::make_shared<Length>("m",
-                                    0.001);  ///> Convert millimeters to meters
-  } else if (unitName == "centimeters" || unitName == "cm") {
-    return std::make_shared<Length>("m",
-                                    0.01);  ///> Convert centimeters to meters
-  } else if (unitName == "decimeters" || unitName == "dm") {
-    return std::make_shared<Length>("m",
-                                    0.1);  ///> Convert decimeters to meters
-  } else if (unitName == "meters" || unitName == "m") {
-    return std::make_shared<Length>("m", 1.0);  ///> Base unit: meters
-  } else if (unitName == "kilometers" || unitName == "km") {
-    return std::make_shared<Length>("m",
-                                    1000.0);  ///> Convert kilometers to meters
+/**
+ * @brief One recognized unit: its long and short names and its factor to
+ * the base unit.
+ */
+struct UnitEntry {
+  const char* name;    ///< Long name, e.g. "kilometers".
+  const char* symbol;  ///< Short name, e.g. "km".
+  UnitKind kind;       ///< Dimension.
+  double factor;       ///< Base units per unit.
+};
 
-    ///> Handling time units
-  } else if (unitName == "milliseconds" || unitName == "ms") {
-    return std::make_shared<TimeUnit>(
-        "s",
-        0.001);  ///> Convert milliseconds to seconds
-  } else if (unitName == "seconds" || unitName == "s") {
-    return std::make_shared<TimeUnit>("s", 1.0);  ///> Base unit: seconds
-  } else if (unitName == "minutes" || unitName == "min") {
-    return std::make_shared<TimeUnit>("s",
-                                      60.0);  ///> Convert minutes to seconds
-  } else if (unitName == "hours" || unitName == "hr") {
-    return std::make_shared<TimeUnit>("s",
-                                      3600.0);  ///> Convert hours to seconds
+///> Constant-initialized, so looking a unit up allocates nothing until the
+///> unit itself is made and nothing runs before main
+constexpr UnitEntry unitTable[] = {
+    {"micrograms", "ug", UnitKind::MASS, 1e-6},
+    {"milligrams", "mg", UnitKind::MASS, 0.001},
+    {"centigrams", "cg", UnitKind::MASS, 0.01},
+    {"decigrams", "dg", UnitKind::MASS, 0.1},
+    {"grams", "g", UnitKind::MASS, 1.0},
+    {"kilograms", "kg", UnitKind::MASS, 1000.0},
+    {"micrometers", "um", UnitKind::LENGTH, 1e-6},
+    {"millimeters", "mm", UnitKind::LENGTH, 0.001},
+    {"centimeters", "cm", UnitKind::LENGTH, 0.01},
+    {"decimeters", "dm", UnitKind::LENGTH, 0.1},
+    {"meters", "m", UnitKind::LENGTH, 1.0},
+    {"kilometers", "km", UnitKind::LENGTH, 1000.0},
+    {"milliseconds", "ms", UnitKind::TIME, 0.001},
+    {"seconds", "s", UnitKind::TIME, 1.0},
+    {"minutes", "min", UnitKind::TIME, 60.0},
+    {"hours", "hr", UnitKind::TIME, 3600.0},
+    {"microliters", "ul", UnitKind::VOLUME, 1e-6},
+    {"milliliters", "ml", UnitKind::VOLUME, 0.001},
+    {"centiliters", "cl", UnitKind::VOLUME, 0.01},
+    {"deciliters", "dl", UnitKind::VOLUME, 0.1},
+    {"liters", "l", UnitKind::VOLUME, 1.0},
+    {"kiloliters", "kl", UnitKind::VOLUME, 1000.0}};
+}  // namespace
 
-    ///> Handling volume units
-  } else if (unitName == "microliters" || unitName == "ul") {
-    return std::make_shared<Volume>("l",
-                                    1e-6);  ///> Convert microliters to liters
-  } else if (unitName == "milliliters" || unitName == "ml") {
-    return std::make_shared<Volume>("l",
-                                    0.001);  ///> Convert milliliters to liters
-  } else if (unitName == "centiliters" || unitName == "cl") {
-    return std::make_shared<Volume>("l",
-                                    0.01);  ///> Convert centiliters to liters
-  } else if (unitName == "deciliters" || unitName == "dl") {
-    return std::make_shared<Volume>("l",
-                                    0.1);  ///> Convert deciliters to liters
-  } else if (unitName == "liters" || unitName == "l") {
-    return std::make_shared<Volume>("l", 1.0);  ///> Base unit: liters
-  } else if (unitName == "kiloliters" || unitName == "kl") {
-    return std::make_shared<Volume>("l",
-                                    1000.0);  ///> Convert kiloliters to liters
-  } else {
-    throw std::invalid_argument("Invalid unit type: " + unitName);
+std::shared_ptr<Units> Units::getUnitByName(const std::string& unitName) {
+  for (const UnitEntry& entry : unitTable) {
+    if (unitName != entry.symbol && unitName != entry.name) {
+      continue;
+    }
+    ///> Every unit is named after its dimension's base unit
+    switch (entry.kind) {
+      case UnitKind::MASS:
+        return std::make_shared<Mass>("g", entry.factor);
+      case UnitKind::LENGTH:
+        return std::make_shared<Length>("m", entry.factor);
+      case UnitKind::TIME:
+        return std::make_shared<TimeUnit>("s", entry.factor);
+      case UnitKind::VOLUME:
+        return std::make_shared<Volume>("l", entry.factor);
+    }
   }
+  throw std::invalid_argument("Invalid unit type: " + unitName);
 }
@@ -1,17 +1,37 @@
 #include <limits.h>  // For PATH_MAX
 #include <unistd.h>  // For getcwd
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <sstream>
 #include <string>
 #include <vector>
+#include "ArrowExporter.h"
+#include "AsyncWriter.h"
+#include "CsvScanner.h"
+#include "FixedPoint.h"
 #include "IOStreamHandler.h"
+#include "InputReader.h"
+#include "JsonReportWriter.h"
 #include "Length.h"
+#include "LineDiff.h"
+#include "LineIndex.h"
 #include "Mass.h"
 #include "Measurement.h"
 #include "MeasurementFileProcessor.h"
 #include "MeasurementValidator.h"
+#include "OutlierDetector.h"
+#include "Query.h"
 #include "ReportGenerator.h"
+#include "ReportUnits.h"
+#include "ResultFile.h"
+#include "ResultFilter.h"
+#include "ResultStore.h"
+#include "Selection.h"
 #include "StatisticsCalculator.h"
 #include "TimeUnit.h"
 #include "UnitConverter.h"
@@ -27,6 +47,9 @@
  * Displays government restricted rights notice and warranty disclaimer, as this 
  * software is developed by SpaceX and licensed to the U.S. Government.
  * 
+ * The banner is written without flushing; it reaches the terminal with the
+ * first flush of std::cout, instead of taking a write per paragraph.
+ *
  * @warning FOR INTERNAL USE ONLY - DO NOT DISTRIBUTE
  */
 void titleBanner() {
@@ -44,23 +67,23 @@ void titleBanner() {
                "   \\/_____/ || \n"
             << "\\============================================================="
                "=======/ \n"
-            << std::endl;
+            << "\n";
 
-  std::cout << "                          Unitify v1.0\n" << std::endl;
+  std::cout << "                          Unitify v1.0\n" << "\n";
     std::cout << "           FOR INTERNAL USE ONLY - DO NOT DISTRIBUTE\n"
-            << std::endl;
+            << "\n";
   std::cout << "Copyright (c) 2024 Space Exploration Technologies Corporation "
                "(SpaceX) \n"
                "Licensed to Mars Exploration Program, NASA, under U.S. "
                "Government Contract.\n"
                "All Foreign Rights Reserved to the U.S. Government.\n"
-            << std::endl;
+            << "\n";
   std::cout
       << " For software support, please contact SpaceX at emusk@spacex.com\n"
-      << std::endl;
+      << "\n";
 
   std::cout << "              GOVERNMENT RESTRICTED RIGHTS NOTICE\n"
-            << std::endl;
+            << "\n";
   std::cout << "This software is developed by SpaceX and licensed to the U.S. "
                "Government\n"
                "with RESTRICTED RIGHTS. Use, duplication, or disclosure is "
@@ -69,24 +92,479 @@ void titleBanner() {
                "Rights in\n"
                "Technical Data and Computer Software clause at DFARS "
                "252.227-7013. \n"
-            << std::endl;
+            << "\n";
   std::cout
       << "Export of this software is controlled under the International "
          "Traffic in Arms\n"
          "Regulations (ITAR). Unauthorized export or disclosure to non-U.S. "
          "persons is\n"
          "prohibited without prior authorization from the U.S. Government.\n"
-      << std::endl;
+      << "\n";
   std::cout << "Warranty Disclaimer: This software is provided 'AS IS' with no "
                "warranties,\n"
                "including fitness for a particular purpose or merchantability. "
                "SpaceX assumes no\n"
                "liability for any damages arising from its use.\n"
-            << std::endl;
+            << "\n";
   
 }
 
 
+/**
+ * @struct CommandLineOptions
+ * @brief Options collected from the command line.
+ */
+struct CommandLineOptions {
+  std::vector<std::string> files;  ///< Positional input file names.
+  OutlierPolicy outlierPolicy;     ///< What to do with outlying results.
+  bool histogram;                  ///< Add histogram tables to the report.
+  bool histogramCsv;               ///< Export histograms as CSV files.
+  bool distinct;                   ///< Add distinct counts to the report.
+  bool adaptiveMode;               ///< Bin the mode of mostly distinct data.
+  int fixedPointPlaces;            ///< Default decimal places, -1 if off.
+  std::map<std::string, int> fixedPointDimensionPlaces;  ///< Per dimension.
+  StoragePolicy storagePolicy;     ///< How results keep their magnitudes.
+  bool saveResults;                ///< Save results as compressed blocks.
+  bool unitSummary;                ///< Add per-unit aggregates to the report.
+  bool csv;                        ///< Read the input files as CSV.
+  bool json;                       ///< Export results as a JSON array.
+  bool ndjson;                     ///< Export results as NDJSON.
+  bool arrow;                      ///< Export results as an Arrow IPC file.
+  bool arrowStream;                ///< Export results as an Arrow IPC stream.
+  CsvOptions csvOptions;           ///< Column mapping of CSV input.
+  uint32_t lineIndexInterval;      ///< Lines per index sample, 0 if off.
+  bool failedLinesOnly;            ///< Re-evaluate the indexed failed lines.
+  std::vector<std::pair<int64_t, int64_t>>
+      lineRanges;                  ///< Lines to evaluate, all if empty.
+  ReaderBackend readerBackend;     ///< How the input files are read.
+  std::string filter;              ///< ResultFilter spec, all rows if empty.
+  ReportUnits reportUnits;         ///< Units the reports render in.
+  bool diff;                       ///< Compare the files line by line.
+  DiffMetric diffMetric;           ///< The change the comparison tests.
+  double diffThreshold;            ///< Lines past it are reported.
+  bool query;                      ///< Run a query instead of the reports.
+  bool quiet;                      ///< Skip the banner and per-line logging.
+  Query queryPlan;                 ///< The compiled query.
+
+  CommandLineOptions()
+      : outlierPolicy(OutlierPolicy::NONE),
+        histogram(false),
+        histogramCsv(false),
+        distinct(false),
+        adaptiveMode(false),
+        fixedPointPlaces(-1),
+        storagePolicy(StoragePolicy::DOUBLE),
+        saveResults(false),
+        unitSummary(false),
+        csv(false),
+        json(false),
+        ndjson(false),
+        arrow(false),
+        arrowStream(false),
+        lineIndexInterval(0),
+        failedLinesOnly(false),
+        readerBackend(ReaderBackend::IFSTREAM),
+        diff(false),
+        diffMetric(DiffMetric::PERCENT),
+        diffThreshold(0),
+        query(false),
+        quiet(false) {}
+};
+
+/**
+ * @brief Parse a --fixed-point[=SPEC] option.
+ * 
+ * SPEC is a comma-separated list of entries, each either a number of decimal
+ * places (the default for every dimension) or Dimension:places.
+ * 
+ * @param arg The option, including the "--fixed-point" prefix.
+ * @param options The options to fill in.
+ * @return true if the specification was valid, false otherwise.
+ */
+bool parseFixedPointSpec(const std::string& arg, CommandLineOptions& options) {
+  options.fixedPointPlaces = 6;
+  if (arg == "--fixed-point") {
+    return true;
+  }
+  if (arg.compare(0, 14, "--fixed-point=") != 0) {
+    return false;
+  }
+
+  std::stringstream spec(arg.substr(14));
+  std::string entry;
+  while (getline(spec, entry, ',')) {
+    size_t colon = entry.find(':');
+    std::string digits = colon == std::string::npos ? entry
+                                                    : entry.substr(colon + 1);
+    if (digits.empty() || digits.size() > 2 ||
+        digits.find_first_not_of("0123456789") != std::string::npos) {
+      return false;
+    }
+    int places = std::stoi(digits);
+    if (places > FixedPoint::MAX_PLACES) {
+      return false;
+    }
+    if (colon == std::string::npos) {
+      options.fixedPointPlaces = places;
+    } else {
+      options.fixedPointDimensionPlaces[entry.substr(0, colon)] = places;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Parse a --csv[=MAGNITUDE,UNIT] option.
+ *
+ * Each column is a header name, or a zero-based index if it is all digits.
+ *
+ * @param arg The option, including the "--csv" prefix.
+ * @param options The options to fill in.
+ * @return true if the specification was valid, false otherwise.
+ */
+bool parseCsvSpec(const std::string& arg, CommandLineOptions& options) {
+  options.csv = true;
+  if (arg == "--csv") {
+    return true;
+  }
+  if (arg.compare(0, 6, "--csv=") != 0) {
+    return false;
+  }
+
+  std::string spec = arg.substr(6);
+  size_t comma = spec.find(',');
+  if (comma == std::string::npos || comma == 0 || comma + 1 == spec.size()) {
+    return false;
+  }
+  std::string columns[2] = {spec.substr(0, comma), spec.substr(comma + 1)};
+  for (int i = 0; i < 2; ++i) {
+    bool isIndex = columns[i].size() <= 4 &&
+                   columns[i].find_first_not_of("0123456789") ==
+                       std::string::npos;
+    if (isIndex) {
+      (i == 0 ? options.csvOptions.magnitudeIndex
+              : options.csvOptions.unitIndex) = std::stoi(columns[i]);
+    } else {
+      (i == 0 ? options.csvOptions.magnitudeColumn
+              : options.csvOptions.unitColumn) = columns[i];
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Parse a --lines=SPEC option.
+ *
+ * SPEC is "failed", or a comma-separated list of line numbers and FIRST-LAST
+ * ranges in increasing order.
+ *
+ * @param arg The option, including the "--lines=" prefix.
+ * @param options The options to fill in.
+ * @return true if the specification was valid, false otherwise.
+ */
+bool parseLineSpec(const std::string& arg, CommandLineOptions& options) {
+  std::string spec = arg.substr(8);
+  if (spec == "failed") {
+    options.failedLinesOnly = true;
+    return true;
+  }
+
+  std::stringstream list(spec);
+  std::string entry;
+  int64_t previous = 0;
+  while (getline(list, entry, ',')) {
+    size_t dash = entry.find('-');
+    std::string bounds[2] = {entry.substr(0, dash),
+                             dash == std::string::npos ? entry
+                                                       : entry.substr(dash + 1)};
+    for (const std::string& bound : bounds) {
+      if (bound.empty() || bound.size() > 18 ||
+          bound.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+      }
+    }
+    int64_t first = std::stoll(bounds[0]);
+    int64_t last = std::stoll(bounds[1]);
+    if (first <= previous || last < first) {
+      return false;
+    }
+    options.lineRanges.push_back(std::make_pair(first, last));
+    previous = last;
+  }
+  return !options.lineRanges.empty();
+}
+
+/**
+ * @brief Parse the command-line arguments.
+ * 
+ * Arguments starting with "--" are options, everything else is an input file;
+ * "-" reads one of the files from standard input (e.g. zcat data.gz | ...).
+ * Supported options:
+ *  - --outliers=flag|exclude  Detect outliers per dimension during ingest.
+ *  - --histogram               Add per-dimension histograms to the report.
+ *  - --histogram-csv           Export each file's histograms to
+ *                              <file>.histogram.csv.
+ *  - --distinct                Add approximate distinct counts to the report.
+ *  - --adaptive-mode           Report the mode of mostly distinct magnitudes
+ *                              as the fullest histogram bucket instead of
+ *                              the exact mode.
+ *  - --fixed-point[=SPEC]      Keep exact scaled-integer results. SPEC is a
+ *                              number of decimal places (default 6) and/or a
+ *                              list like Length:3,Mass:6.
+ *  - --float32                 Store result magnitudes as float.
+ *  - --save-results            Save each file's results to the compressed
+ *                              binary file <file>.results.
+ *  - --unit-summary            Add per-unit counts and ranges to the report.
+ *  - --csv[=MAGNITUDE,UNIT]    Read the input files as CSV, e.g. the output
+ *                              of generateCSVReport. The columns are header
+ *                              names (default Magnitude,Unit) or zero-based
+ *                              indices.
+ *  - --csv-delimiter=C         Separate CSV fields with C instead of ','.
+ *  - --csv-no-header           The CSV files have no header record; columns
+ *                              default to 0,1.
+ *  - --json                    Export each file's results to <file>.json.
+ *  - --ndjson                  Export each file's results to <file>.ndjson,
+ *                              one record per line.
+ *  - --arrow                   Export each file's results to the Arrow IPC
+ *                              file <file>.arrow.
+ *  - --arrow-stream            Export each file's results to the Arrow IPC
+ *                              stream <file>.arrows.
+ *  - --line-index[=N]          Save each file's line start offsets, sampled
+ *                              every N lines (default 64), and its failed
+ *                              lines to <file>.lidx.
+ *  - --lines=SPEC              Evaluate only some lines, using the saved
+ *                              <file>.lidx. SPEC is "failed" or a list like
+ *                              1-100,250.
+ *  - --reader=BACKEND          Read the input files with ifstream (default),
+ *                              mmap, io_uring or readahead.
+ *  - --report-units=LIST       Render each dimension of the reports in one
+ *                              unit, e.g. km,kg,min.
+ *  - --diff=METRIC:THRESHOLD   Instead of the reports, pair the files' results
+ *                              by line and save the lines whose change
+ *                              exceeds THRESHOLD to measurement_diff.csv.
+ *                              METRIC is delta (base units), ratio or
+ *                              percent, e.g. percent:10.
+ *  - --filter=SPEC             Report only the results SPEC selects, e.g.
+ *                              'dimension=Length,min=0|unit=g' (',' is AND,
+ *                              '|' is OR; min and max are in base units;
+ *                              see ResultFilter::select).
+ *  - --query=QUERY             Instead of the reports, print what QUERY
+ *                              returns for each file, e.g. 'select dim=Length
+ *                              where mag>500m stats mean,p99 sort desc
+ *                              limit 20' (see Query).
+ *  - --quiet                   Skip the title banner and the per-line
+ *                              processing log.
+ * 
+ * @param argc The number of command-line arguments.
+ * @param argv The array of command-line arguments.
+ * @param options The options to fill in.
+ * @return true if the arguments were valid, false otherwise.
+ */
+bool parseCommandLine(int argc, char* argv[], CommandLineOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg.compare(0, 2, "--") != 0) {
+      options.files.push_back(arg);
+    } else if (arg == "--outliers=flag") {
+      options.outlierPolicy = OutlierPolicy::FLAG;
+    } else if (arg == "--outliers=exclude") {
+      options.outlierPolicy = OutlierPolicy::EXCLUDE;
+    } else if (arg == "--histogram") {
+      options.histogram = true;
+    } else if (arg == "--histogram-csv") {
+      options.histogramCsv = true;
+    } else if (arg == "--distinct") {
+      options.distinct = true;
+    } else if (arg == "--adaptive-mode") {
+      options.adaptiveMode = true;
+    } else if (arg == "--float32") {
+      options.storagePolicy = StoragePolicy::FLOAT32;
+    } else if (arg == "--save-results") {
+      options.saveResults = true;
+    } else if (arg == "--unit-summary") {
+      options.unitSummary = true;
+    } else if (arg.compare(0, 16, "--csv-delimiter=") == 0 &&
+               arg.size() == 17) {
+      options.csvOptions.delimiter = arg[16];
+    } else if (arg == "--json") {
+      options.json = true;
+    } else if (arg == "--ndjson") {
+      options.ndjson = true;
+    } else if (arg == "--arrow") {
+      options.arrow = true;
+    } else if (arg == "--arrow-stream") {
+      options.arrowStream = true;
+    } else if (arg == "--line-index") {
+      options.lineIndexInterval = LineIndex::DEFAULT_INTERVAL;
+    } else if (arg.compare(0, 13, "--line-index=") == 0) {
+      std::string digits = arg.substr(13);
+      if (digits.empty() || digits.size() > 9 ||
+          digits.find_first_not_of("0123456789") != std::string::npos ||
+          std::stoi(digits) == 0) {
+        std::cerr << "Invalid line index interval: " << arg << std::endl;
+        return false;
+      }
+      options.lineIndexInterval = static_cast<uint32_t>(std::stoi(digits));
+    } else if (arg.compare(0, 9, "--reader=") == 0) {
+      const ReaderBackend backends[] = {
+          ReaderBackend::IFSTREAM, ReaderBackend::MMAP,
+          ReaderBackend::IO_URING, ReaderBackend::READAHEAD};
+      bool isKnown = false;
+      for (ReaderBackend backend : backends) {
+        if (arg.substr(9) == InputReader::getBackendName(backend)) {
+          options.readerBackend = backend;
+          isKnown = true;
+        }
+      }
+      if (!isKnown) {
+        std::cerr << "Unknown reader: " << arg << std::endl;
+        return false;
+      }
+    } else if (arg.compare(0, 15, "--report-units=") == 0) {
+      try {
+        options.reportUnits = ReportUnits::parse(arg.substr(15));
+      } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+      }
+    } else if (arg.compare(0, 7, "--diff=") == 0) {
+      if (!LineDiff::parseSpec(arg.substr(7), options.diffMetric,
+                               options.diffThreshold)) {
+        std::cerr << "Invalid diff specification: " << arg << std::endl;
+        return false;
+      }
+      options.diff = true;
+    } else if (arg.compare(0, 9, "--filter=") == 0) {
+      options.filter = arg.substr(9);
+      try {
+        ///> Evaluating on no rows checks the syntax
+        ResultFilter::select(ResultStore(), options.filter);
+      } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+      }
+    } else if (arg == "--quiet") {
+      options.quiet = true;
+    } else if (arg.compare(0, 8, "--query=") == 0) {
+      try {
+        options.queryPlan = Query::parse(arg.substr(8));
+      } catch (const std::invalid_argument& e) {
+        std::cerr << e.what() << std::endl;
+        return false;
+      }
+      options.query = true;
+    } else if (arg.compare(0, 8, "--lines=") == 0) {
+      if (!parseLineSpec(arg, options)) {
+        std::cerr << "Invalid line specification: " << arg << std::endl;
+        return false;
+      }
+    } else if (arg == "--csv-no-header") {
+      options.csvOptions.hasHeader = false;
+    } else if (arg.compare(0, 5, "--csv") == 0) {
+      if (!parseCsvSpec(arg, options)) {
+        std::cerr << "Invalid CSV specification: " << arg << std::endl;
+        return false;
+      }
+    } else if (arg.compare(0, 13, "--fixed-point") == 0) {
+      if (!parseFixedPointSpec(arg, options)) {
+        std::cerr << "Invalid fixed-point specification: " << arg
+                  << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Compare the files line by line and save the lines that changed.
+ *
+ * Both files are read in lockstep, a batch of lines at a time, so memory
+ * does not grow with the files.
+ *
+ * @param year1File The first file.
+ * @param year2File The second file.
+ * @param options The command-line options.
+ * @return The exit status.
+ */
+int diffFiles(const std::string& year1File, const std::string& year2File,
+              const CommandLineOptions& options) {
+  MeasurementFileProcessor year1(year1File);
+  MeasurementFileProcessor year2(year2File);
+  MeasurementFileProcessor* processors[] = {&year1, &year2};
+  for (MeasurementFileProcessor* processor : processors) {
+    processor->setStoragePolicy(options.storagePolicy);
+    processor->setReaderBackend(options.readerBackend);
+    processor->enableLogging(false);
+  }
+
+  const std::string outputFileName = "measurement_diff.csv";
+  std::ofstream out(outputFileName.c_str());
+  if (!out) {
+    std::cerr << "Cannot write " << outputFileName << std::endl;
+    return 1;
+  }
+  LineDiff diff(year1, year2, options.diffMetric, options.diffThreshold);
+  const LineDiffStatistics& statistics = diff.run(out);
+
+  std::cout << "Compared " << statistics.lines << " lines: "
+            << statistics.paired << " paired, " << statistics.unpaired
+            << " with a result in one file only, " << statistics.mismatched
+            << " with different dimensions.\n"
+            << statistics.reported << " lines past the threshold saved to "
+            << outputFileName << std::endl;
+  return 0;
+}
+
+/**
+ * @brief Configure a file processor from the options and read its input.
+ *
+ * @param fileProcessor The processor of the file.
+ * @param fileName The name of the file.
+ * @param options The command-line options.
+ */
+void readInput(MeasurementFileProcessor& fileProcessor,
+               const std::string& fileName,
+               const CommandLineOptions& options) {
+  if (options.quiet) {
+    fileProcessor.enableLogging(false);
+  }
+  fileProcessor.setOutlierPolicy(options.outlierPolicy);
+  fileProcessor.setStoragePolicy(options.storagePolicy);
+  fileProcessor.enableHistograms(options.histogram || options.histogramCsv);
+  fileProcessor.enableDistinctCounts(options.distinct);
+  fileProcessor.enableAdaptiveMode(options.adaptiveMode);
+  if (options.csv) {
+    fileProcessor.setCsvInput(options.csvOptions);
+  }
+  if (options.fixedPointPlaces >= 0) {
+    fileProcessor.enableFixedPoint(options.fixedPointPlaces,
+                                   options.fixedPointDimensionPlaces);
+  }
+  fileProcessor.setReaderBackend(options.readerBackend);
+  fileProcessor.setReportUnits(options.reportUnits);
+  if (options.lineIndexInterval > 0) {
+    fileProcessor.enableLineIndex(options.lineIndexInterval);
+  }
+  if (options.failedLinesOnly) {
+    fileProcessor.readLines(
+        LineIndex::load(LineIndex::getSidecarPath(fileName)).getFailedLines());
+  } else if (!options.lineRanges.empty()) {
+    std::vector<int64_t> lines;
+    for (const auto& range : options.lineRanges) {
+      for (int64_t line = range.first; line <= range.second; ++line) {
+        lines.push_back(line);
+      }
+    }
+    fileProcessor.readLines(lines);
+  } else {
+    fileProcessor.readFile();
+  }
+}
+
 /**
  * @brief Process the file and generate reports.
  * 
@@ -94,43 +572,132 @@ void titleBanner() {
  * sorted order, and stores the responses in the provided vectors.
  * 
  * @param fileName The name of the file to process.
+ * @param options The command-line options.
  * @param responses The vector to store the responses in original order.
  * @param sortedResponses The vector to store the responses in sorted order.
+ * @param statistics The vector to store the magnitudes the statistics are
+ * computed over in.
+ * @param summary The string to store the optional report sections
+ * (outliers, histograms, distinct counts, exact sums, precision loss, per-unit summaries) in, left empty when none is enabled.
  */
 void processFile(const std::string& fileName,
+                 const CommandLineOptions& options,
                  std::vector<std::string>& responses,
-                 std::vector<std::string>& sortedResponses) {
+                 std::vector<std::string>& sortedResponses,
+                 std::vector<double>& statistics,
+                 std::string& summary) {
   MeasurementFileProcessor fileProcessor(fileName);
-  fileProcessor.readFile();
-
-  responses = fileProcessor.generateReportsInOriginalOrder();
-
-  sortedResponses = fileProcessor.generateReportsInSortedOrder();
+  readInput(fileProcessor, fileName, options);
+
+  const ResultStore& results = fileProcessor.getResults();
+  const Selection selection =
+      options.filter.empty() ? Selection(results.size(), true)
+                             : ResultFilter::select(results, options.filter);
+  responses = fileProcessor.generateReportsInOriginalOrder(selection);
+  sortedResponses = fileProcessor.generateReportsInSortedOrder(selection);
+
+  ///> The statistics keep the stored units: the responses as printed, or
+  ///> the stored magnitudes when the responses were rescaled
+  statistics.clear();
+  statistics.reserve(responses.size());
+  if (options.reportUnits.empty()) {
+    for (const auto& response : responses) {
+      statistics.push_back(std::strtod(response.c_str(), nullptr));
+    }
+  } else {
+    for (uint32_t row : selection.getRows()) {
+      statistics.push_back(results.getMagnitude(row));
+    }
+  }
+  ///> NaN has no place in an order or a count
+  statistics.erase(std::remove_if(statistics.begin(), statistics.end(),
+                                  [](double value) { return std::isnan(value); }),
+                   statistics.end());
+
+  if (options.outlierPolicy != OutlierPolicy::NONE) {
+    summary += ReportGenerator::generateOutlierReport(
+        fileProcessor.getOutlierDetectors());
+  }
+  if (options.histogram) {
+    summary += ReportGenerator::generateHistogramReport(
+        fileProcessor.getHistograms());
+  }
+  if (options.fixedPointPlaces >= 0) {
+    summary += ReportGenerator::generateFixedPointReport(
+        fileProcessor.getFixedPointColumns());
+  }
+  if (options.storagePolicy == StoragePolicy::FLOAT32) {
+    summary += ReportGenerator::generatePrecisionLossReport(
+        fileProcessor.getResults());
+  }
+  if (options.unitSummary) {
+    summary += ReportGenerator::generateUnitSummaryReport(
+        fileProcessor.getResults());
+  }
+  if (options.distinct) {
+    summary += ReportGenerator::generateDistinctCountReport(
+        fileProcessor.getHistograms(), fileProcessor.getDistinctMagnitudes(),
+        fileProcessor.getDistinctUnits());
+  }
+  if (options.histogramCsv) {
+    std::ofstream csvFile(fileName + ".histogram.csv");
+    csvFile << ReportGenerator::generateHistogramCSV(
+        fileProcessor.getHistograms());
+  }
+  if (options.json) {
+    std::ofstream jsonFile(fileName + ".json", std::ios::binary);
+    JsonReportWriter writer(jsonFile, JsonFormat::ARRAY);
+    writer.write(fileProcessor.getResults());
+  }
+  if (options.ndjson) {
+    std::ofstream jsonFile(fileName + ".ndjson", std::ios::binary);
+    JsonReportWriter writer(jsonFile, JsonFormat::NDJSON);
+    writer.write(fileProcessor.getResults());
+  }
+  if (options.arrow) {
+    ArrowExporter::save(fileProcessor.getResults(), fileName + ".arrow",
+                        ArrowFormat::FILE);
+  }
+  if (options.arrowStream) {
+    ArrowExporter::save(fileProcessor.getResults(), fileName + ".arrows",
+                        ArrowFormat::STREAM);
+  }
+  if (options.saveResults) {
+    const ResultStore& results = fileProcessor.getResults();
+    std::size_t bytes = ResultFile::save(results, fileName + ".results");
+    std::cout << "Saved " << results.size() << " results to " << fileName
+              << ".results (" << bytes << " bytes)" << std::endl;
+  }
 }
 
 /**
  * @brief Compute and display statistics.
  * 
  * This function computes and displays the mean, mode, and median statistics
- * for the provided responses and writes them to the output file.
+ * for the provided magnitudes and writes them to the output file.
  * 
- * @param responses The responses to compute statistics for.
+ * @param statistics The magnitudes to compute statistics for, filled by
+ * processFile. The vector is reordered.
  * @param fileName The name of the file to display statistics for.
- * @param outputFile The output file stream to write the statistics to.
+ * @param outputFile The output stream to write the statistics to.
+ * @param adaptiveMode Whether the mode may be binned (see
+ * StatisticsCalculator::computeAdaptiveMode) rather than exact.
  */
-void computeAndDisplayStatistics(const std::vector<std::string>& responses,
+void computeAndDisplayStatistics(std::vector<double>& statistics,
                                  const std::string& fileName,
-                                 std::ofstream& outputFile) {
-  std::vector<Measurement> measurements;
-
-  for (const auto& response : responses) {
-    Measurement m = Measurement::fromString(response);
-    measurements.push_back(m);
+                                 std::ostream& outputFile, bool adaptiveMode) {
+  ///> A filter can select nothing, which has no mean, mode or median
+  if (statistics.empty()) {
+    std::cout << "\nStatistics for " << fileName << ":\nNo results\n";
+    outputFile << "\nStatistics for " << fileName << ":\nNo results\n";
+    return;
   }
 
-  double mean = StatisticsCalculator::computeMean(measurements);
-  double mode = StatisticsCalculator::computeMode(measurements);
-  double median = StatisticsCalculator::computeMedian(measurements);
+  double mean = StatisticsCalculator::computeMean(statistics);
+  double mode = adaptiveMode
+                    ? StatisticsCalculator::computeAdaptiveMode(statistics)
+                    : StatisticsCalculator::computeMode(statistics);
+  double median = StatisticsCalculator::computeMedian(statistics);
 
   std::cout << "\nStatistics for " << fileName << ":\n";
   std::cout << "Mean: " << mean << "\n";
@@ -147,19 +714,31 @@ void computeAndDisplayStatistics(const std::vector<std::string>& responses,
  * @brief Save output to a file.
  * 
  * This function saves the output to a file with the provided file name.
+ * The report is formatted into an AsyncWriter, whose background thread
+ * writes it to the file while the rest is being formatted.
  * 
  * @param outputFileName The name of the output file.
  * @param responsesYear1 The responses for argv[1] in original order.
  * @param sortedResponsesYear1 The responses for argv[1] in sorted order.
  * @param responsesYear2 The responses for argv[2] in original order.
  * @param sortedResponsesYear2 The responses for argv[2] in sorted order.
+ * @param statisticsYear1 The magnitudes of the argv[1] statistics.
+ * @param statisticsYear2 The magnitudes of the argv[2] statistics.
+ * @param summaryYear1 The optional report sections for argv[1], may be empty.
+ * @param summaryYear2 The optional report sections for argv[2], may be empty.
+ * @param adaptiveMode Whether the modes may be binned rather than exact.
  */
 void saveOutputToFile(const std::string& outputFileName,
                       const std::vector<std::string>& responsesYear1,
                       const std::vector<std::string>& sortedResponsesYear1,
                       const std::vector<std::string>& responsesYear2,
-                      const std::vector<std::string>& sortedResponsesYear2) {
-  std::ofstream outputFile(outputFileName);
+                      const std::vector<std::string>& sortedResponsesYear2,
+                      std::vector<double>& statisticsYear1,
+                      std::vector<double>& statisticsYear2,
+                      const std::string& summaryYear1,
+                      const std::string& summaryYear2, bool adaptiveMode) {
+  AsyncWriter writer(outputFileName);
+  std::ostream outputFile(&writer);
 
   outputFile << "Responses for year1measurements.txt in original order:\n";
   for (const auto& response : responsesYear1) {
@@ -171,7 +750,10 @@ void saveOutputToFile(const std::string& outputFileName,
     outputFile << response << "\n";
   }
 
-  computeAndDisplayStatistics(responsesYear1, "argv[1]", outputFile);
+  computeAndDisplayStatistics(statisticsYear1, "argv[1]", outputFile,
+                              adaptiveMode);
+  std::cout << summaryYear1;
+  outputFile << summaryYear1;
 
   outputFile << "\nResponses for year2measurements.txt in original order:\n";
   for (const auto& response : responsesYear2) {
@@ -183,42 +765,154 @@ void saveOutputToFile(const std::string& outputFileName,
     outputFile << response << "\n";
   }
 
-  computeAndDisplayStatistics(responsesYear2, "argv[2]", outputFile);
+  computeAndDisplayStatistics(statisticsYear2, "argv[2]", outputFile,
+                              adaptiveMode);
+  std::cout << summaryYear2;
+  outputFile << summaryYear2;
+
+  writer.flush();
+}
+
+AsyncWriter* stdoutWriter = nullptr;  ///< Buffers std::cout during main.
+std::terminate_handler defaultTerminate = nullptr;  ///< The handler replaced.
 
-  outputFile.close();
+/**
+ * @brief Writes out buffered standard output before terminating.
+ *
+ * An exception escaping main terminates without unwinding, so the
+ * AsyncWriter behind std::cout would otherwise lose what it holds.
+ */
+void flushAndTerminate() {
+  if (stdoutWriter != nullptr) {
+    try {
+      stdoutWriter->flush();
+    } catch (const std::exception&) {
+    }
+  }
+  defaultTerminate();
+}
+
+/**
+ * @brief Run the query on a file and print what it returns.
+ *
+ * The query was compiled once while parsing the options; each file only
+ * executes the plan.
+ *
+ * @param fileName The name of the file to query.
+ * @param options The command-line options.
+ */
+void queryFile(const std::string& fileName,
+               const CommandLineOptions& options) {
+  MeasurementFileProcessor fileProcessor(fileName);
+  fileProcessor.enableLogging(false);
+  readInput(fileProcessor, fileName, options);
+  QueryResult result = options.queryPlan.execute(fileProcessor.getResults());
+  std::cout << "Query results for " << fileName << ":\n";
+  for (const std::string& line : Query::format(result)) {
+    std::cout << line << "\n";
+  }
 }
 
 /**
  * @brief Main function to process the files and generate reports.
  * 
  * This function processes the files provided as command-line arguments,
- * generates reports, and saves the output to a file.
+ * generates reports, and saves the output to a file. Standard output goes
+ * through an AsyncWriter so printing never waits on the terminal or disk.
  * 
  * @param argc The number of command-line arguments.
  * @param argv The array of command-line arguments.
  * @return 0 if the program exits successfully, 1 otherwise.
  */
 int main(int argc, char* argv[]) {
-  titleBanner();
+  ///> Must come before any I/O, and before std::cout is redirected below
+  std::ios::sync_with_stdio(false);
+  AsyncWriter writer(STDOUT_FILENO);
+  StreamRedirect redirect(std::cout, writer);
+  stdoutWriter = &writer;
+  defaultTerminate = std::set_terminate(flushAndTerminate);
+
+  ///> The banner comes before any message about the arguments
+  if (std::find(argv + 1, argv + argc, std::string("--quiet")) ==
+      argv + argc) {
+    titleBanner();
+  }
 
   ///> Check if the correct number of arguments are provided
-  if (argc < 3) {
-    std::cerr << "Usage: " << argv[0] << " <year1_file> <year2_file>"
+  CommandLineOptions options;
+  if (!parseCommandLine(argc, argv, options) || options.files.size() < 2) {
+    std::cerr << "Usage: " << argv[0]
+              << " [--outliers=flag|exclude] [--histogram] [--histogram-csv]"
+                 " [--distinct] [--adaptive-mode] [--fixed-point[=SPEC]]"
+                 " [--float32]"
+                 " [--save-results] [--unit-summary]"
+                 " [--csv[=MAGNITUDE,UNIT]] [--csv-delimiter=C]"
+                 " [--csv-no-header] [--json] [--ndjson]"
+                 " [--arrow] [--arrow-stream] [--line-index[=N]]"
+                 " [--lines=SPEC|failed]"
+                 " [--reader=ifstream|mmap|io_uring|readahead]"
+                 " [--report-units=LIST] [--filter=SPEC]"
+                 " [--diff=delta|ratio|percent:THRESHOLD] [--query=QUERY]"
+                 " [--quiet]"
+                 " <year1_file> <year2_file>"
+                 " (either file may be - for standard input)"
               << std::endl;
     return 1;
   }
+  const std::string stdinName = MeasurementFileProcessor::STDIN_NAME;
+  const bool isStdinInput =
+      options.files[0] == stdinName || options.files[1] == stdinName;
+  if (options.files[0] == options.files[1] && isStdinInput) {
+    std::cerr << "Only one input can be read from standard input."
+              << std::endl;
+    return 1;
+  }
+  if (isStdinInput && (options.lineIndexInterval > 0 ||
+                       options.failedLinesOnly ||
+                       !options.lineRanges.empty())) {
+    std::cerr << "Line indexes need named input files." << std::endl;
+    return 1;
+  }
 
   ///> Store the file names from the command-line arguments
-  std::string year1File = argv[1];
-  std::string year2File = argv[2];
+  std::string year1File = options.files[0];
+  std::string year2File = options.files[1];
+
+  if (options.diff) {
+    if (options.csv || options.lineIndexInterval > 0 ||
+        options.failedLinesOnly || !options.lineRanges.empty()) {
+      std::cerr << "The line diff reads whole expression files." << std::endl;
+      return 1;
+    }
+    if (options.query) {
+      std::cerr << "Choose one of --diff and --query." << std::endl;
+      return 1;
+    }
+    return diffFiles(year1File, year2File, options);
+  }
+  if (options.query) {
+    if (!options.filter.empty()) {
+      std::cerr << "A query selects rows with its own where clause."
+                << std::endl;
+      return 1;
+    }
+    queryFile(year1File, options);
+    std::cout << "\n";
+    queryFile(year2File, options);
+    return 0;
+  }
 
   ///> Create vectors to store the responses and sorted responses
   std::vector<std::string> responsesYear1, sortedResponsesYear1;
   std::vector<std::string> responsesYear2, sortedResponsesYear2;
+  std::vector<double> statisticsYear1, statisticsYear2;
+  std::string summaryYear1, summaryYear2;
 
   ///> Process both files
-  processFile(year1File, responsesYear1, sortedResponsesYear1);
-  processFile(year2File, responsesYear2, sortedResponsesYear2);
+  processFile(year1File, options, responsesYear1, sortedResponsesYear1,
+              statisticsYear1, summaryYear1);
+  processFile(year2File, options, responsesYear2, sortedResponsesYear2,
+              statisticsYear2, summaryYear2);
 
   ///> Display results for year1 in original order
   std::cout << "Responses for " << year1File << " in original order:\n";
@@ -248,7 +942,9 @@ int main(int argc, char* argv[]) {
 
   ///> Save output to file
   saveOutputToFile(outputFileName, responsesYear1, sortedResponsesYear1,
-                   responsesYear2, sortedResponsesYear2);
+                   responsesYear2, sortedResponsesYear2, statisticsYear1,
+                   statisticsYear2, summaryYear1, summaryYear2,
+                   options.adaptiveMode);
 
   ///> Get the current working directory and print the output file path for the user
   char cwd[PATH_MAX];
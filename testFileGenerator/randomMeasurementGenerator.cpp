@@ -8,6 +8,12 @@
  * The units are randomly chosen from predefined categories (length, mass, volume, time).
  * The operators are randomly chosen from a list of operators (+, -, *, /).
  * The file is generated with 687 lines. (A Martian year is 687 Earth days.)
+ *
+ * Usage: RandomMeasurementGenerator [--same-dimension] [LINES [SEED [FILE]]]
+ * The optional arguments set the line count, a fixed seed for a repeatable
+ * file and the output file. --same-dimension draws all three units of a line
+ * from one category, so that Unitify can evaluate every line; the PGO
+ * training run uses it.
  * 
  * @version 0.1
  */
@@ -44,13 +50,30 @@ T getRandomElement(const std::vector<T>& vec) {
 /**
  * @brief Main function to generate the file with random measurement expressions.
  * 
+ * @param argc Number of command-line arguments.
+ * @param argv Optional line count, seed and output file.
  * @return Program exit status.
  */
-int main() {
-    std::ofstream file("generated_measurements.txt");
+int main(int argc, char* argv[]) {
+    bool sameDimension = argc > 1 && std::string(argv[1]) == "--same-dimension";
+    if (sameDimension) {
+        --argc;
+        ++argv;
+    }
+    long lines = argc > 1 ? std::strtol(argv[1], nullptr, 10) : 687;
+    std::string fileName = argc > 3 ? argv[3] : "generated_measurements.txt";
+    if (lines < 0) {
+        std::cerr << "Usage: RandomMeasurementGenerator [--same-dimension] [LINES [SEED [FILE]]]" << std::endl;
+        return 1;
+    }
+    std::ofstream file(fileName);
 
     // Initialize random seed
-    srand(static_cast<unsigned>(time(0)));
+    if (argc > 2) {
+        srand(static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)));
+    } else {
+        srand(static_cast<unsigned>(time(0)));
+    }
 
     // List of categorized units
     std::vector<std::string> lengthUnits = {"millimeters", "centimeters", "meters", "kilometers"};
@@ -58,12 +81,14 @@ int main() {
     std::vector<std::string> volumeUnits = {"milliliters", "centiliters", "liters", "kiloliters"};
     std::vector<std::string> timeUnits = {"seconds", "minutes", "hours"};
 
+    std::vector<std::vector<std::string>> categories = {lengthUnits, massUnits, volumeUnits, timeUnits};
+
     // List of operators
     std::vector<std::string> operators = {"+", "-", "*", "/"};
 
     if (file.is_open()) {
-        // Generate 687 lines
-        for (int i = 0; i < 687; ++i) {
+        // Generate 687 lines unless told otherwise
+        for (long i = 0; i < lines; ++i) {
             double magnitude1 = getRandomMagnitude();
             double magnitude2 = getRandomMagnitude();
             double magnitude3 = getRandomMagnitude();
@@ -73,7 +98,13 @@ int main() {
             std::string unit1, unit2, unit3;
 
             // Choose compatible units based on the operator
-            if (operator1 == "+" || operator1 == "-") {
+            if (sameDimension) {
+                // All three units from one category
+                const std::vector<std::string>& units = getRandomElement(categories);
+                unit1 = getRandomElement(units);
+                unit2 = getRandomElement(units);
+                unit3 = getRandomElement(units);
+            } else if (operator1 == "+" || operator1 == "-") {
                 // For addition and subtraction, units must be of the same type
                 int unitType = rand() % 4;  // Randomly select unit category: 0=length, 1=mass, 2=volume, 3=time
 
@@ -102,7 +133,9 @@ int main() {
             }
 
             // Choose a random unit for the third magnitude (operator2 can be anything)
-            unit3 = getRandomElement(lengthUnits);  // You can change this to match your specific use case
+            if (!sameDimension) {
+                unit3 = getRandomElement(lengthUnits);  // You can change this to match your specific use case
+            }
 
             // Write the line to the file (using spaces instead of commas)
             file << magnitude1 << " " << unit1 << " " << operator1 << " "
@@ -111,9 +144,10 @@ int main() {
         }
 
         file.close();
-        std::cout << "File 'generated_measurements.txt' generated successfully." << std::endl;
+        std::cout << "File '" << fileName << "' generated successfully." << std::endl;
     } else {
         std::cerr << "Error opening file for writing." << std::endl;
+        return 1;
     }
 
     return 0;